@@ -0,0 +1,570 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#include "benchmark.hpp"
+#include "ssh_mounter.hpp"
+#include "console.hpp"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QJsonDocument>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QMetaObject>
+#include <QProcess>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QThreadPool>
+#include <QTimer>
+#include <arpa/inet.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <random>
+
+extern Console console;
+
+// --- LoopbackSSHD ---
+
+LoopbackSSHD::LoopbackSSHD(QObject* parent)
+    : QObject(parent), sshd_(nullptr), port_(0), ready_(false) {
+}
+
+LoopbackSSHD::~LoopbackSSHD() {
+    stop();
+}
+
+int LoopbackSSHD::freePort() {
+    // Let the kernel pick; sshd binds it a moment later
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return 0;
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    int port = 0;
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0 &&
+        ::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) == 0) {
+        port = ntohs(addr.sin_port);
+    }
+    ::close(fd);
+    return port;
+}
+
+bool LoopbackSSHD::generateKey(const QString& path, QString& error) {
+    QProcess keygen;
+    keygen.setProcessChannelMode(QProcess::MergedChannels);
+    keygen.start("ssh-keygen", {"-q", "-t", "ed25519", "-N", "", "-C", "ssh-mounter-bench", "-f", path});
+    if (!keygen.waitForFinished(10000) || keygen.exitCode() != 0) {
+        error = "ssh-keygen failed: " + QString::fromLocal8Bit(keygen.readAll()).trimmed();
+        return false;
+    }
+    return true;
+}
+
+void LoopbackSSHD::start() {
+    QString sshdPath = QStandardPaths::findExecutable("sshd", {"/usr/sbin", "/usr/local/sbin", "/sbin"});
+    if (sshdPath.isEmpty()) sshdPath = QStandardPaths::findExecutable("sshd");
+    if (sshdPath.isEmpty()) {
+        emit failed("sshd is not installed");
+        return;
+    }
+
+    dir_.reset(new QTemporaryDir(QDir::tempPath() + "/ssh-mounter-bench-XXXXXX"));
+    if (!dir_->isValid()) {
+        emit failed("Cannot create a temporary directory");
+        return;
+    }
+    const QString root = dir_->path();
+    QDir().mkpath(root + "/remote");
+
+    QString error;
+    if (!generateKey(root + "/host_key", error) || !generateKey(root + "/client_key", error)) {
+        emit failed(error);
+        return;
+    }
+    QFile::copy(root + "/client_key.pub", root + "/authorized_keys");
+
+    port_ = freePort();
+    if (port_ == 0) {
+        emit failed("No free port on 127.0.0.1");
+        return;
+    }
+
+    QFile config(root + "/sshd_config");
+    if (!config.open(QIODevice::WriteOnly)) {
+        emit failed("Cannot write sshd_config");
+        return;
+    }
+    config.write(QString(
+        "ListenAddress 127.0.0.1\n"
+        "Port %1\n"
+        "HostKey %2/host_key\n"
+        "AuthorizedKeysFile %2/authorized_keys\n"
+        "PidFile %2/sshd.pid\n"
+        "PasswordAuthentication no\n"
+        "KbdInteractiveAuthentication no\n"
+        "PubkeyAuthentication yes\n"
+        "UsePAM no\n"
+        "StrictModes no\n"
+        "Subsystem sftp internal-sftp\n").arg(port_).arg(root).toUtf8());
+    config.close();
+
+    sshd_ = new QProcess(this);
+    sshd_->setProcessChannelMode(QProcess::MergedChannels);
+    connect(sshd_, &QProcess::readyReadStandardOutput, this, [this]() {
+        QString out = QString::fromLocal8Bit(sshd_->readAllStandardOutput());
+        console.log("sshd:", out.trimmed().toStdString());
+        if (!ready_ && out.contains("Server listening")) {
+            ready_ = true;
+            emit ready();
+        }
+    });
+    connect(sshd_, static_cast<void(QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished),
+            this, [this](int exitCode) {
+        if (!ready_) emit failed("sshd exited with code " + QString::number(exitCode));
+    });
+    connect(sshd_, &QProcess::errorOccurred, this, [this](QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart) emit failed("Failed to start sshd");
+    });
+    QTimer::singleShot(10000, this, [this]() {
+        if (!ready_ && sshd_) {
+            stop();
+            emit failed("sshd did not start listening within 10 s");
+        }
+    });
+
+    // -D stays in the foreground, -e logs to stderr where we look for
+    // "Server listening"
+    sshd_->start(sshdPath, {"-D", "-e", "-f", root + "/sshd_config"});
+}
+
+void LoopbackSSHD::stop() {
+    if (!sshd_) return;
+    sshd_->disconnect(this);
+    sshd_->terminate();
+    if (!sshd_->waitForFinished(2000)) sshd_->kill();
+    sshd_->deleteLater();
+    sshd_ = nullptr;
+    ready_ = false;
+}
+
+SSHHost LoopbackSSHD::host() const {
+    const QString root = dir_ ? dir_->path() : QString();
+    SSHHost h;
+    h.name = "loopback";
+    h.user = QString::fromLocal8Bit(qgetenv("USER"));
+    h.host = "127.0.0.1";
+    h.port = port_;
+    h.remotePath = root + "/remote";
+    h.usePublicKey = true;
+    h.controlPersist = 0;
+    h.profile.extraOptions = QString(
+        "IdentityFile=%1/client_key,IdentitiesOnly=yes,"
+        "StrictHostKeyChecking=no,UserKnownHostsFile=/dev/null").arg(root);
+    return h;
+}
+
+// --- Workloads ---
+
+namespace {
+
+double perSecond(qint64 count, qint64 nsecs) {
+    return nsecs > 0 ? count * 1e9 / nsecs : 0.0;
+}
+
+QByteArray pathOf(const QString& path) {
+    return QFile::encodeName(path);
+}
+
+} // namespace
+
+QJsonObject MountBenchmark::runWorkload(const QString& dir, const BenchmarkConfig& config) {
+    QJsonObject out;
+    const QString base = dir + QString("/ssh-mounter-bench-%1").arg(QCoreApplication::applicationPid());
+    const QString dataFile = base + "/seq.bin";
+    QElapsedTimer t;
+    QString error;
+
+    auto fail = [&](const char* step) {
+        error = QString("%1: %2").arg(step).arg(strerror(errno));
+        return false;
+    };
+
+    // Each stage returns false on the first failing call
+    auto run = [&]() -> bool {
+        if (::mkdir(pathOf(base).constData(), 0700) != 0 && errno != EEXIST) return fail("mkdir");
+
+        // Sequential write, 1 MiB at a time, fsync included
+        const int block = 1 << 20;
+        QByteArray buf(block, '\0');
+        std::mt19937 rng(42);
+        for (int i = 0; i < block; ++i) buf[i] = char(rng());
+
+        int fd = ::open(pathOf(dataFile).constData(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+        if (fd < 0) return fail("open for write");
+        t.start();
+        for (int i = 0; i < config.fileMiB; ++i) {
+            if (::write(fd, buf.constData(), block) != block) { fail("write"); ::close(fd); return false; }
+        }
+        if (::fsync(fd) != 0) { fail("fsync"); ::close(fd); return false; }
+        ::close(fd);
+        out["seq_write_mib_s"] = perSecond(config.fileMiB, t.nsecsElapsed());
+
+        // Sequential read
+        fd = ::open(pathOf(dataFile).constData(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return fail("open for read");
+        t.start();
+        qint64 total = 0;
+        for (;;) {
+            ssize_t n = ::read(fd, buf.data(), block);
+            if (n < 0) { fail("read"); ::close(fd); return false; }
+            if (n == 0) break;
+            total += n;
+        }
+        out["seq_read_mib_s"] = perSecond(total, t.nsecsElapsed()) / block;
+
+        // Random 4 KiB reads
+        const qint64 blocks = qMax<qint64>(1, total / 4096);
+        t.start();
+        for (int i = 0; i < config.randomReads; ++i) {
+            off_t offset = off_t(rng() % blocks) * 4096;
+            if (::pread(fd, buf.data(), 4096, offset) < 0) { fail("pread"); ::close(fd); return false; }
+        }
+        out["random_4k_read_iops"] = perSecond(config.randomReads, t.nsecsElapsed());
+        ::close(fd);
+        ::unlink(pathOf(dataFile).constData());
+
+        // Small files: create, stat, unlink
+        QVector<QByteArray> names;
+        names.reserve(config.smallFiles);
+        for (int i = 0; i < config.smallFiles; ++i) {
+            names.append(pathOf(QString("%1/small-%2").arg(base).arg(i)));
+        }
+        t.start();
+        for (const auto& name : names) {
+            int f = ::open(name.constData(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+            if (f < 0) return fail("create");
+            ::close(f);
+        }
+        out["create_per_s"] = perSecond(names.size(), t.nsecsElapsed());
+        struct stat st;
+        t.start();
+        for (const auto& name : names) {
+            if (::stat(name.constData(), &st) != 0) return fail("stat");
+        }
+        out["stat_per_s"] = perSecond(names.size(), t.nsecsElapsed());
+        t.start();
+        for (const auto& name : names) {
+            if (::unlink(name.constData()) != 0) return fail("unlink");
+        }
+        out["unlink_per_s"] = perSecond(names.size(), t.nsecsElapsed());
+
+        // readdir on a large directory, cold then warm
+        const QString bigDir = base + "/dir";
+        if (::mkdir(pathOf(bigDir).constData(), 0700) != 0) return fail("mkdir");
+        for (int i = 0; i < config.dirEntries; ++i) {
+            int f = ::open(pathOf(QString("%1/entry-%2").arg(bigDir).arg(i)).constData(),
+                           O_WRONLY | O_CREAT | O_CLOEXEC, 0600);
+            if (f < 0) return fail("populate");
+            ::close(f);
+        }
+        auto listing = [&](const char* key) -> bool {
+            t.start();
+            DIR* d = ::opendir(pathOf(bigDir).constData());
+            if (!d) return fail("opendir");
+            int entries = 0;
+            while (::readdir(d)) ++entries;
+            ::closedir(d);
+            out[key] = t.nsecsElapsed() / 1e6;
+            out["readdir_entries"] = entries;
+            return true;
+        };
+        if (!listing("readdir_cold_ms") || !listing("readdir_warm_ms")) return false;
+        return true;
+    };
+
+    bool ok = run();
+
+    // Best-effort cleanup whatever happened above
+    ::unlink(pathOf(dataFile).constData());
+    for (int i = 0; i < config.smallFiles; ++i) {
+        ::unlink(pathOf(QString("%1/small-%2").arg(base).arg(i)).constData());
+    }
+    for (int i = 0; i < config.dirEntries; ++i) {
+        ::unlink(pathOf(QString("%1/dir/entry-%2").arg(base).arg(i)).constData());
+    }
+    ::rmdir(pathOf(base + "/dir").constData());
+    ::rmdir(pathOf(base).constData());
+
+    if (!ok) out["error"] = error;
+    return out;
+}
+
+// --- MountBenchmark ---
+
+MountBenchmark::MountBenchmark(const BenchmarkConfig& config, QObject* parent)
+    : QObject(parent), config_(config), mounter_(new SSHMounter(this)), loopback_(nullptr),
+      mountMs_(0), running_(false), unmounting_(false) {
+    connect(mounter_, &SSHMounter::mountSuccess, this, [this]() {
+        mountMs_ = mountTimer_.elapsed();
+        emit progress(QString("Running workloads on %1 (%2)...")
+            .arg(current_.target).arg(current_.host.profile.name));
+
+        const QString dir = mountDir_->path();
+        const BenchmarkConfig config = config_;
+        QThreadPool::globalInstance()->start([this, dir, config]() {
+            QJsonObject r = runWorkload(dir, config);
+            QMetaObject::invokeMethod(this, [this, r]() {
+                record(r);
+                unmounting_ = true;
+                mounter_->unmount(mountDir_->path());
+            }, Qt::QueuedConnection);
+        });
+    });
+    connect(mounter_, &SSHMounter::unmountSuccess, this, [this]() {
+        unmounting_ = false;
+        next();
+    });
+    connect(mounter_, &SSHMounter::mountError, this, [this](const QString& error) {
+        if (unmounting_) {
+            unmounting_ = false;
+            console.warn("Benchmark unmount failed:", error.toStdString());
+        } else {
+            QJsonObject r;
+            r["error"] = error;
+            record(r);
+        }
+        next();
+    });
+    connect(mounter_, &SSHMounter::mountCancelled, this, [this]() {
+        QJsonObject r;
+        r["error"] = QString("Mount cancelled");
+        record(r);
+        next();
+    });
+    // Benchmarks never prompt
+    connect(mounter_, &SSHMounter::passwordRequired, mounter_, &SSHMounter::noPassword);
+}
+
+MountBenchmark::~MountBenchmark() = default;
+
+void MountBenchmark::run(const QList<SSHHost>& hosts, const QStringList& profiles) {
+    if (running_) return;
+    running_ = true;
+    start(hosts, profiles);
+}
+
+void MountBenchmark::start(const QList<SSHHost>& hosts, const QStringList& profiles) {
+    results_ = QJsonArray();
+    jobs_.clear();
+
+    mountDir_.reset(new QTemporaryDir(QDir::tempPath() + "/ssh-mounter-mnt-XXXXXX"));
+    if (!mountDir_->isValid()) {
+        QJsonObject r;
+        r["error"] = QString("Cannot create a temporary mount point");
+        results_.append(r);
+        done();
+        return;
+    }
+
+    for (const auto& host : hosts) {
+        const QStringList names = profiles.isEmpty() ? QStringList{host.profile.name} : profiles;
+        for (const QString& name : names) {
+            Job job;
+            job.target = host.name;
+            job.host = host;
+            job.host.localPath = mountDir_->path();
+            // Every run pays for its own connection so runs compare fairly
+            job.host.controlPersist = 0;
+            if (name != host.profile.name) {
+                const QString extra = host.profile.extraOptions;
+                job.host.profile = SSHFSProfile::preset(name);
+                job.host.profile.extraOptions = extra;
+            }
+            jobs_.append(job);
+        }
+    }
+    next();
+}
+
+void MountBenchmark::runLoopback(const QStringList& profiles) {
+    if (running_) return;
+    running_ = true;
+    results_ = QJsonArray();
+    loopback_ = new LoopbackSSHD(this);
+    connect(loopback_, &LoopbackSSHD::ready, this, [this, profiles]() {
+        start({loopback_->host()}, profiles);
+    });
+    connect(loopback_, &LoopbackSSHD::failed, this, [this](const QString& error) {
+        QJsonObject r;
+        r["host"] = QString("loopback");
+        r["error"] = error;
+        emit result(r);
+        results_.append(r);
+        done();
+    });
+    emit progress("Starting loopback sshd...");
+    loopback_->start();
+}
+
+void MountBenchmark::next() {
+    if (jobs_.isEmpty()) {
+        done();
+        return;
+    }
+    current_ = jobs_.takeFirst();
+    if (!current_.host.usePublicKey) {
+        QJsonObject r;
+        r["error"] = QString("Benchmarks need public key authentication");
+        record(r);
+        next();
+        return;
+    }
+    emit progress(QString("Mounting %1 (%2)...").arg(current_.target).arg(current_.host.profile.name));
+    mountTimer_.start();
+    mountMs_ = 0;
+    mounter_->mount(current_.host);
+}
+
+void MountBenchmark::record(QJsonObject r) {
+    r["host"] = current_.target;
+    r["profile"] = current_.host.profile.name;
+    r["options"] = current_.host.profile.optionString();
+    r["timestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    if (mountMs_ > 0) r["mount_ms"] = mountMs_;
+    QJsonObject config;
+    config["file_mib"] = config_.fileMiB;
+    config["random_reads"] = config_.randomReads;
+    config["small_files"] = config_.smallFiles;
+    config["dir_entries"] = config_.dirEntries;
+    r["config"] = config;
+    mountMs_ = 0;
+
+    results_.append(r);
+    emit result(r);
+}
+
+void MountBenchmark::done() {
+    running_ = false;
+    if (loopback_) {
+        loopback_->stop();
+        loopback_->deleteLater();
+        loopback_ = nullptr;
+    }
+    emit progress("Benchmark finished");
+    emit finished(results_);
+}
+
+int MountBenchmark::runCli(QCoreApplication& app) {
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Benchmark sshfs mounts and print the results as JSON");
+    parser.addHelpOption();
+    parser.addOption({"benchmark", "Run the benchmark suite."});
+    parser.addOption({"loopback", "Benchmark a throwaway sshd on 127.0.0.1 (default without --host)."});
+    parser.addOption({"host", "Benchmark the saved host called <name>; repeatable.", "name"});
+    parser.addOption({"profile", "Profile to benchmark (" + SSHFSProfile::presetNames().join(", ") +
+                      "); repeatable. Defaults to each host's own profile.", "name"});
+    parser.addOption({"output", "Write the JSON to <file> instead of stdout.", "file"});
+    parser.addOption({"file-mib", "Sequential test file size in MiB.", "n", "64"});
+    parser.addOption({"random-reads", "Number of random 4 KiB reads.", "n", "2000"});
+    parser.addOption({"small-files", "Number of small files to create, stat and unlink.", "n", "500"});
+    parser.addOption({"dir-entries", "Entries in the readdir test directory.", "n", "2000"});
+    parser.process(app);
+
+    BenchmarkConfig config;
+    config.fileMiB = qMax(1, parser.value("file-mib").toInt());
+    config.randomReads = qMax(1, parser.value("random-reads").toInt());
+    config.smallFiles = qMax(1, parser.value("small-files").toInt());
+    config.dirEntries = qMax(1, parser.value("dir-entries").toInt());
+
+    const QStringList profiles = parser.values("profile");
+    for (const QString& name : profiles) {
+        if (!SSHFSProfile::presetNames().contains(name)) {
+            console.error("Unknown profile", name.toStdString());
+            return 2;
+        }
+    }
+
+    QList<SSHHost> hosts;
+    const QStringList names = parser.values("host");
+    if (!names.isEmpty()) {
+        SSHStore store;
+        if (!store.load()) return 2;
+        for (const QString& name : names) {
+            QList<const SSHHost*> found = store.byName(name);
+            if (found.isEmpty()) {
+                console.error("No saved host called", name.toStdString());
+                return 2;
+            }
+            hosts.append(*found.first());
+        }
+    }
+    const bool loopback = parser.isSet("loopback") || hosts.isEmpty();
+
+    MountBenchmark bench(config);
+    QObject::connect(&bench, &MountBenchmark::progress, [](const QString& msg) {
+        console.info(msg.toStdString());
+    });
+
+    int exitCode = 0;
+    QJsonArray all;
+    // Real hosts first, then the loopback server if asked for
+    auto finish = [&]() {
+        for (const auto& r : all) {
+            if (r.toObject().contains("error")) exitCode = 1;
+        }
+        QByteArray json = QJsonDocument(all).toJson(QJsonDocument::Indented);
+        const QString output = parser.value("output");
+        if (output.isEmpty()) {
+            std::cout << json.constData() << std::flush;
+        } else {
+            QFile file(output);
+            if (!file.open(QIODevice::WriteOnly) || file.write(json) != json.size()) {
+                console.error("Cannot write", output.toStdString());
+                exitCode = 2;
+            }
+        }
+        app.quit();
+    };
+    bool loopbackDone = !loopback;
+    QObject::connect(&bench, &MountBenchmark::finished, [&](const QJsonArray& results) {
+        for (const auto& r : results) all.append(r);
+        if (!loopbackDone) {
+            loopbackDone = true;
+            bench.runLoopback(profiles);
+            return;
+        }
+        finish();
+    });
+
+    QTimer::singleShot(0, &bench, [&]() {
+        if (!hosts.isEmpty()) {
+            bench.run(hosts, profiles);
+        } else {
+            loopbackDone = true;
+            bench.runLoopback(profiles);
+        }
+    });
+    app.exec();
+    return exitCode;
+}
+
+#include "benchmark.moc"
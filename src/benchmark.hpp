@@ -0,0 +1,114 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#pragma once
+
+#include "ssh_store.hpp"
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QList>
+#include <QObject>
+#include <QStringList>
+#include <memory>
+
+class QCoreApplication;
+class QProcess;
+class QTemporaryDir;
+class SSHMounter;
+
+struct BenchmarkConfig {
+    int fileMiB = 64;           // Sequential read/write file size
+    int randomReads = 2000;     // 4 KiB preads at random offsets
+    int smallFiles = 500;       // create/stat/unlink count
+    int dirEntries = 2000;      // Directory size for the readdir test
+};
+
+// Throwaway sshd on 127.0.0.1 with a fresh host key and client key, so
+// benchmarks can run without a real server. Everything lives in a
+// temporary directory that is removed with the object.
+class LoopbackSSHD : public QObject {
+    Q_OBJECT
+public:
+    explicit LoopbackSSHD(QObject* parent = nullptr);
+    ~LoopbackSSHD() override;
+
+    void start();
+    void stop();
+    // A key-authenticated host pointing at this server
+    SSHHost host() const;
+
+signals:
+    void ready();
+    void failed(const QString& error);
+
+private:
+    bool generateKey(const QString& path, QString& error);
+    static int freePort();
+
+    std::unique_ptr<QTemporaryDir> dir_;
+    QProcess* sshd_;
+    int port_;
+    bool ready_;
+};
+
+// Mounts each host through the normal SSHMounter path, once per profile,
+// runs a fixed set of file system workloads on the mount and reports the
+// numbers as JSON (one object per host and profile).
+class MountBenchmark : public QObject {
+    Q_OBJECT
+public:
+    explicit MountBenchmark(const BenchmarkConfig& config, QObject* parent = nullptr);
+    ~MountBenchmark() override;
+
+    // An empty profile list benchmarks each host with its own profile
+    void run(const QList<SSHHost>& hosts, const QStringList& profiles);
+    void runLoopback(const QStringList& profiles);
+    bool isRunning() const { return running_; }
+
+    // Blocking; runs all workloads in a scratch directory under dir
+    static QJsonObject runWorkload(const QString& dir, const BenchmarkConfig& config);
+
+    // ssh-mounter --benchmark [options]; returns the process exit code
+    static int runCli(QCoreApplication& app);
+
+signals:
+    void progress(const QString& message);
+    void result(const QJsonObject& result);
+    void finished(const QJsonArray& results);
+
+private:
+    struct Job {
+        SSHHost host;
+        QString target;
+    };
+
+    void start(const QList<SSHHost>& hosts, const QStringList& profiles);
+    void next();
+    void record(QJsonObject result);
+    void done();
+
+    BenchmarkConfig config_;
+    QList<Job> jobs_;
+    Job current_;
+    QJsonArray results_;
+    SSHMounter* mounter_;
+    LoopbackSSHD* loopback_;
+    std::unique_ptr<QTemporaryDir> mountDir_;
+    QElapsedTimer mountTimer_;
+    qint64 mountMs_;
+    bool running_;
+    bool unmounting_;
+};
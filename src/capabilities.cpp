@@ -0,0 +1,115 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#include "capabilities.hpp"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+QString Capabilities::cachePath() {
+    return QDir::homePath() + "/.ssh/mounter/capabilities.json";
+}
+
+QStringList Capabilities::issues() const {
+    QStringList list;
+    if (!sshfsInstalled()) list << "sshfs is not installed";
+    if (!fuseAvailable) list << "FUSE is not available";
+    return list;
+}
+
+static qint64 mtimeOf(const QString& path) {
+    QFileInfo info(path);
+    return info.exists() ? info.lastModified().toMSecsSinceEpoch() : -1;
+}
+
+// Directory mtimes along PATH; installing a binary anywhere on it changes one
+static QJsonArray pathStamps(const QString& pathEnv) {
+    QJsonArray stamps;
+    for (const QString& dir : pathEnv.split(':', Qt::SkipEmptyParts)) stamps.append(double(mtimeOf(dir)));
+    return stamps;
+}
+
+// Whether the cache still answers for a binary; path is empty for one
+// that was not found and has not been installed since
+static bool cachedBinary(const QJsonObject& cache, const QString& name, const QJsonArray& stamps, QString& path) {
+    QJsonObject entry = cache["binaries"].toObject()[name].toObject();
+    path = entry["path"].toString();
+    if (path.isEmpty()) return entry["missing"].toBool() && entry["dirs"].toArray() == stamps;
+    return mtimeOf(path) == qint64(entry["mtime"].toDouble(-2));
+}
+
+Capabilities Capabilities::probe() {
+    const QString pathEnv = QString::fromLocal8Bit(qgetenv("PATH"));
+
+    QJsonObject cache;
+    QFile file(cachePath());
+    if (file.open(QIODevice::ReadOnly)) {
+        cache = QJsonDocument::fromJson(file.readAll()).object();
+        file.close();
+    }
+    bool samePath = cache["PATH"].toString() == pathEnv;
+
+    Capabilities caps;
+    caps.fuseAvailable = QFile::exists("/dev/fuse") || QFile::exists("/usr/local/bin/sshfs");
+
+    const QJsonArray stamps = pathStamps(pathEnv);
+    bool hit = samePath;
+    auto resolve = [&](const QString& name) {
+        QString path;
+        if (!samePath || !cachedBinary(cache, name, stamps, path)) {
+            hit = false;
+            path = QStandardPaths::findExecutable(name);
+        }
+        return path;
+    };
+    caps.sshfsPath = resolve("sshfs");
+    caps.fusermountPath = resolve("fusermount");
+    caps.fromCache = hit;
+
+    if (!hit) {
+        QJsonObject binaries;
+        for (const auto& pair : {qMakePair(QString("sshfs"), caps.sshfsPath),
+                                 qMakePair(QString("fusermount"), caps.fusermountPath)}) {
+            QJsonObject entry;
+            entry["path"] = pair.second;
+            if (pair.second.isEmpty()) {
+                // Remembered too, so a system without it is not rescanned
+                // and the cache rewritten on every start
+                entry["missing"] = true;
+                entry["dirs"] = stamps;
+            } else {
+                entry["mtime"] = double(mtimeOf(pair.second));
+            }
+            binaries[pair.first] = entry;
+        }
+        QJsonObject root;
+        root["PATH"] = pathEnv;
+        root["binaries"] = binaries;
+
+        QDir().mkpath(QFileInfo(cachePath()).path());
+        QSaveFile out(cachePath());
+        if (out.open(QIODevice::WriteOnly)) {
+            out.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+            out.commit();
+        }
+    }
+    return caps;
+}
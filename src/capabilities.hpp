@@ -0,0 +1,37 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#pragma once
+
+#include <QString>
+#include <QStringList>
+
+// What the host system provides for mounting. Probing scans PATH
+// in-process and remembers the result in ~/.ssh/mounter/capabilities.json;
+// a cached binary is trusted for as long as its mtime and PATH are unchanged,
+// a missing one until a directory on PATH changes.
+struct Capabilities {
+    QString sshfsPath;
+    QString fusermountPath;
+    bool fuseAvailable = false;
+    bool fromCache = false;
+
+    bool sshfsInstalled() const { return !sshfsPath.isEmpty(); }
+    QStringList issues() const;
+
+    // Safe to call from any thread
+    static Capabilities probe();
+    static QString cachePath();
+};
@@ -0,0 +1,274 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#include "console.hpp"
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+void writeAll(int fd, const std::string& data) {
+    const char* p = data.data();
+    std::size_t left = data.size();
+    while (left > 0) {
+        ssize_t n = ::write(fd, p, left);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        p += n;
+        left -= std::size_t(n);
+    }
+}
+
+const char* levelName(LogLevel level) {
+    switch (level) {
+    case LogLevel::Info: return "INFO ";
+    case LogLevel::Warn: return "WARN ";
+    case LogLevel::Error: return "ERR  ";
+    case LogLevel::Log: break;
+    }
+    return "LOG  ";
+}
+
+} // namespace
+
+Console::Console() : slots_(new Slot[Capacity]) {
+    for (std::size_t i = 0; i < Capacity; ++i) slots_[i].seq.store(i, std::memory_order_relaxed);
+    color_ = ::isatty(STDOUT_FILENO);
+    drain_ = std::thread(&Console::run, this);
+}
+
+Console::~Console() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+        stop_.store(true);
+    }
+    wake_.notify_one();
+    drain_.join();
+    if (fileFd_ >= 0) ::close(fileFd_);
+}
+
+void Console::push(LogLevel level, std::string&& text) {
+    // Bounded multi-producer queue: claim a position, fill the slot, then
+    // publish it through the slot's sequence number.
+    std::uint64_t pos = head_.load(std::memory_order_relaxed);
+    Slot* slot;
+    for (;;) {
+        slot = &slots_[pos & (Capacity - 1)];
+        std::uint64_t seq = slot->seq.load(std::memory_order_acquire);
+        std::int64_t diff = std::int64_t(seq) - std::int64_t(pos);
+        if (diff == 0) {
+            if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            // Full
+            if (level < LogLevel::Warn || stop_.load(std::memory_order_relaxed)) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                wake();
+                return;
+            }
+            wake_.notify_one();
+            std::this_thread::yield();
+            pos = head_.load(std::memory_order_relaxed);
+        } else {
+            pos = head_.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->level = level;
+    slot->time = std::chrono::system_clock::now();
+    slot->text = std::move(text);
+    slot->seq.store(pos + 1, std::memory_order_release);
+    wake();
+}
+
+void Console::wake() {
+    // Pairs with the fence in run(): either this sees sleeping_, or the
+    // drain thread's last check before sleeping sees what was just pushed
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!sleeping_.load(std::memory_order_relaxed)) return;
+    // One caller does the waking; the mutex makes sure the drain thread is
+    // already waiting, not between its check and its wait
+    if (!sleeping_.exchange(false, std::memory_order_relaxed)) return;
+    { std::lock_guard<std::mutex> lock(wakeMutex_); }
+    wake_.notify_one();
+}
+
+bool Console::ready() const {
+    const Slot& slot = slots_[tail_ & (Capacity - 1)];
+    return slot.seq.load(std::memory_order_acquire) == tail_ + 1;
+}
+
+void Console::run() {
+    std::string out;
+    std::string file;
+    std::uint64_t reportedDrops = 0;
+
+    for (;;) {
+        out.clear();
+        file.clear();
+        bool toFile;
+        {
+            std::lock_guard<std::mutex> lock(fileMutex_);
+            toFile = fileFd_ >= 0;
+        }
+        std::uint64_t count = 0;
+        while (ready()) {
+            Slot& slot = slots_[tail_ & (Capacity - 1)];
+            format(slot, out, toFile ? &file : nullptr);
+            // Freed here rather than by the next caller to use the slot
+            slot.text = std::string();
+            slot.seq.store(tail_ + Capacity, std::memory_order_release);
+            ++tail_;
+            ++count;
+        }
+
+        std::uint64_t drops = dropped_.load(std::memory_order_relaxed);
+        if (drops != reportedDrops) {
+            std::string note = "[WARN] " + std::to_string(drops - reportedDrops) + " log message(s) dropped\n";
+            out += note;
+            file += note;
+            reportedDrops = drops;
+        }
+
+        if (!out.empty()) writeAll(outFd_.load(std::memory_order_relaxed), out);
+        if (!file.empty()) writeFile(file);
+        if (count > 0) {
+            {
+                std::lock_guard<std::mutex> lock(wakeMutex_);
+                written_.fetch_add(count, std::memory_order_release);
+            }
+            flushed_.notify_all();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(wakeMutex_);
+        if (stop_.load()) break;
+        sleeping_.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        // No timeout: every push and drop after the fence goes through wake()
+        wake_.wait(lock, [this, reportedDrops]() {
+            return stop_.load() || ready() || dropped_.load(std::memory_order_relaxed) != reportedDrops;
+        });
+        sleeping_.store(false, std::memory_order_relaxed);
+    }
+}
+
+void Console::setOutput(int fd) {
+    flush();
+    outFd_.store(fd);
+    color_.store(::isatty(fd));
+}
+
+void Console::format(const Slot& slot, std::string& out, std::string* file) const {
+    const bool color = color_.load(std::memory_order_relaxed);
+    switch (slot.level) {
+    case LogLevel::Log:
+        out += slot.text;
+        break;
+    case LogLevel::Info:
+        if (color) out += CLR_INFO;
+        out += "[INFO] ";
+        if (color) out += CLR_RESET;
+        out += slot.text;
+        break;
+    case LogLevel::Warn:
+        if (color) out += CLR_WARN;
+        out += "[WARN] ";
+        if (color) out += CLR_RESET;
+        out += slot.text;
+        break;
+    case LogLevel::Error:
+        if (color) out += CLR_ERR;
+        out += "[ERR] ";
+        if (color) out += CLR_RESET;
+        out += slot.text;
+        break;
+    }
+    out += '\n';
+
+    if (!file) return;
+    // 2025-01-31 12:34:56.789 INFO  message
+    std::time_t secs = std::chrono::system_clock::to_time_t(slot.time);
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(slot.time.time_since_epoch()).count() % 1000;
+    std::tm tm;
+    localtime_r(&secs, &tm);
+    char stamp[40];
+    std::size_t n = std::strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &tm);
+    std::snprintf(stamp + n, sizeof(stamp) - n, ".%03d ", int(ms));
+    *file += stamp;
+    *file += levelName(slot.level);
+    *file += slot.text;
+    *file += '\n';
+}
+
+bool Console::setLogFile(const std::string& path, std::size_t maxBytes, int keep) {
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        error("Cannot open log file", path, std::strerror(errno));
+        return false;
+    }
+    struct stat st;
+    std::size_t size = ::fstat(fd, &st) == 0 ? std::size_t(st.st_size) : 0;
+
+    std::lock_guard<std::mutex> lock(fileMutex_);
+    if (fileFd_ >= 0) ::close(fileFd_);
+    fileFd_ = fd;
+    filePath_ = path;
+    fileBytes_ = size;
+    fileMax_ = maxBytes;
+    fileKeep_ = keep;
+    return true;
+}
+
+void Console::writeFile(const std::string& data) {
+    std::lock_guard<std::mutex> lock(fileMutex_);
+    if (fileFd_ < 0) return;
+    if (fileMax_ > 0 && fileBytes_ > 0 && fileBytes_ + data.size() > fileMax_) rotate();
+    if (fileFd_ < 0) return;
+    writeAll(fileFd_, data);
+    fileBytes_ += data.size();
+}
+
+void Console::rotate() {
+    ::close(fileFd_);
+    fileFd_ = -1;
+    if (fileKeep_ > 0) {
+        for (int i = fileKeep_ - 1; i >= 1; --i) {
+            std::string from = filePath_ + "." + std::to_string(i);
+            std::string to = filePath_ + "." + std::to_string(i + 1);
+            ::rename(from.c_str(), to.c_str());
+        }
+        ::rename(filePath_.c_str(), (filePath_ + ".1").c_str());
+    } else {
+        ::unlink(filePath_.c_str());
+    }
+    fileFd_ = ::open(filePath_.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+    fileBytes_ = 0;
+}
+
+void Console::flush() {
+    const std::uint64_t target = head_.load(std::memory_order_acquire);
+    std::unique_lock<std::mutex> lock(wakeMutex_);
+    wake_.notify_one();
+    flushed_.wait_for(lock, std::chrono::seconds(1), [this, target]() {
+        // Dropped lines never took a position, so written_ catches up
+        return written_.load(std::memory_order_acquire) >= target;
+    });
+}
@@ -1,7 +1,7 @@
 /*
  * SSH Mounter - Simple GUI for SSHFS mounts
  * Copyright (C) 2025 SonicandTailsCD
- * 
+ *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
  * the Free Software Foundation, either version 3 of the License, or
@@ -15,13 +15,26 @@
 
 #pragma once
 
-#include <iostream>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
 #include <mutex>
+#include <sstream>
 #include <string>
 #include <string_view>
+#include <thread>
+#include <type_traits>
 #include <utility>
-#include <chrono>
-#include <ctime>
+
+// Calls below this level compile to nothing (make LOG_LEVEL=2 keeps only
+// warnings and errors). 0 = log, 1 = info, 2 = warn, 3 = error.
+#ifndef SSH_MOUNTER_LOG_LEVEL
+#define SSH_MOUNTER_LOG_LEVEL 0
+#endif
 
 // optional ANSI color codes (works in most terminals)
 inline constexpr const char* CLR_RESET = "\033[0m";
@@ -29,54 +42,137 @@ inline constexpr const char* CLR_INFO  = "\033[1;34m"; // bold blue
 inline constexpr const char* CLR_WARN  = "\033[1;33m"; // bold yellow
 inline constexpr const char* CLR_ERR   = "\033[1;31m"; // bold red
 
-struct Console {
-    std::mutex mtx;
+enum class LogLevel : int {
+    Log = 0,
+    Info = 1,
+    Warn = 2,
+    Error = 3
+};
+
+constexpr bool logEnabled(LogLevel level) {
+    return int(level) >= SSH_MOUNTER_LOG_LEVEL;
+}
+
+// Logging without locks or syscalls on the caller's thread: a call formats
+// its line and hands it to a bounded lock-free queue; a background thread
+// writes whatever has piled up in one write() per batch, to stdout and
+// optionally to a rotating log file.
+//
+// When the queue is full, log and info lines are dropped (and counted);
+// warnings and errors wait for room.
+class Console {
+public:
+    Console();
+    ~Console();
+    Console(const Console&) = delete;
+    Console& operator=(const Console&) = delete;
 
     // basic single-arg (avoid copying if caller has string_view)
     void log(std::string_view string) {
-        std::lock_guard lock(mtx);
-        std::cout << string << '\n';
+        if constexpr (logEnabled(LogLevel::Log)) push(LogLevel::Log, std::string(string));
     }
 
     // variadic, prints space-separated values like JS console.log
     template<typename... Args>
-    void log(const Args&... args) {
-        std::lock_guard lock(mtx);
-        (print_one(args), ...);        // fold expression (C++17)
-        std::cout << '\n' << std::flush;
-    }
+    void log(const Args&... args) { write<LogLevel::Log>(args...); }
 
     template<typename... Args>
-    void info(const Args&... args) {
-        std::lock_guard lock(mtx);
-        std::cout << CLR_INFO;
-        std::cout << "[INFO] " << CLR_RESET;
-        (print_one(args), ...);
-        std::cout << CLR_RESET << '\n' << std::flush;
-    }
+    void info(const Args&... args) { write<LogLevel::Info>(args...); }
 
     template<typename... Args>
-    void warn(const Args&... args) {
-        std::lock_guard lock(mtx);
-        std::cout << CLR_WARN;
-        std::cout << "[WARN] " << CLR_RESET;
-        (print_one(args), ...);
-        std::cout << CLR_RESET << '\n' << std::flush;
-    }
+    void warn(const Args&... args) { write<LogLevel::Warn>(args...); }
 
     template<typename... Args>
-    void error(const Args&... args) {
-        std::lock_guard lock(mtx);
-        std::cout << CLR_ERR;
-        std::cout << "[ERR] " << CLR_RESET;
-        (print_one(args), ...);
-        std::cout << CLR_RESET << '\n' << std::flush;
-    }
+    void error(const Args&... args) { write<LogLevel::Error>(args...); }
+
+    // Also write to path; once it grows past maxBytes it becomes path.1,
+    // path.1 becomes path.2 and so on, keeping at most keep old files.
+    bool setLogFile(const std::string& path, std::size_t maxBytes = 4 << 20, int keep = 3);
+
+    // Where lines go instead of stdout, e.g. stderr when stdout carries JSON
+    void setOutput(int fd);
+
+    // Blocks (up to a second) until everything logged so far is written
+    void flush();
+
+    std::uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
 
 private:
-    // helper prints one item followed by a space
+    struct Slot {
+        std::atomic<std::uint64_t> seq{0};
+        LogLevel level = LogLevel::Log;
+        std::chrono::system_clock::time_point time;
+        std::string text;
+    };
+
+    static constexpr std::size_t Capacity = 8192;     // Power of two
+
+    template<LogLevel Level, typename... Args>
+    void write(const Args&... args) {
+        if constexpr (logEnabled(Level)) {
+            std::string line;
+            line.reserve(128);
+            (append_one(line, args), ...);
+            if (!line.empty()) line.pop_back();
+            push(Level, std::move(line));
+        }
+    }
+
+    // helper appends one item followed by a space
     template<typename T>
-    void print_one(const T& v) {
-        std::cout << v << ' ';
+    static void append_one(std::string& out, const T& v) {
+        if constexpr (std::is_pointer_v<T> && std::is_convertible_v<T, const char*>) {
+            out.append(v ? v : "(null)");
+        } else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+            out.append(std::string_view(v));
+        } else if constexpr (std::is_same_v<T, char>) {
+            out.push_back(v);
+        } else if constexpr (std::is_same_v<T, bool>) {
+            out.push_back(v ? '1' : '0');
+        } else if constexpr (std::is_integral_v<T>) {
+            char buf[24];
+            auto result = std::to_chars(buf, buf + sizeof(buf), v);
+            out.append(buf, result.ptr);
+        } else if constexpr (std::is_floating_point_v<T>) {
+            char buf[32];
+            int n = std::snprintf(buf, sizeof(buf), "%g", double(v));
+            out.append(buf, n > 0 ? std::size_t(n) : 0);
+        } else {
+            std::ostringstream s;
+            s << v;
+            out += s.str();
+        }
+        out.push_back(' ');
     }
-};
\ No newline at end of file
+
+    void push(LogLevel level, std::string&& text);
+    // Wakes the drain thread if it is asleep
+    void wake();
+    void run();
+    bool ready() const;
+    void format(const Slot& slot, std::string& out, std::string* file) const;
+    void writeFile(const std::string& data);
+    void rotate();
+
+    std::unique_ptr<Slot[]> slots_;
+    alignas(64) std::atomic<std::uint64_t> head_{0};   // Next position to claim
+    alignas(64) std::uint64_t tail_ = 0;               // Drain thread only
+    std::atomic<std::uint64_t> written_{0};
+    std::atomic<std::uint64_t> dropped_{0};
+    std::atomic<bool> sleeping_{false};
+    std::atomic<bool> stop_{false};
+    std::mutex wakeMutex_;
+    std::condition_variable wake_;
+    std::condition_variable flushed_;
+
+    std::mutex fileMutex_;
+    int fileFd_ = -1;
+    std::string filePath_;
+    std::size_t fileBytes_ = 0;
+    std::size_t fileMax_ = 0;
+    int fileKeep_ = 0;
+
+    std::atomic<int> outFd_{1};
+    std::atomic<bool> color_{false};
+    std::thread drain_;
+};
@@ -0,0 +1,548 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#include "control.hpp"
+#include "ssh_store.hpp"
+#include "mount_manager.hpp"
+#include "mount_watcher.hpp"
+#include "mount_supervisor.hpp"
+#include "runtime_dir.hpp"
+#include "console.hpp"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QSocketNotifier>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+extern Console console;
+
+namespace {
+
+// A request line longer than this is a client bug, not a request
+const int MaxLine = 1 << 20;
+// Replies and events a client has not read yet; past this it is dropped
+const int MaxBacklog = 8 << 20;
+const int MaxClients = 64;
+
+QString stateName(MountState state) {
+    switch (state) {
+    case MountState::Idle: return "idle";
+    case MountState::Mounting: return "mounting";
+    case MountState::Mounted: return "mounted";
+    case MountState::Unmounting: return "unmounting";
+    case MountState::Error: return "error";
+    }
+    return "idle";
+}
+
+QByteArray compact(const QJsonObject& obj) {
+    return QJsonDocument(obj).toJson(QJsonDocument::Compact);
+}
+
+// Blocking client side, used by request() and the command line
+int connectTo(const QString& path, int timeoutMs) {
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    const QByteArray native = QFile::encodeName(path);
+    if (native.size() >= int(sizeof(addr.sun_path))) return -1;
+    memcpy(addr.sun_path, native.constData(), native.size());
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    timeval tv = {timeoutMs / 1000, (timeoutMs % 1000) * 1000};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool writeAll(int fd, const QByteArray& data) {
+    const char* p = data.constData();
+    qint64 left = data.size();
+    while (left > 0) {
+        ssize_t n = ::send(fd, p, size_t(left), MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        left -= n;
+    }
+    return true;
+}
+
+struct LineReader {
+    int fd;
+    QByteArray buf;
+    int pos = 0;
+
+    bool next(QByteArray& line) {
+        for (;;) {
+            int nl = buf.indexOf('\n', pos);
+            if (nl >= 0) {
+                line = buf.mid(pos, nl - pos);
+                pos = nl + 1;
+                return true;
+            }
+            buf.remove(0, pos);
+            pos = 0;
+            char chunk[65536];
+            ssize_t n = ::read(fd, chunk, sizeof(chunk));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            buf.append(chunk, int(n));
+        }
+    }
+};
+
+} // namespace
+
+ControlServer::ControlServer(SSHStore* store, MountWatcher* watcher, MountManager* manager,
+                             MountSupervisor* supervisor, QObject* parent)
+    : QObject(parent), store_(store), watcher_(watcher), manager_(manager), supervisor_(supervisor),
+      fd_(-1), notifier_(nullptr), subscribers_(0) {
+    connect(manager_, &MountManager::hostStateChanged, this, [this](const QString& key, MountState state) {
+        publish(key, {{"event", "state"}, {"state", stateName(state)}});
+    });
+    connect(manager_, &MountManager::hostMountSuccess, this, [this](const QString& key) {
+        publish(key, {{"event", "mounted"}});
+    });
+    connect(manager_, &MountManager::hostUnmountSuccess, this, [this](const QString& key) {
+        publish(key, {{"event", "unmounted"}});
+    });
+    connect(manager_, &MountManager::hostMountError, this, [this](const QString& key, const QString& error) {
+        publish(key, {{"event", "error"}, {"error", error}});
+    });
+    // The prompt is in the window; tooling only learns that someone has to answer it
+    connect(manager_, &MountManager::hostPasswordRequired, this, [this](const QString& key) {
+        publish(key, {{"event", "password_required"}});
+    });
+    connect(watcher_, &MountWatcher::hostMountChanged, this, [this](const QString& key, bool mounted) {
+        publish(key, {{"event", "mount"}, {"mounted", mounted}});
+    });
+    if (supervisor_) {
+        connect(supervisor_, &MountSupervisor::healthChanged, this, [this](const QString& key, MountHealth health) {
+            publish(key, {{"event", "health"}, {"health", MountSupervisor::healthName(health)}});
+        });
+    }
+}
+
+ControlServer::~ControlServer() {
+    for (int fd : clients_.keys()) dropClient(fd);
+    if (fd_ >= 0) ::close(fd_);
+    if (!socketPath_.isEmpty()) QFile::remove(socketPath_);
+}
+
+QString ControlServer::defaultSocketPath() {
+    const QString configured = qEnvironmentVariable("SSH_MOUNTER_CONTROL_SOCKET");
+    if (!configured.isEmpty() && configured != "off") return configured;
+    return RuntimeDir::path() + "/control.sock";
+}
+
+bool ControlServer::request(const QByteArray& line, QByteArray* reply, const QString& path) {
+    int fd = connectTo(path, 2000);
+    if (fd < 0) return false;
+    bool ok = writeAll(fd, line.trimmed() + '\n');
+    if (ok && reply) {
+        LineReader reader{fd};
+        ok = reader.next(*reply);
+    }
+    ::close(fd);
+    return ok;
+}
+
+bool ControlServer::listen(const QString& path, QString& error) {
+    if (fd_ >= 0) {
+        error = "Already listening on " + socketPath_;
+        return false;
+    }
+
+    // Only our own directory is created; a configured path's must exist
+    if (QFileInfo(path).absolutePath() == RuntimeDir::path() && !RuntimeDir::ensure(error)) return false;
+
+    // Only unlink a socket nobody answers on; that one is left over from a crash
+    int probe = connectTo(path, 500);
+    if (probe >= 0) {
+        ::close(probe);
+        error = "Another instance is already listening on " + path;
+        return false;
+    }
+
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    const QByteArray native = QFile::encodeName(path);
+    if (native.size() >= int(sizeof(addr.sun_path))) {
+        error = "Socket path too long: " + path;
+        return false;
+    }
+    memcpy(addr.sun_path, native.constData(), native.size());
+
+    fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    ::unlink(native.constData());
+    if (fd_ < 0 || ::bind(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        ::listen(fd_, 64) != 0) {
+        error = QString("Cannot listen on %1: %2").arg(path, strerror(errno));
+        if (fd_ >= 0) ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    ::chmod(native.constData(), 0600);
+    socketPath_ = path;
+
+    notifier_ = new QSocketNotifier(fd_, QSocketNotifier::Read, this);
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    connect(notifier_, &QSocketNotifier::activated, this, &ControlServer::onAccept);
+#else
+    connect(notifier_, SIGNAL(activated(int)), this, SLOT(onAccept()));
+#endif
+    console.info("Control socket listening on", path.toStdString());
+    return true;
+}
+
+void ControlServer::onAccept() {
+    for (;;) {
+        int fd = ::accept4(fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;
+        if (clients_.size() >= MaxClients) {
+            ::close(fd);
+            continue;
+        }
+
+        Client& client = clients_[fd];
+        client.reader = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+        client.writer = new QSocketNotifier(fd, QSocketNotifier::Write, this);
+        client.writer->setEnabled(false);
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+        connect(client.reader, &QSocketNotifier::activated, this, [this, fd]() { onClientReadable(fd); });
+        connect(client.writer, &QSocketNotifier::activated, this, [this, fd]() { onClientWritable(fd); });
+#else
+        connect(client.reader, SIGNAL(activated(int)), this, SLOT(onClientReadable(int)));
+        connect(client.writer, SIGNAL(activated(int)), this, SLOT(onClientWritable(int)));
+#endif
+    }
+}
+
+void ControlServer::onClientReadable(int fd) {
+    auto it = clients_.find(fd);
+    if (it == clients_.end()) return;
+
+    // Drain everything queued up; a pipelining client may have sent
+    // thousands of requests since the last wakeup
+    bool closed = false;
+    char buf[65536];
+    for (;;) {
+        ssize_t n = ::read(fd, buf, sizeof(buf));
+        if (n > 0) {
+            it->in.append(buf, int(n));
+            if (size_t(n) < sizeof(buf)) break;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else {
+            closed = n == 0 || errno != EAGAIN;
+            break;
+        }
+    }
+
+    const int end = it->in.lastIndexOf('\n');
+    if (end < 0 && it->in.size() > MaxLine) {
+        console.warn("Control client sent an overlong line; dropping it");
+        dropClient(fd);
+        return;
+    }
+    const QByteArray lines = it->in.left(end + 1);
+    it->in.remove(0, end + 1);
+
+    // Replies for the whole read go out in one send
+    QByteArray replies;
+    int pos = 0;
+    while (pos < lines.size()) {
+        const int nl = lines.indexOf('\n', pos);
+        const QByteArray line = lines.mid(pos, nl - pos).trimmed();
+        pos = nl + 1;
+        if (line.isEmpty()) continue;
+
+        QJsonParseError err;
+        const QJsonDocument doc = QJsonDocument::fromJson(line, &err);
+        if (err.error != QJsonParseError::NoError) {
+            replies += compact({{"ok", false}, {"error", "Invalid JSON: " + err.errorString()}});
+        } else if (doc.isArray()) {
+            QJsonArray batch;
+            for (const QJsonValue& v : doc.array()) {
+                batch.append(v.isObject() ? handle(v.toObject(), fd)
+                                          : QJsonObject{{"ok", false}, {"error", "Batch entries must be objects"}});
+            }
+            replies += QJsonDocument(batch).toJson(QJsonDocument::Compact);
+        } else {
+            replies += compact(handle(doc.object(), fd));
+        }
+        replies += '\n';
+    }
+
+    // Handlers may have published events; re-find rather than trust it
+    it = clients_.find(fd);
+    if (it == clients_.end()) return;
+    it->out += replies;
+    if (closed) {
+        // Half-closed clients still get their replies, then the socket closes
+        it->reader->setEnabled(false);
+        it->closing = true;
+    }
+    flush(fd);
+}
+
+void ControlServer::onClientWritable(int fd) {
+    flush(fd);
+}
+
+void ControlServer::flush(int fd) {
+    auto it = clients_.find(fd);
+    if (it == clients_.end()) return;
+
+    int sent = 0;
+    while (sent < it->out.size()) {
+        ssize_t n = ::send(fd, it->out.constData() + sent, size_t(it->out.size() - sent),
+                           MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n > 0) {
+            sent += int(n);
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && errno == EAGAIN) {
+            break;
+        } else {
+            dropClient(fd);
+            return;
+        }
+    }
+    it->out.remove(0, sent);
+
+    if (it->out.size() > MaxBacklog) {
+        console.warn("Control client is not reading its replies; dropping it");
+        dropClient(fd);
+        return;
+    }
+    if (it->out.isEmpty() && it->closing) {
+        dropClient(fd);
+        return;
+    }
+    it->writer->setEnabled(!it->out.isEmpty());
+}
+
+void ControlServer::dropClient(int fd) {
+    auto it = clients_.find(fd);
+    if (it == clients_.end()) return;
+    if (it->subscribed) --subscribers_;
+    // Usually called from inside a notifier's own activated()
+    for (QSocketNotifier* n : {it->reader, it->writer}) {
+        n->setEnabled(false);
+        n->deleteLater();
+    }
+    clients_.erase(it);
+    ::close(fd);
+}
+
+QJsonObject ControlServer::hostStatus(const SSHHost& host) const {
+    const QString key = MountManager::keyFor(host);
+    QJsonObject obj;
+    obj["id"] = host.id;
+    obj["key"] = key;
+    obj["name"] = host.name;
+    obj["user"] = host.user;
+    obj["host"] = host.host;
+    obj["port"] = host.port;
+    obj["remotePath"] = host.remotePath;
+    obj["localPath"] = host.localPath;
+    obj["mounted"] = watcher_->isMounted(key);
+    obj["state"] = stateName(manager_->state(key));
+    obj["busy"] = manager_->isBusy(key);
+    if (supervisor_) {
+        const MountSupervisor::Status status = supervisor_->status(key);
+        obj["health"] = MountSupervisor::healthName(status.health);
+        if (status.totalBytes > 0) {
+            obj["freeBytes"] = double(status.freeBytes);
+            obj["totalBytes"] = double(status.totalBytes);
+        }
+        if (status.recovering) obj["recovering"] = true;
+    }
+    return obj;
+}
+
+QVector<SSHHost> ControlServer::resolve(const QJsonObject& request, QString& error) const {
+    QJsonArray names = request.value("hosts").toArray();
+    if (request.contains("host")) names.append(request.value("host"));
+
+    QVector<SSHHost> hosts;
+    for (const QJsonValue& v : names) {
+        const QString name = v.toString();
+        const SSHHost* host = store_->byId(name);
+        if (!host) {
+            const QList<const SSHHost*> found = store_->byName(name);
+            if (!found.isEmpty()) host = found.first();
+        }
+        if (!host) {
+            error = "No saved host called " + name;
+            return {};
+        }
+        hosts.append(*host);
+    }
+    return hosts;
+}
+
+QJsonObject ControlServer::handle(const QJsonObject& request, int fd) {
+    QJsonObject reply;
+    if (request.contains("id")) reply["id"] = request.value("id");
+    const QString cmd = request.value("cmd").toString();
+    auto fail = [&reply](const QString& error) {
+        reply["ok"] = false;
+        reply["error"] = error;
+        return reply;
+    };
+
+    const bool named = request.contains("host") || request.contains("hosts");
+    QString error;
+    const QVector<SSHHost> picked = resolve(request, error);
+    if (!error.isEmpty()) return fail(error);
+    // All hosts are read from the store in place, not copied per request
+    const bool all = !named && (cmd == "status" || cmd == "subscribe" || request.value("all").toBool());
+    const QVector<SSHHost>& hosts = all ? store_->hosts() : picked;
+
+    if (cmd == "ping") {
+        reply["pid"] = QCoreApplication::applicationPid();
+    } else if (cmd == "status") {
+        QJsonArray list;
+        for (const SSHHost& host : hosts) list.append(hostStatus(host));
+        reply["hosts"] = list;
+    } else if (cmd == "mount" || cmd == "unmount") {
+        if (!named && !request.value("all").toBool()) return fail("Name a host, hosts, or set all");
+        const bool mount = cmd == "mount";
+        QList<SSHHost> todo;
+        QJsonArray queued;
+        QJsonArray skipped;
+        for (const SSHHost& host : hosts) {
+            const QString key = MountManager::keyFor(host);
+            if (watcher_->isMounted(key) == mount || manager_->isBusy(key)) {
+                skipped.append(key);
+            } else {
+                todo.append(host);
+                queued.append(key);
+            }
+        }
+        // Results arrive as events; subscribe first to see them
+        if (mount) manager_->mountAll(todo);
+        else manager_->unmountAll(todo);
+        reply["queued"] = queued;
+        if (!skipped.isEmpty()) reply["skipped"] = skipped;
+    } else if (cmd == "subscribe" || cmd == "unsubscribe") {
+        auto it = clients_.find(fd);
+        if (it == clients_.end()) return fail("Client is gone");
+        const bool subscribe = cmd == "subscribe";
+        if (subscribe != it->subscribed) subscribers_ += subscribe ? 1 : -1;
+        it->subscribed = subscribe;
+        it->keys.clear();
+        if (subscribe) {
+            // Current state, so nothing between this reply and the first event is missed
+            QJsonArray list;
+            for (const SSHHost& host : hosts) {
+                if (named) it->keys.insert(MountManager::keyFor(host));
+                list.append(hostStatus(host));
+            }
+            reply["hosts"] = list;
+        }
+    } else if (cmd == "show") {
+        emit showRequested();
+    } else {
+        return fail(cmd.isEmpty() ? QString("Missing cmd") : "Unknown command: " + cmd);
+    }
+    reply["ok"] = true;
+    return reply;
+}
+
+void ControlServer::publish(const QString& key, QJsonObject event) {
+    if (subscribers_ == 0) return;
+    event["key"] = key;
+    event["name"] = manager_->host(key).name;
+    const QByteArray line = compact(event) + '\n';
+
+    QList<int> targets;
+    for (auto it = clients_.begin(); it != clients_.end(); ++it) {
+        if (!it->subscribed || (!it->keys.isEmpty() && !it->keys.contains(key))) continue;
+        it->out += line;
+        targets.append(it.key());
+    }
+    // flush() may drop a client, so not while iterating
+    for (int fd : targets) flush(fd);
+}
+
+bool ControlServer::wanted(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--control") == 0) return true;
+    }
+    return false;
+}
+
+int ControlServer::runCli(QCoreApplication& app) {
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Talk to the running SSH Mounter over its control socket");
+    parser.addHelpOption();
+    parser.addOption({"control", "Send each <request> (one JSON object or array) and print the replies."});
+    parser.addOption({"socket", "Control socket path.", "path", defaultSocketPath()});
+    parser.addPositionalArgument("request", "JSON request line, e.g. '{\"cmd\":\"status\"}'.", "[request...]");
+    parser.process(app);
+    console.setOutput(STDERR_FILENO);
+
+    const QStringList requests = parser.positionalArguments();
+    if (requests.isEmpty()) {
+        console.error("--control needs at least one JSON request");
+        return 2;
+    }
+    const QString path = parser.value("socket");
+    int fd = connectTo(path, 10000);
+    if (fd < 0) {
+        console.error("No running instance answers on", path.toStdString());
+        return 1;
+    }
+    LineReader reader{fd};
+    QByteArray line;
+
+    QByteArray out;
+    bool subscribed = false;
+    for (const QString& r : requests) {
+        out += r.toUtf8().trimmed() + '\n';
+        subscribed = subscribed || r.contains("\"subscribe\"");
+    }
+    if (!writeAll(fd, out)) return 1;
+
+    // Replies in order, events in between; subscribers follow the stream until the app exits
+    timeval none = {0, 0};
+    if (subscribed) setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &none, sizeof(none));
+    int replies = 0;
+    while ((subscribed || replies < requests.size()) && reader.next(line)) {
+        std::cout << line.constData() << '\n' << std::flush;
+        if (!QJsonDocument::fromJson(line).object().contains("event")) ++replies;
+    }
+    ::close(fd);
+    return replies >= requests.size() ? 0 : 1;
+}
+
+#include "control.moc"
@@ -0,0 +1,102 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#pragma once
+
+#include "ssh_mounter.hpp"
+#include <QByteArray>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QObject>
+#include <QSet>
+
+class SSHStore;
+class MountManager;
+class MountWatcher;
+class MountSupervisor;
+class QCoreApplication;
+class QSocketNotifier;
+
+// Control socket of the running instance, $XDG_RUNTIME_DIR/ssh-mounter/
+// control.sock. Speaks line-delimited JSON:
+//
+//   {"id": 1, "cmd": "status", "hosts": ["web"]}
+//   {"id": 1, "ok": true, "hosts": [{"name": "web", "mounted": true, ...}]}
+//
+// Commands: ping, status, mount, unmount, subscribe, unsubscribe, show.
+// A line holding a JSON array is a batch and gets one array back. Requests
+// may be pipelined; replies come back in order. Subscribers also receive
+// {"event": ...} lines, which may arrive between replies.
+class ControlServer : public QObject {
+    Q_OBJECT
+public:
+    ControlServer(SSHStore* store, MountWatcher* watcher, MountManager* manager,
+                  MountSupervisor* supervisor, QObject* parent = nullptr);
+    ~ControlServer() override;
+
+    // Fails if another instance already answers on path
+    bool listen(const QString& path, QString& error);
+    bool listen(QString& error) { return listen(defaultSocketPath(), error); }
+
+    // $SSH_MOUNTER_CONTROL_SOCKET if set ("off" disables the socket)
+    static QString defaultSocketPath();
+    static bool enabled() { return qEnvironmentVariable("SSH_MOUNTER_CONTROL_SOCKET") != "off"; }
+    // Sends one request line to a running instance; false if none answers
+    static bool request(const QByteArray& line, QByteArray* reply = nullptr,
+                        const QString& path = defaultSocketPath());
+
+    // ssh-mounter --control JSON...
+    static bool wanted(int argc, char** argv);
+    static int runCli(QCoreApplication& app);
+
+signals:
+    // A second instance was started; bring the window to the front
+    void showRequested();
+
+private slots:
+    void onAccept();
+    void onClientReadable(int fd);
+    void onClientWritable(int fd);
+
+private:
+    struct Client {
+        QSocketNotifier* reader = nullptr;
+        QSocketNotifier* writer = nullptr;
+        QByteArray in;
+        QByteArray out;
+        bool subscribed = false;
+        bool closing = false;       // Peer is done sending; close once out is sent
+        QSet<QString> keys;         // Empty: every host
+    };
+
+    QJsonObject handle(const QJsonObject& request, int fd);
+    QJsonObject hostStatus(const SSHHost& host) const;
+    // Resolves "host"/"hosts" by ID or name; fills error on unknown names
+    QVector<SSHHost> resolve(const QJsonObject& request, QString& error) const;
+    void publish(const QString& key, QJsonObject event);
+    void flush(int fd);
+    void dropClient(int fd);
+
+    SSHStore* store_;
+    MountWatcher* watcher_;
+    MountManager* manager_;
+    MountSupervisor* supervisor_;
+    int fd_;
+    QSocketNotifier* notifier_;
+    QString socketPath_;
+    QHash<int, Client> clients_;
+    int subscribers_;
+};
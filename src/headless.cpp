@@ -0,0 +1,429 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#include "headless.hpp"
+#include "mount_manager.hpp"
+#include "known_hosts.hpp"
+#include "mount_table.hpp"
+#include "reachability.hpp"
+#include "startup.hpp"
+#include "console.hpp"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QTimer>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <termios.h>
+#include <unistd.h>
+
+extern Console console;
+
+namespace {
+
+const char* const Flags[] = {"--mount-all", "--mount", "--unmount-all", "--unmount", "--status", "--check"};
+
+// No echo; empty if stdin is not a terminal or the user just hits enter
+QString readPassword(const QString& prompt) {
+    if (!::isatty(STDIN_FILENO)) return QString();
+    console.flush();
+    std::cerr << prompt.toStdString() << std::flush;
+
+    termios saved;
+    bool restore = tcgetattr(STDIN_FILENO, &saved) == 0;
+    if (restore) {
+        termios quiet = saved;
+        quiet.c_lflag &= ~tcflag_t(ECHO);
+        tcsetattr(STDIN_FILENO, TCSAFLUSH, &quiet);
+    }
+    std::string line;
+    std::getline(std::cin, line);
+    if (restore) tcsetattr(STDIN_FILENO, TCSAFLUSH, &saved);
+    std::cerr << std::endl;
+    return QString::fromStdString(line);
+}
+
+QString label(const SSHHost& host) {
+    return host.name.isEmpty() ? host.host : host.name;
+}
+
+} // namespace
+
+QJsonObject HeadlessResult::toJson() const {
+    QJsonObject obj;
+    obj["id"] = host.id;
+    obj["name"] = host.name;
+    obj["localPath"] = host.localPath;
+    obj["ok"] = ok;
+    if (skipped) obj["skipped"] = true;
+    if (!error.isEmpty()) obj["error"] = error;
+    if (startedMs >= 0) obj["startedMs"] = startedMs;
+    if (finishedMs >= 0) obj["finishedMs"] = finishedMs;
+    if (startedMs >= 0 && finishedMs >= startedMs) obj["ms"] = finishedMs - startedMs;
+    return obj;
+}
+
+HeadlessRunner::HeadlessRunner(int maxConcurrent, QObject* parent)
+    : QObject(parent), manager_(new MountManager(this)), op_(Operation::Mount), pending_(0) {
+    manager_->setMaxConcurrent(maxConcurrent);
+
+    connect(manager_, &MountManager::hostStateChanged, this, [this](const QString& key, MountState state) {
+        HeadlessResult* r = result(key);
+        if (r && r->startedMs < 0 && (state == MountState::Mounting || state == MountState::Unmounting)) {
+            r->startedMs = clock_.elapsed();
+        }
+    });
+    connect(manager_, &MountManager::hostMountSuccess, this, [this](const QString& key) {
+        complete(key, true, QString());
+    });
+    connect(manager_, &MountManager::hostUnmountSuccess, this, [this](const QString& key) {
+        complete(key, true, QString());
+    });
+    connect(manager_, &MountManager::hostMountError, this, [this](const QString& key, const QString& error) {
+        complete(key, false, error);
+    });
+    // Cancelled sessions (no password) only show up as a finished job
+    connect(manager_, &MountManager::hostBusyChanged, this, [this](const QString& key, bool busy) {
+        if (!busy) complete(key, false, "Cancelled");
+    });
+    // Queued: reading the terminal must not happen inside a session's slot
+    connect(manager_, &MountManager::hostPasswordRequired, this, &HeadlessRunner::askPassword,
+            Qt::QueuedConnection);
+    connect(manager_, &MountManager::hostKeyMismatch, this, [this](const QString& key) {
+        // Never drop a known host key without a person deciding to
+        console.error("Host key for", manager_->host(key).host.toStdString(),
+                      "has changed; run the GUI or ssh-keygen -R to accept the new key");
+        manager_->keepHostKey(key);
+        complete(key, false, "Host key has changed");
+    }, Qt::QueuedConnection);
+}
+
+void HeadlessRunner::run(Operation op, const QList<SSHHost>& hosts) {
+    op_ = op;
+    clock_.start();
+    results_.clear();
+    indexByKey_.clear();
+
+    MountTable table;
+    table.load();
+
+    QList<SSHHost> todo;
+    for (const SSHHost& host : hosts) {
+        HeadlessResult r;
+        r.host = host;
+        const bool mounted = table.isMounted(host);
+        if (mounted == (op == Operation::Mount)) {
+            r.ok = true;
+            r.skipped = true;
+        } else {
+            todo.append(host);
+        }
+        indexByKey_.insert(MountManager::keyFor(host), results_.size());
+        results_.append(r);
+    }
+
+    pending_ = todo.size();
+    if (pending_ == 0) {
+        QTimer::singleShot(0, this, &HeadlessRunner::finished);
+        return;
+    }
+    if (op == Operation::Unmount) {
+        manager_->unmountAll(todo);
+        return;
+    }
+    // Host keys first: a key nobody confirmed fails its host here instead
+    // of at a prompt in the middle of the run
+    manager_->hostKeys()->scan(todo, this, [this, todo](const HostKeyScanner::Results& checks) {
+        if (pending_ == 0) return;  // Aborted meanwhile
+        QList<SSHHost> mountable;
+        for (const SSHHost& host : todo) {
+            const QString key = MountManager::keyFor(host);
+            const HostKeyCheck check = checks.value(key);
+            if (check.status == HostKeyStatus::Changed) {
+                console.error("Host key for", check.token.toStdString(), "has changed to",
+                              check.offered.first().fingerprint().toStdString() +
+                              "; run the GUI or ssh-keygen -R to accept the new key");
+                complete(key, false, "Host key has changed");
+            } else if (check.status == HostKeyStatus::Revoked) {
+                complete(key, false, "The server's host key has been revoked");
+            } else if (check.status == HostKeyStatus::New && !check.seeded) {
+                console.error("Unknown host key for", check.token.toStdString() + ":",
+                              check.offered.first().fingerprint().toStdString() +
+                              "; check it, then rerun with --accept-new-keys or accept it in the GUI");
+                complete(key, false, "Host key not confirmed");
+            } else {
+                mountable.append(host);
+            }
+        }
+        if (!mountable.isEmpty()) manager_->mountAll(mountable);
+    });
+}
+
+void HeadlessRunner::setAcceptNewKeys(bool enabled) {
+    manager_->hostKeys()->setSeedNew(enabled);
+}
+
+HeadlessResult* HeadlessRunner::result(const QString& key) {
+    auto it = indexByKey_.constFind(key);
+    return it == indexByKey_.constEnd() ? nullptr : &results_[it.value()];
+}
+
+void HeadlessRunner::complete(const QString& key, bool ok, const QString& error) {
+    HeadlessResult* r = result(key);
+    if (!r || r->skipped || r->finishedMs >= 0) return;
+    r->ok = ok;
+    r->error = error;
+    r->finishedMs = clock_.elapsed();
+    --pending_;
+    checkDone();
+}
+
+void HeadlessRunner::abort(const QString& reason) {
+    for (HeadlessResult& r : results_) {
+        if (r.skipped || r.finishedMs >= 0) continue;
+        r.error = reason;
+        r.finishedMs = clock_.elapsed();
+        manager_->noPassword(MountManager::keyFor(r.host));
+    }
+    pending_ = 0;
+    checkDone();
+}
+
+void HeadlessRunner::askPassword(const QString& key) {
+    HeadlessResult* r = result(key);
+    if (!r || r->finishedMs >= 0) return;
+    const QString password = readPassword(QString("Password for %1 (%2@%3): ")
+        .arg(label(r->host), r->host.user, r->host.host));
+    if (password.isEmpty()) {
+        manager_->noPassword(key);
+        complete(key, false, ::isatty(STDIN_FILENO) ? "No password given"
+                                                     : "Needs a password and stdin is not a terminal");
+    } else {
+        manager_->supplyPassword(key, password);
+    }
+}
+
+void HeadlessRunner::checkDone() {
+    if (pending_ == 0) emit finished();
+}
+
+bool HeadlessRunner::wanted(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        for (const char* flag : Flags) {
+            if (strcmp(argv[i], flag) == 0) return true;
+        }
+    }
+    return false;
+}
+
+int HeadlessRunner::runCli(QCoreApplication& app) {
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Mount and unmount saved sshfs hosts without a window");
+    parser.addHelpOption();
+    parser.addOption({"mount-all", "Mount every saved host that is not mounted yet."});
+    parser.addOption({"mount", "Mount the saved host called <name>; repeatable, further names may follow.", "name"});
+    parser.addOption({"unmount-all", "Unmount every saved host that is mounted."});
+    parser.addOption({"unmount", "Unmount the saved host called <name>; repeatable, further names may follow.", "name"});
+    parser.addOption({"status", "Show which saved hosts are mounted."});
+    parser.addOption({"check", "Check that the servers answer; names that are not saved hosts are taken as host[:port]."});
+    parser.addOption({"deadline", "Time limit for --check in <ms>.", "ms", "2000"});
+    parser.addOption({"json", "Print results as JSON."});
+    parser.addOption({"accept-new-keys", "Trust and record the host keys of hosts never connected to before."});
+    parser.addOption({{"j", "jobs"}, "Run up to <n> operations at once.", "n", "8"});
+    parser.addOption({"timeout", "Give up on hosts still pending after <seconds>.", "seconds", "120"});
+    parser.addPositionalArgument("names", "More host names for --mount, --unmount or --check.", "[name...]");
+    parser.process(app);
+
+    // stdout is for results only
+    console.setOutput(STDERR_FILENO);
+    const bool json = parser.isSet("json");
+
+    const int modes = int(parser.isSet("mount-all")) + int(parser.isSet("mount")) +
+                      int(parser.isSet("unmount-all")) + int(parser.isSet("unmount")) +
+                      int(parser.isSet("status")) + int(parser.isSet("check"));
+    if (modes != 1) {
+        console.error("Use exactly one of --mount-all, --mount, --unmount-all, --unmount, --status, --check");
+        return 2;
+    }
+
+    SSHStore store;
+    store.setUseSnapshot(true);
+    if (!store.load()) return 2;
+
+    if (parser.isSet("status")) {
+        MountTable table;
+        table.load();
+        QJsonArray hosts;
+        for (const SSHHost& host : store.hosts()) {
+            const bool mounted = table.isMounted(host);
+            if (json) {
+                QJsonObject obj;
+                obj["id"] = host.id;
+                obj["name"] = host.name;
+                obj["source"] = MountTable::sourceFor(host);
+                obj["localPath"] = host.localPath;
+                obj["mounted"] = mounted;
+                hosts.append(obj);
+            } else {
+                std::cout << (mounted ? "mounted     " : "not mounted ") << label(host).toStdString()
+                          << "  " << host.localPath.toStdString() << '\n';
+            }
+        }
+        if (json) std::cout << QJsonDocument(hosts).toJson(QJsonDocument::Indented).constData();
+        std::cout << std::flush;
+        return 0;
+    }
+
+    if (parser.isSet("check")) {
+        // Every saved host, or the names given; anything else is host[:port]
+        QVector<ReachTarget> targets;
+        QStringList labels;
+        const QStringList names = parser.positionalArguments();
+        if (names.isEmpty()) {
+            for (const SSHHost& host : store.hosts()) {
+                targets.append({host.host, host.port});
+                labels << label(host);
+            }
+        }
+        for (const QString& name : names) {
+            const QList<const SSHHost*> found = store.byName(name);
+            if (!found.isEmpty()) {
+                targets.append({found.first()->host, found.first()->port});
+                labels << label(*found.first());
+                continue;
+            }
+            ReachTarget target{name, 22};
+            const int colon = name.lastIndexOf(':');
+            const bool bracketed = name.startsWith('[') && name.indexOf(']') > 0;
+            if (bracketed) {
+                const int close = name.indexOf(']');
+                target.host = name.mid(1, close - 1);
+                if (name.mid(close + 1).startsWith(':')) target.port = name.mid(close + 2).toInt();
+            } else if (colon > 0 && name.count(':') == 1) {
+                target.host = name.left(colon);
+                target.port = name.mid(colon + 1).toInt();
+            }
+            if (target.port <= 0 || target.port > 65535) {
+                console.error("Bad port in", name.toStdString());
+                return 2;
+            }
+            targets.append(target);
+            labels << name;
+        }
+
+        const QVector<ReachResult> results = Reachability::probe(targets, qMax(1, parser.value("deadline").toInt()));
+        int failed = 0;
+        QJsonArray out;
+        for (int i = 0; i < results.size(); ++i) {
+            const ReachResult& r = results[i];
+            if (r.failed()) ++failed;
+            if (json) {
+                QJsonObject obj;
+                obj["name"] = labels[i];
+                obj["host"] = targets[i].host;
+                obj["port"] = targets[i].port;
+                obj["ok"] = !r.failed();
+                obj["result"] = r.describe();
+                obj["ms"] = r.ms;
+                if (!r.banner.isEmpty()) obj["banner"] = r.banner;
+                out.append(obj);
+                continue;
+            }
+            const std::string status = r.reach == Reach::Reachable ? "ok   " : r.failed() ? "FAIL " : "?    ";
+            std::cout << status << labels[i].toStdString() << "  " << r.ms << " ms  "
+                      << r.describe().toStdString() << '\n';
+        }
+        if (json) std::cout << QJsonDocument(out).toJson(QJsonDocument::Indented).constData();
+        std::cout << std::flush;
+        return failed > 0 ? 1 : 0;
+    }
+
+    // Pick the hosts
+    const bool mount = parser.isSet("mount-all") || parser.isSet("mount");
+    QList<SSHHost> hosts;
+    if (parser.isSet("mount-all") || parser.isSet("unmount-all")) {
+        for (const SSHHost& host : store.hosts()) hosts.append(host);
+    } else {
+        const QStringList names = parser.values(mount ? "mount" : "unmount") + parser.positionalArguments();
+        for (const QString& name : names) {
+            QList<const SSHHost*> found = store.byName(name);
+            if (found.isEmpty()) {
+                const SSHHost* byId = store.byId(name);
+                if (byId) found.append(byId);
+            }
+            if (found.isEmpty()) {
+                console.error("No saved host called", name.toStdString());
+                return 2;
+            }
+            hosts.append(*found.first());
+        }
+    }
+
+    HeadlessRunner runner(qMax(1, parser.value("jobs").toInt()));
+    runner.setAcceptNewKeys(parser.isSet("accept-new-keys"));
+    const qint64 startupMs = StartupPipeline::clock().elapsed();
+
+    int exitCode = 0;
+    QObject::connect(&runner, &HeadlessRunner::finished, &app, [&]() {
+        int succeeded = 0;
+        int failed = 0;
+        QJsonArray results;
+        for (const HeadlessResult& r : runner.results()) {
+            if (r.ok) ++succeeded;
+            else ++failed;
+            if (json) {
+                results.append(r.toJson());
+                continue;
+            }
+            std::string status = r.skipped ? "skip " : r.ok ? "ok   " : "FAIL ";
+            std::cout << status << label(r.host).toStdString();
+            if (r.startedMs >= 0 && r.finishedMs >= r.startedMs) std::cout << "  " << (r.finishedMs - r.startedMs) << " ms";
+            if (!r.error.isEmpty()) std::cout << "  " << r.error.section('\n', 0, 0).toStdString();
+            std::cout << '\n';
+        }
+        if (json) {
+            QJsonObject doc;
+            doc["operation"] = mount ? "mount" : "unmount";
+            doc["succeeded"] = succeeded;
+            doc["failed"] = failed;
+            doc["startupMs"] = startupMs;
+            doc["elapsedMs"] = runner.elapsedMs();
+            doc["results"] = results;
+            std::cout << QJsonDocument(doc).toJson(QJsonDocument::Indented).constData();
+        } else {
+            std::cout << succeeded << " ok, " << failed << " failed in " << runner.elapsedMs()
+                      << " ms (started after " << startupMs << " ms)\n";
+        }
+        std::cout << std::flush;
+        exitCode = failed > 0 ? 1 : 0;
+        app.quit();
+    }, Qt::QueuedConnection);
+
+    const int timeout = parser.value("timeout").toInt();
+    if (timeout > 0) {
+        QTimer::singleShot(timeout * 1000, &runner, [&runner, timeout]() {
+            runner.abort(QString("Timed out after %1 s").arg(timeout));
+        });
+    }
+    QTimer::singleShot(0, &runner, [&]() {
+        runner.run(mount ? Operation::Mount : Operation::Unmount, hosts);
+    });
+    app.exec();
+    return exitCode;
+}
+
+#include "headless.moc"
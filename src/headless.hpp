@@ -0,0 +1,82 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#pragma once
+
+#include "ssh_store.hpp"
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QObject>
+#include <QStringList>
+
+class MountManager;
+class QCoreApplication;
+
+// One result line of a headless run
+struct HeadlessResult {
+    SSHHost host;
+    bool ok = false;
+    bool skipped = false;       // Already in the requested state
+    QString error;
+    qint64 startedMs = -1;      // Relative to the start of the run
+    qint64 finishedMs = -1;
+
+    QJsonObject toJson() const;
+};
+
+// Mounts or unmounts a set of hosts through MountManager without any
+// window, for scripts: ssh-mounter --mount-all, --mount NAME...,
+// --unmount-all, --unmount NAME..., --status, --check [NAME|HOST[:PORT]...]
+// [--json] [--accept-new-keys].
+class HeadlessRunner : public QObject {
+    Q_OBJECT
+public:
+    enum class Operation { Mount, Unmount };
+
+    explicit HeadlessRunner(int maxConcurrent, QObject* parent = nullptr);
+
+    void run(Operation op, const QList<SSHHost>& hosts);
+    // Record keys of hosts never seen before (ssh's accept-new); otherwise
+    // those hosts fail with the fingerprint to check
+    void setAcceptNewKeys(bool enabled);
+    // Gives up on whatever has not finished yet
+    void abort(const QString& reason);
+
+    const QList<HeadlessResult>& results() const { return results_; }
+    qint64 elapsedMs() const { return clock_.elapsed(); }
+
+    // True if argv asks for any headless operation
+    static bool wanted(int argc, char** argv);
+    // Returns the process exit code: 0 all ok, 1 some host failed, 2 usage
+    static int runCli(QCoreApplication& app);
+
+signals:
+    void finished();
+
+private:
+    HeadlessResult* result(const QString& key);
+    void complete(const QString& key, bool ok, const QString& error);
+    void askPassword(const QString& key);
+    void checkDone();
+
+    MountManager* manager_;
+    Operation op_;
+    QList<HeadlessResult> results_;
+    QHash<QString, int> indexByKey_;
+    int pending_;
+    QElapsedTimer clock_;
+};
@@ -0,0 +1,618 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#include "host_import.hpp"
+#include "glob_match.hpp"
+#include "console.hpp"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <glob.h>
+#include <unistd.h>
+#include <cstring>
+#include <iostream>
+
+extern Console console;
+
+namespace {
+
+const int MaxIncludeDepth = 16;     // As ssh
+const int MaxWarnings = 100;
+
+bool isPlain(const QString& pattern) {
+    return !pattern.startsWith('!') && !pattern.contains('*') && !pattern.contains('?');
+}
+
+// "Keyword args", "Keyword=args" or "Keyword = args"; args may be quoted
+bool splitConfigLine(const QString& line, QString& keyword, QStringList& args) {
+    int i = 0;
+    while (i < line.size() && !line[i].isSpace() && line[i] != '=') ++i;
+    keyword = line.left(i).toLower();
+    while (i < line.size() && line[i].isSpace()) ++i;
+    if (i < line.size() && line[i] == '=') ++i;
+
+    args.clear();
+    QString arg;
+    bool quoted = false, any = false;
+    for (; i < line.size(); ++i) {
+        const QChar c = line[i];
+        if (c == '"') {
+            quoted = !quoted;
+            any = true;
+        } else if (c.isSpace() && !quoted) {
+            if (any) args.append(arg);
+            arg.clear();
+            any = false;
+        } else {
+            arg += c;
+            any = true;
+        }
+    }
+    if (any) args.append(arg);
+    return !keyword.isEmpty() && !quoted;
+}
+
+QString expandHostName(const QString& hostName, const QString& alias) {
+    if (!hostName.contains('%')) return hostName;
+    QString out;
+    for (int i = 0; i < hostName.size(); ++i) {
+        if (hostName[i] == '%' && i + 1 < hostName.size()) {
+            const QChar token = hostName[++i];
+            if (token == 'h') out += alias;
+            else if (token == '%') out += '%';
+            else out += '%' + QString(token);
+        } else {
+            out += hostName[i];
+        }
+    }
+    return out;
+}
+
+// "Host Name" and "host_name" both become "hostname"
+QString normalizeKey(const QString& key) {
+    QString out;
+    out.reserve(key.size());
+    for (QChar c : key) {
+        if (c.isLetterOrNumber()) out += c.toLower();
+    }
+    return out;
+}
+
+// One CSV record, which may span lines inside quotes. Works on bytes:
+// quotes and separators are ASCII, so UTF-8 passes through untouched.
+bool readCsvRow(QFile& file, char separator, QStringList& fields, int& lineNo) {
+    fields.clear();
+    QByteArray field;
+    bool quoted = false, any = false;
+    while (!file.atEnd()) {
+        const QByteArray line = file.readLine();
+        ++lineNo;
+        any = true;
+        for (int i = 0; i < line.size(); ++i) {
+            const char c = line[i];
+            if (quoted) {
+                if (c != '"') {
+                    field += c;
+                } else if (i + 1 < line.size() && line[i + 1] == '"') {
+                    field += '"';
+                    ++i;
+                } else {
+                    quoted = false;
+                }
+            } else if (c == '"') {
+                quoted = true;
+            } else if (c == separator) {
+                fields.append(QString::fromUtf8(field).trimmed());
+                field.clear();
+            } else if (c != '\n' && c != '\r') {
+                field += c;
+            }
+        }
+        if (!quoted) break;
+    }
+    if (!any) return false;
+    fields.append(QString::fromUtf8(field).trimmed());
+    return true;
+}
+
+} // namespace
+
+HostImporter::HostImporter()
+    : defaultUser_(qEnvironmentVariable("USER")), mountRoot_(QDir::homePath() + "/mnt"),
+      warningCount_(0), duplicates_(0) {
+}
+
+ImportFormat HostImporter::formatFromName(const QString& name) {
+    const QString n = name.toLower();
+    if (n == "ssh-config" || n == "ssh_config" || n == "ssh") return ImportFormat::SshConfig;
+    if (n == "csv") return ImportFormat::Csv;
+    if (n == "json") return ImportFormat::Json;
+    return ImportFormat::Auto;
+}
+
+ImportFormat HostImporter::detect(const QString& path) {
+    const QFileInfo info(path);
+    const QString suffix = info.suffix().toLower();
+    if (suffix == "csv" || suffix == "tsv") return ImportFormat::Csv;
+    if (suffix == "json" || suffix == "jsonl" || suffix == "ndjson") return ImportFormat::Json;
+    if (suffix == "conf" || info.fileName() == "config") return ImportFormat::SshConfig;
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return ImportFormat::SshConfig;
+    while (!file.atEnd()) {
+        const QString line = QString::fromUtf8(file.readLine()).trimmed();
+        if (line.isEmpty() || line.startsWith('#')) continue;
+        if (line.startsWith('{') || line.startsWith('[')) return ImportFormat::Json;
+        QString keyword;
+        QStringList args;
+        if (splitConfigLine(line, keyword, args) &&
+            (keyword == "host" || keyword == "match" || keyword == "include")) {
+            return ImportFormat::SshConfig;
+        }
+        return line.contains(',') || line.contains(';') || line.contains('\t') ? ImportFormat::Csv
+                                                                                : ImportFormat::SshConfig;
+    }
+    return ImportFormat::SshConfig;
+}
+
+bool HostImporter::importFile(const QString& path, ImportFormat format, QString& error) {
+    QElapsedTimer timer;
+    timer.start();
+    const int before = hosts_.size();
+    if (format == ImportFormat::Auto) format = detect(path);
+
+    bool ok = false;
+    switch (format) {
+    case ImportFormat::Csv:
+        ok = importCsv(path, error);
+        break;
+    case ImportFormat::Json:
+        ok = importJson(path, error);
+        break;
+    default: {
+        SshConfig config;
+        addBlock(config, Block());
+        ok = readSshConfig(path, 0, config, error);
+        if (ok) resolveSshConfig(config);
+        break;
+    }
+    }
+    if (ok) {
+        console.log("Imported", hosts_.size() - before, "host(s) from", path.toStdString(), "in",
+                    timer.elapsed(), "ms");
+    }
+    return ok;
+}
+
+bool HostImporter::readSshConfig(const QString& path, int depth, SshConfig& config, QString& error) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        error = "Cannot read " + path + ": " + file.errorString();
+        return false;
+    }
+
+    int lineNo = 0;
+    QString keyword;
+    QStringList args;
+    while (!file.atEnd()) {
+        const QString line = QString::fromUtf8(file.readLine()).trimmed();
+        ++lineNo;
+        if (line.isEmpty() || line.startsWith('#')) continue;
+        const QString where = QString("%1:%2").arg(path).arg(lineNo);
+        if (!splitConfigLine(line, keyword, args)) {
+            warn(where + ": unbalanced quotes; line ignored");
+            continue;
+        }
+
+        if (keyword == "host" || keyword == "match") {
+            Block block;
+            block.global = false;
+            block.match = keyword == "match";
+            if (block.match) {
+                // Conditions such as exec or localuser mean nothing here
+                if (args.size() != 1 || args.first().toLower() != "all") {
+                    warn(where + ": Match block skipped");
+                } else {
+                    block.match = false;
+                    block.global = true;
+                }
+            }
+            if (!block.match && !block.global) {
+                for (const QString& pattern : args) {
+                    block.patterns.append(pattern.toLower());
+                    if (isPlain(pattern) && !config.seen.contains(pattern.toLower())) {
+                        config.seen.insert(pattern.toLower());
+                        config.aliases.append(pattern);
+                    }
+                }
+            }
+            addBlock(config, block);
+        } else if (keyword == "include") {
+            if (depth >= MaxIncludeDepth) {
+                error = where + ": Include nested too deeply";
+                return false;
+            }
+            const int outer = config.blocks.size() - 1;
+            for (const QString& arg : args) {
+                // Relative to ~/.ssh, like ssh does for the user's config
+                QString pattern = arg;
+                if (pattern.startsWith("~/")) pattern = QDir::homePath() + pattern.mid(1);
+                else if (QDir::isRelativePath(pattern)) pattern = QDir::homePath() + "/.ssh/" + pattern;
+
+                glob_t matches;
+                if (::glob(QFile::encodeName(pattern).constData(), 0, nullptr, &matches) != 0) {
+                    continue;   // Nothing matched; ssh is fine with that too
+                }
+                for (size_t i = 0; i < matches.gl_pathc; ++i) {
+                    if (!readSshConfig(QFile::decodeName(matches.gl_pathv[i]), depth + 1, config, error)) {
+                        globfree(&matches);
+                        return false;
+                    }
+                }
+                globfree(&matches);
+            }
+            // Lines after the Include belong to the block it sat in again
+            if (config.blocks.size() - 1 != outer) {
+                Block rest;
+                rest.patterns = config.blocks[outer].patterns;
+                rest.global = config.blocks[outer].global;
+                rest.match = config.blocks[outer].match;
+                addBlock(config, rest);
+            }
+        } else if (!args.isEmpty()) {
+            // First value wins, within a block as across blocks
+            Block& block = config.blocks.last();
+            if (keyword == "hostname") {
+                if (block.hostName.isEmpty()) block.hostName = args.first();
+            } else if (keyword == "user") {
+                if (block.user.isEmpty()) block.user = args.first();
+            } else if (keyword == "port") {
+                if (block.port.isEmpty()) block.port = args.first();
+            } else {
+                block.other = true;
+            }
+        }
+    }
+    return true;
+}
+
+void HostImporter::addBlock(SshConfig& config, const Block& block) {
+    const int index = config.blocks.size();
+    config.blocks.append(block);
+    if (block.match) return;
+    bool plain = !block.global;
+    for (const QString& pattern : block.patterns) plain = plain && isPlain(pattern);
+    if (!plain) {
+        config.scanned.append(index);
+        return;
+    }
+    for (const QString& pattern : block.patterns) {
+        QVector<int>& list = config.byName[pattern];
+        if (list.isEmpty() || list.last() != index) list.append(index);
+    }
+}
+
+void HostImporter::resolveSshConfig(const SshConfig& config) {
+    hosts_.reserve(hosts_.size() + config.aliases.size());
+    for (const QString& alias : config.aliases) {
+        const QString name = alias.toLower();
+        const QVector<int> named = config.byName.value(name);
+
+        QString hostName, user, port;
+        bool other = false;
+        // Both lists are in file order; walk them together
+        int a = 0, b = 0;
+        while (a < named.size() || b < config.scanned.size()) {
+            const bool fromNamed = b >= config.scanned.size() ||
+                                   (a < named.size() && named[a] < config.scanned[b]);
+            const Block& block = config.blocks[fromNamed ? named[a++] : config.scanned[b++]];
+            if (!fromNamed && !block.global) {
+                bool matched = false, negated = false;
+                for (const QString& pattern : block.patterns) {
+                    if (pattern.startsWith('!')) {
+                        negated = negated || globMatch(name, pattern.mid(1));
+                    } else {
+                        matched = matched || globMatch(name, pattern);
+                    }
+                }
+                if (!matched || negated) continue;
+            }
+            if (hostName.isEmpty()) hostName = block.hostName;
+            if (user.isEmpty()) user = block.user;
+            if (port.isEmpty()) port = block.port;
+            // "Host *" applies whatever name ssh is given
+            other = other || (block.other && !block.global && block.patterns != QStringList{"*"});
+        }
+
+        SSHHost host;
+        host.name = alias;
+        // Options we cannot store (IdentityFile, ProxyJump...) only reach
+        // ssh if it is given the alias, so those hosts keep it
+        host.host = other || hostName.isEmpty() ? alias : expandHostName(hostName, alias);
+        host.user = user.isEmpty() ? defaultUser_ : user;
+        if (!port.isEmpty()) {
+            bool ok = false;
+            const int value = port.toInt(&ok);
+            if (ok && value > 0 && value < 65536) host.port = value;
+            else warn(alias + ": bad Port " + port + "; using 22");
+        }
+        host.usePublicKey = true;
+        host.localPath = localPathFor(alias);
+        addHost(host);
+    }
+}
+
+bool HostImporter::importCsv(const QString& path, QString& error) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        error = "Cannot read " + path + ": " + file.errorString();
+        return false;
+    }
+
+    // The separator is whichever the header uses most
+    const QByteArray head = file.peek(4096).split('\n').first();
+    char separator = ',';
+    for (char c : {';', '\t'}) {
+        if (head.count(c) > head.count(separator)) separator = c;
+    }
+
+    int lineNo = 0;
+    QStringList fields;
+    if (!readCsvRow(file, separator, fields, lineNo)) {
+        error = path + " is empty";
+        return false;
+    }
+    if (!fields.isEmpty() && fields.first().startsWith(QChar(0xFEFF))) fields.first().remove(0, 1);
+    QStringList columns;
+    for (const QString& field : fields) columns.append(normalizeKey(field));
+    if (!columns.contains("host") && !columns.contains("hostname") && !columns.contains("address") &&
+        !columns.contains("ip") && !columns.contains("fqdn")) {
+        error = path + ": no host or hostname column in the header";
+        return false;
+    }
+
+    QHash<QString, QString> record;
+    record.reserve(columns.size());
+    while (true) {
+        const int start = lineNo + 1;
+        if (!readCsvRow(file, separator, fields, lineNo)) break;
+        if (fields.size() == 1 && fields.first().isEmpty()) continue;
+        record.clear();
+        for (int i = 0; i < columns.size() && i < fields.size(); ++i) record.insert(columns[i], fields[i]);
+        addRecord(record, QString("%1:%2").arg(path).arg(start));
+    }
+    return true;
+}
+
+bool HostImporter::importJson(const QString& path, QString& error) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        error = "Cannot read " + path + ": " + file.errorString();
+        return false;
+    }
+
+    auto toRecord = [](const QJsonObject& obj) {
+        QHash<QString, QString> record;
+        for (auto it = obj.begin(); it != obj.end(); ++it) {
+            record.insert(normalizeKey(it.key()), it.value().toVariant().toString());
+        }
+        return record;
+    };
+
+    QJsonParseError parseError;
+    const QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (doc.isObject() && doc.object().contains("hosts")) {
+        // Our own export: keep everything, profiles included
+        for (const QJsonValue& value : doc.object()["hosts"].toArray()) {
+            SSHHost host = SSHHost::fromJson(value.toObject());
+            if (host.host.isEmpty()) {
+                warn(path + ": entry without a host skipped");
+                continue;
+            }
+            if (host.name.isEmpty()) host.name = host.host;
+            if (host.user.isEmpty()) host.user = defaultUser_;
+            if (host.localPath.isEmpty()) host.localPath = localPathFor(host.name);
+            addHost(host);
+        }
+        return true;
+    }
+    if (doc.isArray()) {
+        int index = 0;
+        for (const QJsonValue& value : doc.array()) {
+            addRecord(toRecord(value.toObject()), QString("%1[%2]").arg(path).arg(index++));
+        }
+        return true;
+    }
+    if (doc.isObject()) {
+        addRecord(toRecord(doc.object()), path);
+        return true;
+    }
+
+    // Not one document: JSON Lines, one object per line
+    file.seek(0);
+    int lineNo = 0, parsed = 0;
+    while (!file.atEnd()) {
+        const QByteArray line = file.readLine().trimmed();
+        ++lineNo;
+        if (line.isEmpty()) continue;
+        const QJsonDocument entry = QJsonDocument::fromJson(line);
+        const QString where = QString("%1:%2").arg(path).arg(lineNo);
+        if (!entry.isObject()) {
+            warn(where + ": not a JSON object; skipped");
+            continue;
+        }
+        ++parsed;
+        addRecord(toRecord(entry.object()), where);
+    }
+    if (parsed == 0) {
+        error = path + ": " + parseError.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool HostImporter::addRecord(const QHash<QString, QString>& record, const QString& where) {
+    auto field = [&record](std::initializer_list<const char*> keys) {
+        for (const char* key : keys) {
+            const QString value = record.value(QLatin1String(key));
+            if (!value.isEmpty()) return value;
+        }
+        return QString();
+    };
+
+    SSHHost host;
+    host.host = field({"host", "hostname", "address", "ip", "fqdn"});
+    if (host.host.isEmpty()) {
+        warn(where + ": no host; skipped");
+        return false;
+    }
+    host.name = field({"name", "alias", "label", "hostalias"});
+    if (host.name.isEmpty()) host.name = host.host;
+    host.user = field({"user", "username", "login"});
+    if (host.user.isEmpty()) host.user = defaultUser_;
+    const QString port = field({"port", "sshport"});
+    if (!port.isEmpty()) {
+        bool ok = false;
+        const int value = port.toInt(&ok);
+        if (ok && value > 0 && value < 65536) host.port = value;
+        else warn(where + ": bad port " + port + "; using 22");
+    }
+    host.remotePath = field({"remotepath", "path", "remotedir"});
+    host.localPath = field({"localpath", "mountpoint", "mount"});
+    if (host.localPath.isEmpty()) host.localPath = localPathFor(host.name);
+    // Keys unless the source says password; a prompt per host would not scale
+    const QString auth = field({"usepublickey", "publickey", "key", "auth"}).toLower();
+    host.usePublicKey = auth != "password" && auth != "false" && auth != "no" && auth != "0";
+    addHost(host);
+    return true;
+}
+
+void HostImporter::addHost(SSHHost host) {
+    if (names_.contains(host.name)) {
+        ++duplicates_;
+        return;
+    }
+    names_.insert(host.name);
+    hosts_.append(host);
+}
+
+int HostImporter::skipExisting(const SSHStore& store) {
+    const int before = hosts_.size();
+    QVector<SSHHost> kept;
+    kept.reserve(hosts_.size());
+    for (const SSHHost& host : hosts_) {
+        if (store.byName(host.name).isEmpty()) kept.append(host);
+    }
+    hosts_ = kept;
+    return before - hosts_.size();
+}
+
+QString HostImporter::localPathFor(const QString& name) const {
+    QString safe = name;
+    safe.replace('/', '_');
+    return mountRoot_ + "/" + safe;
+}
+
+void HostImporter::warn(const QString& message) {
+    if (warningCount_++ < MaxWarnings) warnings_.append(message);
+}
+
+bool HostImporter::wanted(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--import") == 0) return true;
+    }
+    return false;
+}
+
+int HostImporter::runCli(QCoreApplication& app) {
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Add hosts from ssh config, CSV or JSON files to the saved hosts");
+    parser.addHelpOption();
+    parser.addOption({"import", "Import each file (default ~/.ssh/config)."});
+    parser.addOption({"format", "Input format: auto, ssh-config, csv or json.", "format", "auto"});
+    parser.addOption({"mount-root", "Directory for the mount points of imported hosts.", "dir",
+                      QDir::homePath() + "/mnt"});
+    parser.addOption({"user", "User for hosts that do not name one.", "user", qEnvironmentVariable("USER")});
+    parser.addOption({"dry-run", "List what would be imported without saving."});
+    parser.addOption({"json", "Print results as JSON."});
+    parser.addPositionalArgument("files", "Files to import.", "[file...]");
+    parser.process(app);
+    console.setOutput(STDERR_FILENO);
+
+    const ImportFormat format = formatFromName(parser.value("format"));
+    if (format == ImportFormat::Auto && parser.value("format").toLower() != "auto") {
+        console.error("Unknown format", parser.value("format").toStdString());
+        return 2;
+    }
+    QStringList files = parser.positionalArguments();
+    if (files.isEmpty()) files.append(QDir::homePath() + "/.ssh/config");
+
+    QElapsedTimer timer;
+    timer.start();
+    HostImporter importer;
+    importer.setMountRoot(parser.value("mount-root"));
+    importer.setDefaultUser(parser.value("user"));
+    for (const QString& file : files) {
+        QString error;
+        if (!importer.importFile(file, format, error)) {
+            console.error(error.toStdString());
+            return 1;
+        }
+    }
+    for (const QString& warning : importer.warnings()) console.warn(warning.toStdString());
+    if (importer.warningCount() > importer.warnings().size()) {
+        console.warn(importer.warningCount() - importer.warnings().size(), "more warning(s)");
+    }
+
+    SSHStore store;
+    if (!store.load()) return 2;
+    const int existing = importer.skipExisting(store);
+    const bool dryRun = parser.isSet("dry-run");
+    if (!dryRun) {
+        store.addHosts(importer.hosts());
+        if (!store.save()) return 1;
+    }
+
+    if (parser.isSet("json")) {
+        QJsonObject doc;
+        QJsonArray hosts;
+        for (const SSHHost& host : importer.hosts()) hosts.append(host.toJson());
+        doc["hosts"] = hosts;
+        doc["imported"] = dryRun ? 0 : importer.hosts().size();
+        doc["existing"] = existing;
+        doc["duplicates"] = importer.duplicates();
+        doc["warnings"] = importer.warningCount();
+        doc["ms"] = timer.elapsed();
+        std::cout << QJsonDocument(doc).toJson(QJsonDocument::Indented).constData() << std::flush;
+        return 0;
+    }
+    if (dryRun) {
+        for (const SSHHost& host : importer.hosts()) {
+            std::cout << host.name.toStdString() << "  " << host.user.toStdString() << '@'
+                      << host.host.toStdString() << ':' << host.port << "  " << host.localPath.toStdString()
+                      << '\n';
+        }
+    }
+    std::cout << (dryRun ? "Would import " : "Imported ") << importer.hosts().size() << " host(s) ("
+              << existing << " already saved, " << importer.duplicates() << " duplicate(s)) in "
+              << timer.elapsed() << " ms\n" << std::flush;
+    return 0;
+}
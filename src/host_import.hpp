@@ -0,0 +1,103 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#pragma once
+
+#include "ssh_store.hpp"
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <QVector>
+
+class QCoreApplication;
+
+enum class ImportFormat { Auto, SshConfig, Csv, Json };
+
+// Turns host inventories into SSHHost records without touching a store:
+// - ssh_config files: Include is followed, and HostName, User and Port
+//   are resolved per Host alias through every matching block, wildcards
+//   included, first value winning as in ssh
+// - CSV with a header row (comma, semicolon or tab separated)
+// - JSON: a hosts.json export, an array of objects, or JSON Lines
+// Files are read line by line. A value type with no Qt parent, so it can
+// run off the UI thread; hand hosts() to SSHStore::addHosts().
+class HostImporter {
+public:
+    HostImporter();
+
+    // For fields a source leaves out: user defaults to $USER, localPath
+    // to mountRoot/name (~/mnt/name)
+    void setDefaultUser(const QString& user) { defaultUser_ = user; }
+    void setMountRoot(const QString& dir) { mountRoot_ = dir; }
+
+    static ImportFormat formatFromName(const QString& name);
+    // By extension, then by the first non-blank character
+    static ImportFormat detect(const QString& path);
+
+    // Appends to hosts(); a name seen before is skipped
+    bool importFile(const QString& path, ImportFormat format, QString& error);
+    // Drops hosts whose name the store already has; returns how many
+    int skipExisting(const SSHStore& store);
+
+    const QVector<SSHHost>& hosts() const { return hosts_; }
+    // The first MaxWarnings of them; warningCount() has them all
+    const QStringList& warnings() const { return warnings_; }
+    int warningCount() const { return warningCount_; }
+    int duplicates() const { return duplicates_; }
+
+    // ssh-mounter --import [FILE...]
+    static bool wanted(int argc, char** argv);
+    static int runCli(QCoreApplication& app);
+
+private:
+    // A Host (or Match) block, or the part of one that follows an Include
+    struct Block {
+        QStringList patterns;   // Lower-case; empty before the first Host line
+        bool global = true;
+        bool match = false;     // Match conditions are not evaluated
+        bool other = false;     // Sets options an SSHHost cannot carry
+        QString hostName;
+        QString user;
+        QString port;
+    };
+    struct SshConfig {
+        QVector<Block> blocks;
+        QHash<QString, QVector<int>> byName;    // Blocks of plain names only
+        QVector<int> scanned;                   // Everything else, in order
+        QStringList aliases;                    // Plain Host names, first seen first
+        QSet<QString> seen;
+    };
+
+    // Indexes block by its plain names, or queues it to be matched
+    static void addBlock(SshConfig& config, const Block& block);
+    bool readSshConfig(const QString& path, int depth, SshConfig& config, QString& error);
+    void resolveSshConfig(const SshConfig& config);
+    bool importCsv(const QString& path, QString& error);
+    bool importJson(const QString& path, QString& error);
+
+    // Keys are normalized column names ("hostname", "localpath")
+    bool addRecord(const QHash<QString, QString>& record, const QString& where);
+    void addHost(SSHHost host);
+    QString localPathFor(const QString& name) const;
+    void warn(const QString& message);
+
+    QString defaultUser_;
+    QString mountRoot_;
+    QVector<SSHHost> hosts_;
+    QSet<QString> names_;
+    QStringList warnings_;
+    int warningCount_;
+    int duplicates_;
+};
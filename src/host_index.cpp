@@ -0,0 +1,324 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#include "host_index.hpp"
+#include "ssh_store.hpp"
+#include <QPair>
+#include <algorithm>
+#include <climits>
+
+namespace {
+
+// Below this many dead slots compaction is not worth a pass
+const int MinCompact = 1024;
+// Up to this many new slots are placed by binary search, more are sorted
+// and merged into the name order in one pass
+const int MaxOrderInserts = 32;
+// Marks the posting key of a trigram of the name, as opposed to anywhere
+// in the text; characters only take the low 48 bits
+const quint64 NameGram = quint64(1) << 63;
+
+} // namespace
+
+void HostSearchIndex::clear() {
+    entries_.clear();
+    dead_ = 0;
+    slotById_.clear();
+    postings_.clear();
+    order_.clear();
+    unordered_.clear();
+    rank_.clear();
+}
+
+void HostSearchIndex::reserve(int hosts) {
+    entries_.reserve(hosts);
+    slotById_.reserve(hosts);
+    order_.reserve(hosts);
+}
+
+void HostSearchIndex::trigrams(const QString& text, QVector<quint64>& out) {
+    out.clear();
+    const QChar* s = text.constData();
+    for (int i = 0; i + 2 < text.size(); ++i) {
+        out.append((quint64(s[i].unicode()) << 32) |
+                   (quint64(s[i + 1].unicode()) << 16) |
+                   quint64(s[i + 2].unicode()));
+    }
+    // Each posting list holds a host at most once
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+quint64 HostSearchIndex::charMask(const QString& text) {
+    quint64 mask = 0;
+    for (QChar c : text) {
+        // Letters and digits get a bit each, the rest share the other 28
+        const ushort u = c.unicode();
+        const int bit = u >= 'a' && u <= 'z' ? u - 'a' : u >= '0' && u <= '9' ? 26 + u - '0' : 36 + u % 28;
+        mask |= quint64(1) << bit;
+    }
+    return mask;
+}
+
+bool HostSearchIndex::nameLess(const Entry& x, const Entry& y) {
+    if (x.name != y.name) return x.name < y.name;
+    return x.id < y.id;
+}
+
+void HostSearchIndex::sortOrder() const {
+    if (unordered_.isEmpty()) return;
+    auto less = [this](const Ordered& a, const Ordered& b) { return nameLess(entries_[a.slot], entries_[b.slot]); };
+    QVector<Ordered> added;
+    added.reserve(unordered_.size());
+    for (int slot : unordered_) added.append({slot, entries_[slot].textChars});
+    unordered_.clear();
+    if (added.size() <= MaxOrderInserts) {
+        for (const Ordered& o : added) order_.insert(std::upper_bound(order_.begin(), order_.end(), o, less), o);
+    } else {
+        std::sort(added.begin(), added.end(), less);
+        const int sorted = order_.size();
+        order_ += added;
+        std::inplace_merge(order_.begin(), order_.begin() + sorted, order_.end(), less);
+    }
+    rank_.resize(entries_.size());
+    for (int i = 0; i < order_.size(); ++i) rank_[order_[i].slot] = i;
+}
+
+void HostSearchIndex::insert(const SSHHost& host) {
+    remove(host.id);
+
+    // Slots are never reused before compact(): stale postings may still
+    // point at a dead one
+    const int slot = entries_.size();
+    entries_.append(Entry());
+
+    Entry& e = entries_[slot];
+    e.id = host.id;
+    e.name = host.name.toLower();
+    e.text = e.name + '\n' + (host.user + '@' + host.host + ':' + host.remotePath).toLower();
+    e.nameChars = charMask(e.name);
+    e.textChars = charMask(e.text);
+    trigrams(e.text, e.grams);
+    // The name's own trigrams again, flagged, for name substrings
+    QVector<quint64> nameGrams;
+    trigrams(e.name, nameGrams);
+    for (quint64 gram : nameGrams) e.grams.append(gram | NameGram);
+
+    for (quint64 gram : e.grams) {
+        postings_[gram].append(slot);
+    }
+    slotById_.insert(host.id, slot);
+    unordered_.append(slot);
+}
+
+void HostSearchIndex::remove(const QString& id) {
+    auto it = slotById_.find(id);
+    if (it == slotById_.end()) return;
+    const int slot = it.value();
+    slotById_.erase(it);
+
+    // The grams stay until compaction, which needs them to rebuild, and
+    // the name and ID keep the slot's place in order_
+    Entry& e = entries_[slot];
+    e.text.clear();
+    if (++dead_ > qMax(MinCompact, slotById_.size())) compact();
+}
+
+void HostSearchIndex::compact() {
+    QVector<Entry> live;
+    live.reserve(slotById_.size());
+    QVector<int> renumbered(entries_.size(), -1);
+    postings_.clear();
+    for (int old = 0; old < entries_.size(); ++old) {
+        Entry& e = entries_[old];
+        if (e.text.isEmpty()) continue;
+        const int slot = live.size();
+        for (quint64 gram : e.grams) {
+            postings_[gram].append(slot);
+        }
+        slotById_[e.id] = slot;
+        renumbered[old] = slot;
+        live.append(std::move(e));
+    }
+    entries_ = std::move(live);
+    dead_ = 0;
+
+    // Renumbering keeps the name order of the live slots
+    int kept = 0;
+    for (const Ordered& o : order_) {
+        if (renumbered[o.slot] >= 0) order_[kept++] = {renumbered[o.slot], o.textChars};
+    }
+    order_.resize(kept);
+    kept = 0;
+    for (int slot : unordered_) {
+        if (renumbered[slot] >= 0) unordered_[kept++] = renumbered[slot];
+    }
+    unordered_.resize(kept);
+    rank_.resize(entries_.size());
+    for (int i = 0; i < order_.size(); ++i) rank_[order_[i].slot] = i;
+}
+
+int HostSearchIndex::score(const Entry& entry, const QString& query, int matched, int total) const {
+    int s = total > 0 ? matched * 100 / total : 0;
+    if (entry.name.startsWith(query)) s += 300;
+    else if (entry.name.contains(query)) s += 200;
+    else if (entry.text.contains(query)) s += 100;
+    return s;
+}
+
+bool HostSearchIndex::better(const Entry& x, int scoreX, const Entry& y, int scoreY) {
+    if (scoreX != scoreY) return scoreX > scoreY;
+    // A total order, so a longer limit extends a shorter one's results
+    return nameLess(x, y);
+}
+
+bool HostSearchIndex::ranksBefore(const QString& a, int scoreA, const QString& b, int scoreB) const {
+    auto x = slotById_.constFind(a);
+    auto y = slotById_.constFind(b);
+    if (x == slotById_.constEnd() || y == slotById_.constEnd()) return x != slotById_.constEnd();
+    return better(entries_[x.value()], scoreA, entries_[y.value()], scoreB);
+}
+
+int HostSearchIndex::match(const QString& id, const QString& query) const {
+    auto it = slotById_.constFind(id);
+    if (it == slotById_.constEnd()) return -1;
+    const Entry& e = entries_[it.value()];
+    const QString q = query.trimmed().toLower();
+    if (q.size() < 3) return q.isEmpty() || e.text.contains(q) ? score(e, q, 0, 0) : -1;
+
+    QVector<quint64> grams;
+    trigrams(q, grams);
+    int matched = 0;
+    for (quint64 gram : grams) {
+        if (std::binary_search(e.grams.constBegin(), e.grams.constEnd(), gram)) ++matched;
+    }
+    const int total = grams.size();
+    if (matched < qMax(1, (total + 1) / 2)) return -1;
+    return score(e, q, matched, total);
+}
+
+QStringList HostSearchIndex::search(const QString& query, int limit, QVector<int>* scores) const {
+    const QString q = query.trimmed().toLower();
+    const int wanted = limit < 0 ? INT_MAX : limit;
+    // A host containing q has every trigram of it
+    const int full = q.size() >= 3 ? 100 : 0;
+    QVector<QPair<int, int>> ranked; // (score, slot), best first
+    sortOrder();
+
+    // Name prefix: one run of order_
+    auto prefix = std::lower_bound(order_.constBegin(), order_.constEnd(), q,
+                                   [this](const Ordered& o, const QString& s) { return entries_[o.slot].name < s; });
+    for (; prefix != order_.constEnd() && ranked.size() < wanted; ++prefix) {
+        const Entry& e = entries_[prefix->slot];
+        if (!e.name.startsWith(q)) break;
+        if (!e.text.isEmpty()) ranked.append(qMakePair(full + 300, prefix->slot));
+    }
+
+    QVector<quint64> grams;
+    if (q.size() >= 3) trigrams(q, grams);
+    // Only hosts on the shortest posting list of q's trigrams can contain
+    // q. False if one has none; list is null for a short query.
+    auto rarest = [&](quint64 flag, const QVector<int>*& list) {
+        list = nullptr;
+        for (quint64 gram : grams) {
+            auto it = postings_.constFind(gram | flag);
+            if (it == postings_.constEnd()) return false;
+            if (!list || it.value().size() < list->size()) list = &it.value();
+        }
+        return true;
+    };
+    const quint64 chars = charMask(q);
+    // The first hosts in name order that accept() takes. A short list is
+    // cheaper to sort than order_ is to walk; on a long one most hosts
+    // match and the walk stops early.
+    auto take = [&](const QVector<int>* list, int score, auto accept) {
+        const int room = wanted - ranked.size();
+        QVector<int> found;
+        if (list && list->size() < order_.size() / 16) {
+            for (int slot : *list) {
+                if (accept(entries_[slot])) found.append(slot);
+            }
+            std::sort(found.begin(), found.end(), [this](int a, int b) { return rank_[a] < rank_[b]; });
+            if (found.size() > room) found.resize(room);
+        } else {
+            for (int i = 0; i < order_.size() && found.size() < room; ++i) {
+                const Ordered& o = order_[i];
+                if ((o.textChars & chars) == chars && accept(entries_[o.slot])) found.append(o.slot);
+            }
+        }
+        for (int slot : found) ranked.append(qMakePair(score, slot));
+    };
+
+    // Then name substring and substring anywhere
+    auto inName = [&q, chars](const Entry& e) { return (e.nameChars & chars) == chars && e.name.contains(q); };
+    const QVector<int>* list = nullptr;
+    if (ranked.size() < wanted && rarest(NameGram, list)) {
+        take(list, full + 200, [&](const Entry& e) { return !e.text.isEmpty() && inName(e) && !e.name.startsWith(q); });
+    }
+    if (ranked.size() < wanted && rarest(0, list)) {
+        take(list, full + 100, [&](const Entry& e) {
+            return (e.textChars & chars) == chars && !e.text.isEmpty() && e.text.contains(q) && !inName(e);
+        });
+    }
+
+    // Only then the hosts sharing some trigrams; every host containing q
+    // is in ranked by now
+    if (!grams.isEmpty() && ranked.size() < wanted) {
+        // Count how many of the query's trigrams each host contains
+        QVector<quint16> hits(entries_.size(), 0);
+        QVector<int> touched;
+        for (quint64 gram : grams) {
+            auto it = postings_.constFind(gram);
+            if (it == postings_.constEnd()) continue;
+            for (int slot : it.value()) {
+                if (hits[slot]++ == 0 && !entries_[slot].text.isEmpty()) touched.append(slot);
+            }
+        }
+        for (const auto& r : ranked) hits[r.second] = 0;
+
+        // Tolerate typos: half of the trigrams is enough to be a candidate
+        const int total = grams.size();
+        const int needed = qMax(1, (total + 1) / 2);
+        QVector<QPair<int, int>> partial;
+        for (int slot : touched) {
+            if (hits[slot] >= needed) partial.append(qMakePair(hits[slot] * 100 / total, slot));
+        }
+        // Ties go by name, which rank_ already has as an integer
+        auto before = [this](const QPair<int, int>& a, const QPair<int, int>& b) {
+            if (a.first != b.first) return a.first > b.first;
+            return rank_[a.second] < rank_[b.second];
+        };
+        const int room = wanted - ranked.size();
+        if (room < partial.size()) {
+            std::partial_sort(partial.begin(), partial.begin() + room, partial.end(), before);
+            partial.resize(room);
+        } else {
+            std::sort(partial.begin(), partial.end(), before);
+        }
+        ranked += partial;
+    }
+
+    QStringList ids;
+    ids.reserve(ranked.size());
+    if (scores) {
+        scores->clear();
+        scores->reserve(ranked.size());
+    }
+    for (const auto& r : ranked) {
+        ids.append(entries_[r.second].id);
+        if (scores) scores->append(r.first);
+    }
+    return ids;
+}
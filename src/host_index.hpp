@@ -0,0 +1,94 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+struct SSHHost;
+
+// In-memory trigram index over each host's name, user, host and remote
+// path, keyed by host ID. Results are ranked: name prefix, then name
+// substring, then substring anywhere, then hosts that only share some of
+// the query's trigrams (so a typo or a partial word still finds the
+// host). Shorter queries than three characters match substrings only.
+//
+// Every host in one of the substring tiers outranks every host below it,
+// and within a tier hosts are in name order. The index keeps its slots in
+// name order, so a query fills the tiers in that order and stops at the
+// limit: a name prefix is one binary search, a substring a scan that a
+// per-host character mask and the query's rarest trigram keep to a few
+// string compares, and trigram counting only runs for the typo tier.
+//
+// Removing a host only marks its slot dead; searches skip dead slots and
+// the posting lists are rebuilt once the dead outnumber the live, so
+// removals and updates cost O(1) amortized whatever the list lengths.
+class HostSearchIndex {
+public:
+    void clear();
+    void reserve(int hosts);
+
+    // Adds the host, replacing any entry with the same ID
+    void insert(const SSHHost& host);
+    void remove(const QString& id);
+
+    // Matching host IDs, best first; limit < 0 returns every match.
+    // scores, if given, receives the score of each result.
+    QStringList search(const QString& query, int limit = -1, QVector<int>* scores = nullptr) const;
+    // The score search() would give the host, or -1 if it does not match
+    int match(const QString& id, const QString& query) const;
+    // The order of search() results, for placing a single host among them
+    bool ranksBefore(const QString& a, int scoreA, const QString& b, int scoreB) const;
+    int size() const { return slotById_.size(); }
+
+private:
+    struct Entry {
+        QString id;
+        QString name;   // lowercased; kept once removed, for the name order
+        QString text;   // lowercased "name\nuser@host:remotePath"; empty once removed
+        quint64 nameChars = 0;  // charMask() of name and of text
+        quint64 textChars = 0;
+        QVector<quint64> grams; // Of text, then of name flagged NameGram
+    };
+    // A slot of the name order, with its text mask so that a walk over
+    // the order rules most hosts out without touching their entries
+    struct Ordered {
+        int slot;
+        quint64 textChars;
+    };
+
+    static void trigrams(const QString& text, QVector<quint64>& out);
+    // One bit per letter or digit, shared bits for the rest: a host whose
+    // mask lacks a bit of the query's cannot contain it
+    static quint64 charMask(const QString& text);
+    static bool nameLess(const Entry& x, const Entry& y);
+    // Sorts the slots inserted since the last search into order_
+    void sortOrder() const;
+    int score(const Entry& entry, const QString& query, int matched, int total) const;
+    static bool better(const Entry& x, int scoreX, const Entry& y, int scoreY);
+    // Drops dead slots and renumbers the live ones
+    void compact();
+
+    QVector<Entry> entries_;
+    int dead_ = 0;
+    QHash<QString, int> slotById_;
+    QHash<quint64, QVector<int>> postings_;     // May list dead slots
+    mutable QVector<Ordered> order_;            // By name, then ID; may list dead slots
+    mutable QVector<int> unordered_;            // Inserted, not in order_ yet
+    mutable QVector<int> rank_;                 // Slot -> index in order_
+};
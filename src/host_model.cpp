@@ -0,0 +1,350 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#include "host_model.hpp"
+#include "ssh_store.hpp"
+#include "mount_manager.hpp"
+#include "mount_watcher.hpp"
+#include "mount_supervisor.hpp"
+#include "lazy_mount.hpp"
+#include <QApplication>
+#include <QStyle>
+
+HostListModel::HostListModel(SSHStore* store, MountWatcher* watcher, MountManager* manager,
+                             QObject* parent)
+    : QAbstractListModel(parent), store_(store), watcher_(watcher), manager_(manager),
+      supervisor_(nullptr), limit_(PageSize), more_(false), removing_(false) {
+    QStyle* style = QApplication::style();
+    mountedIcon_ = style->standardIcon(QStyle::SP_DriveNetIcon);
+    busyIcon_ = style->standardIcon(QStyle::SP_BrowserReload);
+    errorIcon_ = style->standardIcon(QStyle::SP_MessageBoxWarning);
+    staleIcon_ = style->standardIcon(QStyle::SP_MessageBoxCritical);
+
+    connect(store_, &SSHStore::hostsAboutToBeReset, this, [this]() {
+        beginResetModel();
+    });
+    connect(store_, &SSHStore::hostsReset, this, [this]() {
+        errors_.clear();
+        applyFilter();
+        endResetModel();
+    });
+    // While filtered only the changed host is tested against the filter;
+    // filtered rows are kept by ID, so store rows moving does not matter
+    connect(store_, &SSHStore::hostAboutToBeAdded, this, [this](int row) {
+        if (!isFiltered()) beginInsertRows(QModelIndex(), row, row);
+    });
+    connect(store_, &SSHStore::hostAdded, this, [this](const QString& id) {
+        if (isFiltered()) showHost(id);
+        else endInsertRows();
+    });
+    connect(store_, &SSHStore::hostAboutToBeRemoved, this, [this](const QString& id, int row) {
+        errors_.remove(id);
+        if (isFiltered()) row = viewRowById_.value(id, -1);
+        removing_ = row >= 0;
+        if (removing_) beginRemoveRows(QModelIndex(), row, row);
+    });
+    connect(store_, &SSHStore::hostRemoved, this, [this](const QString& id) {
+        if (!removing_) return;
+        removing_ = false;
+        if (isFiltered()) {
+            const int row = viewRowById_.take(id);
+            ids_.removeAt(row);
+            scores_.remove(row);
+            renumber(row);
+        }
+        endRemoveRows();
+    });
+    connect(store_, &SSHStore::hostUpdated, this, [this](const QString& id) {
+        if (isFiltered()) updateFiltered(id);
+        else hostChanged(id);
+    });
+
+    connect(watcher_, &MountWatcher::hostMountChanged, this, [this](const QString& key) {
+        hostChanged(key);
+    });
+    connect(manager_, &MountManager::hostStateChanged, this, [this](const QString& key, MountState state) {
+        // A new attempt clears the previous failure
+        if (state == MountState::Mounting || state == MountState::Unmounting) errors_.remove(key);
+        hostChanged(key);
+    });
+    connect(manager_, &MountManager::hostBusyChanged, this, [this](const QString& key) {
+        hostChanged(key);
+    });
+    connect(manager_, &MountManager::hostMountError, this, [this](const QString& key, const QString& error) {
+        errors_.insert(key, error);
+        hostChanged(key);
+    });
+}
+
+void HostListModel::setSupervisor(MountSupervisor* supervisor) {
+    supervisor_ = supervisor;
+    connect(supervisor_, &MountSupervisor::statusChanged, this, [this](const QString& key) {
+        hostChanged(key);
+    });
+}
+
+namespace {
+
+QString formatBytes(qint64 bytes) {
+    const double gib = bytes / (1024.0 * 1024.0 * 1024.0);
+    if (gib >= 1.0) return QString("%1 GiB").arg(gib, 0, 'f', 1);
+    return QString("%1 MiB").arg(bytes / (1024 * 1024));
+}
+
+} // namespace
+
+int HostListModel::rowCount(const QModelIndex& parent) const {
+    if (parent.isValid()) return 0;
+    return isFiltered() ? ids_.size() : store_->count();
+}
+
+QVariant HostListModel::data(const QModelIndex& index, int role) const {
+    const int row = index.isValid() ? storeRow(index.row()) : -1;
+    if (row < 0) return QVariant();
+    const SSHHost& host = store_->at(row);
+    const QString key = MountManager::keyFor(host);
+
+    switch (role) {
+    case Qt::DisplayRole: {
+        QString text = QString("%1 (%2@%3)").arg(host.name).arg(host.user).arg(host.host);
+        if (supervisor_ && watcher_->isMounted(key)) {
+            qint64 free = supervisor_->status(key).freeBytes;
+            if (free >= 0) text += ", " + formatBytes(free) + " free";
+        }
+        return text;
+    }
+    case Qt::DecorationRole:
+        if (manager_->isBusy(key)) return busyIcon_;
+        if (supervisor_) {
+            MountHealth health = supervisor_->health(key);
+            if (health == MountHealth::Stale || health == MountHealth::Dead) return staleIcon_;
+            if (health == MountHealth::Slow) return errorIcon_;
+        }
+        if (errors_.contains(key)) return errorIcon_;
+        if (watcher_->isMounted(key)) return mountedIcon_;
+        return QVariant();
+    case Qt::ToolTipRole:
+        return statusText(key);
+    case IdRole:
+        return host.id;
+    case MountedRole:
+        return watcher_->isMounted(key);
+    case StateRole:
+        return int(manager_->state(key));
+    case ErrorRole:
+        return errors_.value(key);
+    default:
+        return QVariant();
+    }
+}
+
+QHash<int, QByteArray> HostListModel::roleNames() const {
+    QHash<int, QByteArray> roles = QAbstractListModel::roleNames();
+    roles.insert(IdRole, "id");
+    roles.insert(MountedRole, "mounted");
+    roles.insert(StateRole, "state");
+    roles.insert(ErrorRole, "error");
+    return roles;
+}
+
+QString HostListModel::idAt(int row) const {
+    row = storeRow(row);
+    return row < 0 ? QString() : store_->at(row).id;
+}
+
+int HostListModel::storeRow(int row) const {
+    if (row < 0) return -1;
+    if (isFiltered()) return row < ids_.size() ? store_->indexOf(ids_[row]) : -1;
+    return row < store_->count() ? row : -1;
+}
+
+int HostListModel::viewRow(const QString& id) const {
+    return isFiltered() ? viewRowById_.value(id, -1) : store_->indexOf(id);
+}
+
+void HostListModel::setFilter(const QString& query) {
+    const QString trimmed = query.trimmed();
+    if (trimmed == filter_) return;
+    filter_ = trimmed;
+    limit_ = PageSize;
+    refilter();
+}
+
+bool HostListModel::canFetchMore(const QModelIndex& parent) const {
+    return !parent.isValid() && isFiltered() && more_;
+}
+
+void HostListModel::fetchMore(const QModelIndex& parent) {
+    if (!canFetchMore(parent)) return;
+    limit_ += PageSize;
+    // Ranking is a total order, so the first rows come back unchanged
+    QVector<int> scores;
+    const QStringList ids = store_->searchIndex().search(filter_, limit_ + 1, &scores);
+    more_ = ids.size() > limit_;
+    // Single-host updates may have shown some of these already
+    QStringList added;
+    QVector<int> addedScores;
+    for (int i = 0; i < qMin(ids.size(), limit_); ++i) {
+        if (viewRowById_.contains(ids[i])) continue;
+        added.append(ids[i]);
+        addedScores.append(scores[i]);
+    }
+    if (added.isEmpty()) return;
+    const int first = ids_.size();
+    beginInsertRows(QModelIndex(), first, first + added.size() - 1);
+    ids_ += added;
+    scores_ += addedScores;
+    renumber(first);
+    endInsertRows();
+}
+
+void HostListModel::refilter() {
+    beginResetModel();
+    applyFilter();
+    endResetModel();
+}
+
+void HostListModel::applyFilter() {
+    ids_.clear();
+    scores_.clear();
+    viewRowById_.clear();
+    more_ = false;
+    if (!isFiltered()) return;
+
+    // One extra result tells whether there is more to fetch
+    ids_ = store_->searchIndex().search(filter_, limit_ + 1, &scores_);
+    more_ = ids_.size() > limit_;
+    if (more_) {
+        ids_.removeLast();
+        scores_.removeLast();
+    }
+    renumber(0);
+}
+
+void HostListModel::renumber(int from) {
+    for (int row = from; row < ids_.size(); ++row) {
+        viewRowById_.insert(ids_[row], row);
+    }
+}
+
+int HostListModel::rankedRow(const QString& id, int score) const {
+    const HostSearchIndex& index = store_->searchIndex();
+    int lo = 0, hi = ids_.size();
+    while (lo < hi) {
+        const int mid = (lo + hi) / 2;
+        if (index.ranksBefore(ids_[mid], scores_[mid], id, score)) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+void HostListModel::showHost(const QString& id) {
+    const int score = store_->searchIndex().match(id, filter_);
+    if (score < 0) return;
+    const int row = rankedRow(id, score);
+    // Past the last shown row with more to fetch: fetchMore() will get to it
+    if (row == ids_.size() && more_) return;
+    beginInsertRows(QModelIndex(), row, row);
+    ids_.insert(row, id);
+    scores_.insert(row, score);
+    renumber(row);
+    endInsertRows();
+}
+
+void HostListModel::hideRow(int row) {
+    beginRemoveRows(QModelIndex(), row, row);
+    viewRowById_.remove(ids_[row]);
+    ids_.removeAt(row);
+    scores_.remove(row);
+    renumber(row);
+    endRemoveRows();
+}
+
+void HostListModel::updateFiltered(const QString& id) {
+    const int from = viewRowById_.value(id, -1);
+    if (from < 0) {
+        showHost(id);
+        return;
+    }
+    const int score = store_->searchIndex().match(id, filter_);
+    if (score < 0) {
+        hideRow(from);
+        return;
+    }
+
+    // Place it among the other rows; the model only changes inside
+    // beginMoveRows/endMoveRows, so it is put back for the search
+    ids_.removeAt(from);
+    scores_.remove(from);
+    const int to = rankedRow(id, score);
+    ids_.insert(from, id);
+    scores_.insert(from, score);
+    if (to == ids_.size() - 1 && more_) {
+        hideRow(from);
+        return;
+    }
+    if (to == from) {
+        hostChanged(id);
+        return;
+    }
+    // beginMoveRows counts the destination before the move
+    beginMoveRows(QModelIndex(), from, from, QModelIndex(), to > from ? to + 1 : to);
+    ids_.move(from, to);
+    scores_.move(from, to);
+    renumber(qMin(from, to));
+    endMoveRows();
+    hostChanged(id);
+}
+
+void HostListModel::hostChanged(const QString& key) {
+    int row = viewRow(key);
+    if (row < 0) return;
+    QModelIndex idx = index(row);
+    emit dataChanged(idx, idx);
+}
+
+QString HostListModel::statusText(const QString& key) const {
+    switch (manager_->state(key)) {
+    case MountState::Mounting:
+        return "Mounting...";
+    case MountState::Unmounting:
+        return "Unmounting...";
+    default:
+        break;
+    }
+    if (supervisor_) {
+        const MountSupervisor::Status status = supervisor_->status(key);
+        if (status.recovering) {
+            return QString("Connection lost, reconnecting (attempt %1)...").arg(qMax(1, status.attempt));
+        }
+        switch (status.health) {
+        case MountHealth::Slow:
+            return QString("Mounted, slow to respond (%1 ms)").arg(status.probeMs);
+        case MountHealth::Stale:
+            return "Mounted, not responding";
+        case MountHealth::Dead:
+            return "Connection lost";
+        default:
+            break;
+        }
+    }
+    auto error = errors_.constFind(key);
+    if (error != errors_.constEnd()) return "Error: " + error.value();
+    if (watcher_->isMounted(key)) return "Mounted";
+    const SSHHost* host = store_->byId(key);
+    return host && LazyMounter::eligible(*host) ? "Not mounted, mounts on first access" : "Not mounted";
+}
+
+#include "host_model.moc"
@@ -0,0 +1,101 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#pragma once
+
+#include "ssh_mounter.hpp"
+#include <QAbstractListModel>
+#include <QHash>
+#include <QIcon>
+#include <QVector>
+
+class SSHStore;
+class MountManager;
+class MountWatcher;
+class MountSupervisor;
+
+// List model over SSHStore. Holds no copy of the hosts: rows map straight
+// onto store rows, text and icons are produced in data() only for the rows
+// a view asks about, and each store, watcher or manager notification turns
+// into a single row insert, removal or dataChanged().
+//
+// With a filter set, only hosts matching SSHStore::search() are shown, in
+// rank order; rows then no longer line up with store rows, so views map
+// them back through storeRow(). Results come PageSize at a time: the
+// view asks for more through fetchMore() as it scrolls. A store change
+// while filtered is matched against the filter for that one host and
+// becomes a single row insert, move, removal or dataChanged().
+class HostListModel : public QAbstractListModel {
+    Q_OBJECT
+public:
+    enum Roles {
+        IdRole = Qt::UserRole + 1,
+        MountedRole,
+        StateRole,
+        ErrorRole
+    };
+
+    HostListModel(SSHStore* store, MountWatcher* watcher, MountManager* manager,
+                  QObject* parent = nullptr);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+    bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
+
+    static const int PageSize = 200;
+
+    QString idAt(int row) const;
+    int storeRow(int row) const;
+
+    void setFilter(const QString& query);
+    QString filter() const { return filter_; }
+    bool isFiltered() const { return !filter_.isEmpty(); }
+
+    // Adds mount health and free space to the rows
+    void setSupervisor(MountSupervisor* supervisor);
+
+private:
+    void applyFilter();
+    void refilter();
+    int viewRow(const QString& id) const;
+    void hostChanged(const QString& key);
+    // Filtered view: where a host with this score goes among the shown rows
+    int rankedRow(const QString& id, int score) const;
+    void showHost(const QString& id);
+    void hideRow(int row);
+    void updateFiltered(const QString& id);
+    void renumber(int from);
+    QString statusText(const QString& key) const;
+
+    SSHStore* store_;
+    MountWatcher* watcher_;
+    MountManager* manager_;
+    MountSupervisor* supervisor_;
+    QHash<QString, QString> errors_;
+    QString filter_;
+    int limit_;                         // Results asked for so far
+    bool more_;                         // The search had more than limit_
+    // Shown while filtered, by ID since store rows move under them
+    QStringList ids_;
+    QVector<int> scores_;
+    QHash<QString, int> viewRowById_;
+    bool removing_;                     // Between the store's two remove signals
+    QIcon mountedIcon_;
+    QIcon busyIcon_;
+    QIcon errorIcon_;
+    QIcon staleIcon_;
+};
@@ -0,0 +1,305 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#include "host_snapshot.hpp"
+#include "console.hpp"
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QtEndian>
+#include <cstring>
+#include <sys/stat.h>
+
+extern Console console;
+
+namespace {
+
+const char Magic[8] = {'S', 'S', 'H', 'M', 'S', 'N', 'P', '1'};
+const quint32 Version = 3;
+
+enum HostField { Id, Name, User, Host, RemotePath, LocalPath, Profile, Extra, FieldCount };
+
+const quint8 FlagPublicKey = 0x01;
+const quint8 FlagFavorite = 0x02;
+const quint8 FlagLazyMount = 0x04;
+
+// Keys with a fixed slot in a host record; everything else goes to Extra
+const char* const FixedKeys[] = {
+    "id", "name", "user", "host", "remotePath", "localPath", "port", "usePublicKey",
+    "favorite", "controlPersist", "lazyMount", "idleUnmountMinutes", "profile"
+};
+
+template<typename T>
+void put(QByteArray& out, T value) {
+    value = qToLittleEndian(value);
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<typename T>
+T get(const uchar* p) {
+    T value;
+    memcpy(&value, p, sizeof(T));
+    return qFromLittleEndian(value);
+}
+
+// magic, version, host count, string count, CRC, JSON inode, mtime, size
+const int HeaderSize = 8 + 4 * 4 + 8 * 3;
+// offset, length
+const int StringRefSize = 4 * 2;
+// string indexes, port, flags, padding, controlPersist, idleUnmountMinutes
+const int HostRecordSize = 4 * FieldCount + 2 + 1 + 1 + 4 + 4;
+
+// Identity of hosts.json: a rename by another writer changes the inode,
+// an edit in place the nanosecond mtime
+struct JsonStamp {
+    quint64 inode = 0;
+    qint64 mtimeNs = 0;
+    qint64 size = 0;
+};
+
+bool jsonStamp(const QString& jsonPath, JsonStamp& stamp) {
+    struct stat st;
+    if (stat(QFile::encodeName(jsonPath).constData(), &st) != 0) return false;
+    stamp.inode = quint64(st.st_ino);
+    stamp.mtimeNs = qint64(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    stamp.size = qint64(st.st_size);
+    return true;
+}
+
+} // namespace
+
+QString HostSnapshot::pathFor(const QString& jsonPath) {
+    QString path = jsonPath;
+    if (path.endsWith(".json")) path.chop(5);
+    return path + ".bin";
+}
+
+quint32 HostSnapshot::crc32(const uchar* data, qint64 size) {
+    // Slicing-by-8: eight bytes per step through eight tables instead of
+    // one byte per step through one
+    static quint32 table[8][256];
+    static bool ready = [] {
+        for (quint32 i = 0; i < 256; ++i) {
+            quint32 c = i;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            table[0][i] = c;
+        }
+        for (int t = 1; t < 8; ++t) {
+            for (quint32 i = 0; i < 256; ++i) table[t][i] = (table[t - 1][i] >> 8) ^ table[0][table[t - 1][i] & 0xFF];
+        }
+        return true;
+    }();
+    Q_UNUSED(ready);
+
+    quint32 crc = 0xFFFFFFFFu;
+    for (; size >= 8; data += 8, size -= 8) {
+        const quint32 lo = get<quint32>(data) ^ crc;
+        const quint32 hi = get<quint32>(data + 4);
+        crc = table[7][lo & 0xFF] ^ table[6][(lo >> 8) & 0xFF] ^ table[5][(lo >> 16) & 0xFF] ^ table[4][lo >> 24] ^
+              table[3][hi & 0xFF] ^ table[2][(hi >> 8) & 0xFF] ^ table[1][(hi >> 16) & 0xFF] ^ table[0][hi >> 24];
+    }
+    for (; size > 0; ++data, --size) crc = table[0][(crc ^ *data) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFFu;
+}
+
+bool HostSnapshot::write(const QString& jsonPath, const QVector<SSHHost>& hosts) {
+    JsonStamp stamp;
+    if (!jsonStamp(jsonPath, stamp)) return false;
+
+    // Deduplicate strings; hosts repeat users, hostnames and paths a lot
+    QHash<QString, quint32> ids;
+    QVector<QByteArray> strings;
+    auto intern = [&](const QString& s) -> quint32 {
+        auto it = ids.constFind(s);
+        if (it != ids.constEnd()) return it.value();
+        quint32 index = quint32(strings.size());
+        ids.insert(s, index);
+        strings.append(s.toUtf8());
+        return index;
+    };
+    intern(QString()); // index 0 is always the empty string
+
+    QByteArray records;
+    records.reserve(hosts.size() * HostRecordSize);
+    for (const auto& h : hosts) {
+        QJsonObject extra = h.toJson();
+        for (const char* key : FixedKeys) extra.remove(key);
+        QString extraJson = extra.isEmpty()
+            ? QString()
+            : QString::fromUtf8(QJsonDocument(extra).toJson(QJsonDocument::Compact));
+
+        put<quint32>(records, intern(h.id));
+        put<quint32>(records, intern(h.name));
+        put<quint32>(records, intern(h.user));
+        put<quint32>(records, intern(h.host));
+        put<quint32>(records, intern(h.remotePath));
+        put<quint32>(records, intern(h.localPath));
+        put<quint32>(records, intern(QString::fromUtf8(
+            QJsonDocument(h.profile.toJson()).toJson(QJsonDocument::Compact))));
+        put<quint32>(records, intern(extraJson));
+        put<quint16>(records, quint16(h.port));
+        put<quint8>(records, quint8((h.usePublicKey ? FlagPublicKey : 0) | (h.favorite ? FlagFavorite : 0) |
+                                    (h.lazyMount ? FlagLazyMount : 0)));
+        put<quint8>(records, 0);
+        put<qint32>(records, qint32(h.controlPersist));
+        put<qint32>(records, qint32(h.idleUnmountMinutes));
+    }
+
+    QByteArray refs;
+    QByteArray blob;
+    refs.reserve(strings.size() * StringRefSize);
+    for (const auto& s : strings) {
+        put<quint32>(refs, quint32(blob.size()));
+        put<quint32>(refs, quint32(s.size()));
+        blob.append(s);
+    }
+
+    QByteArray body = refs + records + blob;
+
+    QByteArray header;
+    header.append(Magic, sizeof(Magic));
+    put<quint32>(header, Version);
+    put<quint32>(header, quint32(hosts.size()));
+    put<quint32>(header, quint32(strings.size()));
+    put<quint32>(header, crc32(reinterpret_cast<const uchar*>(body.constData()), body.size()));
+    put<quint64>(header, stamp.inode);
+    put<qint64>(header, stamp.mtimeNs);
+    put<qint64>(header, stamp.size);
+
+    QSaveFile file(pathFor(jsonPath));
+    if (!file.open(QIODevice::WriteOnly)) return false;
+    file.write(header);
+    file.write(body);
+    return file.commit();
+}
+
+bool HostSnapshot::read(const QString& jsonPath, QVector<SSHHost>& hosts) {
+    JsonStamp stamp;
+    if (!jsonStamp(jsonPath, stamp)) return false;
+
+    QFile file(pathFor(jsonPath));
+    if (!file.open(QIODevice::ReadOnly) || file.size() < HeaderSize) return false;
+
+    const qint64 fileSize = file.size();
+    const uchar* base = file.map(0, fileSize);
+    if (!base) return false;
+
+    // Validate the header before trusting any offsets in it
+    if (memcmp(base, Magic, sizeof(Magic)) != 0) return false;
+    const uchar* p = base + sizeof(Magic);
+    quint32 version = get<quint32>(p); p += 4;
+    quint32 hostCount = get<quint32>(p); p += 4;
+    quint32 stringCount = get<quint32>(p); p += 4;
+    quint32 crc = get<quint32>(p); p += 4;
+    quint64 stampInode = get<quint64>(p); p += 8;
+    qint64 stampMtime = get<qint64>(p); p += 8;
+    qint64 stampSize = get<qint64>(p); p += 8;
+
+    if (version != Version || stampInode != stamp.inode || stampMtime != stamp.mtimeNs || stampSize != stamp.size) {
+        return false;
+    }
+
+    const qint64 refsSize = qint64(stringCount) * StringRefSize;
+    const qint64 recordsSize = qint64(hostCount) * HostRecordSize;
+    if (stringCount == 0 || HeaderSize + refsSize + recordsSize > fileSize) return false;
+
+    const uchar* body = base + HeaderSize;
+    if (crc32(body, fileSize - HeaderSize) != crc) {
+        console.warn("Host snapshot checksum mismatch, falling back to JSON");
+        return false;
+    }
+
+    const uchar* refs = body;
+    const uchar* records = refs + refsSize;
+    const uchar* blob = records + recordsSize;
+    const qint64 blobSize = fileSize - (blob - base);
+
+    // Strings are decoded the first time a record refers to them and then
+    // shared by every other record that uses the same value.
+    QVector<QString> strings(int(stringCount));
+    QVector<bool> decoded(int(stringCount), false);
+    bool ok = true;
+    auto str = [&](quint32 index) -> QString {
+        if (index >= stringCount) {
+            ok = false;
+            return QString();
+        }
+        if (!decoded[int(index)]) {
+            const uchar* ref = refs + qint64(index) * StringRefSize;
+            quint32 offset = get<quint32>(ref);
+            quint32 length = get<quint32>(ref + 4);
+            if (qint64(offset) + length > blobSize) {
+                ok = false;
+                return QString();
+            }
+            strings[int(index)] = QString::fromUtf8(reinterpret_cast<const char*>(blob + offset), int(length));
+            decoded[int(index)] = true;
+        }
+        return strings[int(index)];
+    };
+
+    // Profiles and extras repeat across hosts; each distinct one is parsed
+    // once and copied from then on
+    QHash<quint32, SSHFSProfile> profiles;
+    QHash<quint32, SSHHost> extras;
+
+    QVector<SSHHost> result;
+    result.reserve(int(hostCount));
+    for (quint32 i = 0; i < hostCount && ok; ++i) {
+        const uchar* r = records + qint64(i) * HostRecordSize;
+        quint32 fields[FieldCount];
+        for (int f = 0; f < FieldCount; ++f) fields[f] = get<quint32>(r + 4 * f);
+
+        SSHHost h;
+        if (fields[Extra] != 0) {
+            auto it = extras.constFind(fields[Extra]);
+            if (it == extras.constEnd()) {
+                it = extras.insert(fields[Extra],
+                    SSHHost::fromJson(QJsonDocument::fromJson(str(fields[Extra]).toUtf8()).object()));
+            }
+            h = it.value();
+        }
+        auto profile = profiles.constFind(fields[Profile]);
+        if (profile == profiles.constEnd()) {
+            profile = profiles.insert(fields[Profile],
+                SSHFSProfile::fromJson(QJsonDocument::fromJson(str(fields[Profile]).toUtf8()).object()));
+        }
+        h.profile = profile.value();
+        h.id = str(fields[Id]);
+        h.name = str(fields[Name]);
+        h.user = str(fields[User]);
+        h.host = str(fields[Host]);
+        h.remotePath = str(fields[RemotePath]);
+        h.localPath = str(fields[LocalPath]);
+        h.port = get<quint16>(r + 4 * FieldCount);
+        const quint8 flags = r[4 * FieldCount + 2];
+        h.usePublicKey = (flags & FlagPublicKey) != 0;
+        h.favorite = (flags & FlagFavorite) != 0;
+        h.lazyMount = (flags & FlagLazyMount) != 0;
+        h.controlPersist = get<qint32>(r + 4 * FieldCount + 4);
+        h.idleUnmountMinutes = get<qint32>(r + 4 * FieldCount + 8);
+        result.append(std::move(h));
+    }
+
+    if (!ok) {
+        console.warn("Host snapshot is corrupt, falling back to JSON");
+        return false;
+    }
+    hosts = std::move(result);
+    return true;
+}
@@ -0,0 +1,50 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#pragma once
+
+#include "ssh_store.hpp"
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+// Compact binary copy of hosts.json (hosts.bin next to it) that loads
+// without JSON parsing. hosts.json stays the source of truth: a snapshot
+// is only used when its checksum is intact and the inode, nanosecond
+// mtime and size of hosts.json match the ones recorded when it was written.
+//
+// Layout (little endian):
+//   header   magic "SSHMSNP1", version, host count, string count,
+//            CRC-32 of everything after the header, JSON inode, mtime (ns)
+//            and size
+//   strings  (offset, length) pairs into the blob; each distinct string
+//            is stored once and decoded on first use
+//   hosts    fixed-size records of string indexes, port, flags and the
+//            integer options; the profile is stored as compact JSON, which
+//            hosts share and which is decoded once per distinct profile.
+//            Fields without a slot (none today) ride along as JSON too.
+//   blob     UTF-8 string data
+class HostSnapshot {
+public:
+    static QString pathFor(const QString& jsonPath);
+
+    static bool write(const QString& jsonPath, const QVector<SSHHost>& hosts);
+    // Decodes every host: the store owns its hosts as SSHHost values.
+    // Each distinct string and profile is decoded once and shared.
+    static bool read(const QString& jsonPath, QVector<SSHHost>& hosts);
+
+private:
+    static quint32 crc32(const uchar* data, qint64 size);
+};
@@ -0,0 +1,377 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#include "known_hosts.hpp"
+#include "mount_manager.hpp"
+#include "reachability.hpp"
+#include "glob_match.hpp"
+#include "console.hpp"
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMessageAuthenticationCode>
+#include <QProcess>
+#include <QRandomGenerator>
+#include <QSaveFile>
+#include <QSet>
+#include <QStandardPaths>
+#include <QThreadPool>
+#include <memory>
+#include <vector>
+
+extern Console console;
+
+namespace {
+
+const int DefaultTimeoutSec = 3;
+const int SshConfigMs = 1000;
+const int SaltBytes = 20;       // SHA-1 sized, as ssh writes them
+
+QByteArray hmac(const QByteArray& salt, const QString& token) {
+    return QMessageAuthenticationCode::hash(token.toUtf8(), salt, QCryptographicHash::Sha1);
+}
+
+QByteArray hashedName(const QString& token) {
+    QByteArray salt(SaltBytes, Qt::Uninitialized);
+    for (char& c : salt) c = char(QRandomGenerator::system()->bounded(256));
+    return "|1|" + salt.toBase64() + '|' + hmac(salt, token).toBase64();
+}
+
+QStringList defaultKnownHostsFiles() {
+    const QString ssh = QDir::homePath() + "/.ssh/";
+    return {ssh + "known_hosts", ssh + "known_hosts2",
+            "/etc/ssh/ssh_known_hosts", "/etc/ssh/ssh_known_hosts2"};
+}
+
+} // namespace
+
+QString HostKey::fingerprint() const {
+    QByteArray digest = QCryptographicHash::hash(blob, QCryptographicHash::Sha256).toBase64();
+    while (digest.endsWith('=')) digest.chop(1);
+    return "SHA256:" + QString::fromLatin1(digest);
+}
+
+QString KnownHosts::token(const QString& host, int port) {
+    const QString name = host.toLower();
+    return port == 22 ? name : QString("[%1]:%2").arg(name).arg(port);
+}
+
+bool KnownHosts::parse(const QByteArray& raw, Entry& entry) {
+    const QByteArray line = raw.simplified();
+    if (line.isEmpty() || line.startsWith('#')) return false;
+    const QList<QByteArray> fields = line.split(' ');
+    int i = 0;
+    if (fields[0].startsWith('@')) {
+        if (fields[0] == "@revoked") entry.marker = Marker::Revoked;
+        else if (fields[0] == "@cert-authority") entry.marker = Marker::CertAuthority;
+        else return false;
+        ++i;
+    }
+    if (fields.size() < i + 3) return false;
+
+    const QByteArray& names = fields[i];
+    if (names.startsWith("|1|")) {
+        const QList<QByteArray> parts = names.split('|');
+        if (parts.size() != 4) return false;
+        entry.salt = QByteArray::fromBase64(parts[2]);
+        entry.hash = QByteArray::fromBase64(parts[3]);
+        if (entry.salt.size() != SaltBytes || entry.hash.size() != SaltBytes) return false;
+    } else {
+        entry.patterns = QString::fromUtf8(names).toLower().split(',', Qt::SkipEmptyParts);
+    }
+    entry.key.type = QString::fromLatin1(fields[i + 1]);
+    entry.key.blob = QByteArray::fromBase64(fields[i + 2]);
+    return !entry.key.blob.isEmpty();
+}
+
+bool KnownHosts::matches(const Entry& entry, const QString& token) {
+    if (!entry.hash.isEmpty()) return hmac(entry.salt, token) == entry.hash;
+    bool matched = false;
+    for (const QString& pattern : entry.patterns) {
+        if (pattern.startsWith('!')) {
+            if (globMatch(token, pattern.mid(1))) return false;
+        } else if (globMatch(token, pattern)) {
+            matched = true;
+        }
+    }
+    return matched;
+}
+
+void KnownHosts::load(const QStringList& files) {
+    for (const QString& path : files) {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) continue;
+        const QList<QByteArray> lines = file.readAll().split('\n');
+        for (const QByteArray& line : lines) {
+            Entry entry;
+            if (!parse(line, entry)) continue;
+            const int index = entries_.size();
+            bool wildcard = !entry.hash.isEmpty();
+            for (const QString& pattern : entry.patterns) {
+                wildcard = wildcard || pattern.contains('*') || pattern.contains('?') || pattern.startsWith('!');
+            }
+            if (wildcard) {
+                scanned_.append(index);
+            } else {
+                for (const QString& name : entry.patterns) byName_[name].append(index);
+            }
+            entries_.append(std::move(entry));
+        }
+    }
+}
+
+QList<const KnownHosts::Entry*> KnownHosts::lookup(const QString& token) const {
+    const QString name = token.toLower();
+    QList<const Entry*> found;
+    for (int index : byName_.value(name)) found.append(&entries_[index]);
+    for (int index : scanned_) {
+        if (matches(entries_[index], name)) found.append(&entries_[index]);
+    }
+    return found;
+}
+
+QList<HostKey> KnownHosts::keys(const QString& token) const {
+    QList<HostKey> keys;
+    for (const Entry* entry : lookup(token)) {
+        if (entry->marker == Marker::None) keys.append(entry->key);
+    }
+    return keys;
+}
+
+HostKeyStatus KnownHosts::compare(const QString& token, const QList<HostKey>& offered) const {
+    bool anyOnFile = false;
+    bool certified = false;
+    bool match = false;
+    for (const Entry* entry : lookup(token)) {
+        switch (entry->marker) {
+        case Marker::Revoked:
+            if (offered.contains(entry->key)) return HostKeyStatus::Revoked;
+            break;
+        case Marker::CertAuthority:
+            // The server's certificate is for ssh to check
+            certified = true;
+            break;
+        case Marker::None:
+            anyOnFile = true;
+            match = match || offered.contains(entry->key);
+            break;
+        }
+    }
+    // ssh prefers the key types it has on file, so one match is enough
+    if (match || certified) return HostKeyStatus::Known;
+    return anyOnFile ? HostKeyStatus::Changed : HostKeyStatus::New;
+}
+
+bool KnownHosts::replace(const QString& path, const QString& token, const QList<HostKey>& keys,
+                         bool hash, QString& error) {
+    const QString name = token.toLower();
+    QByteArray original;
+    QFile file(path);
+    if (file.exists()) {
+        if (!file.open(QIODevice::ReadOnly)) {
+            error = "Cannot read " + path + ": " + file.errorString();
+            return false;
+        }
+        original = file.readAll();
+        file.close();
+    }
+
+    QByteArray out;
+    int dropped = 0;
+    QList<QByteArray> lines = original.split('\n');
+    if (!lines.isEmpty() && lines.last().isEmpty()) lines.removeLast();
+    for (const QByteArray& line : lines) {
+        Entry entry;
+        if (parse(line, entry) && entry.marker == Marker::None && matches(entry, name)) {
+            ++dropped;
+            continue;
+        }
+        out += line + '\n';
+    }
+    for (const HostKey& key : keys) {
+        out += (hash ? hashedName(name) : name.toUtf8()) + ' ' + key.type.toLatin1() + ' ' +
+               key.blob.toBase64() + '\n';
+    }
+    if (dropped == 0 && keys.isEmpty()) return true;
+
+    const QString dir = QFileInfo(path).absolutePath();
+    if (!QDir(dir).exists()) {
+        if (!QDir().mkpath(dir)) {
+            error = "Cannot create " + dir;
+            return false;
+        }
+        QFile::setPermissions(dir, QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner);
+    }
+    if (dropped > 0) {
+        QFile::remove(path + ".old");
+        QFile::copy(path, path + ".old");
+    }
+    QSaveFile save(path);
+    if (!save.open(QIODevice::WriteOnly) || save.write(out) != out.size() || !save.commit()) {
+        error = "Cannot write " + path + ": " + save.errorString();
+        return false;
+    }
+    return true;
+}
+
+HostKeyScanner::HostKeyScanner(QObject* parent)
+    : QObject(parent), timeout_(DefaultTimeoutSec), seedNew_(false) {
+}
+
+void HostKeyScanner::scan(const QList<SSHHost>& hosts, QObject* context,
+                          std::function<void(const Results&)> done) {
+    QPointer<QObject> guard(context);
+    const int timeout = timeout_;
+    const bool seedNew = seedNew_;
+    QThreadPool::globalInstance()->start([hosts, timeout, seedNew, guard, done]() {
+        const Results results = check(hosts, timeout, seedNew);
+        QMetaObject::invokeMethod(QCoreApplication::instance(), [guard, done, results]() {
+            if (guard) done(results);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void HostKeyScanner::accept(const QList<HostKeyCheck>& checks, QObject* context,
+                            std::function<void(const QStringList&)> done) {
+    QPointer<QObject> guard(context);
+    QThreadPool::globalInstance()->start([checks, guard, done]() {
+        const QStringList errors = store(checks);
+        QMetaObject::invokeMethod(QCoreApplication::instance(), [guard, done, errors]() {
+            if (guard) done(errors);
+        }, Qt::QueuedConnection);
+    });
+}
+
+HostKeyScanner::Results HostKeyScanner::check(const QList<SSHHost>& hosts, int timeoutSec, bool seedNew) {
+    Results results;
+    QVector<ReachTarget> targets;
+    for (const SSHHost& host : hosts) targets.append({host.host, host.port});
+    const QVector<SshHostConfig> configs = Reachability::sshConfig(targets, SshConfigMs);
+
+    // What ssh-keyscan should ask for, one process per port
+    QHash<int, QStringList> namesByPort;
+    QHash<QString, QString> scanTokens;     // Host key -> name as ssh-keyscan prints it
+    QStringList files;
+    for (int i = 0; i < hosts.size(); ++i) {
+        const SshHostConfig& config = configs[i];
+        HostKeyCheck& check = results[MountManager::keyFor(hosts[i])];
+        const QString name = (config.hostName.isEmpty() ? hosts[i].host : config.hostName).toLower();
+        const int port = config.ok ? config.port : hosts[i].port;
+        check.token = config.hostKeyAlias.isEmpty() ? KnownHosts::token(name, port) : config.hostKeyAlias.toLower();
+        check.file = config.userKnownHosts.value(0, defaultKnownHostsFiles().first());
+        check.hash = config.hashKnownHosts;
+        files << (config.ok ? config.userKnownHosts + config.globalKnownHosts : defaultKnownHostsFiles());
+        if (config.proxied) {
+            check.error = "Reached through a proxy; not scanned";
+            continue;
+        }
+        if (name.isEmpty()) continue;
+        scanTokens.insert(MountManager::keyFor(hosts[i]), KnownHosts::token(name, port));
+        QStringList& names = namesByPort[port];
+        if (!names.contains(name)) names << name;
+    }
+    files.removeDuplicates();
+
+    QHash<QString, QList<HostKey>> offered;
+    KnownHosts known;
+    if (QStandardPaths::findExecutable("ssh-keyscan").isEmpty()) {
+        for (HostKeyCheck& check : results) {
+            if (check.error.isEmpty()) check.error = "ssh-keyscan not found";
+        }
+        return results;
+    }
+    std::vector<std::unique_ptr<QProcess>> procs;
+    for (auto it = namesByPort.constBegin(); it != namesByPort.constEnd(); ++it) {
+        auto proc = std::make_unique<QProcess>();
+        proc->start("ssh-keyscan", QStringList{"-T", QString::number(timeoutSec), "-p", QString::number(it.key())}
+                                   + it.value());
+        procs.push_back(std::move(proc));
+    }
+    // Parsed while the scans run
+    known.load(files);
+    for (const auto& proc : procs) {
+        if (!proc->waitForFinished((timeoutSec * 2 + 5) * 1000)) {
+            proc->kill();
+            proc->waitForFinished(100);
+        }
+        // "name type key", with name as "[name]:port" off port 22
+        for (const QByteArray& line : proc->readAllStandardOutput().split('\n')) {
+            const QList<QByteArray> fields = line.simplified().split(' ');
+            if (fields.size() < 3 || fields[0].startsWith('#')) continue;
+            HostKey key{QString::fromLatin1(fields[1]), QByteArray::fromBase64(fields[2])};
+            if (!key.blob.isEmpty()) offered[QString::fromUtf8(fields[0]).toLower()].append(key);
+        }
+    }
+
+    QSet<QString> written;
+    for (auto it = results.begin(); it != results.end(); ++it) {
+        HostKeyCheck& check = it.value();
+        if (!scanTokens.contains(it.key())) continue;
+        check.offered = offered.value(scanTokens.value(it.key()));
+        if (check.offered.isEmpty()) {
+            check.error = "No host key received";
+            continue;
+        }
+        check.status = known.compare(check.token, check.offered);
+        if (check.status != HostKeyStatus::New || !seedNew) continue;
+
+        const QString target = check.file + '\n' + check.token;
+        QString error;
+        if (written.contains(target) || KnownHosts::replace(check.file, check.token, check.offered, check.hash, error)) {
+            if (!written.contains(target)) {
+                console.info("Recorded host key for", check.token.toStdString(),
+                             check.offered.first().fingerprint().toStdString());
+            }
+            written.insert(target);
+            check.seeded = true;
+        } else {
+            check.error = error;
+        }
+    }
+    return results;
+}
+
+QStringList HostKeyScanner::store(const QList<HostKeyCheck>& checks) {
+    QStringList errors;
+    for (const HostKeyCheck& check : checks) {
+        QString error;
+        if (KnownHosts::replace(check.file, check.token, check.offered, check.hash, error)) {
+            console.info("Stored host key for", check.token.toStdString(),
+                         check.offered.isEmpty() ? "" : check.offered.first().fingerprint().toStdString());
+        } else {
+            errors << check.token + ": " + error;
+        }
+    }
+    return errors;
+}
+
+bool HostKeyScanner::forget(const SSHHost& host, QString& error) {
+    const SshHostConfig config = Reachability::sshConfig({{host.host, host.port}}, SshConfigMs).value(0);
+    const QString name = config.hostName.isEmpty() ? host.host : config.hostName;
+    const QString token = config.hostKeyAlias.isEmpty()
+        ? KnownHosts::token(name, config.ok ? config.port : host.port)
+        : config.hostKeyAlias;
+    const QStringList files = config.userKnownHosts.isEmpty()
+        ? defaultKnownHostsFiles().mid(0, 2) : config.userKnownHosts;
+    for (const QString& file : files) {
+        if (!QFile::exists(file)) continue;
+        if (!KnownHosts::replace(file, token, {}, false, error)) return false;
+    }
+    return true;
+}
+
+#include "known_hosts.moc"
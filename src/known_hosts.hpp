@@ -0,0 +1,130 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#pragma once
+
+#include "ssh_store.hpp"
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QStringList>
+#include <QVector>
+#include <functional>
+
+struct HostKey {
+    QString type;               // "ssh-ed25519"
+    QByteArray blob;            // Decoded key
+
+    bool operator==(const HostKey& other) const { return type == other.type && blob == other.blob; }
+    // "SHA256:...", as ssh-keygen -l prints it
+    QString fingerprint() const;
+};
+
+enum class HostKeyStatus {
+    Unchecked,                  // Not scanned: proxied, down, or no ssh-keyscan
+    Known,                      // An offered key is on file
+    New,                        // Nothing on file for the host
+    Changed,                    // Keys on file, none of them offered
+    Revoked                     // An offered key is marked @revoked
+};
+
+// known_hosts files parsed into an index. Plain names are looked up in a
+// hash; hashed (|1|salt|hash) and wildcard entries are matched one by one,
+// the former through HMAC-SHA1 of "host" or "[host]:port" as ssh does.
+// A value type with no Qt parent, so it can be built off the UI thread.
+class KnownHosts {
+public:
+    // Missing files are skipped
+    void load(const QStringList& files);
+    int size() const { return entries_.size(); }
+
+    // How known_hosts names a host: "host", or "[host]:port" off port 22
+    static QString token(const QString& host, int port);
+    QList<HostKey> keys(const QString& token) const;
+    HostKeyStatus compare(const QString& token, const QList<HostKey>& offered) const;
+
+    // Drops every line of file that names token; keys (if any) are then
+    // appended under token, hashed if asked. The old file is kept as
+    // file.old, like ssh-keygen -R does.
+    static bool replace(const QString& file, const QString& token, const QList<HostKey>& keys,
+                        bool hash, QString& error);
+
+private:
+    enum class Marker { None, Revoked, CertAuthority };
+    struct Entry {
+        Marker marker = Marker::None;
+        QByteArray salt;        // Hashed entries
+        QByteArray hash;
+        QStringList patterns;   // Everything else
+        HostKey key;
+    };
+
+    static bool parse(const QByteArray& line, Entry& entry);
+    static bool matches(const Entry& entry, const QString& token);
+    QList<const Entry*> lookup(const QString& token) const;
+
+    QVector<Entry> entries_;
+    QHash<QString, QVector<int>> byName_;   // Lower-case names without wildcards
+    QVector<int> scanned_;                  // Hashed and wildcard entries
+};
+
+// Result of HostKeyScanner for one host
+struct HostKeyCheck {
+    HostKeyStatus status = HostKeyStatus::Unchecked;
+    QString token;              // Name in known_hosts (HostKeyAlias if set)
+    QString file;               // User known_hosts file keys are written to
+    bool hash = false;          // HashKnownHosts
+    QList<HostKey> offered;     // What the server presented
+    bool seeded = false;        // Was New; offered keys are now on file
+    QString error;
+};
+
+// Fetches the host keys of many hosts at once with ssh-keyscan (one
+// process per port, each connecting to all of its hosts in parallel) and
+// compares them against known_hosts before anything is mounted, so a
+// batch never stops halfway for a key prompt. Nothing is written unless
+// asked: the caller shows New and Changed keys with their fingerprints and
+// passes the confirmed ones to accept(). setSeedNew(true) records keys of
+// hosts seen for the first time right away instead (ssh's accept-new).
+class HostKeyScanner : public QObject {
+    Q_OBJECT
+public:
+    explicit HostKeyScanner(QObject* parent = nullptr);
+
+    void setTimeout(int seconds) { timeout_ = seconds; }
+    void setSeedNew(bool enabled) { seedNew_ = enabled; }
+
+    using Results = QHash<QString, HostKeyCheck>;   // By MountManager::keyFor()
+
+    // Calls done on this thread once every host is scanned; nothing is
+    // called if context is destroyed first
+    void scan(const QList<SSHHost>& hosts, QObject* context, std::function<void(const Results&)> done);
+    // Replaces what is on file for each check with its offered keys;
+    // done gets one message per host that could not be written
+    void accept(const QList<HostKeyCheck>& checks, QObject* context,
+                std::function<void(const QStringList&)> done);
+
+    // Blocking forms of the above
+    static Results check(const QList<SSHHost>& hosts, int timeoutSec, bool seedNew);
+    static QStringList store(const QList<HostKeyCheck>& checks);
+    // Drops the host's keys from every user known_hosts file
+    static bool forget(const SSHHost& host, QString& error);
+
+private:
+    int timeout_;
+    bool seedNew_;
+};
@@ -0,0 +1,286 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#include "lazy_mount.hpp"
+#include "mount_manager.hpp"
+#include "mount_watcher.hpp"
+#include "mount_supervisor.hpp"
+#include "mount_table.hpp"
+#include "console.hpp"
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QPointer>
+#include <QSocketNotifier>
+#include <QThreadPool>
+#include <QTimer>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+extern Console console;
+
+namespace {
+
+const int SampleMs = 30000;
+// A failed mount is not retried on every access of an empty directory
+const int RetryAfterMs = 30000;
+// fusermount itself opens the mount point; those events trail the change
+const int SettleMs = 2000;
+// sshfs traffic per sample that is not user I/O: supervisor statvfs
+// probes and keepalives stay well below this
+const quint64 IdleIoBytes = 16 * 1024;
+
+// inotify only reports an access after it happened, so the access that
+// triggers the mount has already seen the empty directory; holding it until
+// the mount is up would need fanotify permission events and CAP_SYS_ADMIN.
+const uint32_t TriggerMask = IN_OPEN | IN_ACCESS | IN_ONLYDIR;
+const uint32_t ActivityMask = IN_OPEN | IN_ACCESS | IN_MODIFY | IN_CREATE | IN_DELETE | IN_MOVE;
+
+// rchar + wchar of a process; 0 if it is gone or unreadable
+quint64 processIo(pid_t pid) {
+    QFile file(QString("/proc/%1/io").arg(pid));
+    if (!file.open(QIODevice::ReadOnly)) return 0;
+    quint64 total = 0;
+    for (const QByteArray& line : file.readAll().split('\n')) {
+        if (line.startsWith("rchar:") || line.startsWith("wchar:")) {
+            total += line.mid(6).trimmed().toULongLong();
+        }
+    }
+    return total;
+}
+
+} // namespace
+
+LazyMounter::LazyMounter(SSHStore* store, MountWatcher* watcher, MountManager* manager,
+                         MountSupervisor* supervisor, QObject* parent)
+    : QObject(parent), store_(store), watcher_(watcher), manager_(manager), supervisor_(supervisor),
+      fd_(-1), notifier_(nullptr), timer_(new QTimer(this)) {
+    timer_->setInterval(SampleMs);
+    connect(timer_, &QTimer::timeout, this, &LazyMounter::sample);
+
+    connect(store_, &SSHStore::hostsReset, this, &LazyMounter::sync);
+    connect(store_, &SSHStore::hostAdded, this, [this](const QString& id) {
+        if (const SSHHost* host = store_->byId(id)) track(*host);
+    });
+    connect(store_, &SSHStore::hostUpdated, this, [this](const QString& id) {
+        untrack(id);
+        if (const SSHHost* host = store_->byId(id)) track(*host);
+    });
+    connect(store_, &SSHStore::hostRemoved, this, &LazyMounter::untrack);
+    connect(watcher_, &MountWatcher::hostMountChanged, this, &LazyMounter::onMountChanged);
+    connect(manager_, &MountManager::hostMountError, this, [this](const QString& key) {
+        auto it = entries_.find(key);
+        if (it != entries_.end()) it->failedAt.start();
+    });
+}
+
+LazyMounter::~LazyMounter() {
+    if (fd_ >= 0) ::close(fd_);
+}
+
+bool LazyMounter::eligible(const SSHHost& host) {
+    // A password prompt popping up because something listed a directory
+    // would be worse than no lazy mounting at all
+    return host.lazyMount && host.usePublicKey && !host.localPath.isEmpty();
+}
+
+bool LazyMounter::isArmed(const QString& key) const {
+    auto it = entries_.constFind(key);
+    return it != entries_.constEnd() && it->triggerWd >= 0 && !it->mounted;
+}
+
+bool LazyMounter::start() {
+    if (fd_ >= 0) return true;
+    fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd_ < 0) {
+        console.warn("Mount on access disabled: inotify:", strerror(errno));
+        return false;
+    }
+    notifier_ = new QSocketNotifier(fd_, QSocketNotifier::Read, this);
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    connect(notifier_, &QSocketNotifier::activated, this, &LazyMounter::onInotify);
+#else
+    connect(notifier_, SIGNAL(activated(int)), this, SLOT(onInotify()));
+#endif
+    timer_->start();
+    sync();
+    return true;
+}
+
+void LazyMounter::sync() {
+    if (fd_ < 0) return;
+    for (const QString& key : entries_.keys()) untrack(key);
+    for (const SSHHost& host : store_->hosts()) track(host);
+}
+
+void LazyMounter::track(const SSHHost& host) {
+    if (fd_ < 0 || !eligible(host)) return;
+    const QString key = MountManager::keyFor(host);
+    Entry& entry = entries_[key];
+    entry.host = host;
+    entry.mounted = watcher_->table().isMounted(host);
+    if (entry.mounted) {
+        onMountChanged(key, true);
+    } else {
+        arm(entry);
+    }
+}
+
+void LazyMounter::untrack(const QString& key) {
+    auto it = entries_.find(key);
+    if (it == entries_.end()) return;
+    for (int wd : {it->triggerWd, it->activityWd}) {
+        if (wd < 0) continue;
+        keyByWd_.remove(wd);
+        inotify_rm_watch(fd_, wd);
+    }
+    entries_.erase(it);
+}
+
+void LazyMounter::arm(Entry& entry) {
+    if (entry.triggerWd >= 0) return;
+    const QString path = QDir::cleanPath(entry.host.localPath);
+    QDir().mkpath(path);
+    entry.triggerWd = inotify_add_watch(fd_, QFile::encodeName(path).constData(), TriggerMask);
+    if (entry.triggerWd < 0) {
+        console.warn("Cannot watch", path.toStdString(), "for access:", strerror(errno));
+        return;
+    }
+    keyByWd_.insert(entry.triggerWd, MountManager::keyFor(entry.host));
+    console.log(entry.host.name.toStdString(), "mounts on first access to", path.toStdString());
+}
+
+void LazyMounter::onMountChanged(const QString& key, bool mounted) {
+    auto it = entries_.find(key);
+    if (it == entries_.end()) return;
+    it->mounted = mounted;
+    it->changedAt.start();
+    if (!mounted) {
+        // The trigger watch sits on the inode underneath and survives the mount
+        arm(it.value());
+        return;
+    }
+
+    it->lastActivity.start();
+    it->ioKnown = false;
+    if (it->activityWd >= 0 || it->host.idleUnmountMinutes <= 0) return;
+
+    // Resolving the path goes through sshfs; keep that off the UI thread
+    QPointer<LazyMounter> self(this);
+    const int fd = fd_;
+    const QByteArray path = QFile::encodeName(QDir::cleanPath(it->host.localPath));
+    QThreadPool::globalInstance()->start([self, fd, key, path]() {
+        int wd = inotify_add_watch(fd, path.constData(), ActivityMask);
+        QMetaObject::invokeMethod(QCoreApplication::instance(), [self, key, wd]() {
+            if (!self || wd < 0) return;
+            auto it = self->entries_.find(key);
+            // Same inode as the trigger: the mount went away meanwhile
+            if (it == self->entries_.end() || !it->mounted || wd == it->triggerWd) return;
+            it->activityWd = wd;
+            self->keyByWd_.insert(wd, key);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void LazyMounter::onInotify() {
+    alignas(inotify_event) char buf[8192];
+    for (;;) {
+        ssize_t n = ::read(fd_, buf, sizeof(buf));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return;
+
+        for (char* p = buf; p < buf + n; p += sizeof(inotify_event) + reinterpret_cast<inotify_event*>(p)->len) {
+            const inotify_event* ev = reinterpret_cast<inotify_event*>(p);
+            auto k = keyByWd_.constFind(ev->wd);
+            if (k == keyByWd_.constEnd()) continue;
+            const QString key = k.value();
+            auto it = entries_.find(key);
+            if (it == entries_.end()) continue;
+
+            if (ev->mask & IN_IGNORED) {
+                // Unmounted, or the directory was removed
+                keyByWd_.remove(ev->wd);
+                if (ev->wd == it->activityWd) it->activityWd = -1;
+                if (ev->wd == it->triggerWd) it->triggerWd = -1;
+                continue;
+            }
+            if (ev->wd == it->activityWd) {
+                it->lastActivity.restart();
+                continue;
+            }
+            if (ev->wd != it->triggerWd || it->mounted || manager_->isBusy(key)) continue;
+            if (it->failedAt.isValid() && it->failedAt.elapsed() < RetryAfterMs) continue;
+            if (it->changedAt.isValid() && it->changedAt.elapsed() < SettleMs) continue;
+
+            console.info(it->host.name.toStdString(), "accessed; mounting");
+            emit triggered(key);
+            manager_->mount(it->host);
+        }
+    }
+}
+
+void LazyMounter::sample() {
+    for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+        Entry& entry = it.value();
+        if (!entry.mounted || entry.host.idleUnmountMinutes <= 0 || manager_->isBusy(it.key())) continue;
+
+        // Reads and writes deep in the tree never reach the root watch,
+        // but they do move bytes through sshfs
+        pid_t pid = supervisor_ ? supervisor_->sshfsPid(it.key()) : 0;
+        if (pid > 0) {
+            const quint64 io = processIo(pid);
+            if (entry.ioKnown && io - entry.ioBytes > IdleIoBytes) entry.lastActivity.restart();
+            entry.ioBytes = io;
+            entry.ioKnown = io > 0;
+        }
+
+        if (entry.lastActivity.elapsed() >= qint64(entry.host.idleUnmountMinutes) * 60000) {
+            checkIdle(it.key());
+        }
+    }
+}
+
+void LazyMounter::checkIdle(const QString& key) {
+    auto it = entries_.find(key);
+    if (it == entries_.end() || it->checking) return;
+    it->checking = true;
+
+    // A shell sitting in the mount or an open file means it is in use
+    // even without traffic; unmounting would fail anyway
+    QPointer<LazyMounter> self(this);
+    const QString mountPoint = QDir::cleanPath(it->host.localPath);
+    QThreadPool::globalInstance()->start([self, key, mountPoint]() {
+        const bool busy = !MountTable::holders(mountPoint, 1).isEmpty();
+        QMetaObject::invokeMethod(QCoreApplication::instance(), [self, key, busy]() {
+            if (!self) return;
+            auto it = self->entries_.find(key);
+            if (it == self->entries_.end()) return;
+            it->checking = false;
+            if (busy) {
+                it->lastActivity.restart();
+                return;
+            }
+            if (!it->mounted || self->manager_->isBusy(key)) return;
+            console.info(it->host.name.toStdString(), "idle for", it->host.idleUnmountMinutes,
+                         "min; unmounting");
+            emit self->idleUnmounted(key, it->host.idleUnmountMinutes);
+            self->manager_->unmount(it->host);
+        }, Qt::QueuedConnection);
+    });
+}
+
+#include "lazy_mount.moc"
@@ -0,0 +1,87 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#pragma once
+
+#include "ssh_store.hpp"
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+
+class MountManager;
+class MountWatcher;
+class MountSupervisor;
+class QSocketNotifier;
+class QTimer;
+
+// Mount-on-access for hosts with SSHHost::lazyMount. While such a host is
+// unmounted its (empty) mount point carries an inotify watch; the first
+// open or readdir of it starts the real mount. That first access is not
+// held back and sees the empty directory; later ones see the remote. While
+// it is mounted, an inotify watch on the mount root, the sshfs process's
+// I/O counters and, before acting, MountTable::holders() decide when it has
+// been idle for SSHHost::idleUnmountMinutes and is unmounted again.
+class LazyMounter : public QObject {
+    Q_OBJECT
+public:
+    LazyMounter(SSHStore* store, MountWatcher* watcher, MountManager* manager,
+                MountSupervisor* supervisor, QObject* parent = nullptr);
+    ~LazyMounter() override;
+
+    // Call once the mount table is known, so armed paths are really unmounted
+    bool start();
+
+    static bool eligible(const SSHHost& host);
+    bool isArmed(const QString& key) const;
+
+signals:
+    void triggered(const QString& key);
+    void idleUnmounted(const QString& key, int idleMinutes);
+
+private slots:
+    void onInotify();
+
+private:
+    struct Entry {
+        SSHHost host;
+        int triggerWd = -1;         // On the directory under the mount
+        int activityWd = -1;        // On the mounted root
+        bool mounted = false;
+        bool checking = false;      // holders() scan in flight
+        QElapsedTimer lastActivity;
+        QElapsedTimer failedAt;
+        QElapsedTimer changedAt;    // Last mount or unmount
+        quint64 ioBytes = 0;
+        bool ioKnown = false;
+    };
+
+    void sync();
+    void track(const SSHHost& host);
+    void untrack(const QString& key);
+    void arm(Entry& entry);
+    void onMountChanged(const QString& key, bool mounted);
+    void sample();
+    void checkIdle(const QString& key);
+
+    SSHStore* store_;
+    MountWatcher* watcher_;
+    MountManager* manager_;
+    MountSupervisor* supervisor_;
+    int fd_;
+    QSocketNotifier* notifier_;
+    QTimer* timer_;
+    QHash<QString, Entry> entries_;
+    QHash<int, QString> keyByWd_;
+};
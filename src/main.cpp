@@ -16,6 +16,18 @@
 #include "console.hpp"
 #include "ssh_store.hpp"
 #include "ssh_mounter.hpp"
+#include "mount_manager.hpp"
+#include "mount_watcher.hpp"
+#include "startup.hpp"
+#include "host_model.hpp"
+#include "benchmark.hpp"
+#include "mount_supervisor.hpp"
+#include "metrics.hpp"
+#include "headless.hpp"
+#include "control.hpp"
+#include "lazy_mount.hpp"
+#include "known_hosts.hpp"
+#include "host_import.hpp"
 
 #include <QApplication>
 #include <QMainWindow>
@@ -23,7 +35,7 @@
 #include <QPushButton>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
-#include <QListWidget>
+#include <QListView>
 #include <QDialog>
 #include <QFormLayout>
 #include <QLineEdit>
@@ -31,13 +43,27 @@
 #include <QLabel>
 #include <QMessageBox>
 #include <QCheckBox>
+#include <QComboBox>
+#include <QGroupBox>
+#include <QJsonDocument>
+#include <QPlainTextEdit>
+#include <QRadioButton>
 #include <QTimer>
 #include <QPainter>
 #include <QPropertyAnimation>
 #include <QFileDialog>
 #include <QCloseEvent>
 #include <QInputDialog>
+#include <QQueue>
+#include <QSet>
+#include <QElapsedTimer>
+#include <QStyle>
+#include <QDir>
+#include <QPointer>
+#include <QThreadPool>
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
 
 Console console;
 
@@ -101,6 +127,22 @@ public:
         remoteEdit_ = new QLineEdit(this);
         localEdit_ = new QLineEdit(this);
         pubkeyCheck_ = new QCheckBox("Use Public Key Authentication", this);
+        favoriteCheck_ = new QCheckBox("Favorite (connect in the background at startup)", this);
+        persistSpin_ = new QSpinBox(this);
+        persistSpin_->setRange(0, 86400);
+        persistSpin_->setValue(600);
+        persistSpin_->setSuffix(" s");
+        persistSpin_->setSpecialValueText("Off");
+        persistSpin_->setToolTip("How long an idle shared SSH connection stays open for faster remounts");
+        lazyCheck_ = new QCheckBox("Mount on first access (public key only)", this);
+        lazyCheck_->setToolTip("Leave the host unmounted until something opens the local path.\n"
+                               "That first access still finds the folder empty; open it again "
+                               "once the host is mounted.");
+        idleSpin_ = new QSpinBox(this);
+        idleSpin_->setRange(0, 1440);
+        idleSpin_->setSuffix(" min");
+        idleSpin_->setSpecialValueText("Never");
+        idleSpin_->setToolTip("Unmount a host mounted on access after this long without use");
         
         if (host) {
             nameEdit_->setText(host->name);
@@ -110,6 +152,10 @@ public:
             remoteEdit_->setText(host->remotePath);
             localEdit_->setText(host->localPath);
             pubkeyCheck_->setChecked(host->usePublicKey);
+            favoriteCheck_->setChecked(host->favorite);
+            persistSpin_->setValue(host->controlPersist);
+            lazyCheck_->setChecked(host->lazyMount);
+            idleSpin_->setValue(host->idleUnmountMinutes);
         }
         
         layout->addRow("Name:", nameEdit_);
@@ -118,6 +164,17 @@ public:
         layout->addRow("Port:", portSpin_);
         layout->addRow("Remote Path:", remoteEdit_);
         layout->addRow("", pubkeyCheck_);
+        layout->addRow("", favoriteCheck_);
+        layout->addRow("Keep Connection:", persistSpin_);
+        layout->addRow("", lazyCheck_);
+        layout->addRow("Unmount When Idle:", idleSpin_);
+        auto updateLazy = [this]() {
+            lazyCheck_->setEnabled(pubkeyCheck_->isChecked());
+            idleSpin_->setEnabled(pubkeyCheck_->isChecked() && lazyCheck_->isChecked());
+        };
+        connect(pubkeyCheck_, &QCheckBox::toggled, this, updateLazy);
+        connect(lazyCheck_, &QCheckBox::toggled, this, updateLazy);
+        updateLazy();
         
         auto* localLayout = new QHBoxLayout();
         localLayout->addWidget(localEdit_);
@@ -130,6 +187,76 @@ public:
             if (!dir.isEmpty()) localEdit_->setText(dir);
         });
         
+        // Performance profile: pick a preset, or tune the fields below,
+        // which turns the profile into "Custom".
+        profileCombo_ = new QComboBox(this);
+        profileCombo_->addItems(SSHFSProfile::presetNames());
+        profileCombo_->addItem(SSHFSProfile::CustomName);
+        layout->addRow("Performance:", profileCombo_);
+        
+        auto* tuning = new QGroupBox("Performance Options", this);
+        tuning->setCheckable(true);
+        tuning->setChecked(false);
+        auto* tuningWidget = new QWidget(tuning);
+        auto* tuningLayout = new QFormLayout(tuningWidget);
+        auto* tuningOuter = new QVBoxLayout(tuning);
+        tuningOuter->addWidget(tuningWidget);
+        tuningWidget->hide();
+        connect(tuning, &QGroupBox::toggled, tuningWidget, &QWidget::setVisible);
+        
+        auto sizeSpin = [this](int max, const QString& suffix, int min, const QString& special) {
+            auto* spin = new QSpinBox(this);
+            spin->setRange(min, max);
+            spin->setSuffix(suffix);
+            spin->setSpecialValueText(special);
+            return spin;
+        };
+        ciphersEdit_ = new QLineEdit(this);
+        ciphersEdit_->setPlaceholderText("ssh default");
+        compressionCheck_ = new QCheckBox("Compression", this);
+        kernelCacheCheck_ = new QCheckBox("Kernel page cache (kernel_cache)", this);
+        maxConnsSpin_ = sizeSpin(64, "", 1, QString());
+        maxReadSpin_ = sizeSpin(1024, " KiB", 0, "Default");
+        maxWriteSpin_ = sizeSpin(1024, " KiB", 0, "Default");
+        cacheTimeoutSpin_ = sizeSpin(86400, " s", -1, "Default");
+        attrTimeoutSpin_ = sizeSpin(86400, " s", -1, "Default");
+        aliveIntervalSpin_ = sizeSpin(3600, " s", 0, "Off");
+        aliveCountSpin_ = sizeSpin(100, "", 1, QString());
+        extraEdit_ = new QLineEdit(this);
+        extraEdit_->setPlaceholderText("opt1,opt2=value");
+        
+        tuningLayout->addRow("Ciphers:", ciphersEdit_);
+        tuningLayout->addRow("", compressionCheck_);
+        tuningLayout->addRow("", kernelCacheCheck_);
+        tuningLayout->addRow("Connections:", maxConnsSpin_);
+        tuningLayout->addRow("Max Read:", maxReadSpin_);
+        tuningLayout->addRow("Max Write:", maxWriteSpin_);
+        tuningLayout->addRow("Cache Timeout:", cacheTimeoutSpin_);
+        tuningLayout->addRow("Attribute Timeout:", attrTimeoutSpin_);
+        tuningLayout->addRow("Keepalive Interval:", aliveIntervalSpin_);
+        tuningLayout->addRow("Keepalive Count:", aliveCountSpin_);
+        tuningLayout->addRow("Extra Options:", extraEdit_);
+        layout->addRow(tuning);
+        
+        setProfile(host ? host->profile : SSHFSProfile());
+        connect(profileCombo_, static_cast<void(QComboBox::*)(int)>(&QComboBox::activated), this, [this]() {
+            const QString name = profileCombo_->currentText();
+            if (name != SSHFSProfile::CustomName) setProfile(SSHFSProfile::preset(name));
+        });
+        auto markCustom = [this]() {
+            if (!updatingProfile_) profileCombo_->setCurrentText(SSHFSProfile::CustomName);
+        };
+        for (QLineEdit* edit : {ciphersEdit_, extraEdit_}) {
+            connect(edit, &QLineEdit::textEdited, this, markCustom);
+        }
+        for (QCheckBox* check : {compressionCheck_, kernelCacheCheck_}) {
+            connect(check, &QCheckBox::toggled, this, markCustom);
+        }
+        for (QSpinBox* spin : {maxConnsSpin_, maxReadSpin_, maxWriteSpin_, cacheTimeoutSpin_,
+                               attrTimeoutSpin_, aliveIntervalSpin_, aliveCountSpin_}) {
+            connect(spin, static_cast<void(QSpinBox::*)(int)>(&QSpinBox::valueChanged), this, markCustom);
+        }
+        
         auto* btnBox = new QHBoxLayout();
         auto* okBtn = new QPushButton("OK", this);
         auto* cancelBtn = new QPushButton("Cancel", this);
@@ -138,10 +265,53 @@ public:
         btnBox->addWidget(cancelBtn);
         layout->addRow(btnBox);
         
-        connect(okBtn, &QPushButton::clicked, this, &QDialog::accept);
+        connect(okBtn, &QPushButton::clicked, this, [this]() {
+            QStringList errors = profile().validate();
+            if (!errors.isEmpty()) {
+                QMessageBox::warning(this, "Invalid Performance Options", errors.join("\n"));
+                return;
+            }
+            accept();
+        });
         connect(cancelBtn, &QPushButton::clicked, this, &QDialog::reject);
     }
     
+    void setProfile(const SSHFSProfile& p) {
+        updatingProfile_ = true;
+        profileCombo_->setCurrentText(p.name);
+        ciphersEdit_->setText(p.ciphers);
+        compressionCheck_->setChecked(p.compression);
+        kernelCacheCheck_->setChecked(p.kernelCache);
+        maxConnsSpin_->setValue(p.maxConns);
+        maxReadSpin_->setValue(p.maxRead / 1024);
+        maxWriteSpin_->setValue(p.maxWrite / 1024);
+        cacheTimeoutSpin_->setValue(p.cacheTimeout);
+        attrTimeoutSpin_->setValue(p.attrTimeout);
+        aliveIntervalSpin_->setValue(p.serverAliveInterval);
+        aliveCountSpin_->setValue(p.serverAliveCountMax);
+        extraEdit_->setText(p.extraOptions);
+        updatingProfile_ = false;
+    }
+    
+    SSHFSProfile profile() const {
+        SSHFSProfile p;
+        p.name = profileCombo_->currentText();
+        p.ciphers = ciphersEdit_->text().trimmed();
+        p.compression = compressionCheck_->isChecked();
+        p.kernelCache = kernelCacheCheck_->isChecked();
+        p.maxConns = maxConnsSpin_->value();
+        p.maxRead = maxReadSpin_->value() * 1024;
+        p.maxWrite = maxWriteSpin_->value() * 1024;
+        p.cacheTimeout = cacheTimeoutSpin_->value();
+        p.attrTimeout = attrTimeoutSpin_->value();
+        p.serverAliveInterval = aliveIntervalSpin_->value();
+        p.serverAliveCountMax = aliveCountSpin_->value();
+        p.extraOptions = extraEdit_->text().trimmed();
+        // A preset name only sticks while the values still match it
+        if (p.isPreset() && p != SSHFSProfile::preset(p.name)) p.name = SSHFSProfile::CustomName;
+        return p;
+    }
+    
     SSHHost getHost() const {
         SSHHost h;
         h.name = nameEdit_->text();
@@ -151,6 +321,11 @@ public:
         h.remotePath = remoteEdit_->text();
         h.localPath = localEdit_->text();
         h.usePublicKey = pubkeyCheck_->isChecked();
+        h.favorite = favoriteCheck_->isChecked();
+        h.controlPersist = persistSpin_->value();
+        h.lazyMount = lazyCheck_->isChecked();
+        h.idleUnmountMinutes = idleSpin_->value();
+        h.profile = profile();
         return h;
     }
     
@@ -162,6 +337,129 @@ private:
     QLineEdit* remoteEdit_;
     QLineEdit* localEdit_;
     QCheckBox* pubkeyCheck_;
+    QCheckBox* favoriteCheck_;
+    QSpinBox* persistSpin_;
+    QCheckBox* lazyCheck_;
+    QSpinBox* idleSpin_;
+    QComboBox* profileCombo_;
+    QLineEdit* ciphersEdit_;
+    QCheckBox* compressionCheck_;
+    QCheckBox* kernelCacheCheck_;
+    QSpinBox* maxConnsSpin_;
+    QSpinBox* maxReadSpin_;
+    QSpinBox* maxWriteSpin_;
+    QSpinBox* cacheTimeoutSpin_;
+    QSpinBox* attrTimeoutSpin_;
+    QSpinBox* aliveIntervalSpin_;
+    QSpinBox* aliveCountSpin_;
+    QLineEdit* extraEdit_;
+    bool updatingProfile_ = false;
+};
+
+// Benchmark dialog: runs MountBenchmark against the selected hosts or a
+// throwaway local sshd and shows the JSON results
+class BenchmarkDialog : public QDialog {
+public:
+    BenchmarkDialog(const QList<SSHHost>& hosts, QWidget* parent = nullptr)
+        : QDialog(parent), hosts_(hosts) {
+        setWindowTitle("Benchmark");
+        setMinimumSize(520, 480);
+        auto* layout = new QVBoxLayout(this);
+        
+        auto* target = new QGroupBox("Target", this);
+        auto* targetLayout = new QVBoxLayout(target);
+        loopbackRadio_ = new QRadioButton("Local test server (sshd on 127.0.0.1)", target);
+        selectedRadio_ = new QRadioButton(QString("Selected hosts (%1)").arg(hosts.size()), target);
+        targetLayout->addWidget(loopbackRadio_);
+        targetLayout->addWidget(selectedRadio_);
+        selectedRadio_->setEnabled(!hosts.isEmpty());
+        (hosts.isEmpty() ? loopbackRadio_ : selectedRadio_)->setChecked(true);
+        layout->addWidget(target);
+        
+        auto* profiles = new QGroupBox("Profiles", this);
+        auto* profilesLayout = new QVBoxLayout(profiles);
+        for (const QString& name : SSHFSProfile::presetNames()) {
+            auto* check = new QCheckBox(name, profiles);
+            check->setChecked(name == SSHFSProfile::DefaultName);
+            profilesLayout->addWidget(check);
+            profileChecks_.append(check);
+        }
+        layout->addWidget(profiles);
+        
+        statusLabel_ = new QLabel("Idle", this);
+        layout->addWidget(statusLabel_);
+        output_ = new QPlainTextEdit(this);
+        output_->setReadOnly(true);
+        layout->addWidget(output_, 1);
+        
+        auto* btnBox = new QHBoxLayout();
+        runBtn_ = new QPushButton("Run", this);
+        saveBtn_ = new QPushButton("Save JSON...", this);
+        closeBtn_ = new QPushButton("Close", this);
+        saveBtn_->setEnabled(false);
+        btnBox->addStretch();
+        btnBox->addWidget(runBtn_);
+        btnBox->addWidget(saveBtn_);
+        btnBox->addWidget(closeBtn_);
+        layout->addLayout(btnBox);
+        
+        bench_ = new MountBenchmark(BenchmarkConfig(), this);
+        connect(bench_, &MountBenchmark::progress, statusLabel_, &QLabel::setText);
+        connect(bench_, &MountBenchmark::finished, this, [this](const QJsonArray& results) {
+            results_ = results;
+            output_->setPlainText(QString::fromUtf8(QJsonDocument(results).toJson(QJsonDocument::Indented)));
+            setRunning(false);
+        });
+        connect(runBtn_, &QPushButton::clicked, this, [this]() {
+            QStringList profiles;
+            for (QCheckBox* check : profileChecks_) {
+                if (check->isChecked()) profiles << check->text();
+            }
+            if (profiles.isEmpty()) {
+                QMessageBox::warning(this, "Benchmark", "Select at least one profile");
+                return;
+            }
+            output_->clear();
+            setRunning(true);
+            if (loopbackRadio_->isChecked()) bench_->runLoopback(profiles);
+            else bench_->run(hosts_, profiles);
+        });
+        connect(saveBtn_, &QPushButton::clicked, this, [this]() {
+            QString path = QFileDialog::getSaveFileName(this, "Save Results", "benchmark.json", "JSON (*.json)");
+            if (path.isEmpty()) return;
+            QFile file(path);
+            if (!file.open(QIODevice::WriteOnly) ||
+                file.write(QJsonDocument(results_).toJson(QJsonDocument::Indented)) < 0) {
+                QMessageBox::warning(this, "Benchmark", "Cannot write " + path);
+            }
+        });
+        connect(closeBtn_, &QPushButton::clicked, this, &QDialog::reject);
+    }
+    
+    void reject() override {
+        // A run owns a live mount; let it finish and unmount first
+        if (bench_->isRunning()) return;
+        QDialog::reject();
+    }
+    
+private:
+    void setRunning(bool running) {
+        runBtn_->setEnabled(!running);
+        closeBtn_->setEnabled(!running);
+        saveBtn_->setEnabled(!running && !results_.isEmpty());
+    }
+    
+    QList<SSHHost> hosts_;
+    QRadioButton* loopbackRadio_;
+    QRadioButton* selectedRadio_;
+    QList<QCheckBox*> profileChecks_;
+    QLabel* statusLabel_;
+    QPlainTextEdit* output_;
+    QPushButton* runBtn_;
+    QPushButton* saveBtn_;
+    QPushButton* closeBtn_;
+    MountBenchmark* bench_;
+    QJsonArray results_;
 };
 
 // Main window
@@ -184,67 +482,197 @@ public:
         spinner_->hide();
         statusLayout->addWidget(spinner_);
         statusLayout->addStretch();
+        statusLayout->addWidget(new QLabel("Parallel:", this));
+        parallelSpin_ = new QSpinBox(this);
+        parallelSpin_->setRange(1, 64);
+        parallelSpin_->setValue(8);
+        parallelSpin_->setToolTip("Maximum number of mounts running at the same time");
+        statusLayout->addWidget(parallelSpin_);
         mainLayout->addLayout(statusLayout);
         
-        // Host list
-        hostList_ = new QListWidget(this);
+        // Search box
+        searchEdit_ = new QLineEdit(this);
+        searchEdit_->setPlaceholderText("Search hosts...");
+        searchEdit_->setClearButtonEnabled(true);
+        mainLayout->addWidget(searchEdit_);
+        
+        // Host list; rows all have the same height, so the view can lay
+        // out and paint only what is on screen without asking every row
+        hostList_ = new QListView(this);
+        hostList_->setSelectionMode(QAbstractItemView::ExtendedSelection);
+        hostList_->setUniformItemSizes(true);
         mainLayout->addWidget(hostList_, 1);
         
         // Buttons
         auto* btnLayout = new QHBoxLayout();
         addBtn_ = new QPushButton("Add Host", this);
+        importBtn_ = new QPushButton("Import...", this);
+        importBtn_->setToolTip("Add hosts from an ssh config, CSV or JSON file");
         editBtn_ = new QPushButton("Edit", this);
         removeBtn_ = new QPushButton("Remove", this);
         mountBtn_ = new QPushButton("Mount", this);
         unmountBtn_ = new QPushButton("Unmount", this);
+        mountAllBtn_ = new QPushButton("Mount All", this);
+        unmountAllBtn_ = new QPushButton("Unmount All", this);
+        unmountAllBtn_->setToolTip("Unmount everything now; busy or dead mounts are detached");
+        benchmarkBtn_ = new QPushButton("Benchmark", this);
         
         btnLayout->addWidget(addBtn_);
+        btnLayout->addWidget(importBtn_);
         btnLayout->addWidget(editBtn_);
         btnLayout->addWidget(removeBtn_);
         btnLayout->addStretch();
         btnLayout->addWidget(mountBtn_);
         btnLayout->addWidget(unmountBtn_);
+        btnLayout->addWidget(mountAllBtn_);
+        btnLayout->addWidget(unmountAllBtn_);
+        btnLayout->addWidget(benchmarkBtn_);
         mainLayout->addLayout(btnLayout);
 
         store_ = new SSHStore(this);
-        mounter_ = new SSHMounter(this);
-        process_ = nullptr;
-        mounts_ = nullptr;
-        
-        checkSystemRequirements();
+        manager_ = new MountManager(this);
+        watcher_ = new MountWatcher(this);
+        manager_->setMaxConcurrent(parallelSpin_->value());
+        supervisor_ = new MountSupervisor(store_, watcher_, manager_, this);
+        lazy_ = new LazyMounter(store_, watcher_, manager_, supervisor_, this);
+        model_ = new HostListModel(store_, watcher_, manager_, this);
+        model_->setSupervisor(supervisor_);
+        hostList_->setModel(model_);
+        connect(searchEdit_, &QLineEdit::textChanged, model_, &HostListModel::setFilter);
+        promptingPassword_ = false;
+        hostsLoaded_ = false;
+        setupMetrics();
+        setupControl();
         
-        if (!store_->load()) {
-            QMessageBox::warning(this, "Error", "Failed to load hosts");
-        }
-        refreshHostList();
+        // Nothing that touches the disk or spawns processes runs here; the
+        // window paints first and fills in as each startup stage finishes.
+        statusLabel_->setText("Loading hosts...");
+        setHostButtonsEnabled(false);
+        startup_ = new StartupPipeline(store_->getFilePath(), this);
+        connect(startup_, &StartupPipeline::capabilitiesReady, this, &MainWindow::checkSystemRequirements);
+        connect(startup_, &StartupPipeline::hostsReady, this, &MainWindow::onHostsLoaded);
+        connect(startup_, &StartupPipeline::mountTableReady, this, &MainWindow::onMountTableLoaded);
+        startup_->start();
         
         // Connect signals
         connect(addBtn_, &QPushButton::clicked, this, &MainWindow::addHost);
+        connect(importBtn_, &QPushButton::clicked, this, &MainWindow::importHosts);
         connect(editBtn_, &QPushButton::clicked, this, &MainWindow::editHost);
         connect(removeBtn_, &QPushButton::clicked, this, &MainWindow::removeHost);
         connect(mountBtn_, &QPushButton::clicked, this, &MainWindow::mountHost);
         connect(unmountBtn_, &QPushButton::clicked, this, &MainWindow::unmountHost);
-        connect(hostList_, &QListWidget::currentRowChanged, this, &MainWindow::onClickHost);
-        connect(mounter_, &SSHMounter::stateChanged, this, &MainWindow::onMountStateChanged);
-        connect(mounter_, &SSHMounter::mountSuccess, this, &MainWindow::onMountSuccess);
-        connect(mounter_, &SSHMounter::mountError, this, &MainWindow::onMountError);
-        connect(mounter_, &SSHMounter::progressMessage, this, &MainWindow::textHandler);
-        connect(mounter_, &SSHMounter::passwordRequired, this, &MainWindow::onPasswordRequired);
-        connect(mounter_, &SSHMounter::hostKeyMismatch, this, &MainWindow::onHostKeyMismatch);
+        connect(mountAllBtn_, &QPushButton::clicked, this, &MainWindow::mountAllHosts);
+        connect(unmountAllBtn_, &QPushButton::clicked, this, [this]() {
+            const QList<SSHHost> mounted = mountedHosts();
+            if (mounted.isEmpty()) {
+                showCheckmark("Nothing is mounted ✓");
+                return;
+            }
+            startBatch(mounted.size());
+            manager_->unmountAll(mounted, bulkUnmountOptions());
+        });
+        connect(benchmarkBtn_, &QPushButton::clicked, this, &MainWindow::showBenchmark);
+        connect(parallelSpin_, static_cast<void(QSpinBox::*)(int)>(&QSpinBox::valueChanged),
+                manager_, &MountManager::setMaxConcurrent);
+        connect(hostList_->selectionModel(), &QItemSelectionModel::currentRowChanged, this,
+                [this](const QModelIndex& current) { onClickHost(model_->storeRow(current.row())); });
+        // Keep the watcher in step with the store one host at a time
+        connect(store_, &SSHStore::hostsReset, this, [this]() { watcher_->setHosts(store_->hosts()); });
+        connect(store_, &SSHStore::hostAdded, this, &MainWindow::onHostEdited);
+        connect(store_, &SSHStore::hostUpdated, this, &MainWindow::onHostEdited);
+        connect(store_, &SSHStore::hostRemoved, watcher_, &MountWatcher::unwatchHost);
+        connect(store_, &SSHStore::reloaded, this, [this](int changes) {
+            statusLabel_->setText(QString("Hosts file changed elsewhere: %1 host(s) updated").arg(changes));
+        });
+        connect(manager_, &MountManager::hostBusyChanged, this, &MainWindow::onMountStateChanged);
+        connect(manager_, &MountManager::hostStateChanged, this, &MainWindow::onMountStateChanged);
+        connect(watcher_, &MountWatcher::hostMountChanged, this, &MainWindow::onHostMountChanged);
+        connect(supervisor_, &MountSupervisor::recovering, manager_->metrics(), &MountMetrics::recordReconnect);
+        connect(supervisor_, &MountSupervisor::recovering, this, [this](const QString& key, int attempt, int delayMs) {
+            statusLabel_->setText(QString("%1: connection lost, reconnecting in %2 s (attempt %3)")
+                .arg(store_->byId(key) ? store_->byId(key)->name : key).arg(delayMs / 1000).arg(attempt));
+        });
+        connect(manager_, &MountManager::busyChanged, this, &MainWindow::onBusyChanged);
+        connect(manager_, &MountManager::batchFinished, this, &MainWindow::onBatchFinished);
+        connect(manager_, &MountManager::hostMountSuccess, this, &MainWindow::onMountSuccess);
+        connect(manager_, &MountManager::hostUnmountSuccess, this, &MainWindow::onUnmountSuccess);
+        connect(manager_, &MountManager::hostMountError, this, &MainWindow::onMountError);
+        connect(manager_, &MountManager::hostProgressMessage, this, &MainWindow::textHandler);
+        // Queued so that a modal prompt never runs inside a session's slot
+        connect(manager_, &MountManager::hostPasswordRequired, this, &MainWindow::onPasswordRequired, Qt::QueuedConnection);
+        connect(manager_, &MountManager::hostKeyMismatch, this, &MainWindow::onHostKeyMismatch, Qt::QueuedConnection);
         
         console.log("Application started");
     }
     
 protected:
+    bool event(QEvent* e) override {
+        if (e->type() == QEvent::Paint && startup_) startup_->markFirstPaint();
+        return QMainWindow::event(e);
+    }
+    
     void closeEvent(QCloseEvent* event) override {
-        if (!store_->save()) {
-            int ret = QMessageBox::warning(this, "Save Error", 
-                "Failed to save hosts. Quit anyway?",
-                QMessageBox::Yes | QMessageBox::No);
-            if (ret == QMessageBox::No) {
-                event->ignore();
-                return;
-            }
+        // Still unmounting from an earlier close; that one finishes the job
+        if (quitting_ && !quitReady_) {
+            event->ignore();
+            return;
+        }
+        
+        // Questions are asked with open(), never exec(): the close is
+        // refused for now and the answer closes the window again
+        if (quitBox_) {
+            event->ignore();
+            quitBox_->raise();
+            quitBox_->activateWindow();
+            return;
+        }
+        
+        // Saving before the store was loaded would wipe hosts.json
+        if (!quitUnsaved_ && hostsLoaded_ && !store_->save()) {
+            event->ignore();
+            auto* box = new QMessageBox(QMessageBox::Warning, "Save Error",
+                "Failed to save hosts. Quit anyway?", QMessageBox::Yes | QMessageBox::No, this);
+            box->setAttribute(Qt::WA_DeleteOnClose);
+            connect(box, &QMessageBox::finished, this, [this](int result) {
+                quitBox_ = nullptr;
+                if (result != QMessageBox::Yes) return;
+                quitUnsaved_ = true;
+                close();
+            });
+            quitBox_ = box;
+            box->open();
+            return;
+        }
+        
+        // sshfs outlives the app; ask whether the mounts should too
+        const QList<SSHHost> mounted = mountedHosts();
+        if (!quitReady_ && !quitKeepMounted_ && !mounted.isEmpty()) {
+            event->ignore();
+            auto* box = new QMessageBox(QMessageBox::Question, "Quit",
+                QString("%1 host(s) are still mounted.").arg(mounted.size()), QMessageBox::NoButton, this);
+            box->setAttribute(Qt::WA_DeleteOnClose);
+            QPushButton* unmountBtn = box->addButton("Unmount and Quit", QMessageBox::AcceptRole);
+            QPushButton* keepBtn = box->addButton("Quit, Keep Mounted", QMessageBox::DestructiveRole);
+            box->addButton(QMessageBox::Cancel);
+            box->setDefaultButton(unmountBtn);
+            connect(box, &QMessageBox::finished, this, [this, box, unmountBtn, keepBtn]() {
+                quitBox_ = nullptr;
+                if (box->clickedButton() == keepBtn) {
+                    quitKeepMounted_ = true;
+                    close();
+                } else if (box->clickedButton() == unmountBtn) {
+                    // Whatever is mounted by now, not when the question was asked
+                    const QList<SSHHost> hosts = mountedHosts();
+                    if (hosts.isEmpty()) close();
+                    else unmountAndQuit(hosts);
+                } else {
+                    // Not quitting after all; the next close asks again
+                    quitUnsaved_ = false;
+                }
+            });
+            quitBox_ = box;
+            box->open();
+            return;
         }
         console.log("Application closed");
         event->accept();
@@ -256,46 +684,85 @@ private slots:
         if (dlg.exec() == QDialog::Accepted) {
             SSHHost host = dlg.getHost();
             store_->addHost(host);
-            refreshHostList();
             showCheckmark("Host added ✓");
         }
     }
     
-    void textHandler(const QString &text) {
+    void importHosts() {
+        const QStringList files = QFileDialog::getOpenFileNames(this, "Import Hosts", QDir::homePath() + "/.ssh",
+            "Host inventories (config *.conf *.csv *.tsv *.json *.jsonl);;All files (*)");
+        if (files.isEmpty()) return;
+        importBtn_->setEnabled(false);
+        statusLabel_->setText("Importing hosts...");
+        
+        // Parsing a large inventory would stall the window
+        QPointer<MainWindow> self(this);
+        QThreadPool::globalInstance()->start([self, files]() {
+            HostImporter importer;
+            QString error;
+            for (const QString& file : files) {
+                if (!importer.importFile(file, ImportFormat::Auto, error)) break;
+            }
+            QMetaObject::invokeMethod(QCoreApplication::instance(), [self, importer, error]() mutable {
+                if (self) self->onHostsImported(importer, error);
+            }, Qt::QueuedConnection);
+        });
+    }
+    
+    void onHostsImported(HostImporter& importer, const QString& error) {
+        importBtn_->setEnabled(hostsLoaded_);
+        if (!error.isEmpty()) {
+            statusLabel_->setText("Import failed");
+            QMessageBox::warning(this, "Import Hosts", error);
+            return;
+        }
+        const int existing = importer.skipExisting(*store_);
+        // One reset for the list, however many hosts
+        store_->addHosts(importer.hosts());
+        QString text = QString("Imported %1 host(s)").arg(importer.hosts().size());
+        if (existing + importer.duplicates() > 0) {
+            text += QString(", skipped %1 already saved").arg(existing + importer.duplicates());
+        }
+        if (importer.warningCount() > 0) {
+            text += QString(", %1 warning(s)").arg(importer.warningCount());
+            for (const QString& warning : importer.warnings()) console.warn(warning.toStdString());
+        }
+        statusLabel_->setText(text);
+        if (!importer.hosts().isEmpty()) showCheckmark("Hosts imported ✓");
+    }
+    
+    void textHandler(const QString& key, const QString &text) {
+        Q_UNUSED(key);
         MainWindow::statusLabel_->setText(text);
         if (text.contains("Connecting")) {
             spinner_->show();
         }
-        else spinner_->hide();
     }
 
     void editHost() {
-        int idx = hostList_->currentRow();
+        int idx = currentRow();
         if (idx < 0) return;
         
-        SSHHost host = store_->getHosts()[idx];
-        HostDialog dlg(this, &host);
+        const QString id = store_->at(idx).id;
+        HostDialog dlg(this, &store_->at(idx));
         if (dlg.exec() == QDialog::Accepted) {
-            store_->updateHost(idx, dlg.getHost());
-            refreshHostList();
+            store_->updateHost(id, dlg.getHost());
             showCheckmark("Host updated ✓");
         }
     }
 
     void onClickHost(int currentRow) {
         if (!store_) return;
-        if (currentRow < 0) return;
-        SSHHost host = store_->getHosts()[currentRow];
-        if (!mounts_) mountListUpdate();
-        bool mounted = false;
-        for (const QString& mount : *mounts_) {
-            QString text = QString("%1@%2:%3").arg(host.user).arg(host.host).arg(host.remotePath);
-            if (mount.contains(text)) {
-                mounted = true;
-                break;
-            }
-        };
-        if (mounted) {
+        if (currentRow < 0 || currentRow >= store_->count()) return;
+        const SSHHost& host = store_->at(currentRow);
+        
+        bool busy = manager_->isBusy(MountManager::keyFor(host));
+        mountBtn_->setEnabled(!busy);
+        unmountBtn_->setEnabled(!busy);
+        editBtn_->setEnabled(!busy);
+        removeBtn_->setEnabled(!busy);
+        
+        if (watcher_->isMounted(MountManager::keyFor(host))) {
             mountBtn_->hide();
             unmountBtn_->show();
         }
@@ -305,183 +772,524 @@ private slots:
         }
     }
 
-    void onPasswordRequired() {
-        bool ok;
-        int id = hostList_->currentRow();
-        if (id < 0) return;
-
-        SSHHost host = store_->getHosts()[id];
-
-        QString password = QInputDialog::getText(this, QString("Login to %1@%2").arg(host.user).arg(host.host), QString("Authentication is required to SSH into %1@%2").arg(host.user).arg(host.host), QLineEdit::Password, QString(), &ok);
-
-        if (ok && !password.isEmpty()) {
-            mounter_->supplyPassword(password);
-        }
-        else {
-            statusLabel_->setText("Cancelled.");
-            mounter_->setState(MountState::Idle);
-            mounter_->noPassword();
+    void onPasswordRequired(const QString& key) {
+        // Several sessions may ask at once; prompt for one host at a time.
+        if (!pendingPasswords_.contains(key)) pendingPasswords_.enqueue(key);
+        if (!promptingPassword_) showNextPasswordPrompt();
+    }
+    
+    void showNextPasswordPrompt() {
+        if (pendingPasswords_.isEmpty()) {
+            promptingPassword_ = false;
+            return;
         }
+        promptingPassword_ = true;
+        QString key = pendingPasswords_.dequeue();
+        SSHHost host = manager_->host(key);
+        
+        // open() instead of exec(): the prompt must not spin a nested
+        // event loop while other mounts are still in flight.
+        auto* dlg = new QInputDialog(this);
+        dlg->setAttribute(Qt::WA_DeleteOnClose);
+        dlg->setWindowTitle(QString("Login to %1@%2").arg(host.user).arg(host.host));
+        dlg->setLabelText(QString("Authentication is required to SSH into %1@%2").arg(host.user).arg(host.host));
+        dlg->setTextEchoMode(QLineEdit::Password);
+        connect(dlg, &QDialog::finished, this, [this, dlg, key](int result) {
+            QString password = dlg->textValue();
+            if (result == QDialog::Accepted && !password.isEmpty()) {
+                manager_->supplyPassword(key, password);
+            }
+            else {
+                statusLabel_->setText("Cancelled.");
+                manager_->noPassword(key);
+            }
+            showNextPasswordPrompt();
+        });
+        dlg->open();
     }
 
-    void onHostKeyMismatch() {
-        int ret = QMessageBox::warning(this, "Host Key Mismatch", 
-            "The host key for " + mounter_->getCurrentHost().host + " has changed!\n"
+    void onHostKeyMismatch(const QString& key) {
+        auto* box = new QMessageBox(QMessageBox::Warning, "Host Key Mismatch",
+            "The host key for " + manager_->host(key).host + " has changed!\n"
             "This could be a sign of a man-in-the-middle attack.\n\n"
             "Do you want to remove the old key and reconnect?",
-            QMessageBox::Yes | QMessageBox::No);
-        
-        if (ret == QMessageBox::Yes) {
-            mounter_->removeHostKey();
-        }
-        else {
-            statusLabel_->setText("Cancelled.");
-            mounter_->setState(MountState::Idle);
-        }
+            QMessageBox::Yes | QMessageBox::No, this);
+        box->setAttribute(Qt::WA_DeleteOnClose);
+        connect(box, &QMessageBox::finished, this, [this, key](int result) {
+            if (result == QMessageBox::Yes) {
+                manager_->removeHostKey(key);
+            }
+            else {
+                statusLabel_->setText("Cancelled.");
+                manager_->keepHostKey(key);
+            }
+        });
+        box->open();
     }
     
     void removeHost() {
-        int idx = hostList_->currentRow();
+        int idx = currentRow();
         if (idx < 0) return;
         
-        store_->removeHost(idx);
-        refreshHostList();
+        store_->removeHost(store_->at(idx).id);
         showCheckmark("Host removed ✓");
     }
     
+    QList<SSHHost> selectedHosts() const {
+        QList<SSHHost> selected;
+        for (const QModelIndex& index : hostList_->selectionModel()->selectedRows()) {
+            int row = model_->storeRow(index.row());
+            if (row >= 0) selected.append(store_->at(row));
+        }
+        return selected;
+    }
+    
     void mountHost() {
-        int idx = hostList_->currentRow();
-        if (idx < 0) {
+        QList<SSHHost> hosts = selectedHosts();
+        if (hosts.isEmpty()) {
             QMessageBox::warning(this, "Error", "Please select a host");
             return;
         }
         
-        SSHHost host = store_->getHosts()[idx];
-        if (mounter_->mount(host)) mountListUpdate();
+        mountChecked(hosts);
+    }
+    
+    void mountAllHosts() {
+        if (store_->count() == 0) return;
+        
+        QList<SSHHost> unmounted;
+        for (const auto& host : store_->hosts()) {
+            if (!watcher_->isMounted(MountManager::keyFor(host))) unmounted.append(host);
+        }
+        if (unmounted.isEmpty()) {
+            showCheckmark("All hosts are already mounted ✓");
+            return;
+        }
+        
+        mountChecked(unmounted);
+    }
+    
+    // Host keys are checked for the whole batch first, so it never stops
+    // halfway for a key prompt: keys of new hosts are recorded, changed
+    // ones are shown together in one question
+    void mountChecked(const QList<SSHHost>& hosts) {
+        startBatch(hosts.size());
+        statusLabel_->setText("Checking host keys...");
+        onBusyChanged(true);
+        manager_->hostKeys()->scan(hosts, this, [this, hosts](const HostKeyScanner::Results& checks) {
+            // Nothing is trusted without the user seeing its fingerprint
+            QList<HostKeyCheck> unconfirmed;
+            QSet<QString> skip;
+            QStringList errors;
+            QStringList changedLines, newLines;
+            for (const SSHHost& host : hosts) {
+                const QString key = MountManager::keyFor(host);
+                const HostKeyCheck check = checks.value(key);
+                if (check.status == HostKeyStatus::Revoked) {
+                    skip.insert(key);
+                    errors << host.name + ": The server's host key has been revoked";
+                    continue;
+                }
+                if (check.status != HostKeyStatus::Changed && check.status != HostKeyStatus::New) continue;
+                skip.insert(key);
+                bool listed = false;
+                for (const HostKeyCheck& other : unconfirmed) listed = listed || other.token == check.token;
+                if (!listed) unconfirmed.append(check);
+                QStringList prints;
+                for (const HostKey& offered : check.offered) prints << offered.type + " " + offered.fingerprint();
+                const QString line = QString("%1 (%2):\n    %3").arg(host.name, check.token, prints.join("\n    "));
+                (check.status == HostKeyStatus::Changed ? changedLines : newLines) << line;
+            }
+            if (unconfirmed.isEmpty()) {
+                mountExcept(hosts, skip, errors);
+                return;
+            }
+            
+            QString text;
+            if (!changedLines.isEmpty()) {
+                text += QString("The host key has changed for %1 host(s):\n\n%2\n\n"
+                                "This could be a sign of a man-in-the-middle attack. "
+                                "Only replace the stored keys if you expected the change.")
+                            .arg(changedLines.size()).arg(changedLines.join("\n"));
+            }
+            if (!newLines.isEmpty()) {
+                if (!text.isEmpty()) text += "\n\n";
+                text += QString("%1 host(s) have not been connected to before:\n\n%2\n\n"
+                                "Compare the fingerprints with the ones the servers' administrators publish.")
+                            .arg(newLines.size()).arg(newLines.join("\n"));
+            }
+            const bool changed = !changedLines.isEmpty();
+            auto* box = new QMessageBox(changed ? QMessageBox::Warning : QMessageBox::Question,
+                changed ? "Host Keys Changed" : "Unknown Host Keys", text, QMessageBox::NoButton, this);
+            QPushButton* trustBtn = box->addButton(changed ? "Replace Keys and Mount" : "Trust and Mount",
+                changed ? QMessageBox::DestructiveRole : QMessageBox::AcceptRole);
+            QPushButton* othersBtn = box->addButton("Mount the Others", QMessageBox::AcceptRole);
+            box->addButton(QMessageBox::Cancel);
+            box->setDefaultButton(changed ? othersBtn : trustBtn);
+            box->setAttribute(Qt::WA_DeleteOnClose);
+            connect(box, &QMessageBox::finished, this, [=]() {
+                if (box->clickedButton() == trustBtn) {
+                    manager_->hostKeys()->accept(unconfirmed, this, [=](const QStringList& failures) {
+                        QSet<QString> stillSkip = skip;
+                        for (const HostKeyCheck& check : unconfirmed) {
+                            bool failed = false;
+                            for (const QString& failure : failures) failed = failed || failure.startsWith(check.token + ": ");
+                            if (failed) continue;
+                            for (auto it = checks.constBegin(); it != checks.constEnd(); ++it) {
+                                if (it->token == check.token) stillSkip.remove(it.key());
+                            }
+                        }
+                        mountExcept(hosts, stillSkip, errors + failures);
+                    });
+                } else if (box->clickedButton() == othersBtn) {
+                    QStringList skipped = errors;
+                    for (const SSHHost& host : hosts) {
+                        const HostKeyStatus status = checks.value(MountManager::keyFor(host)).status;
+                        if (status == HostKeyStatus::Changed) {
+                            skipped << host.name + ": Host key has changed; not mounted";
+                        } else if (status == HostKeyStatus::New) {
+                            skipped << host.name + ": Host key not confirmed; not mounted";
+                        }
+                    }
+                    mountExcept(hosts, skip, skipped);
+                } else {
+                    mountExcept({}, {}, {});
+                    statusLabel_->setText("Cancelled.");
+                }
+            });
+            box->open();
+        });
+    }
+    
+    void mountExcept(const QList<SSHHost>& hosts, const QSet<QString>& skip, const QStringList& errors) {
+        QList<SSHHost> todo;
+        for (const SSHHost& host : hosts) {
+            if (!skip.contains(MountManager::keyFor(host))) todo.append(host);
+        }
+        if (todo.isEmpty()) {
+            batchSize_ = 0;
+            onBusyChanged(manager_->isBusy());
+            statusLabel_->clear();
+            if (!errors.isEmpty()) QMessageBox::warning(this, "Mount Errors", errors.join("\n"));
+            return;
+        }
+        // Reported with the rest of the batch once it is done
+        batchErrors_ << errors;
+        manager_->mountAll(todo);
     }
     
     void unmountHost() {
-        int idx = hostList_->currentRow();
-        if (idx < 0) {
+        QList<SSHHost> hosts = selectedHosts();
+        if (hosts.isEmpty()) {
             QMessageBox::warning(this, "Error", "Please select a host");
             return;
         }
         
-        SSHHost host = store_->getHosts()[idx];
-        mounter_->unmount(host.localPath);
-        mountListUpdate();
+        startBatch(hosts.size());
+        manager_->unmountAll(hosts);
+    }
+    
+    void showBenchmark() {
+        auto* dlg = new BenchmarkDialog(selectedHosts(), this);
+        dlg->setAttribute(Qt::WA_DeleteOnClose);
+        dlg->open();
+    }
+    
+    QList<SSHHost> mountedHosts() const {
+        QList<SSHHost> mounted;
+        for (const auto& host : store_->hosts()) {
+            if (watcher_->isMounted(MountManager::keyFor(host))) mounted.append(host);
+        }
+        return mounted;
     }
     
-    void onMountStateChanged(MountState state) {
-        bool busy = (state == MountState::Mounting || state == MountState::Unmounting);
+    // Each attempt gets a few seconds: fusermount -u, -uz, then kill sshfs
+    static UnmountOptions bulkUnmountOptions() {
+        UnmountOptions options;
+        options.stepTimeoutMs = 3000;
+        options.escalate = true;
+        return options;
+    }
+    
+    // Quits once every unmount has finished, or after QuitDeadlineMs anyway
+    void unmountAndQuit(const QList<SSHHost>& hosts) {
+        static const int QuitDeadlineMs = 15000;
+        quitting_ = true;
+        setHostButtonsEnabled(false);
+        statusLabel_->setText(QString("Unmounting %1 host(s) before quitting...").arg(hosts.size()));
+        manager_->cancelQueued();
         
+        for (const auto& host : hosts) quitPending_.insert(MountManager::keyFor(host));
+        connect(manager_, &MountManager::hostBusyChanged, this, [this](const QString& key, bool busy) {
+            if (busy || !quitPending_.remove(key)) return;
+            if (quitPending_.isEmpty()) finishQuit();
+        });
+        QTimer::singleShot(QuitDeadlineMs, this, &MainWindow::finishQuit);
+        manager_->unmountAll(hosts, bulkUnmountOptions());
+    }
+    
+    void finishQuit() {
+        if (quitReady_) return;
+        quitReady_ = true;
+        const QList<SSHHost> left = mountedHosts();
+        for (const auto& host : left) {
+            console.warn("Still mounted at quit:", host.name.toStdString(), host.localPath.toStdString());
+        }
+        close();
+    }
+    
+    void startBatch(int size) {
+        batchSize_ = size;
+        batchErrors_.clear();
+        batchTimer_.start();
+    }
+    
+    void onMountStateChanged(const QString& key) {
+        int row = currentRow();
+        if (row >= 0 && row == store_->indexOf(key)) {
+            onClickHost(row);
+        }
+    }
+    
+    void onBusyChanged(bool busy) {
         if (busy) {
+            spinner_->show();
             spinner_->start();
         } else {
             spinner_->stop();
             spinner_->hide();
         }
-        
-        // Disable buttons during operations
-        mountBtn_->setEnabled(!busy);
-        unmountBtn_->setEnabled(!busy);
-        addBtn_->setEnabled(!busy);
-        editBtn_->setEnabled(!busy);
-        removeBtn_->setEnabled(!busy);
+        mountAllBtn_->setEnabled(!busy && !quitting_);
     }
     
-    void mountListUpdate() {
-        if (process_) delete process_;
-        if (mounts_) delete mounts_;
-        mounts_ = new QStringList();
-        process_ = new QProcess(this);
-        QEventLoop loop;
-        connect(process_, static_cast<void(QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished), &loop, &QEventLoop::quit);
-        connect(process_, &QProcess::errorOccurred, &loop, &QEventLoop::quit);
-        connect(process_, &QProcess::readyReadStandardOutput, this, &MainWindow::onProcessOutput);
-        connect(process_, &QProcess::readyReadStandardError, this, &MainWindow::onProcessOutput);
+    void onBatchFinished(int succeeded, int failed) {
+        if (quitting_) return;
+        if (batchSize_ > 1) {
+            QString summary = QString("%1 succeeded, %2 failed in %3 s")
+                .arg(succeeded).arg(failed)
+                .arg(batchTimer_.elapsed() / 1000.0, 0, 'f', 1);
+            if (batchErrors_.isEmpty()) {
+                showCheckmark("Done: " + summary + " ✓");
+            } else {
+                statusLabel_->setText("Done: " + summary);
+                QMessageBox::warning(this, "Mount Errors", batchErrors_.join("\n"));
+            }
+        }
+        batchSize_ = 0;
+        batchErrors_.clear();
+    }
     
-        process_->start("mount");
-        loop.exec();
+    void onHostMountChanged(const QString& key) {
+        onMountStateChanged(key);
     }
 
-    void onProcessOutput() {
-        QString output = process_->readAllStandardOutput();
-        QString errors = process_->readAllStandardError();
-        if (errors.contains("not found")) {
-            mounts_->append("none");
-        }
-        else {
-            for (const QString& mount : output.split("\n")) {
-                if (mount.trimmed() != "") mounts_->append(mount);
-            }
-        };
+    void onMountSuccess(const QString& key) {
+        showCheckmark(manager_->host(key).name + " mounted successfully ✓");
     }
-
-    void onMountSuccess() {
-        showCheckmark("Mounted successfully ✓");
-        mountBtn_->hide();
-        unmountBtn_->show();
+    
+    void onUnmountSuccess(const QString& key) {
+        showCheckmark(manager_->host(key).name + " unmounted ✓");
     }
     
-    void onMountError(const QString& error) {
+    void onMountError(const QString& key, const QString& error) {
+        QString name = manager_->host(key).name;
         statusLabel_->setText("Error: " + error);
-        QMessageBox::critical(this, "Mount Error", error);
+        // Background reconnects retry on their own; the row shows progress
+        if (supervisor_->status(key).recovering) return;
+        // Quitting: logged, and the window is about to go away
+        if (quitting_) return;
+        if (batchSize_ > 1) {
+            // Collected and shown once the whole batch is done
+            batchErrors_ << name + ": " + error;
+            return;
+        }
+        QMessageBox::critical(this, "Mount Error", name.isEmpty() ? error : name + ": " + error);
     }
     
     void showCheckmark(const QString& msg) {
         statusLabel_->setText(msg);
-        QTimer::singleShot(2000, [this](){ statusLabel_->setText("Ready"); mounter_->setState(MountState::Idle); });
+        QTimer::singleShot(2000, this, [this](){
+            if (!manager_->isBusy()) statusLabel_->setText("Ready");
+        });
     }
     
-    void refreshHostList() {
-        hostList_->clear();
-        for (const auto& host : store_->getHosts()) {
-            QString text = QString("%1 (%2@%3)")
-                .arg(host.name)
-                .arg(host.user)
-                .arg(host.host);
-            hostList_->addItem(text);
+    void onHostEdited(const QString& id) {
+        const SSHHost* host = store_->byId(id);
+        if (!host) return;
+        watcher_->watchHost(*host);
+        if (host->favorite) manager_->masters()->warm(*host);
+    }
+    
+    // Store row of the current host; view rows differ while filtered
+    int currentRow() const {
+        return model_->storeRow(hostList_->currentIndex().row());
+    }
+    
+    void checkSystemRequirements(const Capabilities& caps) {
+        QStringList issues = caps.issues();
+        if (!issues.isEmpty()) {
+            auto* box = new QMessageBox(QMessageBox::Warning, "System Requirements", 
+                "Some requirements are missing:\n" + issues.join("\n") +
+                "\n\nThe application may not work correctly.",
+                QMessageBox::Ok, this);
+            box->setAttribute(Qt::WA_DeleteOnClose);
+            box->open();
         }
     }
     
-    void checkSystemRequirements() {
-        QStringList issues;
-        
-        if (!SSHMounter::checkSSHFSInstalled()) {
-            issues << "sshfs is not installed";
+    void onHostsLoaded(const QVector<SSHHost>& hosts, const QString& error) {
+        if (!error.isEmpty()) {
+            console.error(error.toStdString());
+            statusLabel_->setText("Error: " + error);
+            QMessageBox::warning(this, "Error", "Failed to load hosts");
+            return;
         }
-        if (!SSHMounter::checkFUSEAvailable()) {
-            issues << "FUSE is not available";
+        store_->setHosts(hosts);
+        hostsLoaded_ = true;
+        // Only now: an earlier autosave would overwrite the unread file
+        store_->setJournalEnabled(true);
+        store_->setAutosave(true);
+        store_->startWatching();
+        setHostButtonsEnabled(true);
+        statusLabel_->setText("Ready");
+        manager_->masters()->warmFavorites(store_->hosts());
+    }
+    
+    void onMountTableLoaded(const MountTable& table) {
+        watcher_->seed(table);
+        watcher_->start();
+        // Per-host mount state for whatever the store already holds
+        if (hostsLoaded_) watcher_->setHosts(store_->hosts());
+        // Arms only paths the table says are unmounted
+        lazy_->start();
+    }
+    
+    // Opt-in export for local monitoring:
+    //   SSH_MOUNTER_METRICS_LISTEN=unix[:PATH] | [127.0.0.1:]PORT
+    //   SSH_MOUNTER_METRICS_FILE=PATH (Prometheus text, rewritten every 15 s)
+    void setupMetrics() {
+        const QString listen = qEnvironmentVariable("SSH_MOUNTER_METRICS_LISTEN");
+        if (!listen.isEmpty()) {
+            auto* server = new MetricsServer(manager_->metrics(), this);
+            QString error;
+            if (!server->listen(listen, error)) {
+                console.warn("Metrics endpoint disabled:", error.toStdString());
+                delete server;
+            }
         }
-        
-        if (!issues.isEmpty()) {
-            QMessageBox::warning(this, "System Requirements", 
-                "Some requirements are missing:\n" + issues.join("\n") +
-                "\n\nThe application may not work correctly.");
+        const QString file = qEnvironmentVariable("SSH_MOUNTER_METRICS_FILE");
+        if (!file.isEmpty()) manager_->metrics()->setSnapshotFile(file);
+    }
+    
+    // Line-delimited JSON for local tooling, see ControlServer
+    void setupControl() {
+        if (!ControlServer::enabled()) return;
+        auto* control = new ControlServer(store_, watcher_, manager_, supervisor_, this);
+        QString error;
+        if (!control->listen(error)) {
+            console.warn("Control socket disabled:", error.toStdString());
+            delete control;
+            return;
         }
+        connect(control, &ControlServer::showRequested, this, [this]() {
+            showNormal();
+            raise();
+            activateWindow();
+        });
+    }
+    
+    void setHostButtonsEnabled(bool enabled) {
+        addBtn_->setEnabled(enabled);
+        importBtn_->setEnabled(enabled);
+        editBtn_->setEnabled(enabled);
+        removeBtn_->setEnabled(enabled);
+        mountBtn_->setEnabled(enabled);
+        unmountBtn_->setEnabled(enabled);
+        mountAllBtn_->setEnabled(enabled);
+        unmountAllBtn_->setEnabled(enabled);
     }
     
 private:
-    QListWidget* hostList_;
+    QLineEdit* searchEdit_;
+    QListView* hostList_;
+    HostListModel* model_;
     QPushButton* addBtn_;
+    QPushButton* importBtn_;
     QPushButton* editBtn_;
     QPushButton* removeBtn_;
     QPushButton* mountBtn_;
     QPushButton* unmountBtn_;
+    QPushButton* mountAllBtn_;
+    QPushButton* unmountAllBtn_;
+    QPushButton* benchmarkBtn_;
+    QSpinBox* parallelSpin_;
     QLabel* statusLabel_;
     SpinnerWidget* spinner_;
-    QProcess* process_;
     SSHStore* store_;
-    SSHMounter* mounter_;
-    QStringList* mounts_;
+    MountManager* manager_;
+    MountWatcher* watcher_;
+    MountSupervisor* supervisor_;
+    LazyMounter* lazy_;
+    StartupPipeline* startup_ = nullptr;
+    bool hostsLoaded_;
+    QQueue<QString> pendingPasswords_;
+    bool promptingPassword_;
+    int batchSize_ = 0;
+    QStringList batchErrors_;
+    QElapsedTimer batchTimer_;
+    bool quitting_ = false;
+    bool quitReady_ = false;
+    QPointer<QMessageBox> quitBox_;     // Save or mounts question on close
+    bool quitUnsaved_ = false;          // Said yes to quitting without saving
+    bool quitKeepMounted_ = false;      // Said quit and keep the mounts
+    QSet<QString> quitPending_;
 };
 
 int main(int argc, char** argv) {
+    StartupPipeline::clock().start();
+    
+    // Optional persistent log, rotated at 4 MiB
+    if (const char* logFile = getenv("SSH_MOUNTER_LOG_FILE")) {
+        if (*logFile) console.setLogFile(logFile);
+    }
+    
+    // Scripted mount/unmount/status; no window, no display needed
+    if (HeadlessRunner::wanted(argc, argv)) {
+        QCoreApplication app(argc, argv);
+        return HeadlessRunner::runCli(app);
+    }
+    
+    // Requests to the running instance over its control socket
+    if (ControlServer::wanted(argc, argv)) {
+        QCoreApplication app(argc, argv);
+        return ControlServer::runCli(app);
+    }
+    
+    // Bulk host import from ssh config, CSV or JSON
+    if (HostImporter::wanted(argc, argv)) {
+        QCoreApplication app(argc, argv);
+        return HostImporter::runCli(app);
+    }
+    
+    // Command line benchmark; no window, no display needed
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--benchmark") == 0) {
+            QCoreApplication app(argc, argv);
+            return MountBenchmark::runCli(app);
+        }
+    }
+    
+    // One window per user: a second start brings the first one forward
+    if (ControlServer::enabled() && ControlServer::request("{\"cmd\":\"show\"}")) {
+        console.info("SSH Mounter is already running; showing its window.");
+        console.flush();
+        return 0;
+    }
+    
     QApplication app(argc, argv);
     MainWindow win;
     win.show();
-    console.info("[INFO] ", CLR_RESET, "Application started.");
+    console.info("Application started.");
     return app.exec();
 }
 
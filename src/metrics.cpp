@@ -0,0 +1,576 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#include "metrics.hpp"
+#include "mount_manager.hpp"
+#include "runtime_dir.hpp"
+#include "console.hpp"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSocketNotifier>
+#include <QThreadPool>
+#include <QTimer>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+extern Console console;
+
+// ---------------------------------------------------------------------------
+// LatencyHistogram
+
+int LatencyHistogram::bucketFor(quint64 micros) {
+    if (micros < quint64(SubCount)) return int(micros);
+    micros = qMin(micros, (quint64(1) << MaxBits) - 1);
+    int msb = 63 - __builtin_clzll(micros);
+    int shift = msb - SubBits + 1;
+    int sub = int(micros >> shift);          // HalfCount .. SubCount-1
+    return SubCount + (shift - 1) * HalfCount + (sub - HalfCount);
+}
+
+quint64 LatencyHistogram::upperBound(int bucket) {
+    if (bucket < SubCount) return quint64(bucket);
+    int shift = (bucket - SubCount) / HalfCount + 1;
+    quint64 sub = quint64((bucket - SubCount) % HalfCount + HalfCount);
+    return ((sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(qint64 micros) {
+    if (micros < 0) return;
+    ++counts_[bucketFor(quint64(micros))];
+    min_ = count_ ? qMin(min_, micros) : micros;
+    max_ = qMax(max_, micros);
+    sum_ += micros;
+    ++count_;
+}
+
+qint64 LatencyHistogram::percentile(double q) const {
+    if (count_ == 0) return 0;
+    quint64 rank = quint64(qBound(0.0, q, 1.0) * double(count_) + 0.5);
+    rank = qBound<quint64>(1, rank, count_);
+    quint64 seen = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+        seen += counts_[i];
+        if (seen >= rank) return qMin(qint64(upperBound(i)), max_);
+    }
+    return max_;
+}
+
+quint64 LatencyHistogram::countAtOrBelow(qint64 micros) const {
+    if (micros < 0) return 0;
+    // Buckets that straddle the bound are counted in full, which can only
+    // overstate by the bucket width (about 3%).
+    const int last = bucketFor(quint64(micros));
+    quint64 n = 0;
+    for (int i = 0; i <= last; ++i) n += counts_[i];
+    return n;
+}
+
+// ---------------------------------------------------------------------------
+// Prometheus text helpers
+
+namespace {
+
+const char* const Prefix = "ssh_mounter_";
+
+// Bucket bounds in seconds; mounts range from a few ms over a shared
+// connection to tens of seconds behind a password prompt.
+const double Bounds[] = {0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 30, 60};
+const double Quantiles[] = {0.5, 0.9, 0.99};
+
+QByteArray escapeLabel(const QString& value) {
+    QByteArray out = value.toUtf8();
+    out.replace('\\', "\\\\").replace('"', "\\\"").replace('\n', "\\n");
+    return out;
+}
+
+QByteArray seconds(qint64 micros) {
+    return QByteArray::number(double(micros) / 1e6, 'g', 9);
+}
+
+// {a="b",c="d"}, or nothing for no labels
+QByteArray labels(const QList<QPair<QByteArray, QString>>& pairs) {
+    if (pairs.isEmpty()) return QByteArray();
+    QByteArray out = "{";
+    for (int i = 0; i < pairs.size(); ++i) {
+        if (i) out += ',';
+        out += pairs[i].first + "=\"" + escapeLabel(pairs[i].second) + '"';
+    }
+    return out + '}';
+}
+
+void header(QByteArray& out, const char* name, const char* type, const char* help) {
+    out += QByteArray("# HELP ") + Prefix + name + ' ' + help + '\n';
+    out += QByteArray("# TYPE ") + Prefix + name + ' ' + type + '\n';
+}
+
+void histogram(QByteArray& out, const char* name, const LatencyHistogram& h,
+               QList<QPair<QByteArray, QString>> base = {}) {
+    const QByteArray metric = QByteArray(Prefix) + name;
+    for (double bound : Bounds) {
+        auto withLe = base;
+        withLe.append({"le", QString::number(bound)});
+        out += metric + "_bucket" + labels(withLe) + ' ' +
+               QByteArray::number(h.countAtOrBelow(qint64(bound * 1e6))) + '\n';
+    }
+    auto inf = base;
+    inf.append({"le", "+Inf"});
+    out += metric + "_bucket" + labels(inf) + ' ' + QByteArray::number(h.count()) + '\n';
+    out += metric + "_sum" + labels(base) + ' ' + seconds(h.sum()) + '\n';
+    out += metric + "_count" + labels(base) + ' ' + QByteArray::number(h.count()) + '\n';
+}
+
+void counterMap(QByteArray& out, const char* name, const QByteArray& label,
+                const QMap<QString, quint64>& values, QList<QPair<QByteArray, QString>> base = {}) {
+    for (auto it = values.constBegin(); it != values.constEnd(); ++it) {
+        auto l = base;
+        l.append({label, it.key()});
+        out += QByteArray(Prefix) + name + labels(l) + ' ' + QByteArray::number(it.value()) + '\n';
+    }
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// MountMetrics
+
+MountMetrics::MountMetrics(QObject* parent)
+    : QObject(parent), reconnects_(0), snapshotTimer_(nullptr), dirty_(false) {
+}
+
+MountMetrics::~MountMetrics() {
+    // Last word on exit; small enough to write in place
+    if (dirty_ && !snapshotPath_.isEmpty()) writeSnapshot(true);
+}
+
+QString MountMetrics::failureCause(const QString& error) {
+    // SSHMounter puts its own summary on the first line; the rest is raw
+    // ssh output that may mention more than one thing.
+    const QString first = error.section('\n', 0, 0);
+    for (const QString& text : {first, error}) {
+        if (text.contains("Permission denied", Qt::CaseInsensitive) ||
+            text.contains("Authentication failed", Qt::CaseInsensitive)) return "auth";
+        if (text.contains("Connection refused", Qt::CaseInsensitive)) return "refused";
+        if (text.contains("timed out", Qt::CaseInsensitive)) return "timeout";
+        if (text.contains("resolve", Qt::CaseInsensitive) ||
+            text.contains("Name or service not known", Qt::CaseInsensitive)) return "dns";
+        if (text.contains("No route to host", Qt::CaseInsensitive) ||
+            text.contains("unreachable", Qt::CaseInsensitive)) return "unreachable";
+        if (text.contains("host key", Qt::CaseInsensitive) ||
+            text.contains("HOST IDENTIFICATION", Qt::CaseInsensitive)) return "host_key";
+        if (text.contains("Connection closed", Qt::CaseInsensitive) ||
+            text.contains("Connection reset", Qt::CaseInsensitive)) return "lost";
+        if (text.contains("Failed to start", Qt::CaseInsensitive)) return "spawn";
+        if (text.contains("Invalid performance profile") || text.contains("directory", Qt::CaseInsensitive) ||
+            text.contains("permission for", Qt::CaseInsensitive) ||
+            text.contains("not empty", Qt::CaseInsensitive)) return "local";
+    }
+    return "other";
+}
+
+MountMetrics::HostMetrics& MountMetrics::hostMetrics(const SSHHost& host) {
+    HostMetrics& m = hosts_[MountManager::keyFor(host)];
+    m.name = host.name.isEmpty() ? host.host : host.name;
+    dirty_ = true;
+    return m;
+}
+
+void MountMetrics::recordPhase(const QString& phase, qint64 fromMs, qint64 toMs) {
+    if (fromMs < 0 || toMs < fromMs) return;
+    phases_[phase].record((toMs - fromMs) * 1000);
+}
+
+void MountMetrics::recordPhases(const MountTrace& t) {
+    recordPhase("path_check", 0, t.pathChecked);
+    recordPhase("master_check", t.pathChecked, t.masterChecked);
+    const qint64 launch = t.masterChecked >= 0 ? t.masterChecked : t.pathChecked;
+    recordPhase("spawn", launch, t.spawned);
+    recordPhase("password_prompt", t.spawned, t.prompted);
+    recordPhase("password_wait", t.prompted, t.answered);
+    // Connect, key exchange, authentication and FUSE start all happen
+    // inside sshfs; from the outside they are one phase, minus the time
+    // the user spent typing the password.
+    if (t.spawned >= 0 && t.finished >= t.spawned) {
+        qint64 waited = t.prompted >= 0 && t.answered >= t.prompted ? t.answered - t.prompted : 0;
+        phases_["handshake"].record(qMax<qint64>(0, t.finished - t.spawned - waited) * 1000);
+    }
+}
+
+void MountMetrics::recordQueueWait(qint64 ms) {
+    phases_["queue"].record(ms * 1000);
+    dirty_ = true;
+}
+
+void MountMetrics::recordMount(const SSHHost& host, const MountTrace& trace) {
+    HostMetrics& m = hostMetrics(host);
+    const qint64 micros = qMax<qint64>(0, trace.finished) * 1000;
+    mount_.record(micros);
+    m.mount.record(micros);
+    m.lastMountMs = trace.finished;
+    m.lastSuccess = QDateTime::currentSecsSinceEpoch();
+    ++m.results["ok"];
+    ++mountResults_["ok"];
+    recordPhases(trace);
+}
+
+void MountMetrics::recordMountFailure(const SSHHost& host, const MountTrace& trace, const QString& error) {
+    HostMetrics& m = hostMetrics(host);
+    const QString cause = failureCause(error);
+    ++m.results["error"];
+    ++m.causes[cause];
+    ++mountResults_["error"];
+    ++causes_[cause];
+    recordPhases(trace);
+}
+
+void MountMetrics::recordCancelled(const SSHHost& host) {
+    ++hostMetrics(host).results["cancelled"];
+    ++mountResults_["cancelled"];
+}
+
+void MountMetrics::recordUnmount(const SSHHost& host, const MountTrace& trace, bool ok) {
+    HostMetrics& m = hostMetrics(host);
+    ++unmountResults_[ok ? "ok" : "error"];
+    if (!ok) return;
+    const qint64 micros = qMax<qint64>(0, trace.finished) * 1000;
+    unmount_.record(micros);
+    m.unmount.record(micros);
+}
+
+void MountMetrics::recordReconnect(const QString& key) {
+    auto it = hosts_.find(key);
+    if (it != hosts_.end()) ++it->reconnects;
+    ++reconnects_;
+    dirty_ = true;
+}
+
+QByteArray MountMetrics::prometheusText() const {
+    QByteArray out;
+    out.reserve(16384);
+
+    header(out, "mounts_total", "counter", "Mount attempts by result");
+    counterMap(out, "mounts_total", "result", mountResults_);
+    header(out, "unmounts_total", "counter", "Unmount attempts by result");
+    counterMap(out, "unmounts_total", "result", unmountResults_);
+    header(out, "mount_failures_total", "counter", "Failed mounts by cause");
+    counterMap(out, "mount_failures_total", "cause", causes_);
+    header(out, "reconnects_total", "counter", "Automatic remounts after a stale or dead mount");
+    out += QByteArray(Prefix) + "reconnects_total " + QByteArray::number(reconnects_) + '\n';
+
+    header(out, "mount_duration_seconds", "histogram", "Time from starting a mount until it was ready");
+    histogram(out, "mount_duration_seconds", mount_);
+    header(out, "unmount_duration_seconds", "histogram", "Time to unmount");
+    histogram(out, "unmount_duration_seconds", unmount_);
+    header(out, "mount_duration_quantile_seconds", "gauge", "Mount latency quantiles from the full-resolution histogram");
+    for (double q : Quantiles) {
+        out += QByteArray(Prefix) + "mount_duration_quantile_seconds" +
+               labels({{"quantile", QString::number(q)}}) + ' ' + seconds(mount_.percentile(q)) + '\n';
+    }
+    header(out, "mount_phase_seconds", "histogram", "Time spent in each phase of a mount");
+    for (auto it = phases_.constBegin(); it != phases_.constEnd(); ++it) {
+        histogram(out, "mount_phase_seconds", it.value(), {{"phase", it.key()}});
+    }
+
+    // Hosts in a stable order so snapshots diff cleanly
+    QMap<QString, const HostMetrics*> byName;
+    for (auto it = hosts_.constBegin(); it != hosts_.constEnd(); ++it) {
+        byName.insert(it->name + '\n' + it.key(), &it.value());
+    }
+
+    header(out, "host_mounts_total", "counter", "Mount attempts per host by result");
+    for (const HostMetrics* m : byName) counterMap(out, "host_mounts_total", "result", m->results, {{"host", m->name}});
+    header(out, "host_mount_failures_total", "counter", "Failed mounts per host by cause");
+    for (const HostMetrics* m : byName) counterMap(out, "host_mount_failures_total", "cause", m->causes, {{"host", m->name}});
+    header(out, "host_reconnects_total", "counter", "Automatic remounts per host");
+    for (const HostMetrics* m : byName) {
+        out += QByteArray(Prefix) + "host_reconnects_total" + labels({{"host", m->name}}) + ' ' +
+               QByteArray::number(m->reconnects) + '\n';
+    }
+    header(out, "host_last_success_timestamp_seconds", "gauge", "Unix time of the last successful mount");
+    for (const HostMetrics* m : byName) {
+        if (m->lastSuccess == 0) continue;
+        out += QByteArray(Prefix) + "host_last_success_timestamp_seconds" + labels({{"host", m->name}}) + ' ' +
+               QByteArray::number(m->lastSuccess) + '\n';
+    }
+    header(out, "host_mount_duration_seconds", "histogram", "Mount latency per host");
+    for (const HostMetrics* m : byName) {
+        if (m->mount.count()) histogram(out, "host_mount_duration_seconds", m->mount, {{"host", m->name}});
+    }
+    header(out, "host_unmount_duration_seconds", "histogram", "Unmount latency per host");
+    for (const HostMetrics* m : byName) {
+        if (m->unmount.count()) histogram(out, "host_unmount_duration_seconds", m->unmount, {{"host", m->name}});
+    }
+    return out;
+}
+
+void MountMetrics::setSnapshotFile(const QString& path, int intervalMs) {
+    snapshotPath_ = path;
+    if (!snapshotTimer_) {
+        snapshotTimer_ = new QTimer(this);
+        connect(snapshotTimer_, &QTimer::timeout, this, [this]() {
+            if (dirty_) writeSnapshot(false);
+        });
+    }
+    snapshotTimer_->start(qMax(1000, intervalMs));
+    writeSnapshot(false);
+}
+
+void MountMetrics::writeSnapshot(bool wait) {
+    dirty_ = false;
+    const QString path = snapshotPath_;
+    const QByteArray text = prometheusText();
+    auto write = [path, text]() {
+        QDir().mkpath(QFileInfo(path).absolutePath());
+        QSaveFile file(path);
+        if (!file.open(QIODevice::WriteOnly) || file.write(text) != text.size() || !file.commit()) {
+            console.warn("Could not write metrics snapshot", path.toStdString());
+        }
+    };
+    if (wait) write();
+    else QThreadPool::globalInstance()->start(write);
+}
+
+// ---------------------------------------------------------------------------
+// MetricsServer
+
+MetricsServer::MetricsServer(MountMetrics* metrics, QObject* parent)
+    : QObject(parent), metrics_(metrics), fd_(-1), notifier_(nullptr), nextSerial_(1) {
+}
+
+MetricsServer::~MetricsServer() {
+    for (int fd : clients_.keys()) dropClient(fd);
+    if (fd_ >= 0) ::close(fd_);
+    if (!socketPath_.isEmpty()) QFile::remove(socketPath_);
+}
+
+QString MetricsServer::defaultSocketPath() {
+    return RuntimeDir::path() + "/metrics.sock";
+}
+
+bool MetricsServer::listen(const QString& spec, QString& error) {
+    if (fd_ >= 0) {
+        error = "Already listening on " + address_;
+        return false;
+    }
+
+    if (spec == "unix" || spec.startsWith("unix:")) {
+        QString path = spec.mid(5);
+        if (path.isEmpty()) path = defaultSocketPath();
+        // Only our own directory is created; a given path's must exist
+        if (QFileInfo(path).absolutePath() == RuntimeDir::path() && !RuntimeDir::ensure(error)) return false;
+
+        sockaddr_un addr = {};
+        addr.sun_family = AF_UNIX;
+        const QByteArray native = QFile::encodeName(path);
+        if (native.size() >= int(sizeof(addr.sun_path))) {
+            error = "Socket path too long: " + path;
+            return false;
+        }
+        memcpy(addr.sun_path, native.constData(), native.size());
+
+        fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        // A socket left behind by a crashed instance would block bind()
+        ::unlink(native.constData());
+        if (fd_ < 0 || ::bind(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            error = QString("Cannot bind %1: %2").arg(path, strerror(errno));
+            if (fd_ >= 0) ::close(fd_);
+            fd_ = -1;
+            return false;
+        }
+        ::chmod(native.constData(), 0600);
+        socketPath_ = path;
+        address_ = "unix:" + path;
+    } else {
+        QString host = "127.0.0.1";
+        QString portText = spec;
+        if (spec.contains(':')) {
+            host = spec.section(':', 0, -2);
+            portText = spec.section(':', -1);
+        }
+        bool ok = false;
+        int port = portText.toInt(&ok);
+        if (!ok || port < 1 || port > 65535) {
+            error = "Invalid metrics address: " + spec;
+            return false;
+        }
+        if (host != "127.0.0.1" && host != "localhost") {
+            error = "Metrics are only served on 127.0.0.1, not " + host;
+            return false;
+        }
+
+        fd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        int one = 1;
+        if (fd_ >= 0) ::setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(quint16(port));
+        if (fd_ < 0 || ::bind(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            error = QString("Cannot bind 127.0.0.1:%1: %2").arg(port).arg(strerror(errno));
+            if (fd_ >= 0) ::close(fd_);
+            fd_ = -1;
+            return false;
+        }
+        address_ = QString("127.0.0.1:%1").arg(port);
+    }
+
+    if (::listen(fd_, 16) != 0) {
+        error = QString("Cannot listen on %1: %2").arg(address_, strerror(errno));
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+
+    notifier_ = new QSocketNotifier(fd_, QSocketNotifier::Read, this);
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    connect(notifier_, &QSocketNotifier::activated, this, &MetricsServer::onAccept);
+#else
+    connect(notifier_, SIGNAL(activated(int)), this, SLOT(onAccept()));
+#endif
+    console.info("Serving metrics on", address_.toStdString());
+    return true;
+}
+
+void MetricsServer::onAccept() {
+    for (;;) {
+        int fd = ::accept4(fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;
+        if (clients_.size() >= 32) {
+            ::close(fd);
+            continue;
+        }
+
+        Client& client = clients_[fd];
+        const quint64 serial = nextSerial_++;
+        client.serial = serial;
+        client.reader = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+        client.writer = new QSocketNotifier(fd, QSocketNotifier::Write, this);
+        client.writer->setEnabled(false);
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+        connect(client.reader, &QSocketNotifier::activated, this, [this, fd]() { onClientReadable(fd); });
+        connect(client.writer, &QSocketNotifier::activated, this, [this, fd]() { onClientWritable(fd); });
+#else
+        connect(client.reader, SIGNAL(activated(int)), this, SLOT(onClientReadable(int)));
+        connect(client.writer, SIGNAL(activated(int)), this, SLOT(onClientWritable(int)));
+#endif
+        // A client that sends nothing (socat, nc) gets the text anyway
+        QTimer::singleShot(250, this, [this, fd, serial]() {
+            auto it = clients_.constFind(fd);
+            if (it != clients_.constEnd() && it->serial == serial) respond(fd);
+        });
+    }
+}
+
+void MetricsServer::onClientReadable(int fd) {
+    auto it = clients_.find(fd);
+    if (it == clients_.end()) return;
+
+    char buf[2048];
+    ssize_t n = ::read(fd, buf, sizeof(buf));
+    if (n < 0 && (errno == EAGAIN || errno == EINTR)) return;
+    if (n > 0) it->request.append(buf, int(n));
+
+    const QByteArray& req = it->request;
+    const bool http = req.startsWith("GET ") || req.startsWith("HEAD ");
+    const bool complete = n <= 0 || req.size() > 8192 ||
+        (http ? req.contains("\r\n\r\n") || req.contains("\n\n") : req.contains('\n'));
+    if (complete) respond(fd);
+}
+
+void MetricsServer::respond(int fd) {
+    auto it = clients_.find(fd);
+    // Both the request and the 250 ms timer end up here
+    if (it == clients_.end() || it->responded) return;
+
+    const QByteArray body = metrics_->prometheusText();
+    QByteArray reply;
+    const QByteArray& req = it->request;
+    if (req.startsWith("GET ") || req.startsWith("HEAD ")) {
+        reply = "HTTP/1.0 200 OK\r\n"
+                "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                "Content-Length: " + QByteArray::number(body.size()) + "\r\n"
+                "Connection: close\r\n\r\n";
+        if (req.startsWith("GET ")) reply += body;
+    } else {
+        reply = body;
+    }
+
+    // Sent as the socket takes it, from the write notifier; a scraper
+    // that stops reading is cut off after a second
+    it->responded = true;
+    it->out = reply;
+    it->reader->setEnabled(false);
+    const quint64 serial = it->serial;
+    QTimer::singleShot(1000, this, [this, fd, serial]() {
+        auto it = clients_.constFind(fd);
+        if (it != clients_.constEnd() && it->serial == serial) dropClient(fd);
+    });
+    flush(fd);
+}
+
+void MetricsServer::onClientWritable(int fd) {
+    flush(fd);
+}
+
+void MetricsServer::flush(int fd) {
+    auto it = clients_.find(fd);
+    if (it == clients_.end()) return;
+
+    int sent = 0;
+    while (sent < it->out.size()) {
+        ssize_t n = ::send(fd, it->out.constData() + sent, size_t(it->out.size() - sent),
+                           MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n > 0) {
+            sent += int(n);
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && errno == EAGAIN) {
+            break;
+        } else {
+            dropClient(fd);
+            return;
+        }
+    }
+    it->out.remove(0, sent);
+
+    // One reply per connection; done once it is out
+    if (it->out.isEmpty()) {
+        dropClient(fd);
+        return;
+    }
+    it->writer->setEnabled(true);
+}
+
+void MetricsServer::dropClient(int fd) {
+    auto it = clients_.find(fd);
+    if (it == clients_.end()) return;
+    // Usually called from inside a notifier's own activated()
+    for (QSocketNotifier* n : {it->reader, it->writer}) {
+        n->setEnabled(false);
+        n->deleteLater();
+    }
+    clients_.erase(it);
+    ::close(fd);
+}
+
+#include "metrics.moc"
@@ -0,0 +1,159 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#pragma once
+
+#include "ssh_store.hpp"
+#include "ssh_mounter.hpp"
+#include <QByteArray>
+#include <QHash>
+#include <QMap>
+#include <QObject>
+#include <QString>
+#include <array>
+
+class QSocketNotifier;
+class QTimer;
+
+// Log-linear latency histogram in the style of HdrHistogram: 32 linear
+// sub-buckets per power of two, so any recorded value is known to within
+// about 3% from 1 us up to 19 hours, in a fixed 4 KiB of counters.
+class LatencyHistogram {
+public:
+    void record(qint64 micros);
+
+    quint64 count() const { return count_; }
+    qint64 sum() const { return sum_; }
+    qint64 min() const { return count_ ? min_ : 0; }
+    qint64 max() const { return max_; }
+
+    // Upper bound of the bucket holding the q-th quantile (0..1)
+    qint64 percentile(double q) const;
+    quint64 countAtOrBelow(qint64 micros) const;
+
+private:
+    static constexpr int SubBits = 5;
+    static constexpr int SubCount = 1 << SubBits;
+    static constexpr int HalfCount = SubCount / 2;
+    static constexpr int MaxBits = 36;
+    static constexpr int BucketCount = SubCount + (MaxBits - SubBits) * HalfCount;
+
+    static int bucketFor(quint64 micros);
+    static quint64 upperBound(int bucket);
+
+    std::array<quint64, BucketCount> counts_ {};
+    quint64 count_ = 0;
+    qint64 sum_ = 0;
+    qint64 min_ = 0;
+    qint64 max_ = 0;
+};
+
+// Counters and latency histograms for mounts and unmounts, fed from each
+// session's MountTrace by MountManager. Rendered as Prometheus text for
+// MetricsServer and, optionally, a snapshot file rewritten periodically.
+class MountMetrics : public QObject {
+    Q_OBJECT
+public:
+    explicit MountMetrics(QObject* parent = nullptr);
+    ~MountMetrics() override;
+
+    void recordQueueWait(qint64 ms);
+    void recordMount(const SSHHost& host, const MountTrace& trace);
+    void recordMountFailure(const SSHHost& host, const MountTrace& trace, const QString& error);
+    void recordCancelled(const SSHHost& host);
+    void recordUnmount(const SSHHost& host, const MountTrace& trace, bool ok);
+    void recordReconnect(const QString& key);
+
+    // Short label for the failures_total{cause=...} counters
+    static QString failureCause(const QString& error);
+
+    QByteArray prometheusText() const;
+
+    // Rewrites path (atomically, off the UI thread) when something changed
+    void setSnapshotFile(const QString& path, int intervalMs = 15000);
+
+private:
+    struct HostMetrics {
+        QString name;
+        LatencyHistogram mount;
+        LatencyHistogram unmount;
+        QMap<QString, quint64> results;     // ok / error / cancelled
+        QMap<QString, quint64> causes;
+        quint64 reconnects = 0;
+        qint64 lastMountMs = -1;
+        qint64 lastSuccess = 0;             // Unix time
+    };
+
+    HostMetrics& hostMetrics(const SSHHost& host);
+    void recordPhases(const MountTrace& trace);
+    void recordPhase(const QString& phase, qint64 fromMs, qint64 toMs);
+    void writeSnapshot(bool wait);
+
+    LatencyHistogram mount_;
+    LatencyHistogram unmount_;
+    QMap<QString, LatencyHistogram> phases_;
+    QMap<QString, quint64> mountResults_;
+    QMap<QString, quint64> unmountResults_;
+    QMap<QString, quint64> causes_;
+    quint64 reconnects_;
+    QHash<QString, HostMetrics> hosts_;
+    QString snapshotPath_;
+    QTimer* snapshotTimer_;
+    bool dirty_;
+};
+
+// Serves MountMetrics::prometheusText() to local scrapers, over a Unix
+// socket or a loopback TCP port. Answers HTTP GETs, and plain clients
+// (socat, nc) get the bare text.
+class MetricsServer : public QObject {
+    Q_OBJECT
+public:
+    explicit MetricsServer(MountMetrics* metrics, QObject* parent = nullptr);
+    ~MetricsServer() override;
+
+    // "unix", "unix:PATH", "PORT" or "127.0.0.1:PORT"; nothing else is
+    // accepted, the endpoint never leaves this machine.
+    bool listen(const QString& spec, QString& error);
+    QString address() const { return address_; }
+
+    static QString defaultSocketPath();
+
+private slots:
+    void onAccept();
+    void onClientReadable(int fd);
+    void onClientWritable(int fd);
+
+private:
+    struct Client {
+        QSocketNotifier* reader = nullptr;
+        QSocketNotifier* writer = nullptr;
+        QByteArray request;
+        QByteArray out;         // Reply not yet sent
+        bool responded = false;
+        quint64 serial = 0;     // fds are reused; timers check this
+    };
+
+    void respond(int fd);
+    void flush(int fd);
+    void dropClient(int fd);
+
+    MountMetrics* metrics_;
+    int fd_;
+    QSocketNotifier* notifier_;
+    QString address_;
+    QString socketPath_;
+    QHash<int, Client> clients_;
+    quint64 nextSerial_;
+};
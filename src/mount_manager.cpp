@@ -0,0 +1,254 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#include "mount_manager.hpp"
+#include "metrics.hpp"
+#include "console.hpp"
+
+extern Console console;
+
+MountManager::MountManager(QObject* parent)
+    : QObject(parent), masters_(new SSHMasterPool(this)), reach_(new Reachability(this)),
+      hostKeys_(new HostKeyScanner(this)), metrics_(new MountMetrics(this)),
+      maxConcurrent_(8),
+      batchSucceeded_(0), batchFailed_(0), pumping_(false) {
+}
+
+QString MountManager::keyFor(const SSHHost& host) {
+    // Hosts that never went through SSHStore have no ID; two mounts can
+    // never share a mount point, so that identifies them instead.
+    return host.id.isEmpty() ? host.localPath : host.id;
+}
+
+void MountManager::setMaxConcurrent(int limit) {
+    maxConcurrent_ = qMax(1, limit);
+    pump();
+}
+
+SSHMounter* MountManager::session(const SSHHost& host) {
+    const QString key = keyFor(host);
+    hosts_[key] = host;
+
+    auto it = sessions_.find(key);
+    if (it != sessions_.end()) {
+        return it.value();
+    }
+
+    auto* s = new SSHMounter(this);
+    s->setMasterPool(masters_);
+    s->setReachability(reach_);
+    sessions_.insert(key, s);
+
+    connect(s, &SSHMounter::stateChanged, this, [this, key](MountState state) {
+        emit hostStateChanged(key, state);
+    });
+    connect(s, &SSHMounter::mountSuccess, this, [this, key, s]() {
+        metrics_->recordMount(hosts_.value(key), s->trace());
+        emit hostMountSuccess(key);
+        finishJob(key, true);
+    });
+    connect(s, &SSHMounter::unmountSuccess, this, [this, key, s]() {
+        metrics_->recordUnmount(hosts_.value(key), s->trace(), true);
+        emit hostUnmountSuccess(key);
+        finishJob(key, true);
+    });
+    connect(s, &SSHMounter::mountError, this, [this, key, s](const QString& error) {
+        // Also reports failed unmounts
+        if (s->trace().unmount) metrics_->recordUnmount(hosts_.value(key), s->trace(), false);
+        else metrics_->recordMountFailure(hosts_.value(key), s->trace(), error);
+        emit hostMountError(key, error);
+        finishJob(key, false);
+    });
+    connect(s, &SSHMounter::mountCancelled, this, [this, key]() {
+        metrics_->recordCancelled(hosts_.value(key));
+        finishJob(key, false);
+    });
+    connect(s, &SSHMounter::passwordRequired, this, [this, key]() {
+        emit hostPasswordRequired(key);
+    });
+    connect(s, &SSHMounter::progressMessage, this, [this, key](const QString& msg) {
+        emit hostProgressMessage(key, msg);
+    });
+    connect(s, &SSHMounter::hostKeyMismatch, this, [this, key]() {
+        emit hostKeyMismatch(key);
+    });
+
+    return s;
+}
+
+MountState MountManager::state(const QString& key) const {
+    SSHMounter* s = sessions_.value(key);
+    return s ? s->state() : MountState::Idle;
+}
+
+bool MountManager::isBusy(const QString& key) const {
+    return running_.contains(key) || queued_.contains(key);
+}
+
+SSHHost MountManager::host(const QString& key) const {
+    return hosts_.value(key);
+}
+
+void MountManager::mount(const SSHHost& host) {
+    // Maybe a retry: look again rather than repeat a failure from a
+    // moment ago. A host found reachable stays cached.
+    ReachResult cached;
+    if (!isBusy(keyFor(host)) && reach_->cached(host, cached) && cached.failed()) reach_->invalidate(host);
+    enqueue(JobKind::Mount, host);
+}
+
+void MountManager::unmount(const SSHHost& host) {
+    enqueue(JobKind::Unmount, host);
+}
+
+void MountManager::mountAll(const QList<SSHHost>& hosts) {
+    // One parallel pre-flight for the batch; queued jobs find the verdict
+    // cached, and the first few wait on it
+    reach_->prefetch(hosts);
+    for (const auto& host : hosts) {
+        enqueue(JobKind::Mount, host);
+    }
+}
+
+void MountManager::unmountAll(const QList<SSHHost>& hosts) {
+    for (const auto& host : hosts) {
+        enqueue(JobKind::Unmount, host);
+    }
+}
+
+void MountManager::unmountAll(const QList<SSHHost>& hosts, const UnmountOptions& options) {
+    for (const auto& host : hosts) {
+        const QString key = keyFor(host);
+        if (key.isEmpty() || running_.contains(key)) continue;
+        // Already waiting behind the limit: jump the queue
+        if (queued_.contains(key)) {
+            for (int i = 0; i < queue_.size(); ++i) {
+                if (keyFor(queue_[i].host) == key) {
+                    queue_.removeAt(i);
+                    break;
+                }
+            }
+            queued_.remove(key);
+            queuedAt_.remove(key);
+        } else {
+            if (!isBusy()) {
+                batchSucceeded_ = 0;
+                batchFailed_ = 0;
+                emit busyChanged(true);
+            }
+            emit hostBusyChanged(key, true);
+        }
+        hosts_[key] = host;
+        running_.insert(key);
+        start({JobKind::Unmount, host, options});
+    }
+}
+
+void MountManager::cancelQueued() {
+    const QList<Job> dropped = queue_;
+    queue_.clear();
+    queued_.clear();
+    queuedAt_.clear();
+    for (const Job& job : dropped) emit hostBusyChanged(keyFor(job.host), false);
+    if (!dropped.isEmpty() && !isBusy()) {
+        emit busyChanged(false);
+        emit batchFinished(batchSucceeded_, batchFailed_);
+    }
+}
+
+void MountManager::enqueue(JobKind kind, const SSHHost& host) {
+    const QString key = keyFor(host);
+    if (key.isEmpty()) {
+        emit hostMountError(key, "Host " + host.name + " has no local path");
+        return;
+    }
+    if (isBusy(key)) {
+        console.warn("Ignoring request for", host.name.toStdString(), "- already busy");
+        return;
+    }
+
+    bool wasBusy = isBusy();
+    if (!wasBusy) {
+        batchSucceeded_ = 0;
+        batchFailed_ = 0;
+    }
+
+    hosts_[key] = host;
+    queue_.append({kind, host, UnmountOptions()});
+    queued_.insert(key);
+    queuedAt_[key].start();
+    if (!wasBusy) emit busyChanged(true);
+    emit hostBusyChanged(key, true);
+    pump();
+}
+
+void MountManager::pump() {
+    // A session can fail synchronously from inside mount(), which lands
+    // back here through finishJob(); the outer loop picks up the slack.
+    if (pumping_) return;
+    pumping_ = true;
+    while (running_.size() < maxConcurrent_ && !queue_.isEmpty()) {
+        Job job = queue_.takeFirst();
+        const QString key = keyFor(job.host);
+        queued_.remove(key);
+        running_.insert(key);
+        metrics_->recordQueueWait(queuedAt_.take(key).elapsed());
+        start(job);
+    }
+    pumping_ = false;
+}
+
+void MountManager::start(const Job& job) {
+    SSHMounter* s = session(job.host);
+    if (job.kind == JobKind::Mount) {
+        s->mount(job.host);
+    } else {
+        s->unmount(job.host.localPath, job.options);
+    }
+}
+
+void MountManager::finishJob(const QString& key, bool ok) {
+    if (!running_.remove(key)) return;
+    emit hostBusyChanged(key, false);
+
+    if (ok) ++batchSucceeded_;
+    else ++batchFailed_;
+
+    pump();
+
+    if (!isBusy()) {
+        console.log("Batch finished:", batchSucceeded_, "ok,", batchFailed_, "failed");
+        emit busyChanged(false);
+        emit batchFinished(batchSucceeded_, batchFailed_);
+    }
+}
+
+void MountManager::supplyPassword(const QString& key, const QString& password) {
+    if (SSHMounter* s = sessions_.value(key)) s->supplyPassword(password);
+}
+
+void MountManager::noPassword(const QString& key) {
+    if (SSHMounter* s = sessions_.value(key)) s->noPassword();
+}
+
+void MountManager::removeHostKey(const QString& key) {
+    if (SSHMounter* s = sessions_.value(key)) s->removeHostKey();
+}
+
+void MountManager::keepHostKey(const QString& key) {
+    if (SSHMounter* s = sessions_.value(key)) s->keepHostKey();
+}
+
+#include "mount_manager.moc"
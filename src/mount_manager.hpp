@@ -0,0 +1,110 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#pragma once
+
+#include "ssh_store.hpp"
+#include "ssh_mounter.hpp"
+#include "ssh_master.hpp"
+#include "reachability.hpp"
+#include "known_hosts.hpp"
+#include <QElapsedTimer>
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QSet>
+
+class MountMetrics;
+
+// Runs mounts and unmounts for many hosts at once. Every host gets its own
+// SSHMounter session, so state and signals are tracked per host, and at most
+// maxConcurrent() operations have a child process running at any time.
+class MountManager : public QObject {
+    Q_OBJECT
+public:
+    explicit MountManager(QObject* parent = nullptr);
+
+    static QString keyFor(const SSHHost& host);
+
+    void mount(const SSHHost& host);
+    void unmount(const SSHHost& host);
+    void mountAll(const QList<SSHHost>& hosts);
+    void unmountAll(const QList<SSHHost>& hosts);
+    // Bulk form for shutdown and dropped networks: every unmount starts at
+    // once, outside the concurrency limit, with options' deadlines and
+    // escalation
+    void unmountAll(const QList<SSHHost>& hosts, const UnmountOptions& options);
+    // Drops jobs that have not started yet
+    void cancelQueued();
+
+    void setMaxConcurrent(int limit);
+    int maxConcurrent() const { return maxConcurrent_; }
+
+    MountState state(const QString& key) const;
+    bool isBusy(const QString& key) const;
+    bool isBusy() const { return !running_.isEmpty() || !queue_.isEmpty(); }
+    SSHHost host(const QString& key) const;
+    SSHMasterPool* masters() const { return masters_; }
+    Reachability* reachability() const { return reach_; }
+    HostKeyScanner* hostKeys() const { return hostKeys_; }
+    MountMetrics* metrics() const { return metrics_; }
+
+public slots:
+    void supplyPassword(const QString& key, const QString& password);
+    void noPassword(const QString& key);
+    void removeHostKey(const QString& key);
+    void keepHostKey(const QString& key);
+
+signals:
+    void hostStateChanged(const QString& key, MountState state);
+    void hostBusyChanged(const QString& key, bool busy);
+    void hostMountSuccess(const QString& key);
+    void hostMountError(const QString& key, const QString& error);
+    void hostUnmountSuccess(const QString& key);
+    void hostPasswordRequired(const QString& key);
+    void hostProgressMessage(const QString& key, const QString& msg);
+    void hostKeyMismatch(const QString& key);
+    void busyChanged(bool busy);
+    void batchFinished(int succeeded, int failed);
+
+private:
+    enum class JobKind { Mount, Unmount };
+    struct Job {
+        JobKind kind;
+        SSHHost host;
+        UnmountOptions options;
+    };
+
+    SSHMounter* session(const SSHHost& host);
+    void enqueue(JobKind kind, const SSHHost& host);
+    void start(const Job& job);
+    void pump();
+    void finishJob(const QString& key, bool ok);
+
+    SSHMasterPool* masters_;
+    Reachability* reach_;
+    HostKeyScanner* hostKeys_;
+    MountMetrics* metrics_;
+    QHash<QString, SSHMounter*> sessions_;
+    QHash<QString, SSHHost> hosts_;
+    QList<Job> queue_;
+    QSet<QString> queued_;
+    QHash<QString, QElapsedTimer> queuedAt_;
+    QSet<QString> running_;
+    int maxConcurrent_;
+    int batchSucceeded_;
+    int batchFailed_;
+    bool pumping_;
+};
@@ -0,0 +1,369 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#include "mount_supervisor.hpp"
+#include "mount_manager.hpp"
+#include "mount_watcher.hpp"
+#include "console.hpp"
+#include <QDir>
+#include <QFile>
+#include <QMetaObject>
+#include <QProcess>
+#include <QSocketNotifier>
+#include <QThreadPool>
+#include <QTimer>
+#include <mutex>
+#include <sys/epoll.h>
+#include <sys/statvfs.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+extern Console console;
+
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
+
+// Probe threads report back through this; once the supervisor is gone a
+// late probe finds no owner and drops its result.
+struct MountSupervisor::Sink {
+    std::mutex mutex;
+    MountSupervisor* owner = nullptr;
+};
+
+MountSupervisor::MountSupervisor(SSHStore* store, MountWatcher* watcher, MountManager* manager,
+                                 QObject* parent)
+    : QObject(parent), store_(store), watcher_(watcher), manager_(manager), nextToken_(1),
+      epollFd_(-1), epollNotifier_(nullptr), timer_(new QTimer(this)),
+      probePool_(new QThreadPool()), sink_(std::make_shared<Sink>()),
+      intervalMs_(10000), slowMs_(2000), staleMs_(15000) {
+    sink_->owner = this;
+    // A probe on a dead mount can hang in the kernel for a long time; keep
+    // those threads out of the global pool. Nothing else runs here, so a
+    // queued probe only ever waits behind other probes.
+    probePool_->setMaxThreadCount(8);
+
+    epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd_ >= 0) {
+        epollNotifier_ = new QSocketNotifier(epollFd_, QSocketNotifier::Read, this);
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+        connect(epollNotifier_, &QSocketNotifier::activated, this, &MountSupervisor::onProcessExited);
+#else
+        connect(epollNotifier_, SIGNAL(activated(int)), this, SLOT(onProcessExited()));
+#endif
+    }
+
+    timer_->setInterval(1000);
+    connect(timer_, &QTimer::timeout, this, &MountSupervisor::tick);
+    timer_->start();
+
+    connect(watcher_, &MountWatcher::hostMountChanged, this, &MountSupervisor::onMountChanged);
+    connect(manager_, &MountManager::hostMountError, this, [this](const QString& key) {
+        auto it = entries_.find(key);
+        if (it != entries_.end() && it->status.recovering) scheduleRemount(key);
+    });
+}
+
+MountSupervisor::~MountSupervisor() {
+    {
+        std::lock_guard<std::mutex> lock(sink_->mutex);
+        sink_->owner = nullptr;
+    }
+    for (auto& entry : entries_) detachProcess(entry);
+    if (epollFd_ >= 0) ::close(epollFd_);
+
+    // Waiting here could mean waiting on a hung mount forever; a pool
+    // with probes still stuck is left behind for process exit to reclaim.
+    if (probePool_->activeThreadCount() == 0) delete probePool_;
+}
+
+QString MountSupervisor::healthName(MountHealth health) {
+    switch (health) {
+    case MountHealth::Healthy: return "healthy";
+    case MountHealth::Slow: return "slow";
+    case MountHealth::Stale: return "stale";
+    case MountHealth::Dead: return "dead";
+    case MountHealth::Unknown: break;
+    }
+    return "unknown";
+}
+
+void MountSupervisor::setProbeInterval(int ms) {
+    intervalMs_ = qMax(1000, ms);
+}
+
+void MountSupervisor::onMountChanged(const QString& key, bool mounted) {
+    if (mounted) {
+        if (const SSHHost* host = store_->byId(key)) supervise(*host);
+        return;
+    }
+
+    auto it = entries_.find(key);
+    if (it == entries_.end()) return;
+    if (it->status.recovering) {
+        // Our own lazy unmount; keep the entry for the remount
+        it->mounted = false;
+        detachProcess(it.value());
+    } else {
+        release(key);
+    }
+}
+
+void MountSupervisor::supervise(const SSHHost& host) {
+    const QString key = MountManager::keyFor(host);
+    Entry& entry = entries_[key];
+    entry.host = host;
+    entry.mounted = true;
+    if (entry.status.recovering) {
+        console.info(host.name.toStdString(), "is mounted again");
+        entry.status.recovering = false;
+        entry.status.health = MountHealth::Unknown;
+    }
+    if (entry.token == 0) {
+        entry.token = nextToken_++;
+        keyByToken_.insert(entry.token, key);
+    }
+    probe(entry);
+
+    // sshfs daemonizes, so the pid QProcess saw is long gone; look the
+    // real one up by its mount point. This only reads /proc, so it cannot
+    // hang on the mount and does not need to wait behind stuck probes.
+    const QString mountPoint = QDir::cleanPath(host.localPath);
+    std::shared_ptr<Sink> sink = sink_;
+    QThreadPool::globalInstance()->start([sink, key, mountPoint]() {
+        pid_t pid = MountTable::sshfsPid(mountPoint);
+        std::lock_guard<std::mutex> lock(sink->mutex);
+        if (!sink->owner || pid <= 0) return;
+        MountSupervisor* owner = sink->owner;
+        QMetaObject::invokeMethod(owner, [owner, key, pid]() {
+            owner->attachProcess(key, pid);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void MountSupervisor::release(const QString& key) {
+    auto it = entries_.find(key);
+    if (it == entries_.end()) return;
+    detachProcess(it.value());
+    keyByToken_.remove(it->token);
+    entries_.erase(it);
+    emit statusChanged(key);
+}
+
+void MountSupervisor::attachProcess(const QString& key, pid_t pid) {
+    auto it = entries_.find(key);
+    if (it == entries_.end() || !it->mounted || epollFd_ < 0) return;
+    Entry& entry = it.value();
+    if (entry.pidfd >= 0 && entry.pid == pid) return;
+    detachProcess(entry);
+
+    int fd = int(syscall(SYS_pidfd_open, pid, 0));
+    if (fd < 0) {
+        // Kernels before 5.3; the probes still catch a dead mount
+        console.warn("pidfd_open failed for sshfs", pid, "- relying on probes only");
+        return;
+    }
+    epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.u64 = entry.token;
+    if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &ev) != 0) {
+        ::close(fd);
+        return;
+    }
+    entry.pidfd = fd;
+    entry.pid = pid;
+}
+
+void MountSupervisor::detachProcess(Entry& entry) {
+    if (entry.pidfd < 0) return;
+    if (epollFd_ >= 0) epoll_ctl(epollFd_, EPOLL_CTL_DEL, entry.pidfd, nullptr);
+    ::close(entry.pidfd);
+    entry.pidfd = -1;
+    entry.pid = 0;
+}
+
+void MountSupervisor::onProcessExited() {
+    epoll_event events[16];
+    int n = epoll_wait(epollFd_, events, 16, 0);
+    for (int i = 0; i < n; ++i) {
+        const QString key = keyByToken_.value(events[i].data.u64);
+        auto it = entries_.find(key);
+        if (it == entries_.end()) continue;
+
+        console.warn("sshfs for", it->host.name.toStdString(), "exited");
+        detachProcess(it.value());
+        setHealth(it.value(), MountHealth::Dead);
+        recover(key);
+    }
+}
+
+void MountSupervisor::tick() {
+    for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+        Entry& entry = it.value();
+        if (!entry.mounted) continue;
+
+        if (entry.probing) {
+            // Still queued behind stuck probes of other mounts; nothing
+            // has touched this one yet, so there is nothing to judge.
+            if (!entry.probeStarted.isValid()) continue;
+            // The probe thread is stuck in the kernel; judge it by age
+            qint64 age = entry.probeStarted.elapsed();
+            if (age >= staleMs_ && entry.status.health != MountHealth::Stale &&
+                !entry.status.recovering) {
+                setHealth(entry, MountHealth::Stale);
+                recover(it.key());
+            } else if (age >= slowMs_ && entry.status.health == MountHealth::Healthy) {
+                setHealth(entry, MountHealth::Slow);
+            }
+        } else if (!entry.probeStarted.isValid() || entry.probeStarted.elapsed() >= intervalMs_) {
+            probe(entry);
+        }
+    }
+}
+
+void MountSupervisor::probe(Entry& entry) {
+    if (entry.probing) return;
+    entry.probing = true;
+    entry.probeStarted.invalidate();
+
+    const QString key = MountManager::keyFor(entry.host);
+    const QByteArray path = QFile::encodeName(entry.host.localPath);
+    std::shared_ptr<Sink> sink = sink_;
+    probePool_->start([sink, key, path]() {
+        QElapsedTimer t;
+        t.start();
+        {
+            // The age is measured from here, not from when it was queued
+            std::lock_guard<std::mutex> lock(sink->mutex);
+            if (!sink->owner) return;
+            MountSupervisor* owner = sink->owner;
+            QMetaObject::invokeMethod(owner, [owner, key, t]() {
+                owner->onProbeStarted(key, t);
+            }, Qt::QueuedConnection);
+        }
+        struct statvfs st;
+        int error = ::statvfs(path.constData(), &st) == 0 ? 0 : errno;
+        qint64 elapsed = t.elapsed();
+        qint64 freeBytes = error ? -1 : qint64(st.f_bavail) * qint64(st.f_frsize);
+        qint64 totalBytes = error ? -1 : qint64(st.f_blocks) * qint64(st.f_frsize);
+
+        std::lock_guard<std::mutex> lock(sink->mutex);
+        if (!sink->owner) return;
+        MountSupervisor* owner = sink->owner;
+        QMetaObject::invokeMethod(owner, [=]() {
+            owner->onProbeResult(key, error, freeBytes, totalBytes, elapsed);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void MountSupervisor::onProbeStarted(const QString& key, const QElapsedTimer& started) {
+    auto it = entries_.find(key);
+    if (it == entries_.end() || !it->probing) return;
+    it->probeStarted = started;
+}
+
+void MountSupervisor::onProbeResult(const QString& key, int error, qint64 freeBytes,
+                                    qint64 totalBytes, qint64 elapsedMs) {
+    auto it = entries_.find(key);
+    if (it == entries_.end()) return;
+    Entry& entry = it.value();
+    entry.probing = false;
+    if (!entry.mounted) return;
+
+    entry.status.probeMs = elapsedMs;
+    if (error == ENOTCONN) {
+        setHealth(entry, MountHealth::Dead);
+        recover(key);
+        return;
+    }
+    if (error) {
+        console.warn("Probe of", entry.host.localPath.toStdString(), "failed:", strerror(error));
+        return;
+    }
+
+    entry.status.freeBytes = freeBytes;
+    entry.status.totalBytes = totalBytes;
+    if (!entry.status.recovering) {
+        entry.status.attempt = 0;
+        setHealth(entry, elapsedMs >= slowMs_ ? MountHealth::Slow : MountHealth::Healthy);
+    }
+    emit statusChanged(key);
+}
+
+void MountSupervisor::setHealth(Entry& entry, MountHealth health) {
+    if (entry.status.health == health) return;
+    entry.status.health = health;
+    const QString key = MountManager::keyFor(entry.host);
+    console.log(entry.host.name.toStdString(), "is", healthName(health).toStdString());
+    emit healthChanged(key, health);
+    emit statusChanged(key);
+}
+
+void MountSupervisor::recover(const QString& key) {
+    auto it = entries_.find(key);
+    if (it == entries_.end() || it->status.recovering) return;
+    Entry& entry = it.value();
+    entry.status.recovering = true;
+    emit statusChanged(key);
+
+    // -z detaches the mount even while processes (and our own probe) are
+    // stuck in it; they get errors instead of hanging forever.
+    auto* p = new QProcess(this);
+#ifdef Q_OS_MAC
+    p->start("umount", {"-f", entry.host.localPath});
+#else
+    p->start("fusermount", {"-uz", entry.host.localPath});
+#endif
+    connect(p, static_cast<void(QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished),
+            this, [this, p, key]() {
+        p->deleteLater();
+        auto it = entries_.find(key);
+        if (it == entries_.end()) return;
+        it->mounted = false;
+        detachProcess(it.value());
+
+        // A remount would prompt for a password out of nowhere; only
+        // hosts that can authenticate on their own come back by themselves.
+        if (!it->host.usePublicKey) {
+            console.warn(it->host.name.toStdString(), "was unmounted; mount it again to reconnect");
+            release(key);
+            return;
+        }
+        scheduleRemount(key);
+    });
+}
+
+void MountSupervisor::scheduleRemount(const QString& key) {
+    auto it = entries_.find(key);
+    if (it == entries_.end()) return;
+    Entry& entry = it.value();
+
+    // 2 s, 4 s, 8 s ... capped at five minutes
+    int attempt = entry.status.attempt++;
+    int delay = int(qMin<qint64>(qint64(2000) << qMin(attempt, 8), 300000));
+    emit recovering(key, entry.status.attempt, delay);
+    emit statusChanged(key);
+
+    QTimer::singleShot(delay, this, [this, key]() {
+        auto it = entries_.find(key);
+        if (it == entries_.end() || !it->status.recovering) return;
+        // Recovery ends when MountWatcher reports the mount back
+        manager_->mount(it->host);
+    });
+}
+
+#include "mount_supervisor.moc"
@@ -0,0 +1,119 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#pragma once
+
+#include "ssh_store.hpp"
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <memory>
+#include <sys/types.h>
+
+class MountManager;
+class MountWatcher;
+class QSocketNotifier;
+class QThreadPool;
+class QTimer;
+
+enum class MountHealth {
+    Unknown,    // Not probed yet
+    Healthy,
+    Slow,       // Last probe took longer than the slow threshold
+    Stale,      // A probe has been stuck past the stale threshold
+    Dead        // sshfs exited or the mount reports ENOTCONN
+};
+
+// Watches every mounted host. Each sshfs process is held as a pidfd in an
+// epoll set, so its exit is noticed immediately; each mount point gets a
+// periodic statvfs() on a private thread pool, and a probe that does not
+// come back in time marks the mount stale without ever blocking the UI
+// thread. Stale and dead mounts of key-authenticated hosts are lazily
+// unmounted and remounted with exponential backoff.
+class MountSupervisor : public QObject {
+    Q_OBJECT
+public:
+    struct Status {
+        MountHealth health = MountHealth::Unknown;
+        qint64 freeBytes = -1;
+        qint64 totalBytes = -1;
+        qint64 probeMs = -1;
+        int attempt = 0;            // Remount attempts since last healthy
+        bool recovering = false;
+    };
+
+    MountSupervisor(SSHStore* store, MountWatcher* watcher, MountManager* manager,
+                    QObject* parent = nullptr);
+    ~MountSupervisor() override;
+
+    void setProbeInterval(int ms);
+    void setSlowThreshold(int ms) { slowMs_ = ms; }
+    void setStaleThreshold(int ms) { staleMs_ = ms; }
+
+    Status status(const QString& key) const { return entries_.value(key).status; }
+    MountHealth health(const QString& key) const { return status(key).health; }
+    // The daemonized sshfs serving key; 0 until it has been found
+    pid_t sshfsPid(const QString& key) const { return entries_.value(key).pid; }
+    static QString healthName(MountHealth health);
+
+signals:
+    void statusChanged(const QString& key);
+    void healthChanged(const QString& key, MountHealth health);
+    void recovering(const QString& key, int attempt, int delayMs);
+
+private slots:
+    void onProcessExited();
+
+private:
+    struct Entry {
+        SSHHost host;
+        Status status;
+        int pidfd = -1;
+        pid_t pid = 0;
+        bool mounted = false;
+        bool probing = false;       // Queued or running
+        QElapsedTimer probeStarted; // Invalid until the probe thread runs it
+        quint64 token = 0;
+    };
+    struct Sink;
+
+    void onMountChanged(const QString& key, bool mounted);
+    void supervise(const SSHHost& host);
+    void release(const QString& key);
+    void tick();
+    void probe(Entry& entry);
+    void onProbeStarted(const QString& key, const QElapsedTimer& started);
+    void onProbeResult(const QString& key, int error, qint64 freeBytes, qint64 totalBytes, qint64 elapsedMs);
+    void attachProcess(const QString& key, pid_t pid);
+    void detachProcess(Entry& entry);
+    void setHealth(Entry& entry, MountHealth health);
+    void recover(const QString& key);
+    void scheduleRemount(const QString& key);
+
+    SSHStore* store_;
+    MountWatcher* watcher_;
+    MountManager* manager_;
+    QHash<QString, Entry> entries_;
+    QHash<quint64, QString> keyByToken_;
+    quint64 nextToken_;
+    int epollFd_;
+    QSocketNotifier* epollNotifier_;
+    QTimer* timer_;
+    QThreadPool* probePool_;
+    std::shared_ptr<Sink> sink_;
+    int intervalMs_;
+    int slowMs_;
+    int staleMs_;
+};
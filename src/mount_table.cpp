@@ -0,0 +1,229 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#include "mount_table.hpp"
+#include "console.hpp"
+#include <QDir>
+#include <QFile>
+#include <QStringList>
+#include <dirent.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <cstring>
+
+extern Console console;
+
+namespace {
+
+bool inside(const char* path, const QByteArray& mountPoint) {
+    const size_t n = size_t(mountPoint.size());
+    return strncmp(path, mountPoint.constData(), n) == 0 && (path[n] == '\0' || path[n] == '/');
+}
+
+// readlink() only; never stats the target, which may be a hung mount
+bool linkInside(const QByteArray& link, const QByteArray& mountPoint) {
+    char target[4096];
+    ssize_t n = ::readlink(link.constData(), target, sizeof(target) - 1);
+    if (n <= 0) return false;
+    target[n] = '\0';
+    return inside(target, mountPoint);
+}
+
+} // namespace
+
+QString MountTable::sourceFor(const SSHHost& host) {
+    return QString("%1@%2:%3").arg(host.user).arg(host.host).arg(host.remotePath);
+}
+
+void MountTable::clear() {
+    entries_.clear();
+    bySource_.clear();
+    byMountPoint_.clear();
+}
+
+bool MountTable::load(const QString& path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        // No procfs (e.g. macOS): treat as an empty table
+        clear();
+        return false;
+    }
+    // procfs reports a size of 0, readAll() reads until EOF regardless
+    parse(file.readAll());
+    return true;
+}
+
+// mountinfo escapes space, tab, newline and backslash as \ooo
+QString MountTable::unescape(const char* begin, const char* end) {
+    if (!memchr(begin, '\\', end - begin)) {
+        return QString::fromUtf8(begin, int(end - begin));
+    }
+
+    QByteArray out;
+    out.reserve(int(end - begin));
+    for (const char* p = begin; p < end; ++p) {
+        if (*p == '\\' && end - p >= 4 &&
+            p[1] >= '0' && p[1] <= '3' &&
+            p[2] >= '0' && p[2] <= '7' &&
+            p[3] >= '0' && p[3] <= '7') {
+            out.append(char(((p[1] - '0') << 6) | ((p[2] - '0') << 3) | (p[3] - '0')));
+            p += 3;
+        } else {
+            out.append(*p);
+        }
+    }
+    return QString::fromUtf8(out);
+}
+
+void MountTable::parse(const QByteArray& data) {
+    clear();
+    entries_.reserve(data.count('\n'));
+
+    const char* p = data.constData();
+    const char* end = p + data.size();
+
+    while (p < end) {
+        const char* eol = static_cast<const char*>(memchr(p, '\n', end - p));
+        if (!eol) eol = end;
+
+        // Split the line on spaces; fields never contain raw spaces
+        const char* fields[32][2];
+        int count = 0;
+        const char* f = p;
+        while (f < eol && count < 32) {
+            const char* sp = static_cast<const char*>(memchr(f, ' ', eol - f));
+            if (!sp) sp = eol;
+            fields[count][0] = f;
+            fields[count][1] = sp;
+            ++count;
+            f = sp + 1;
+        }
+
+        // id parent maj:min root mountpoint options [optional...] - fstype source superopts
+        int sep = -1;
+        for (int i = 6; i < count; ++i) {
+            if (fields[i][1] - fields[i][0] == 1 && *fields[i][0] == '-') {
+                sep = i;
+                break;
+            }
+        }
+
+        if (sep >= 6 && sep + 2 < count) {
+            MountEntry e;
+            e.id = QByteArray::fromRawData(fields[0][0], int(fields[0][1] - fields[0][0])).toInt();
+            e.parentId = QByteArray::fromRawData(fields[1][0], int(fields[1][1] - fields[1][0])).toInt();
+            e.root = unescape(fields[3][0], fields[3][1]);
+            e.mountPoint = unescape(fields[4][0], fields[4][1]);
+            e.options = QString::fromLatin1(fields[5][0], int(fields[5][1] - fields[5][0]));
+            e.fsType = unescape(fields[sep + 1][0], fields[sep + 1][1]);
+            e.source = unescape(fields[sep + 2][0], fields[sep + 2][1]);
+
+            // Later lines are mounted on top of earlier ones, so let them win
+            int index = entries_.size();
+            bySource_.insert(e.source, index);
+            byMountPoint_.insert(e.mountPoint, index);
+            entries_.append(std::move(e));
+        } else if (eol > p) {
+            console.warn("Skipping malformed mountinfo line");
+        }
+
+        p = eol + 1;
+    }
+}
+
+const MountEntry* MountTable::bySource(const QString& source) const {
+    auto it = bySource_.constFind(source);
+    return it == bySource_.constEnd() ? nullptr : &entries_[it.value()];
+}
+
+const MountEntry* MountTable::byMountPoint(const QString& mountPoint) const {
+    auto it = byMountPoint_.constFind(QDir::cleanPath(mountPoint));
+    return it == byMountPoint_.constEnd() ? nullptr : &entries_[it.value()];
+}
+
+bool MountTable::isMounted(const SSHHost& host) const {
+    if (bySource(sourceFor(host))) return true;
+
+    // Fall back to the mount point; sshfs may record the remote path
+    // slightly differently (trailing slash, ~ expansion).
+    const MountEntry* e = byMountPoint(host.localPath);
+    return e && e->fsType == "fuse.sshfs";
+}
+
+pid_t MountTable::sshfsPid(const QString& mountPoint) {
+    const QByteArray target = QFile::encodeName(mountPoint);
+    const QStringList pids = QDir("/proc").entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString& name : pids) {
+        bool ok = false;
+        pid_t pid = name.toInt(&ok);
+        if (!ok) continue;
+
+        QFile file("/proc/" + name + "/cmdline");
+        if (!file.open(QIODevice::ReadOnly)) continue;
+        const QList<QByteArray> argv = file.readAll().split('\0');
+        if (argv.isEmpty() || !argv.first().endsWith("sshfs")) continue;
+        for (const QByteArray& arg : argv) {
+            if (arg == target || (arg.endsWith('/') && arg.chopped(1) == target)) return pid;
+        }
+    }
+    return 0;
+}
+
+QList<pid_t> MountTable::holders(const QString& mountPoint, int limit) {
+    QList<pid_t> result;
+    const QByteArray target = QFile::encodeName(QDir::cleanPath(mountPoint));
+    const pid_t self = getpid();
+
+    DIR* proc = opendir("/proc");
+    if (!proc) return result;
+    while (dirent* d = readdir(proc)) {
+        char* end = nullptr;
+        const long pid = strtol(d->d_name, &end, 10);
+        if (pid <= 0 || *end != '\0' || pid == self) continue;
+
+        const QByteArray base = QByteArray("/proc/") + d->d_name;
+        bool holds = linkInside(base + "/cwd", target) || linkInside(base + "/root", target);
+        if (!holds) {
+            const QByteArray fdDir = base + "/fd";
+            if (DIR* fds = opendir(fdDir.constData())) {
+                while (dirent* f = readdir(fds)) {
+                    if (f->d_name[0] == '.') continue;
+                    if (linkInside(fdDir + '/' + f->d_name, target)) {
+                        holds = true;
+                        break;
+                    }
+                }
+                closedir(fds);
+            }
+        }
+        if (holds) {
+            result.append(pid_t(pid));
+            if (limit > 0 && result.size() >= limit) break;
+        }
+    }
+    closedir(proc);
+    return result;
+}
+
+QString MountTable::describeProcesses(const QList<pid_t>& pids) {
+    QStringList names;
+    for (pid_t pid : pids) {
+        QFile comm(QString("/proc/%1/comm").arg(pid));
+        const QString name = comm.open(QIODevice::ReadOnly) ? QString::fromLocal8Bit(comm.readAll()).trimmed()
+                                                             : QString("?");
+        names << QString("%1 (%2)").arg(name).arg(pid);
+    }
+    return names.join(", ");
+}
@@ -0,0 +1,74 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#pragma once
+
+#include "ssh_store.hpp"
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QVector>
+#include <sys/types.h>
+
+// One line of /proc/self/mountinfo
+struct MountEntry {
+    int id = 0;
+    int parentId = 0;
+    QString root;
+    QString mountPoint;
+    QString options;
+    QString fsType;
+    QString source;
+};
+
+// Snapshot of the kernel mount table with hash indexes by source
+// (user@host:path for sshfs) and by mount point.
+class MountTable {
+public:
+    static constexpr const char* DefaultPath = "/proc/self/mountinfo";
+
+    // The fsname sshfs records for a host, e.g. "me@box:/srv"
+    static QString sourceFor(const SSHHost& host);
+
+    bool load(const QString& path = DefaultPath);
+    void parse(const QByteArray& data);
+    void clear();
+
+    const MountEntry* bySource(const QString& source) const;
+    const MountEntry* byMountPoint(const QString& mountPoint) const;
+    bool isMounted(const SSHHost& host) const;
+
+    const QVector<MountEntry>& entries() const { return entries_; }
+    int size() const { return entries_.size(); }
+
+    // /proc lookups around a mount point. They only readlink() and read
+    // cmdline, never touch the mount itself, so a hung mount can't block them;
+    // still a full /proc walk, so keep them off the UI thread.
+    //
+    // The daemonized sshfs serving mountPoint; 0 if there is none
+    static pid_t sshfsPid(const QString& mountPoint);
+    // Processes whose cwd, root or an open file lies inside mountPoint
+    static QList<pid_t> holders(const QString& mountPoint, int limit = -1);
+    // "vim (1234), bash (5678)"
+    static QString describeProcesses(const QList<pid_t>& pids);
+
+private:
+    static QString unescape(const char* begin, const char* end);
+
+    QVector<MountEntry> entries_;
+    QHash<QString, int> bySource_;
+    QHash<QString, int> byMountPoint_;
+};
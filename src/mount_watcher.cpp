@@ -0,0 +1,196 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#include "mount_watcher.hpp"
+#include "mount_manager.hpp"
+#include "console.hpp"
+#include <QDir>
+#include <QFile>
+#include <QSet>
+#include <QSocketNotifier>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+
+extern Console console;
+
+MountWatcher::MountWatcher(QObject* parent)
+    : QObject(parent), fd_(-1), notifier_(nullptr) {
+}
+
+MountWatcher::~MountWatcher() {
+    if (fd_ >= 0) ::close(fd_);
+}
+
+bool MountWatcher::start(const QString& path) {
+    path_ = path;
+    fd_ = ::open(QFile::encodeName(path).constData(), O_RDONLY | O_CLOEXEC);
+    if (fd_ < 0) {
+        console.warn("Cannot watch", path.toStdString(), "- mount state will not update live");
+        table_.load(path);
+        return false;
+    }
+
+    // mountinfo signals changes as an exceptional condition (POLLPRI)
+    notifier_ = new QSocketNotifier(fd_, QSocketNotifier::Exception, this);
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    connect(notifier_, &QSocketNotifier::activated, this, &MountWatcher::refresh);
+#else
+    // Qt 5.15 overloads activated(), which makes the pointer form ambiguous
+    connect(notifier_, SIGNAL(activated(int)), this, SLOT(refresh()));
+#endif
+
+    refresh();
+    return true;
+}
+
+QByteArray MountWatcher::readTable() {
+    QByteArray data;
+    if (::lseek(fd_, 0, SEEK_SET) < 0) return data;
+
+    char buf[16384];
+    for (;;) {
+        ssize_t n = ::read(fd_, buf, sizeof(buf));
+        if (n > 0) {
+            data.append(buf, int(n));
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else {
+            break;
+        }
+    }
+    return data;
+}
+
+void MountWatcher::refresh() {
+    MountTable next;
+    if (fd_ >= 0) {
+        next.parse(readTable());
+    } else {
+        next.load(path_);
+    }
+
+    // Mount IDs are unique for the lifetime of a mount, so the symmetric
+    // difference of the two ID sets is exactly what came and went.
+    QHash<int, int> oldIds;
+    oldIds.reserve(table_.size());
+    for (int i = 0; i < table_.size(); ++i) {
+        oldIds.insert(table_.entries()[i].id, i);
+    }
+
+    QVector<MountEntry> added;
+    for (const auto& e : next.entries()) {
+        if (!oldIds.remove(e.id)) added.append(e);
+    }
+    QVector<MountEntry> removed;
+    removed.reserve(oldIds.size());
+    for (int index : oldIds) {
+        removed.append(table_.entries()[index]);
+    }
+
+    if (added.isEmpty() && removed.isEmpty() && table_.size() == next.size()) {
+        return;
+    }
+
+    table_ = std::move(next);
+
+    for (const auto& e : removed) {
+        emit mountRemoved(e);
+        updateHostsFor(e);
+    }
+    for (const auto& e : added) {
+        emit mountAdded(e);
+        updateHostsFor(e);
+    }
+    emit tableChanged();
+}
+
+void MountWatcher::setHosts(const QVector<SSHHost>& hosts) {
+    hosts_.clear();
+    keyBySource_.clear();
+    keyByMountPoint_.clear();
+
+    QHash<QString, bool> previous;
+    previous.swap(mounted_);
+
+    for (const auto& host : hosts) {
+        const QString key = MountManager::keyFor(host);
+        hosts_.insert(key, host);
+        keyBySource_.insert(MountTable::sourceFor(host), key);
+        keyByMountPoint_.insert(QDir::cleanPath(host.localPath), key);
+
+        bool mounted = table_.isMounted(host);
+        mounted_.insert(key, mounted);
+        if (previous.value(key, false) != mounted) {
+            emit hostMountChanged(key, mounted);
+        }
+    }
+}
+
+void MountWatcher::updateHostsFor(const MountEntry& entry) {
+    QSet<QString> keys;
+    auto bySource = keyBySource_.constFind(entry.source);
+    if (bySource != keyBySource_.constEnd()) keys.insert(bySource.value());
+    auto byPoint = keyByMountPoint_.constFind(entry.mountPoint);
+    if (byPoint != keyByMountPoint_.constEnd()) keys.insert(byPoint.value());
+
+    for (const auto& key : keys) {
+        refreshHost(key);
+    }
+}
+
+void MountWatcher::watchHost(const SSHHost& host) {
+    const QString key = MountManager::keyFor(host);
+    auto old = hosts_.constFind(key);
+    if (old != hosts_.constEnd()) {
+        // An edit may have moved the host to a new source or mount point
+        const QString oldSource = MountTable::sourceFor(old.value());
+        const QString oldPoint = QDir::cleanPath(old->localPath);
+        if (keyBySource_.value(oldSource) == key) keyBySource_.remove(oldSource);
+        if (keyByMountPoint_.value(oldPoint) == key) keyByMountPoint_.remove(oldPoint);
+    }
+
+    hosts_.insert(key, host);
+    keyBySource_.insert(MountTable::sourceFor(host), key);
+    keyByMountPoint_.insert(QDir::cleanPath(host.localPath), key);
+    refreshHost(key);
+}
+
+void MountWatcher::unwatchHost(const QString& key) {
+    auto host = hosts_.find(key);
+    if (host == hosts_.end()) return;
+
+    const QString source = MountTable::sourceFor(host.value());
+    const QString point = QDir::cleanPath(host->localPath);
+    if (keyBySource_.value(source) == key) keyBySource_.remove(source);
+    if (keyByMountPoint_.value(point) == key) keyByMountPoint_.remove(point);
+    hosts_.erase(host);
+    mounted_.remove(key);
+}
+
+void MountWatcher::refreshHost(const QString& key) {
+    auto host = hosts_.constFind(key);
+    if (host == hosts_.constEnd()) return;
+
+    bool mounted = table_.isMounted(host.value());
+    bool& current = mounted_[key];
+    if (current != mounted) {
+        current = mounted;
+        console.log(host->name.toStdString(), mounted ? "is now mounted" : "is no longer mounted");
+        emit hostMountChanged(key, mounted);
+    }
+}
+
+#include "mount_watcher.moc"
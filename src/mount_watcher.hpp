@@ -0,0 +1,70 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#pragma once
+
+#include "mount_table.hpp"
+#include "ssh_store.hpp"
+#include <QObject>
+#include <QHash>
+
+class QSocketNotifier;
+
+// Keeps a live MountTable. The kernel flags /proc/self/mountinfo with
+// POLLPRI whenever the mount table changes; on each change the table is
+// re-read, diffed against the previous one and per-host state is emitted.
+class MountWatcher : public QObject {
+    Q_OBJECT
+public:
+    explicit MountWatcher(QObject* parent = nullptr);
+    ~MountWatcher() override;
+
+    // Adopt a table read elsewhere (e.g. during startup) without emitting
+    void seed(const MountTable& table) { table_ = table; }
+    bool start(const QString& path = MountTable::DefaultPath);
+
+    const MountTable& table() const { return table_; }
+
+    // Hosts to report hostMountChanged() for, keyed by MountManager::keyFor()
+    void setHosts(const QVector<SSHHost>& hosts);
+    // Incremental forms of setHosts() for single adds, edits and removals
+    void watchHost(const SSHHost& host);
+    void unwatchHost(const QString& key);
+    bool isMounted(const QString& key) const { return mounted_.value(key, false); }
+
+public slots:
+    void refresh();
+
+signals:
+    void mountAdded(const MountEntry& entry);
+    void mountRemoved(const MountEntry& entry);
+    void hostMountChanged(const QString& key, bool mounted);
+    void tableChanged();
+
+private:
+    QByteArray readTable();
+    void refreshHost(const QString& key);
+    void updateHostsFor(const MountEntry& entry);
+
+    QString path_;
+    int fd_;
+    QSocketNotifier* notifier_;
+    MountTable table_;
+
+    QHash<QString, SSHHost> hosts_;
+    QHash<QString, QString> keyBySource_;
+    QHash<QString, QString> keyByMountPoint_;
+    QHash<QString, bool> mounted_;
+};
@@ -0,0 +1,229 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#include "output_scanner.hpp"
+#include <QStringList>
+#include <array>
+#include <cstring>
+#include <queue>
+
+namespace {
+
+struct Pattern {
+    const char* text;       // Lower case
+    OutputEvent event;
+};
+
+// "password:" only matches an actual prompt, not every line that happens
+// to mention passwords.
+const Pattern Patterns[] = {
+    {"password:", OutputEvent::PasswordPrompt},
+    {"passphrase for key", OutputEvent::PasswordPrompt},
+    {"remote host identification has changed", OutputEvent::HostKeyChanged},
+    {"host key verification failed", OutputEvent::HostKeyVerificationFailed},
+    {"permission denied", OutputEvent::AuthFailed},
+    {"too many authentication failures", OutputEvent::AuthFailed},
+    {"authentication failed", OutputEvent::AuthFailed},
+    {"connection refused", OutputEvent::ConnectionRefused},
+    {"connection timed out", OutputEvent::ConnectionTimedOut},
+    {"operation timed out", OutputEvent::ConnectionTimedOut},
+    {"no route to host", OutputEvent::HostUnreachable},
+    {"network is unreachable", OutputEvent::HostUnreachable},
+    {"could not resolve hostname", OutputEvent::NameResolutionFailed},
+    {"name or service not known", OutputEvent::NameResolutionFailed},
+    {"connection closed by", OutputEvent::ConnectionLost},
+    {"connection reset by", OutputEvent::ConnectionLost},
+    {"mountpoint is not empty", OutputEvent::MountPointNotEmpty},
+    {"mount point is not empty", OutputEvent::MountPointNotEmpty},
+};
+
+// Most specific first; the first one seen explains a failed mount
+const OutputEvent FailureOrder[] = {
+    OutputEvent::MountPointNotEmpty,
+    OutputEvent::HostKeyChanged,
+    OutputEvent::HostKeyVerificationFailed,
+    OutputEvent::AuthFailed,
+    OutputEvent::ConnectionRefused,
+    OutputEvent::ConnectionTimedOut,
+    OutputEvent::NameResolutionFailed,
+    OutputEvent::HostUnreachable,
+    OutputEvent::ConnectionLost,
+};
+
+} // namespace
+
+// A full DFA: fail links are folded into the transition table at build
+// time, so scanning is one table lookup per byte. Bytes are first mapped
+// to a small alphabet of the characters the patterns use (everything else
+// is class 0), which keeps the table a few KiB.
+struct OutputScanner::Automaton {
+    std::array<quint8, 256> classOf {};
+    int classes = 1;
+    std::vector<int> next;          // node * classes + class
+    std::vector<quint32> output;    // Event bits completed at each node
+
+    Automaton() {
+        for (const Pattern& p : Patterns) {
+            for (const char* c = p.text; *c; ++c) {
+                quint8 b = quint8(*c);
+                if (classOf[b] == 0) classOf[b] = quint8(classes++);
+            }
+        }
+        // Case folding happens here, once, instead of per byte scanned
+        for (int b = 'A'; b <= 'Z'; ++b) classOf[b] = classOf[b - 'A' + 'a'];
+
+        std::vector<int> trie(classes, -1);
+        output.assign(1, 0);
+        for (const Pattern& p : Patterns) {
+            int node = 0;
+            for (const char* c = p.text; *c; ++c) {
+                int cls = classOf[quint8(*c)];
+                int& slot = trie[size_t(node) * classes + cls];
+                if (slot < 0) {
+                    slot = int(output.size());
+                    output.push_back(0);
+                    trie.resize(trie.size() + classes, -1);
+                }
+                node = trie[size_t(node) * classes + cls];
+            }
+            output[node] |= 1u << int(p.event);
+        }
+
+        // Breadth-first: a node's fail target is always finished first
+        next.assign(trie.size(), 0);
+        std::vector<int> fail(output.size(), 0);
+        std::queue<int> queue;
+        for (int cls = 0; cls < classes; ++cls) {
+            int child = trie[cls];
+            if (child > 0) {
+                next[cls] = child;
+                queue.push(child);
+            }
+        }
+        while (!queue.empty()) {
+            int node = queue.front();
+            queue.pop();
+            output[node] |= output[fail[node]];
+            for (int cls = 0; cls < classes; ++cls) {
+                int child = trie[size_t(node) * classes + cls];
+                int viaFail = next[size_t(fail[node]) * classes + cls];
+                if (child > 0) {
+                    fail[child] = viaFail;
+                    next[size_t(node) * classes + cls] = child;
+                    queue.push(child);
+                } else {
+                    next[size_t(node) * classes + cls] = viaFail;
+                }
+            }
+        }
+    }
+};
+
+const OutputScanner::Automaton& OutputScanner::automaton() {
+    static const Automaton instance;
+    return instance;
+}
+
+OutputScanner::OutputScanner(int tailBytes)
+    : state_(0), seen_(0), ring_(size_t(qMax(256, tailBytes))), ringPos_(0), ringFull_(false) {
+}
+
+void OutputScanner::reset() {
+    state_ = 0;
+    seen_ = 0;
+    ringPos_ = 0;
+    ringFull_ = false;
+}
+
+QVector<OutputEvent> OutputScanner::feed(const char* data, int size) {
+    QVector<OutputEvent> events;
+    if (size <= 0) return events;
+
+    const Automaton& a = automaton();
+    int state = state_;
+    for (int i = 0; i < size; ++i) {
+        state = a.next[size_t(state) * a.classes + a.classOf[quint8(data[i])]];
+        quint32 bits = a.output[state];
+        while (bits) {
+            int event = __builtin_ctz(bits);
+            bits &= bits - 1;
+            events.append(OutputEvent(event));
+            seen_ |= 1u << event;
+        }
+    }
+    state_ = state;
+
+    // Keep the tail; only the last ring_.size() bytes of a big chunk matter
+    const size_t cap = ring_.size();
+    size_t n = size_t(size);
+    if (n >= cap) {
+        memcpy(ring_.data(), data + (n - cap), cap);
+        ringPos_ = 0;
+        ringFull_ = true;
+    } else {
+        size_t first = qMin(n, cap - ringPos_);
+        memcpy(ring_.data() + ringPos_, data, first);
+        memcpy(ring_.data(), data + first, n - first);
+        if (ringPos_ + n >= cap) ringFull_ = true;
+        ringPos_ = (ringPos_ + n) % cap;
+    }
+    return events;
+}
+
+bool OutputScanner::failure(OutputEvent& event) const {
+    for (OutputEvent e : FailureOrder) {
+        if (seen(e)) {
+            event = e;
+            return true;
+        }
+    }
+    return false;
+}
+
+QString OutputScanner::tail(int maxLines) const {
+    QByteArray bytes;
+    if (ringFull_) {
+        bytes.append(ring_.data() + ringPos_, int(ring_.size() - ringPos_));
+        bytes.append(ring_.data(), int(ringPos_));
+        // Don't start in the middle of a UTF-8 sequence or a line
+        int start = bytes.indexOf('\n');
+        bytes.remove(0, start >= 0 ? start + 1 : 0);
+    } else {
+        bytes.append(ring_.data(), int(ringPos_));
+    }
+
+    QString text = QString::fromLocal8Bit(bytes).trimmed();
+    if (maxLines > 0) {
+        QStringList lines = text.split('\n');
+        if (lines.size() > maxLines) text = lines.mid(lines.size() - maxLines).join('\n');
+    }
+    return text;
+}
+
+QString OutputScanner::describe(OutputEvent event) {
+    switch (event) {
+    case OutputEvent::PasswordPrompt: return "Password requested";
+    case OutputEvent::HostKeyChanged: return "The server's host key has changed";
+    case OutputEvent::HostKeyVerificationFailed: return "Host key verification failed";
+    case OutputEvent::AuthFailed: return "Authentication failed";
+    case OutputEvent::ConnectionRefused: return "Connection refused";
+    case OutputEvent::ConnectionTimedOut: return "Connection timed out";
+    case OutputEvent::HostUnreachable: return "Host unreachable (no route to host)";
+    case OutputEvent::NameResolutionFailed: return "Could not resolve the host name";
+    case OutputEvent::ConnectionLost: return "Connection closed by the server";
+    case OutputEvent::MountPointNotEmpty: return "The mount point is not empty";
+    }
+    return QString();
+}
@@ -0,0 +1,70 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+#include <vector>
+
+// Things sshfs and ssh say that SSHMounter acts on
+enum class OutputEvent {
+    PasswordPrompt,
+    HostKeyChanged,
+    HostKeyVerificationFailed,
+    AuthFailed,
+    ConnectionRefused,
+    ConnectionTimedOut,
+    HostUnreachable,
+    NameResolutionFailed,
+    ConnectionLost,
+    MountPointNotEmpty
+};
+
+// Streaming matcher for child process output. All patterns live in one
+// case-insensitive Aho-Corasick automaton whose state carries over between
+// chunks, so every byte is looked at once and a prompt split across two
+// reads is still recognized. The last few KiB of output are kept in a ring
+// buffer for error messages.
+class OutputScanner {
+public:
+    explicit OutputScanner(int tailBytes = 8192);
+
+    void reset();
+
+    // Events completed within this chunk, in order of appearance
+    QVector<OutputEvent> feed(const char* data, int size);
+    QVector<OutputEvent> feed(const QByteArray& chunk) { return feed(chunk.constData(), chunk.size()); }
+
+    bool seen(OutputEvent event) const { return seen_ & (1u << int(event)); }
+    // The most telling failure seen so far; false if there was none
+    bool failure(OutputEvent& event) const;
+
+    // Last tailBytes of output, at most maxLines lines, trimmed
+    QString tail(int maxLines = -1) const;
+
+    static QString describe(OutputEvent event);
+
+private:
+    struct Automaton;
+    static const Automaton& automaton();
+
+    int state_;
+    quint32 seen_;
+    std::vector<char> ring_;
+    size_t ringPos_;
+    bool ringFull_;
+};
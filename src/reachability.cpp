@@ -0,0 +1,684 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#include "reachability.hpp"
+#include "console.hpp"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QProcess>
+#include <QStandardPaths>
+#include <QThreadPool>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+extern Console console;
+
+namespace {
+
+const int DefaultDeadlineMs = 2000;
+const int ReachableTtlMs = 60000;
+const int FailedTtlMs = 10000;
+// ssh -G reads ~/.ssh/config and does nothing else; it is quick or broken.
+// Each batch gets the whole timeout.
+const int SshConfigMs = 1000;
+const int SshConfigBatch = 32;
+// Answers are reused this long, or until ~/.ssh/config changes
+const int SshConfigTtlMs = 60000;
+const int MaxAddresses = 4;
+// getaddrinfo() threads shared by every pre-flight
+const int ResolverThreads = 8;
+const int BannerBytes = 255;
+const uint64_t WakeTag = ~uint64_t(0);
+
+struct Endpoint {
+    QString host;
+    int port = 22;
+    bool skip = false;          // Reached through a proxy; nothing to probe
+};
+
+QString expandPath(const QString& path) {
+    QString out = path;
+    if (out.startsWith("~/")) out = QDir::homePath() + out.mid(1);
+    return out.replace("%d", QDir::homePath());
+}
+
+// ssh -G answers by host:port, shared by every pre-flight and host key
+// check; those run on pool threads
+struct ConfigCache {
+    struct Entry {
+        SshHostConfig config;
+        qint64 at = 0;
+    };
+    std::mutex mutex;
+    QHash<QString, Entry> entries;
+    qint64 configMtime = -1;
+
+    static ConfigCache& instance() {
+        static ConfigCache cache;
+        return cache;
+    }
+    static QString keyFor(const ReachTarget& target) { return target.host + ':' + QString::number(target.port); }
+
+    // Fills what it has; returns the indexes of the targets still to ask
+    QVector<int> lookup(const QVector<ReachTarget>& targets, QVector<SshHostConfig>& configs) {
+        const QFileInfo config(QDir::homePath() + "/.ssh/config");
+        const qint64 mtime = config.exists() ? config.lastModified().toMSecsSinceEpoch() : 0;
+        const qint64 now = QDateTime::currentMSecsSinceEpoch();
+        QVector<int> missing;
+        std::lock_guard<std::mutex> lock(mutex);
+        if (mtime != configMtime) {
+            entries.clear();
+            configMtime = mtime;
+        }
+        for (int i = 0; i < targets.size(); ++i) {
+            auto it = entries.constFind(keyFor(targets[i]));
+            if (it != entries.constEnd() && now - it->at < SshConfigTtlMs) {
+                configs[i] = it->config;
+            } else {
+                missing.append(i);
+            }
+        }
+        return missing;
+    }
+
+    void store(const ReachTarget& target, const SshHostConfig& config) {
+        std::lock_guard<std::mutex> lock(mutex);
+        entries.insert(keyFor(target), {config, QDateTime::currentMSecsSinceEpoch()});
+    }
+};
+
+struct Lookup {
+    std::string host;
+    std::string port;
+    bool done = false;
+    bool consumed = false;
+    int error = 0;              // getaddrinfo() code
+    std::vector<sockaddr_storage> addrs;
+    std::vector<socklen_t> lens;
+};
+
+// Shared with the resolver threads, which may outlive probe(): getaddrinfo
+// cannot be cancelled, so a slow name is abandoned rather than waited for.
+struct Resolver {
+    std::mutex mutex;
+    std::vector<Lookup> lookups;
+    int wakeFd = -1;
+    // Set when probe() returns; names still queued are not looked up
+    std::atomic<bool> abandoned{false};
+
+    ~Resolver() {
+        if (wakeFd >= 0) ::close(wakeFd);
+    }
+};
+
+void resolve(Lookup& lookup, int flags, std::mutex* mutex) {
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = flags;
+    addrinfo* list = nullptr;
+    const int error = getaddrinfo(lookup.host.c_str(), lookup.port.c_str(), &hints, &list);
+
+    std::unique_lock<std::mutex> lock;
+    if (mutex) lock = std::unique_lock<std::mutex>(*mutex);
+    lookup.error = error;
+    for (addrinfo* ai = list; ai && int(lookup.addrs.size()) < MaxAddresses; ai = ai->ai_next) {
+        sockaddr_storage addr{};
+        memcpy(&addr, ai->ai_addr, ai->ai_addrlen);
+        lookup.addrs.push_back(addr);
+        lookup.lens.push_back(ai->ai_addrlen);
+    }
+    if (list) freeaddrinfo(list);
+    lookup.done = true;
+}
+
+// A few threads that do every name lookup, started as needed and kept.
+// A thread per name let a large batch, or one against a dead DNS server,
+// pile up threads without limit; now such names wait in the queue and
+// end up as Unknown at the deadline, like any other slow lookup.
+class ResolverPool {
+public:
+    static ResolverPool& instance() {
+        // Never destroyed: its threads may still be in getaddrinfo at exit
+        static ResolverPool* pool = new ResolverPool;
+        return *pool;
+    }
+
+    // Looks up resolver->lookups[index] and wakes the resolver's probe;
+    // false if no thread could be started to do it
+    bool submit(const std::shared_ptr<Resolver>& resolver, size_t index) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Idle threads that have not woken yet already have a job each
+        if (int(jobs_.size()) >= idle_ && threads_ < ResolverThreads) {
+            try {
+                std::thread(&ResolverPool::run, this).detach();
+                ++threads_;
+            } catch (const std::system_error&) {
+                if (threads_ == 0) return false;
+            }
+        }
+        jobs_.push_back({resolver, index});
+        ready_.notify_one();
+        return true;
+    }
+
+private:
+    struct Job {
+        std::shared_ptr<Resolver> resolver;
+        size_t index = 0;
+    };
+
+    void run() {
+        for (;;) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                ++idle_;
+                ready_.wait(lock, [this]() { return !jobs_.empty(); });
+                --idle_;
+                job = std::move(jobs_.front());
+                jobs_.pop_front();
+            }
+            Resolver& resolver = *job.resolver;
+            if (resolver.abandoned.load()) continue;
+            resolve(resolver.lookups[job.index], AI_ADDRCONFIG, &resolver.mutex);
+            const uint64_t one = 1;
+            ssize_t ignored = ::write(resolver.wakeFd, &one, sizeof(one));
+            (void)ignored;
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::deque<Job> jobs_;
+    int threads_ = 0;
+    int idle_ = 0;
+};
+
+Reach fromErrno(int error) {
+    switch (error) {
+    case ECONNREFUSED: return Reach::Refused;
+    case ETIMEDOUT: return Reach::TimedOut;
+    case EHOSTUNREACH:
+    case ENETUNREACH:
+    case EHOSTDOWN:
+    case ENETDOWN: return Reach::Unreachable;
+    default: return Reach::Unknown;
+    }
+}
+
+// Which failure speaks for a host when each of its addresses failed
+int rank(Reach reach) {
+    switch (reach) {
+    case Reach::Refused: return 3;
+    case Reach::Unreachable: return 2;
+    case Reach::TimedOut: return 1;
+    default: return 0;
+    }
+}
+
+struct Attempt {
+    int fd = -1;
+    int target = -1;
+    bool connected = false;
+    std::string received;
+};
+
+struct TargetState {
+    int lookup = -1;
+    bool decided = false;
+    int open = 0;               // Attempts still in flight
+    bool connected = false;
+    Reach failure = Reach::Unknown;
+};
+
+} // namespace
+
+bool ReachResult::failed() const {
+    switch (reach) {
+    case Reach::Refused:
+    case Reach::TimedOut:
+    case Reach::Unresolved:
+    case Reach::Unreachable:
+    case Reach::NotSsh:
+        return true;
+    case Reach::Unknown:
+    case Reach::Reachable:
+        break;
+    }
+    return false;
+}
+
+QString ReachResult::describe() const {
+    // Same wording as OutputScanner::describe(), so metrics classify both alike
+    switch (reach) {
+    case Reach::Unknown: return "Not checked";
+    case Reach::Reachable: return banner.isEmpty() ? "Reachable" : "Reachable (" + banner + ")";
+    case Reach::Refused: return "Connection refused";
+    case Reach::TimedOut: return "Connection timed out";
+    case Reach::Unresolved: return "Could not resolve the host name";
+    case Reach::Unreachable: return "Host unreachable (no route to host)";
+    case Reach::NotSsh: return "No SSH server answered on this port";
+    }
+    return QString();
+}
+
+QVector<SshHostConfig> Reachability::sshConfig(const QVector<ReachTarget>& targets, int timeoutMs) {
+    QVector<SshHostConfig> configs(targets.size());
+    if (QStandardPaths::findExecutable("ssh").isEmpty()) return configs;
+
+    ConfigCache& cache = ConfigCache::instance();
+    const QVector<int> missing = cache.lookup(targets, configs);
+    for (int first = 0; first < missing.size(); first += SshConfigBatch) {
+        const int last = qMin(first + SshConfigBatch, int(missing.size()));
+        std::vector<std::unique_ptr<QProcess>> procs;
+        for (int m = first; m < last; ++m) {
+            const ReachTarget& target = targets[missing[m]];
+            auto proc = std::make_unique<QProcess>();
+            proc->start("ssh", {"-G", "-p", QString::number(target.port), target.host});
+            procs.push_back(std::move(proc));
+        }
+        // Per batch: a budget shared by all of them left later batches
+        // with nothing, and their hosts unchecked
+        QElapsedTimer clock;
+        clock.start();
+        for (int m = first; m < last; ++m) {
+            QProcess* proc = procs[m - first].get();
+            const int left = qMax(0, timeoutMs - int(clock.elapsed()));
+            if (!proc->waitForFinished(left) || proc->exitStatus() != QProcess::NormalExit ||
+                proc->exitCode() != 0) {
+                if (proc->state() != QProcess::NotRunning) {
+                    proc->kill();
+                    proc->waitForFinished(100);
+                }
+                continue;
+            }
+            SshHostConfig& config = configs[missing[m]];
+            config.ok = true;
+            for (const QByteArray& line : proc->readAllStandardOutput().split('\n')) {
+                const int space = line.indexOf(' ');
+                if (space < 0) continue;
+                const QByteArray key = line.left(space).toLower();
+                const QString value = QString::fromUtf8(line.mid(space + 1).trimmed());
+                if (key == "hostname") {
+                    config.hostName = value;
+                } else if (key == "port") {
+                    config.port = value.toInt();
+                } else if ((key == "proxyjump" || key == "proxycommand") && value != "none") {
+                    config.proxied = true;
+                } else if (key == "hostkeyalias") {
+                    config.hostKeyAlias = value;
+                } else if (key == "userknownhostsfile" || key == "globalknownhostsfile") {
+                    QStringList& files = key == "userknownhostsfile" ? config.userKnownHosts
+                                                                     : config.globalKnownHosts;
+                    for (const QString& file : value.split(' ', Qt::SkipEmptyParts)) files << expandPath(file);
+                } else if (key == "hashknownhosts") {
+                    config.hashKnownHosts = value == "yes";
+                }
+            }
+            cache.store(targets[missing[m]], config);
+        }
+    }
+    return configs;
+}
+
+Reachability::Reachability(QObject* parent)
+    : QObject(parent), deadlineMs_(DefaultDeadlineMs), readBanner_(true),
+      reachableTtlMs_(ReachableTtlMs), failedTtlMs_(FailedTtlMs) {
+}
+
+void Reachability::setTtl(int reachableMs, int failedMs) {
+    reachableTtlMs_ = reachableMs;
+    failedTtlMs_ = failedMs;
+}
+
+bool Reachability::cached(const SSHHost& host, ReachResult& result) const {
+    auto it = cache_.constFind(keyFor(host.host, host.port));
+    if (it == cache_.constEnd()) return false;
+    // Unknown is re-checked as soon as a failure would be
+    const int ttl = it->result.reach == Reach::Reachable ? reachableTtlMs_ : failedTtlMs_;
+    if (it->age.elapsed() >= ttl) return false;
+    result = it->result;
+    return true;
+}
+
+void Reachability::invalidate(const SSHHost& host) {
+    cache_.remove(keyFor(host.host, host.port));
+}
+
+void Reachability::prefetch(const QList<SSHHost>& hosts) {
+    QVector<ReachTarget> targets;
+    ReachResult result;
+    for (const SSHHost& host : hosts) {
+        const QString key = keyFor(host.host, host.port);
+        if (host.host.isEmpty() || inFlight_.contains(key) || cached(host, result)) continue;
+        inFlight_.insert(key);
+        targets.append({host.host, host.port});
+    }
+    if (!targets.isEmpty()) launch(targets);
+}
+
+void Reachability::check(const SSHHost& host, QObject* context,
+                         std::function<void(const ReachResult&)> done) {
+    ReachResult result;
+    if (host.host.isEmpty() || cached(host, result)) {
+        done(result);
+        return;
+    }
+    const QString key = keyFor(host.host, host.port);
+    waiters_[key].append({QPointer<QObject>(context), std::move(done)});
+    if (inFlight_.contains(key)) return;
+    inFlight_.insert(key);
+    launch({{host.host, host.port}});
+}
+
+void Reachability::launch(const QVector<ReachTarget>& targets) {
+    QPointer<Reachability> self(this);
+    const int deadlineMs = deadlineMs_;
+    const bool readBanner = readBanner_;
+    QThreadPool::globalInstance()->start([self, targets, deadlineMs, readBanner]() {
+        const QVector<ReachResult> results = probe(targets, deadlineMs, readBanner);
+        QMetaObject::invokeMethod(QCoreApplication::instance(), [self, targets, results]() {
+            if (self) self->deliver(targets, results);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void Reachability::deliver(const QVector<ReachTarget>& targets, const QVector<ReachResult>& results) {
+    for (int i = 0; i < targets.size(); ++i) {
+        const QString key = keyFor(targets[i].host, targets[i].port);
+        const ReachResult& result = results[i];
+        Entry& entry = cache_[key];
+        entry.result = result;
+        entry.age.start();
+        inFlight_.remove(key);
+        if (result.failed()) {
+            console.log("Pre-flight:", key.toStdString(), result.describe().toStdString(),
+                        "after", result.ms, "ms");
+        }
+        emit checked(targets[i].host, targets[i].port, result);
+
+        // Taken first: a callback may well start the next check
+        const QList<Waiter> waiters = waiters_.take(key);
+        for (const Waiter& waiter : waiters) {
+            if (waiter.context) waiter.done(result);
+        }
+    }
+}
+
+QVector<ReachResult> Reachability::probe(const QVector<ReachTarget>& targets, int deadlineMs,
+                                         bool readBanner) {
+    QElapsedTimer clock;
+    clock.start();
+    QVector<ReachResult> results(targets.size());
+    if (targets.isEmpty()) return results;
+
+    // Where ssh would really connect to. An alias in ~/.ssh/config probed
+    // as given would look unresolvable, and a ProxyJump host may not be
+    // routable from here at all; neither must fail a mount that ssh can do.
+    // Without ssh, sshfs fails anyway and the names are all there is.
+    const bool haveSsh = !QStandardPaths::findExecutable("ssh").isEmpty();
+    const QVector<SshHostConfig> configs = haveSsh ? sshConfig(targets, qMin(deadlineMs, SshConfigMs))
+                                                   : QVector<SshHostConfig>();
+    // Several batches of ssh -G must not eat into the connect deadline
+    clock.restart();
+    QVector<Endpoint> endpoints;
+    for (int t = 0; t < targets.size(); ++t) {
+        Endpoint endpoint{targets[t].host, targets[t].port, false};
+        if (haveSsh) {
+            const SshHostConfig& config = configs[t];
+            endpoint.skip = !config.ok || config.proxied;
+            if (!config.hostName.isEmpty()) endpoint.host = config.hostName;
+            if (config.port > 0) endpoint.port = config.port;
+        }
+        endpoints.append(endpoint);
+    }
+
+    std::vector<TargetState> states(targets.size());
+    std::vector<Attempt> attempts;
+    auto resolver = std::make_shared<Resolver>();
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    resolver->wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epfd < 0 || resolver->wakeFd < 0) {
+        if (epfd >= 0) ::close(epfd);
+        console.warn("Pre-flight unavailable:", strerror(errno));
+        return results;
+    }
+    epoll_event wake{};
+    wake.events = EPOLLIN;
+    wake.data.u64 = WakeTag;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, resolver->wakeFd, &wake);
+
+    auto decide = [&](int target, Reach reach, const QString& banner = QString()) {
+        TargetState& state = states[target];
+        if (state.decided) return;
+        state.decided = true;
+        results[target].reach = reach;
+        results[target].ms = clock.elapsed();
+        results[target].banner = banner;
+        for (Attempt& attempt : attempts) {
+            if (attempt.target != target || attempt.fd < 0) continue;
+            ::close(attempt.fd);
+            attempt.fd = -1;
+        }
+    };
+    // One address gave up; the host has failed once all of them have
+    auto attemptFailed = [&](Attempt& attempt, Reach reach) {
+        if (attempt.fd >= 0) ::close(attempt.fd);
+        attempt.fd = -1;
+        TargetState& state = states[attempt.target];
+        if (rank(reach) >= rank(state.failure)) state.failure = reach;
+        if (--state.open == 0 && !state.decided) {
+            decide(attempt.target, state.connected ? Reach::Reachable : state.failure);
+        }
+    };
+    auto connected = [&](size_t index) {
+        Attempt& attempt = attempts[index];
+        TargetState& state = states[attempt.target];
+        if (!readBanner) {
+            decide(attempt.target, Reach::Reachable);
+            return;
+        }
+        attempt.connected = true;
+        state.connected = true;
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.u64 = index;
+        epoll_ctl(epfd, EPOLL_CTL_MOD, attempt.fd, &ev);
+    };
+    auto startConnects = [&](int target, const Lookup& lookup) {
+        if (lookup.error != 0) {
+            const bool unknownName = lookup.error == EAI_NONAME
+#ifdef EAI_NODATA
+                || lookup.error == EAI_NODATA
+#endif
+                ;
+            // EAI_AGAIN and friends are the resolver's trouble, not the host's
+            decide(target, unknownName ? Reach::Unresolved : Reach::Unknown);
+            return;
+        }
+        TargetState& state = states[target];
+        for (size_t a = 0; a < lookup.addrs.size(); ++a) {
+            const sockaddr* addr = reinterpret_cast<const sockaddr*>(&lookup.addrs[a]);
+            int fd = ::socket(addr->sa_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            if (fd < 0) continue;
+            attempts.push_back({fd, target, false, std::string()});
+            const size_t index = attempts.size() - 1;
+            ++state.open;
+            if (::connect(fd, addr, lookup.lens[a]) == 0) {
+                // Loopback completes at once
+                epoll_event ev{};
+                ev.events = EPOLLOUT;
+                ev.data.u64 = index;
+                epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+                connected(index);
+            } else if (errno == EINPROGRESS) {
+                epoll_event ev{};
+                ev.events = EPOLLOUT;
+                ev.data.u64 = index;
+                epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+            } else {
+                attemptFailed(attempts[index], fromErrno(errno));
+            }
+            if (state.decided) return;
+        }
+        if (state.open == 0) decide(target, state.failure);
+    };
+    auto collectLookups = [&]() {
+        std::vector<int> ready;
+        {
+            std::lock_guard<std::mutex> lock(resolver->mutex);
+            for (size_t l = 0; l < resolver->lookups.size(); ++l) {
+                Lookup& lookup = resolver->lookups[l];
+                if (!lookup.done || lookup.consumed) continue;
+                lookup.consumed = true;
+                ready.push_back(int(l));
+            }
+        }
+        // Done lookups are no longer written to; no lock needed past here
+        for (int l : ready) {
+            for (int t = 0; t < int(states.size()); ++t) {
+                if (states[t].lookup == l && !states[t].decided) startConnects(t, resolver->lookups[l]);
+            }
+        }
+    };
+
+    // One lookup per distinct host and port; the vector is sized before
+    // any lookup is queued and never reallocated
+    QHash<QString, int> lookupByKey;
+    for (int t = 0; t < endpoints.size(); ++t) {
+        if (endpoints[t].skip || endpoints[t].host.isEmpty()) {
+            states[t].decided = true;
+            results[t].ms = clock.elapsed();
+            continue;
+        }
+        const QString key = keyFor(endpoints[t].host, endpoints[t].port);
+        auto it = lookupByKey.constFind(key);
+        if (it == lookupByKey.constEnd()) {
+            it = lookupByKey.insert(key, int(resolver->lookups.size()));
+            Lookup lookup;
+            lookup.host = endpoints[t].host.toStdString();
+            lookup.port = std::to_string(endpoints[t].port);
+            resolver->lookups.push_back(std::move(lookup));
+        }
+        states[t].lookup = it.value();
+    }
+    for (size_t l = 0; l < resolver->lookups.size(); ++l) {
+        Lookup& lookup = resolver->lookups[l];
+        // Addresses need no thread
+        resolve(lookup, AI_NUMERICHOST, nullptr);
+        if (lookup.error == 0) continue;
+        lookup.done = false;
+        lookup.error = 0;
+        if (!ResolverPool::instance().submit(resolver, l)) {
+            lookup.done = true;
+            lookup.error = EAI_AGAIN;
+        }
+    }
+    collectLookups();
+
+    epoll_event events[64];
+    for (;;) {
+        bool pending = false;
+        for (const TargetState& state : states) pending = pending || !state.decided;
+        const int left = deadlineMs - int(clock.elapsed());
+        if (!pending || left <= 0) break;
+
+        const int n = epoll_wait(epfd, events, 64, left);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) break;
+        for (int i = 0; i < n; ++i) {
+            if (events[i].data.u64 == WakeTag) {
+                uint64_t count;
+                ssize_t ignored = ::read(resolver->wakeFd, &count, sizeof(count));
+                (void)ignored;
+                collectLookups();
+                continue;
+            }
+            const size_t index = size_t(events[i].data.u64);
+            Attempt& attempt = attempts[index];
+            if (attempt.fd < 0 || states[attempt.target].decided) continue;
+
+            if (!attempt.connected) {
+                int error = 0;
+                socklen_t len = sizeof(error);
+                getsockopt(attempt.fd, SOL_SOCKET, SO_ERROR, &error, &len);
+                if (error != 0) attemptFailed(attempt, fromErrno(error));
+                else connected(index);
+                continue;
+            }
+
+            // Waiting for "SSH-2.0-..."; servers may send other lines first
+            char buf[BannerBytes];
+            const ssize_t got = ::recv(attempt.fd, buf, sizeof(buf), 0);
+            if (got < 0 && (errno == EAGAIN || errno == EINTR)) continue;
+            if (got > 0) attempt.received.append(buf, size_t(got));
+            const std::string& text = attempt.received;
+            const size_t at = text.compare(0, 4, "SSH-") == 0 ? 0 : text.find("\nSSH-");
+            if (at != std::string::npos) {
+                const size_t begin = at == 0 ? 0 : at + 1;
+                const size_t end = text.find_first_of("\r\n", begin);
+                if (end == std::string::npos && got > 0 && text.size() < size_t(BannerBytes)) continue;
+                decide(attempt.target, Reach::Reachable,
+                       QString::fromStdString(text.substr(begin, end == std::string::npos ? end : end - begin)));
+            } else if (text.size() >= size_t(BannerBytes)) {
+                decide(attempt.target, Reach::NotSsh);
+            } else if (got <= 0) {
+                // Closed: a full sshd (MaxStartups) says nothing, other
+                // services usually say something else first
+                if (text.empty()) attemptFailed(attempt, Reach::Unknown);
+                else decide(attempt.target, Reach::NotSsh);
+            }
+        }
+    }
+
+    // Out of time: connected but quiet is still reachable, and a name that
+    // is slow to resolve is no verdict on the host
+    for (int t = 0; t < int(states.size()); ++t) {
+        TargetState& state = states[t];
+        if (state.decided) continue;
+        bool resolved = false;
+        {
+            std::lock_guard<std::mutex> lock(resolver->mutex);
+            resolved = state.lookup >= 0 && resolver->lookups[state.lookup].done;
+        }
+        if (state.connected) decide(t, Reach::Reachable);
+        else if (!resolved || state.open == 0) decide(t, Reach::Unknown);
+        else decide(t, Reach::TimedOut);
+    }
+    resolver->abandoned.store(true);
+    ::close(epfd);
+    return results;
+}
+
+#include "reachability.moc"
@@ -0,0 +1,122 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#pragma once
+
+#include "ssh_store.hpp"
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QSet>
+#include <QStringList>
+#include <QVector>
+#include <functional>
+
+enum class Reach {
+    Unknown,        // Not checked, or no verdict (proxied host, slow DNS)
+    Reachable,
+    Refused,
+    TimedOut,
+    Unresolved,
+    Unreachable,    // No route to host or network
+    NotSsh          // Something answered, but not with an SSH banner
+};
+
+struct ReachResult {
+    Reach reach = Reach::Unknown;
+    qint64 ms = -1;             // Time to the verdict
+    QString banner;             // "SSH-2.0-OpenSSH_9.6", if read
+
+    // Only definite failures; Unknown never stops a mount
+    bool failed() const;
+    QString describe() const;
+};
+
+struct ReachTarget {
+    QString host;
+    int port = 22;
+};
+
+// A host as ssh sees it once ~/.ssh/config is applied (`ssh -G`)
+struct SshHostConfig {
+    bool ok = false;            // ssh -G answered
+    QString hostName;
+    int port = 22;
+    bool proxied = false;       // ProxyJump or ProxyCommand
+    QString hostKeyAlias;
+    QStringList userKnownHosts;
+    QStringList globalKnownHosts;
+    bool hashKnownHosts = false;
+};
+
+// TCP pre-flight for mounts. Targets are first mapped through `ssh -G`,
+// so ~/.ssh/config aliases resolve to their real HostName/Port and hosts
+// behind ProxyJump/ProxyCommand are left alone; then every address is
+// connect()ed without blocking, all in one epoll set under one deadline,
+// optionally waiting for the SSH banner. Verdicts are cached briefly so a
+// batch pays for one pre-flight and unreachable hosts fail in milliseconds.
+class Reachability : public QObject {
+    Q_OBJECT
+public:
+    explicit Reachability(QObject* parent = nullptr);
+
+    void setDeadline(int ms) { deadlineMs_ = ms; }
+    void setReadBanner(bool enabled) { readBanner_ = enabled; }
+    // How long verdicts stay valid; failures are re-checked sooner
+    void setTtl(int reachableMs, int failedMs);
+
+    // Starts one parallel pre-flight for every host not cached or in flight
+    void prefetch(const QList<SSHHost>& hosts);
+    bool cached(const SSHHost& host, ReachResult& result) const;
+    // Calls done on this thread with the verdict; at once if it is cached.
+    // Nothing is called if context is destroyed first.
+    void check(const SSHHost& host, QObject* context, std::function<void(const ReachResult&)> done);
+    void invalidate(const SSHHost& host);
+
+    // Runs `ssh -G` for every target at once; entries stay !ok where ssh
+    // is missing or did not answer within timeoutMs. Blocking.
+    static QVector<SshHostConfig> sshConfig(const QVector<ReachTarget>& targets, int timeoutMs);
+
+    // The blocking worker behind prefetch() and check(); one result per target
+    static QVector<ReachResult> probe(const QVector<ReachTarget>& targets, int deadlineMs,
+                                      bool readBanner = true);
+
+signals:
+    void checked(const QString& host, int port, const ReachResult& result);
+
+private:
+    struct Entry {
+        ReachResult result;
+        QElapsedTimer age;
+    };
+    struct Waiter {
+        QPointer<QObject> context;
+        std::function<void(const ReachResult&)> done;
+    };
+
+    static QString keyFor(const QString& host, int port) { return host + ':' + QString::number(port); }
+    void launch(const QVector<ReachTarget>& targets);
+    void deliver(const QVector<ReachTarget>& targets, const QVector<ReachResult>& results);
+
+    int deadlineMs_;
+    bool readBanner_;
+    int reachableTtlMs_;
+    int failedTtlMs_;
+    QHash<QString, Entry> cache_;
+    QSet<QString> inFlight_;
+    QHash<QString, QList<Waiter>> waiters_;
+};
@@ -0,0 +1,61 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#include "runtime_dir.hpp"
+#include <QDir>
+#include <QFile>
+#include <QStandardPaths>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+QString RuntimeDir::path() {
+    const QString base = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation);
+    if (!base.isEmpty()) return base + "/ssh-mounter";
+    // Shared with every other user; the uid keeps each one to their own
+    return QDir::tempPath() + "/ssh-mounter-" + QString::number(::getuid());
+}
+
+bool RuntimeDir::ensure(QString& error) {
+    const QString dir = path();
+    const QByteArray native = QFile::encodeName(dir);
+    if (::mkdir(native.constData(), 0700) == 0) {
+        // mkdir() applies the umask
+        ::chmod(native.constData(), 0700);
+    } else if (errno != EEXIST) {
+        error = QString("Cannot create %1: %2").arg(dir, strerror(errno));
+        return false;
+    }
+
+    struct stat st;
+    if (::lstat(native.constData(), &st) != 0) {
+        error = QString("Cannot stat %1: %2").arg(dir, strerror(errno));
+        return false;
+    }
+    if (!S_ISDIR(st.st_mode)) {
+        error = dir + " is not a directory";
+        return false;
+    }
+    if (st.st_uid != ::getuid()) {
+        error = QString("%1 is owned by uid %2, not %3").arg(dir).arg(st.st_uid).arg(::getuid());
+        return false;
+    }
+    if ((st.st_mode & 07777) != 0700) {
+        error = QString("%1 has mode %2, not 0700").arg(dir).arg(st.st_mode & 07777, 4, 8, QChar('0'));
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,33 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#pragma once
+
+#include <QString>
+
+// The per-user directory the control and metrics sockets live in:
+// $XDG_RUNTIME_DIR/ssh-mounter, or ssh-mounter-UID in the temp directory
+// when there is no runtime directory. Only that one directory is ever
+// created or chmodded; its parent is left as it is.
+class RuntimeDir {
+public:
+    static QString path();
+
+    // Creates path() with mode 0700 if it is missing. One that exists must
+    // be a directory (not a symlink) owned by this user with mode 0700;
+    // anything else is refused rather than fixed, since another user may
+    // control it.
+    static bool ensure(QString& error);
+};
@@ -0,0 +1,141 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#include "ssh_master.hpp"
+#include "mount_manager.hpp"
+#include "console.hpp"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QProcess>
+#include <QStandardPaths>
+
+extern Console console;
+
+SSHMasterPool::SSHMasterPool(QObject* parent) : QObject(parent) {
+}
+
+SSHMasterPool::~SSHMasterPool() {
+    // A master that is still authenticating is abandoned; one that already
+    // forked into the background keeps running until ControlPersist expires.
+    // All are killed first and then reaped against one shared deadline, so
+    // quitting with many masters warming is not a second per process.
+    for (QProcess* p : warming_) {
+        p->disconnect(this);
+        p->kill();
+    }
+    QElapsedTimer clock;
+    clock.start();
+    for (QProcess* p : warming_) {
+        p->waitForFinished(qMax(0, 1000 - int(clock.elapsed())));
+    }
+}
+
+QString SSHMasterPool::socketDir() {
+    QString base = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation);
+    if (base.isEmpty()) base = QDir::homePath() + "/.ssh/mounter";
+    QString dir = base + "/ssh-mounter";
+    if (!QDir(dir).exists() && QDir().mkpath(dir)) {
+        QFile::setPermissions(dir, QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner);
+    }
+    return dir;
+}
+
+QString SSHMasterPool::socketPath(const SSHHost& host) {
+    // Hashed so the path stays well under the 108 byte sun_path limit
+    QByteArray target = QString("%1@%2:%3").arg(host.user).arg(host.host).arg(host.port).toUtf8();
+    QByteArray hash = QCryptographicHash::hash(target, QCryptographicHash::Sha1).toHex().left(20);
+    return socketDir() + "/cm-" + QString::fromLatin1(hash);
+}
+
+QStringList SSHMasterPool::sshOptions(const SSHHost& host) {
+    return {
+        "ControlMaster=auto",
+        "ControlPath=" + socketPath(host),
+        "ControlPersist=" + QString::number(host.controlPersist)
+    };
+}
+
+QStringList SSHMasterPool::checkArgs(const SSHHost& host) {
+    return {
+        "-O", "check",
+        "-o", "ControlPath=" + socketPath(host),
+        "-p", QString::number(host.port),
+        QString("%1@%2").arg(host.user).arg(host.host)
+    };
+}
+
+bool SSHMasterPool::isWarming(const SSHHost& host) const {
+    return warming_.contains(MountManager::keyFor(host));
+}
+
+void SSHMasterPool::warm(const SSHHost& host) {
+    const QString key = MountManager::keyFor(host);
+    if (!enabledFor(host) || !host.usePublicKey || warming_.contains(key)) return;
+    // Already up; an ssh -N attaching to it would only linger as a client
+    if (QFile::exists(socketPath(host))) return;
+
+    QStringList args;
+    // -f backgrounds ssh once it is authenticated, so finished() means the
+    // master is up (or failed); BatchMode makes sure it never prompts.
+    args << "-f" << "-N"
+         << "-o" << "BatchMode=yes"
+         << "-o" << "ConnectTimeout=15";
+    for (const QString& opt : sshOptions(host)) {
+        args << "-o" << opt;
+    }
+    // The master owns the transport, so it has to carry the profile's
+    // cipher and compression choices for everyone who joins it later
+    if (!host.profile.ciphers.isEmpty()) args << "-o" << "Ciphers=" + host.profile.ciphers;
+    args << "-o" << QString("Compression=%1").arg(host.profile.compression ? "yes" : "no");
+    args << "-p" << QString::number(host.port)
+         << QString("%1@%2").arg(host.user).arg(host.host);
+
+    auto* p = new QProcess(this);
+    p->setProcessChannelMode(QProcess::MergedChannels);
+    warming_.insert(key, p);
+
+    connect(p, static_cast<void(QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished),
+            this, [this, p, key, host](int exitCode, QProcess::ExitStatus status) {
+        warming_.remove(key);
+        p->deleteLater();
+        if (exitCode == 0 && status == QProcess::NormalExit) {
+            console.log("Pre-warmed connection to", host.host.toStdString());
+            emit masterReady(key);
+        } else {
+            QString msg = QString::fromLocal8Bit(p->readAll()).trimmed();
+            if (msg.isEmpty()) msg = "ssh exited with code " + QString::number(exitCode);
+            console.warn("Could not pre-warm", host.host.toStdString() + ":", msg.toStdString());
+            emit masterFailed(key, msg);
+        }
+    });
+    connect(p, &QProcess::errorOccurred, this, [this, p, key](QProcess::ProcessError error) {
+        if (error != QProcess::FailedToStart) return;
+        warming_.remove(key);
+        p->deleteLater();
+        emit masterFailed(key, "Failed to start ssh");
+    });
+
+    p->start("ssh", args);
+}
+
+void SSHMasterPool::warmFavorites(const QVector<SSHHost>& hosts) {
+    for (const auto& host : hosts) {
+        if (host.favorite) warm(host);
+    }
+}
+
+#include "ssh_master.moc"
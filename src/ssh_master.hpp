@@ -0,0 +1,61 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#pragma once
+
+#include "ssh_store.hpp"
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QStringList>
+
+class QProcess;
+
+// One OpenSSH ControlMaster socket per user@host:port. sshfs and every
+// other ssh call for a host pass the same ControlPath, so only the first
+// connection pays for TCP setup, key exchange and authentication; the
+// master then stays up for the host's controlPersist seconds after the
+// last client leaves. warm() opens a master in the background ahead of
+// time so a later mount skips the handshake entirely.
+class SSHMasterPool : public QObject {
+    Q_OBJECT
+public:
+    explicit SSHMasterPool(QObject* parent = nullptr);
+    ~SSHMasterPool() override;
+
+    static bool enabledFor(const SSHHost& host) { return host.controlPersist > 0; }
+
+    // $XDG_RUNTIME_DIR/ssh-mounter (private to the user)
+    static QString socketDir();
+    static QString socketPath(const SSHHost& host);
+    // ssh_config options (Key=Value) that attach to or create the master
+    static QStringList sshOptions(const SSHHost& host);
+    // Arguments for `ssh -O check`; exits 0 while a master is running
+    static QStringList checkArgs(const SSHHost& host);
+
+    // Starts a master without prompting; only hosts with key
+    // authentication can be warmed
+    void warm(const SSHHost& host);
+    // warm() for every favorite host that can be warmed
+    void warmFavorites(const QVector<SSHHost>& hosts);
+    bool isWarming(const SSHHost& host) const;
+
+signals:
+    void masterReady(const QString& key);
+    void masterFailed(const QString& key, const QString& error);
+
+private:
+    QHash<QString, QProcess*> warming_;
+};
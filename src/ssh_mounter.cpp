@@ -15,21 +15,42 @@
 
 #include "ssh_mounter.hpp"
 #include "console.hpp"
+#include "ssh_master.hpp"
+#include "mount_table.hpp"
+#include "reachability.hpp"
+#include "known_hosts.hpp"
 #include <QDir>
 #include <QFileInfo>
 #include <QDebug>
-#include <QEventLoop>
 #include <QString>
+#include <QStandardPaths>
+#include <QCoreApplication>
+#include <QPointer>
+#include <QThreadPool>
+#include <QTimer>
+#include <csignal>
 
 extern Console console;
 
 const QString newline = "\n";
 
 SSHMounter::SSHMounter(QObject* parent) 
-    : QObject(parent), process_(nullptr), state_(MountState::Idle) {
+    : QObject(parent), process_(nullptr), masters_(nullptr), reach_(nullptr), masterAlive_(false),
+      state_(MountState::Idle), step_(Step::None),
+      passwordAsked_(false), cancelled_(false), hostKeyMismatch_(false), hostKeyRetried_(false),
+      removeKeyPending_(false), sshfsKilled_(false), stepTimer_(new QTimer(this)) {
+    stepTimer_->setSingleShot(true);
+    connect(stepTimer_, &QTimer::timeout, this, &SSHMounter::onStepTimeout);
+}
+
+SSHMounter::~SSHMounter() {
+    resetProcess();
 }
 
 void SSHMounter::setState(MountState state) {
+    if (state != MountState::Mounting && state != MountState::Unmounting) {
+        mark(&MountTrace::finished);
+    }
     if (state_ != state) {
         state_ = state;
         emit stateChanged(state);
@@ -37,10 +58,8 @@ void SSHMounter::setState(MountState state) {
 }
 
 bool SSHMounter::checkSSHFSInstalled() {
-    QProcess p;
-    p.start("which", {"sshfs"});
-    p.waitForFinished(2000);
-    return p.exitCode() == 0;
+    // PATH scan in-process; no need to fork `which`
+    return !QStandardPaths::findExecutable("sshfs").isEmpty();
 }
 
 bool SSHMounter::checkFUSEAvailable() {
@@ -66,23 +85,87 @@ QString SSHMounter::checkWritePermission(const QString& path) {
     return QString(); // Empty = OK
 }
 
-bool SSHMounter::mount(const SSHHost& host) {
+void SSHMounter::mount(const SSHHost& host) {
     if (state_ != MountState::Idle && state_ != MountState::Error) {
         emit mountError("Already busy with another operation");
-        return false;
+        return;
     }
     
     currentHost_ = host;
+    password_.clear();
+    passwordAsked_ = false;
+    hostKeyRetried_ = false;
+    startTrace(false);
     setState(MountState::Mounting);
     
-    // Validate local path
-    QString writeErr = checkWritePermission(host.localPath);
+    QStringList profileErrors = host.profile.validate();
+    if (!profileErrors.isEmpty()) {
+        setState(MountState::Error);
+        emit mountError("Invalid performance profile: " + profileErrors.join("; "));
+        return;
+    }
+    
+    // Validate local path off the UI thread: a stale mount below it would
+    // block stat() until the kernel gives up.
+    step_ = Step::CheckPath;
+    QPointer<SSHMounter> self(this);
+    const QString path = host.localPath;
+    QThreadPool::globalInstance()->start([self, path]() {
+        QString writeErr = checkWritePermission(path);
+        QMetaObject::invokeMethod(QCoreApplication::instance(), [self, writeErr]() {
+            if (self && self->step_ == Step::CheckPath) self->onPathChecked(writeErr);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void SSHMounter::onPathChecked(const QString& writeErr) {
+    step_ = Step::None;
+    mark(&MountTrace::pathChecked);
+    const SSHHost& host = currentHost_;
     if (!writeErr.isEmpty()) {
         setState(MountState::Error);
         emit mountError(writeErr);
-        return false;
+        return;
+    }
+    
+    // A live master means no handshake and no password prompt. Only ask
+    // ssh when its socket exists; otherwise sshfs becomes the master.
+    masterAlive_ = false;
+    if (masters_ && SSHMasterPool::enabledFor(host) && QFile::exists(SSHMasterPool::socketPath(host))) {
+        startProcess(Step::CheckMaster, "ssh", SSHMasterPool::checkArgs(host));
+        return;
+    }
+    
+    preflight();
+}
+
+void SSHMounter::preflight() {
+    if (!reach_) {
+        startSshfs();
+        return;
     }
     
+    // A host that is down fails here in milliseconds instead of holding a
+    // slot, and a password, until ssh's own connect times out
+    step_ = Step::Preflight;
+    reach_->check(currentHost_, this, [this](const ReachResult& result) {
+        if (step_ != Step::Preflight) return;
+        step_ = Step::None;
+        if (!result.failed()) {
+            startSshfs();
+            return;
+        }
+        QString msg = QString("%1 (%2 port %3, checked in %4 ms)")
+            .arg(result.describe(), currentHost_.host).arg(currentHost_.port).arg(result.ms);
+        finishMount(MountState::Error);
+        emit mountError(msg);
+        console.log("Mount failed:", msg.toStdString());
+    });
+}
+
+void SSHMounter::startSshfs() {
+    const SSHHost& host = currentHost_;
+    
     // Build sshfs command
     QString remote = QString("%1@%2:%3")
         .arg(host.user)
@@ -93,10 +176,16 @@ bool SSHMounter::mount(const SSHHost& host) {
     args << remote << host.localPath;
     args << "-p" << QString::number(host.port);
 
-    QString options = "reconnect,ServerAliveInterval=15,ServerAliveCountMax=3,max_conns=16";
+    QString options = host.profile.optionString();
+    const bool askPassword = !host.usePublicKey && !masterAlive_;
+    if (masters_ && SSHMasterPool::enabledFor(host)) {
+        options += "," + SSHMasterPool::sshOptions(host).join(",");
+    }
     if (!host.usePublicKey) {
-        // If not using public key, use password authentication and disable pubkey
-        options += ",password_stdin,PubkeyAuthentication=no";
+        // If not using public key, use password authentication and disable pubkey.
+        // Over an existing master there is nothing to authenticate.
+        if (askPassword) options += ",password_stdin";
+        options += ",PubkeyAuthentication=no";
     } else {
         // If using public key, disable password authentication
         options += ",PasswordAuthentication=no";
@@ -106,177 +195,384 @@ bool SSHMounter::mount(const SSHHost& host) {
     console.log("Mounting: sshfs", args.join(" ").toStdString());
     emit progressMessage("Connecting to " + host.host + "...");
     
-    if (process_) {
-        delete process_;
-    }
-    
-    process_ = new QProcess(this);
-    process_->setProcessChannelMode(QProcess::MergedChannels);
+    hostKeyMismatch_ = false;
+    removeKeyPending_ = false;
+    startProcess(Step::Sshfs, "sshfs", args);
     
-    // Create event loop but don't start it yet
-    QEventLoop loop;
-    connect(process_, static_cast<void(QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished), 
-            &loop, &QEventLoop::quit);
-    connect(process_, &QProcess::errorOccurred, &loop, &QEventLoop::quit);
-    
-    // Connect our regular handlers
-    connect(process_, &QProcess::readyReadStandardOutput, this, &SSHMounter::onProcessOutput);
-    connect(process_, &QProcess::readyReadStandardError, this, &SSHMounter::onProcessOutput);
-    
-    // For password auth, emit password prompt before starting
-    if (!host.usePublicKey) {
-        emit passwordRequired();
-    }
-    
-    process_->start("sshfs", args);
-    
-    // Now wait for completion
-    loop.exec();    
-    if (process_->exitCode() == 0 && process_->exitStatus() == QProcess::NormalExit) {
-        setState(MountState::Idle);
-        emit mountSuccess();
-        console.log("Mount successful:", currentHost_.name.toStdString());
-        return true;
-    } else {
-        setState(MountState::Error);
-        QByteArray errors = process_->readAllStandardError();
-        QString msg = errors.isEmpty() ? "Mount failed with unknown error" : errors;
-        if (process_->error() == QProcess::FailedToStart) {
-            msg = "Failed to start sshfs. Is it installed and in your PATH?";
+    if (!askPassword || !process_) return;
+    // Only once sshfs runs: a failed start is reported as an error, and a
+    // password prompt on top of it would ask for nothing
+    connect(process_, &QProcess::started, this, [this]() {
+        if (step_ != Step::Sshfs) return;
+        if (!password_.isEmpty()) {
+            // Retrying after a host key change; don't ask twice
+            supplyPassword(password_);
+        } else {
+            // Ask for the password right away; it is buffered until sshfs
+            // reads it from stdin.
+            passwordAsked_ = true;
+            mark(&MountTrace::prompted);
+            emit passwordRequired();
         }
-        emit mountError(msg);
-        console.log("Mount failed:", msg.toStdString());
-        return false;
-    }
+    });
 }
 
-void SSHMounter::unmount(const QString& localPath) {
+void SSHMounter::unmount(const QString& localPath, const UnmountOptions& options) {
     if (state_ == MountState::Mounting || state_ == MountState::Unmounting) {
         emit mountError("Already busy with another operation");
         return;
     }
     
+    unmountPath_ = localPath;
+    unmountOptions_ = options;
+    sshfsKilled_ = false;
+    startTrace(true);
     setState(MountState::Unmounting);
     emit progressMessage("Unmounting " + localPath + "...");
-    
-    if (process_) {
-        delete process_;
+    startUnmount(Step::Unmount);
+}
+
+void SSHMounter::startUnmount(Step step) {
+    const bool lazy = step == Step::UnmountLazy;
+#ifdef Q_OS_MAC
+    startProcess(step, "umount", lazy ? QStringList{"-f", unmountPath_} : QStringList{unmountPath_});
+#else
+    startProcess(step, "fusermount", {lazy ? "-uz" : "-u", unmountPath_});
+#endif
+    if (unmountOptions_.stepTimeoutMs > 0) stepTimer_->start(unmountOptions_.stepTimeoutMs);
+}
+
+void SSHMounter::onStepTimeout() {
+    if (step_ != Step::Unmount && step_ != Step::UnmountLazy) return;
+    const Step step = step_;
+    // A fusermount stuck on a dead connection; give up on this attempt
+    resetProcess();
+    step_ = Step::None;
+    onUnmountFailed(step, QString("Unmount of %1 did not finish within %2 s")
+        .arg(unmountPath_).arg(unmountOptions_.stepTimeoutMs / 1000.0));
+}
+
+void SSHMounter::onUnmountFailed(Step failed, const QString& error) {
+    // Who keeps it busy, and which sshfs to kill if it comes to that;
+    // a /proc walk, so not on the UI thread
+    step_ = Step::ScanHolders;
+    QPointer<SSHMounter> self(this);
+    const QString path = QDir::cleanPath(unmountPath_);
+    const bool needPid = unmountOptions_.escalate && failed == Step::UnmountLazy && !sshfsKilled_;
+    QThreadPool::globalInstance()->start([self, path, failed, error, needPid]() {
+        const QString holders = MountTable::describeProcesses(MountTable::holders(path, 16));
+        const pid_t sshfs = needPid ? MountTable::sshfsPid(path) : 0;
+        QMetaObject::invokeMethod(QCoreApplication::instance(), [self, failed, error, holders, sshfs]() {
+            if (self && self->step_ == Step::ScanHolders) self->onHoldersScanned(failed, error, holders, sshfs);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void SSHMounter::onHoldersScanned(Step failed, const QString& error, const QString& holders, pid_t sshfs) {
+    step_ = Step::None;
+    if (!holders.isEmpty()) console.warn(unmountPath_.toStdString(), "is in use by", holders.toStdString());
+
+    if (unmountOptions_.escalate && failed == Step::Unmount) {
+        // Detach now; the kernel finishes once the last user lets go
+        console.warn("Unmount failed, detaching lazily:", error.section('\n', 0, 0).toStdString());
+        emit progressMessage("Detaching " + unmountPath_ + "...");
+        startUnmount(Step::UnmountLazy);
+        return;
+    }
+    if (unmountOptions_.escalate && failed == Step::UnmountLazy && !sshfsKilled_ && sshfs > 0) {
+        console.warn("Lazy unmount failed; stopping sshfs", sshfs);
+        emit progressMessage("Stopping sshfs for " + unmountPath_ + "...");
+        sshfsKilled_ = true;
+        step_ = Step::KillSshfs;
+        ::kill(sshfs, SIGTERM);
+        QPointer<SSHMounter> self(this);
+        QTimer::singleShot(1000, this, [self, sshfs]() {
+            if (!self || self->step_ != Step::KillSshfs) return;
+            if (::kill(sshfs, 0) == 0) ::kill(sshfs, SIGKILL);
+            // The FUSE connection is gone now; the mount point only needs detaching
+            self->startUnmount(Step::UnmountLazy);
+        });
+        return;
     }
+
+    setState(MountState::Error);
+    QString msg = error;
+    if (!holders.isEmpty()) msg += "\n\nIn use by: " + holders;
+    emit mountError(msg);
+    console.log("Unmount failed:", msg.toStdString());
+}
+
+void SSHMounter::startProcess(Step step, const QString& program, const QStringList& args) {
+    resetProcess();
+    cancelled_ = false;
+    step_ = step;
     
     process_ = new QProcess(this);
-    connect(process_, static_cast<void(QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished), this, &SSHMounter::onProcessFinished);
+    // ssh writes prompts and errors to stderr; one stream keeps their
+    // order and lets a single scanner see everything.
+    process_->setProcessChannelMode(QProcess::MergedChannels);
+    scanner_.reset();
+    
+    // Every step is driven from these signals; nothing here waits for the
+    // child, so many sessions can have processes in flight at once.
+    connect(process_, static_cast<void(QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished), 
+            this, &SSHMounter::onProcessFinished);
     connect(process_, &QProcess::errorOccurred, this, &SSHMounter::onProcessError);
+    connect(process_, &QProcess::readyReadStandardOutput, this, &SSHMounter::onProcessOutput);
+    if (step == Step::Sshfs || step == Step::Unmount || step == Step::UnmountLazy) {
+        connect(process_, &QProcess::started, this, [this]() { mark(&MountTrace::spawned); });
+    }
     
-#ifdef Q_OS_MAC
-    process_->start("umount", {localPath});
-#else
-    process_->start("fusermount", {"-u", localPath});
-#endif
+    process_->start(program, args);
+}
+
+void SSHMounter::resetProcess() {
+    if (!process_) return;
+    // Detach first so a still-running child can't call back into us
+    // while it is being torn down.
+    process_->disconnect(this);
+    if (process_->state() != QProcess::NotRunning) {
+        process_->kill();
+    }
+    process_->deleteLater();
+    process_ = nullptr;
 }
 
 void SSHMounter::onProcessFinished(int exitCode, QProcess::ExitStatus status) {
-    QString output = process_->readAllStandardOutput();
-    QString errors = process_->readAllStandardError();
+    if (!process_) return;
     
-    if (!output.isEmpty()) console.log("stdout:", output.toStdString());
-    if (!errors.isEmpty()) console.log("stderr:", errors.toStdString());
+    // The last chunk can still hold the host key banner
+    const QVector<OutputEvent> events = readOutput();
+    if (step_ == Step::Sshfs) handleEvents(events);
     
-    if (state_ == MountState::Mounting) {
-        if (exitCode == 0 && status == QProcess::NormalExit) {
-            setState(MountState::Idle);
+    bool ok = exitCode == 0 && status == QProcess::NormalExit;
+    Step step = step_;
+    step_ = Step::None;
+    
+    switch (step) {
+    case Step::CheckMaster:
+        masterAlive_ = ok;
+        mark(&MountTrace::masterChecked);
+        trace_.reusedMaster = ok;
+        if (ok) {
+            console.log("Reusing shared connection to", currentHost_.host.toStdString());
+            startSshfs();
+        } else {
+            preflight();
+        }
+        break;
+        
+    case Step::Sshfs:
+        if (cancelled_) {
+            finishMount(MountState::Idle);
+            emit mountCancelled();
+            console.log("Mount cancelled:", currentHost_.name.toStdString());
+        } else if (ok) {
+            finishMount(MountState::Idle);
             emit mountSuccess();
             console.log("Mount successful:", currentHost_.name.toStdString());
+        } else if (hostKeyMismatch_ && !hostKeyRetried_) {
+            // Stay in Mounting until the user answers hostKeyMismatch()
+            // through removeHostKey() or keepHostKey().
+            step_ = Step::HostKeyPrompt;
+            emit progressMessage("Host key for " + currentHost_.host + " has changed");
+            if (removeKeyPending_) removeHostKey();
         } else {
-            setState(MountState::Error);
-            QString msg = errors.isEmpty() ? "Mount failed" : errors;
+            finishMount(MountState::Error);
+            QString msg = failureMessage("Mount failed");
             emit mountError(msg);
             console.log("Mount failed:", msg.toStdString());
         }
-    } else if (state_ == MountState::Unmounting) {
-        if (exitCode == 0 && status == QProcess::NormalExit) {
+        break;
+        
+    case Step::Unmount:
+    case Step::UnmountLazy:
+        stepTimer_->stop();
+        if (ok) {
             setState(MountState::Idle);
             emit unmountSuccess();
-            console.log("Unmount successful");
+            console.log(step == Step::UnmountLazy ? "Unmount successful (lazy)" : "Unmount successful");
         } else {
-            setState(MountState::Error);
-            QString msg = errors.isEmpty() ? "Unmount failed" : errors;
-            emit mountError(msg);
-            console.log("Unmount failed:", msg.toStdString());
+            onUnmountFailed(step, failureMessage("Unmount failed"));
         }
+        break;
+        
+    case Step::None:
+    case Step::CheckPath:
+    case Step::Preflight:
+    case Step::HostKeyPrompt:
+    case Step::RemovingHostKey:
+    case Step::ScanHolders:
+    case Step::KillSshfs:
+        break;
     }
 }
 
+void SSHMounter::finishMount(MountState state) {
+    password_.clear();
+    cancelled_ = false;
+    setState(state);
+}
+
+void SSHMounter::startTrace(bool unmount) {
+    trace_ = MountTrace();
+    trace_.unmount = unmount;
+    traceClock_.start();
+}
+
+void SSHMounter::mark(qint64 MountTrace::* milestone) {
+    // First time only: a host key retry must not move the milestones
+    if (trace_.*milestone < 0 && traceClock_.isValid()) trace_.*milestone = traceClock_.elapsed();
+}
+
 SSHHost SSHMounter::getCurrentHost() {
     return currentHost_;
 }
 
 void SSHMounter::onProcessError(QProcess::ProcessError error) {
-    QString msg;
-    switch (error) {
-        case QProcess::FailedToStart:
-            msg = "Failed to start sshfs. Is it installed?";
-            break;
-        case QProcess::Timedout:
-            msg = "Operation timed out";
-            break;
-        default:
-            msg = "Process error occurred";
+    // Crashes and read/write errors are followed by finished(), which
+    // reports the failure; only a failed start has no finished().
+    if (error != QProcess::FailedToStart || !process_) return;
+    
+    if (step_ == Step::CheckMaster) {
+        // No ssh to ask: there is no master to reuse either
+        console.log("Cannot check for a shared connection:", process_->errorString().toStdString());
+        step_ = Step::None;
+        resetProcess();
+        masterAlive_ = false;
+        mark(&MountTrace::masterChecked);
+        trace_.reusedMaster = false;
+        preflight();
+        return;
     }
     
-    setState(MountState::Error);
+    QString msg = QString("Failed to start %1. Is it installed?").arg(process_->program());
+    step_ = Step::None;
+    
+    finishMount(MountState::Error);
     emit mountError(msg);
     console.log("Process error:", msg.toStdString());
 }
 
 void SSHMounter::onProcessOutput() {
-    QString output = process_->readAllStandardOutput();
-    QString errors = process_->readAllStandardError();
+    if (!process_) return;
     
-    console.log("Process output:", output.toStdString());
-    console.log("Process errors:", errors.toStdString());
-
-    // Check for various password prompts that SSHFS/SSH might use
-    if (output.contains("password", Qt::CaseInsensitive) || 
-        errors.contains("password", Qt::CaseInsensitive) ||
-        output.contains("Password:") ||
-        errors.contains("Password:") ||
-        output.contains("password for") ||
-        errors.contains("password for")) {
-        emit passwordRequired();
-    }
+    const QVector<OutputEvent> events = readOutput();
+    if (step_ == Step::Sshfs) handleEvents(events);
+}
 
-    if (output.contains("WARNING: REMOTE HOST IDENTIFICATION HAS CHANGED!") || errors.contains("WARNING: REMOTE HOST IDENTIFICATION HAS CHANGED!")) {
-        emit hostKeyMismatch();
+QVector<OutputEvent> SSHMounter::readOutput() {
+    const QByteArray chunk = process_->readAllStandardOutput();
+    if (chunk.isEmpty()) return {};
+    console.log("Process output:", QString::fromLocal8Bit(chunk).trimmed().toStdString());
+    return scanner_.feed(chunk);
+}
+
+void SSHMounter::handleEvents(const QVector<OutputEvent>& events) {
+    for (OutputEvent event : events) {
+        switch (event) {
+        case OutputEvent::PasswordPrompt:
+            if (currentHost_.usePublicKey) {
+                console.warn(currentHost_.name.toStdString(),
+                             "asks for a password or key passphrase; load the key into ssh-agent");
+            } else if (!passwordAsked_ && process_->state() != QProcess::NotRunning) {
+                // Normally asked up front; one prompt per attempt either way
+                passwordAsked_ = true;
+                mark(&MountTrace::prompted);
+                emit passwordRequired();
+            }
+            break;
+        case OutputEvent::HostKeyChanged:
+            if (!hostKeyMismatch_) {
+                hostKeyMismatch_ = true;
+                emit hostKeyMismatch();
+            }
+            break;
+        default:
+            // Failures are explained from the scanner once sshfs exits
+            break;
+        }
     }
 }
 
+QString SSHMounter::failureMessage(const QString& fallback) const {
+    const QString detail = scanner_.tail(10);
+    OutputEvent event;
+    if (!scanner_.failure(event)) return detail.isEmpty() ? fallback : detail;
+    const QString summary = OutputScanner::describe(event);
+    return detail.isEmpty() ? summary : summary + "\n\n" + detail;
+}
+
 void SSHMounter::removeHostKey() {
-    if (process_) {
-        delete process_;
+    if (state_ != MountState::Mounting || !hostKeyMismatch_) return;
+    if (step_ == Step::Sshfs) {
+        // sshfs is still on its way out; onProcessFinished() comes back here
+        removeKeyPending_ = true;
+        return;
     }
+    if (step_ != Step::HostKeyPrompt) return;
     
-    process_ = new QProcess(this);
-    
-    QEventLoop loop;
-    connect(process_, static_cast<void(QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished), &loop, &QEventLoop::quit);
-    connect(process_, &QProcess::errorOccurred, &loop, &QEventLoop::quit);
-    
-    process_->start("ssh-keygen", {"-R", currentHost_.host});
-    loop.exec();
+    removeKeyPending_ = false;
+    resetProcess();
+    // Edits known_hosts in-process, hashed entries and HostKeyAlias
+    // included; off the UI thread since it runs ssh -G first
+    emit progressMessage("Removing old host key for " + currentHost_.host + "...");
+    step_ = Step::RemovingHostKey;
+    QPointer<SSHMounter> self(this);
+    const SSHHost host = currentHost_;
+    QThreadPool::globalInstance()->start([self, host]() {
+        QString error;
+        const bool ok = HostKeyScanner::forget(host, error);
+        QMetaObject::invokeMethod(QCoreApplication::instance(), [self, ok, error]() {
+            if (self && self->step_ == Step::RemovingHostKey) self->onHostKeyRemoved(ok, error);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void SSHMounter::onHostKeyRemoved(bool ok, const QString& error) {
+    step_ = Step::None;
+    if (ok) {
+        console.log("Removed old host key for", currentHost_.host.toStdString());
+        hostKeyRetried_ = true;
+        startSshfs();
+    } else {
+        finishMount(MountState::Error);
+        emit mountError("Could not remove the old host key for " + currentHost_.host + ": " + error);
+    }
+}
+
+void SSHMounter::keepHostKey() {
+    // During Sshfs the failing attempt is simply cut short
+    if (state_ != MountState::Mounting || !hostKeyMismatch_ ||
+        (step_ != Step::HostKeyPrompt && step_ != Step::Sshfs)) {
+        return;
+    }
     
-    mount(currentHost_);
+    resetProcess();
+    step_ = Step::None;
+    finishMount(MountState::Idle);
+    emit mountCancelled();
 }
 
 void SSHMounter::supplyPassword(const QString& password) {
-    if (process_ && process_->state() == QProcess::Running) {
+    if (process_ && step_ == Step::Sshfs && process_->state() != QProcess::NotRunning) {
+        password_ = password;
+        mark(&MountTrace::answered);
         process_->write((password + newline).toUtf8());
         process_->closeWriteChannel();
     }
 }
 
 void SSHMounter::noPassword() {
-    process_->terminate();
-    delete process_;
+    if (process_ && step_ == Step::Sshfs && process_->state() != QProcess::NotRunning) {
+        cancelled_ = true;
+        process_->terminate();
+    } else if (state_ == MountState::Mounting) {
+        resetProcess();
+        step_ = Step::None;
+        finishMount(MountState::Idle);
+        emit mountCancelled();
+    }
 }
 
 #include "ssh_mounter.moc"
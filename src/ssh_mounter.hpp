@@ -16,8 +16,15 @@
 #pragma once
 
 #include "ssh_store.hpp"
+#include "output_scanner.hpp"
+#include <QElapsedTimer>
 #include <QObject>
 #include <QProcess>
+#include <sys/types.h>
+
+class SSHMasterPool;
+class Reachability;
+class QTimer;
 
 enum class MountState {
     Idle,
@@ -27,13 +34,41 @@ enum class MountState {
     Error
 };
 
+// Milestones of the last mount or unmount, in monotonic milliseconds since
+// it started; -1 where the operation never got that far.
+struct MountTrace {
+    bool unmount = false;
+    bool reusedMaster = false;
+    qint64 pathChecked = -1;
+    qint64 masterChecked = -1;
+    qint64 spawned = -1;        // sshfs (or fusermount) is running
+    qint64 prompted = -1;       // First password prompt
+    qint64 answered = -1;       // Password handed to sshfs
+    qint64 finished = -1;       // Mounted and FUSE ready, or given up
+};
+
+// How hard unmount() tries; the defaults are one plain fusermount -u
+struct UnmountOptions {
+    int stepTimeoutMs = 0;      // Per attempt; 0 waits as long as fusermount does
+    bool escalate = false;      // On failure: fusermount -uz, then kill sshfs and -uz again
+};
+
 class SSHMounter : public QObject {
     Q_OBJECT
 public:
     explicit SSHMounter(QObject* parent = nullptr);
+    ~SSHMounter() override;
 
-    bool mount(const SSHHost& host);
-    void unmount(const QString& localPath);
+    // Starts sshfs and returns immediately; the outcome is reported
+    // through mountSuccess(), mountError() or mountCancelled().
+    void mount(const SSHHost& host);
+    // Failed unmounts name the processes keeping the mount busy
+    void unmount(const QString& localPath, const UnmountOptions& options = UnmountOptions());
+
+    // Share one ControlMaster connection per host (see SSHMasterPool)
+    void setMasterPool(SSHMasterPool* pool) { masters_ = pool; }
+    // Check the server answers before spawning sshfs (see Reachability)
+    void setReachability(Reachability* reach) { reach_ = reach; }
 
     // Check system capabilities
     static bool checkSSHFSInstalled();
@@ -41,8 +76,14 @@ public:
     static QString checkWritePermission(const QString& path);
 
     void setState(MountState state);
+    MountState state() const { return state_; }
     SSHHost getCurrentHost();
+    const MountTrace& trace() const { return trace_; }
+
+    // Answers to hostKeyMismatch(): drop the stale key and retry, or give up.
+    // An answer that comes while sshfs is still exiting is kept until it has.
     void removeHostKey();
+    void keepHostKey();
 
 public slots:
     void supplyPassword(const QString& password); // UI calls this
@@ -53,6 +94,7 @@ signals:
     void mountSuccess();
     void mountError(const QString& error);
     void unmountSuccess();
+    void mountCancelled();
     void passwordRequired(); // Emitted by mounter when password request is detected
     void progressMessage(const QString& msg);
     void hostKeyMismatch();
@@ -63,7 +105,56 @@ private slots:
     void onProcessOutput();
 
 private:
+    // Which child process is running; the mount flow is a chain of these.
+    enum class Step {
+        None,
+        CheckPath,
+        CheckMaster,
+        Preflight,
+        Sshfs,
+        HostKeyPrompt,
+        RemovingHostKey,
+        Unmount,
+        UnmountLazy,
+        ScanHolders,
+        KillSshfs
+    };
+
+    void onPathChecked(const QString& writeErr);
+    void preflight();
+    void startSshfs();
+    QVector<OutputEvent> readOutput();
+    void handleEvents(const QVector<OutputEvent>& events);
+    QString failureMessage(const QString& fallback) const;
+    void startProcess(Step step, const QString& program, const QStringList& args);
+    void resetProcess();
+    void finishMount(MountState state);
+    void startUnmount(Step step);
+    void onUnmountFailed(Step failed, const QString& error);
+    void onHostKeyRemoved(bool ok, const QString& error);
+    void onHoldersScanned(Step failed, const QString& error, const QString& holders, pid_t sshfs);
+    void onStepTimeout();
+    void startTrace(bool unmount);
+    void mark(qint64 MountTrace::* milestone);
+
     QProcess* process_;
+    SSHMasterPool* masters_;
+    Reachability* reach_;
+    bool masterAlive_;
     MountState state_;
+    Step step_;
     SSHHost currentHost_;
+    QString password_;
+    bool passwordAsked_;
+    OutputScanner scanner_;
+    bool cancelled_;
+    bool hostKeyMismatch_;
+    bool hostKeyRetried_;
+    bool removeKeyPending_;     // removeHostKey() came before sshfs exited
+    MountTrace trace_;
+    QElapsedTimer traceClock_;
+    UnmountOptions unmountOptions_;
+    QString unmountPath_;
+    bool sshfsKilled_;
+    QTimer* stepTimer_;
 };
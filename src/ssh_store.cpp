@@ -15,15 +15,96 @@
 
 #include "ssh_store.hpp"
 #include "console.hpp"
+#include "host_snapshot.hpp"
+#include <QCoreApplication>
 #include <QFile>
 #include <QDir>
+#include <QElapsedTimer>
 #include <QJsonDocument>
+#include <QPointer>
+#include <QSaveFile>
+#include <QSocketNotifier>
 #include <QStandardPaths>
+#include <QThreadPool>
+#include <QTimer>
+#include <QUuid>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 extern Console console;
 
+namespace {
+
+// Past this, the next save folds the journal back into hosts.json
+const qint64 JournalLimit = 256 * 1024;
+// Bulk additions bigger than this rewrite hosts.json instead
+const int BulkJournalLimit = 256;
+// A reload removing more hosts than this resets views instead of
+// removing rows one at a time
+const int BulkReloadLimit = 256;
+// Quiet time after the last inotify event before the files are re-read
+const int ReloadDelayMs = 200;
+
+// A host file without IDs gets them on load; when it is merged into again,
+// hosts that match one in memory field for field get that host's ID back,
+// so the file and the store keep agreeing
+void reuseIds(QVector<SSHHost>& merged, const QVector<SSHHost>& memory) {
+    auto key = [](SSHHost host) {
+        host.id.clear();
+        return QJsonDocument(host.toJson()).toJson(QJsonDocument::Compact);
+    };
+    QSet<QString> taken;
+    for (const SSHHost& host : merged) {
+        if (!host.id.isEmpty()) taken.insert(host.id);
+    }
+    QMultiHash<QByteArray, QString> idsByContent;
+    for (const SSHHost& host : memory) {
+        if (!taken.contains(host.id)) idsByContent.insert(key(host), host.id);
+    }
+    for (SSHHost& host : merged) {
+        if (!host.id.isEmpty()) continue;
+        auto it = idsByContent.find(key(host));
+        if (it != idsByContent.end()) {
+            host.id = it.value();
+            idsByContent.erase(it);
+        } else {
+            host.id = SSHHost::newId();
+        }
+    }
+}
+
+// flock() on the store's lock file for the lifetime of the object
+class FileLock {
+public:
+    FileLock(const QString& path, bool exclusive) {
+        fd_ = ::open(QFile::encodeName(path).constData(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+        if (fd_ < 0) {
+            console.warn("Cannot open lock file", path.toStdString() + ":", strerror(errno));
+            return;
+        }
+        while (::flock(fd_, exclusive ? LOCK_EX : LOCK_SH) != 0 && errno == EINTR) {}
+    }
+    ~FileLock() {
+        // Closing releases the lock
+        if (fd_ >= 0) ::close(fd_);
+    }
+    FileLock(const FileLock&) = delete;
+    FileLock& operator=(const FileLock&) = delete;
+
+private:
+    int fd_;
+};
+
+} // namespace
+
 QJsonObject SSHHost::toJson() const {
     QJsonObject obj;
+    obj["id"] = id;
     obj["name"] = name;
     obj["user"] = user;
     obj["host"] = host;
@@ -31,11 +112,17 @@ QJsonObject SSHHost::toJson() const {
     obj["localPath"] = localPath;
     obj["port"] = port;
     obj["usePublicKey"] = usePublicKey;
+    obj["favorite"] = favorite;
+    obj["controlPersist"] = controlPersist;
+    obj["lazyMount"] = lazyMount;
+    obj["idleUnmountMinutes"] = idleUnmountMinutes;
+    obj["profile"] = profile.toJson();
     return obj;
 }
 
 SSHHost SSHHost::fromJson(const QJsonObject& obj) {
     SSHHost h;
+    h.id = obj["id"].toString();
     h.name = obj["name"].toString();
     h.user = obj["user"].toString();
     h.host = obj["host"].toString();
@@ -43,12 +130,81 @@ SSHHost SSHHost::fromJson(const QJsonObject& obj) {
     h.localPath = obj["localPath"].toString();
     h.port = obj["port"].toInt(22);
     h.usePublicKey = obj["usePublicKey"].toBool(false);
+    h.favorite = obj["favorite"].toBool(false);
+    h.controlPersist = qMax(0, obj["controlPersist"].toInt(600));
+    h.lazyMount = obj["lazyMount"].toBool(false);
+    h.idleUnmountMinutes = qMax(0, obj["idleUnmountMinutes"].toInt(0));
+    h.profile = SSHFSProfile::fromJson(obj["profile"].toObject());
     return h;
 }
 
-SSHStore::SSHStore(QObject* parent) : QObject(parent) {
+QString SSHHost::newId() {
+    return QUuid::createUuid().toString(QUuid::WithoutBraces);
+}
+
+bool SSHHost::operator==(const SSHHost& other) const {
+    return id == other.id && name == other.name && user == other.user && host == other.host &&
+           remotePath == other.remotePath && localPath == other.localPath && port == other.port &&
+           usePublicKey == other.usePublicKey && favorite == other.favorite &&
+           controlPersist == other.controlPersist && lazyMount == other.lazyMount &&
+           idleUnmountMinutes == other.idleUnmountMinutes && profile == other.profile;
+}
+
+bool SSHStore::DiskStamp::operator==(const DiskStamp& other) const {
+    return jsonInode == other.jsonInode && jsonSize == other.jsonSize && jsonMtimeNs == other.jsonMtimeNs &&
+           journalInode == other.journalInode && journalSize == other.journalSize;
+}
+
+SSHStore::SSHStore(QObject* parent)
+    : QObject(parent), indexedRows_(0), useSnapshot_(true), autosave_(false), journal_(false), needsFull_(false),
+      saveTimer_(new QTimer(this)), savePool_(new QThreadPool(this)), savesInFlight_(0),
+      watchFd_(-1), watchNotifier_(nullptr), reloadTimer_(new QTimer(this)), reloading_(false),
+      reloadPending_(false), forceReload_(false) {
     QString home = QDir::homePath();
     filePath_ = home + "/.ssh/mounter/hosts.json";
+    saveTimer_->setSingleShot(true);
+    connect(saveTimer_, &QTimer::timeout, this, &SSHStore::startSave);
+    savePool_->setMaxThreadCount(1);
+    reloadTimer_->setSingleShot(true);
+    reloadTimer_->setInterval(ReloadDelayMs);
+    connect(reloadTimer_, &QTimer::timeout, this, &SSHStore::checkDisk);
+}
+
+SSHStore::~SSHStore() {
+    stopWatching();
+}
+
+QString SSHStore::lockPath(const QString& jsonPath) {
+    QString path = jsonPath;
+    if (path.endsWith(".json")) path.chop(5);
+    return path + ".lock";
+}
+
+SSHStore::DiskStamp SSHStore::stampOf(const QString& jsonPath) {
+    DiskStamp stamp;
+    struct stat st;
+    if (::stat(QFile::encodeName(jsonPath).constData(), &st) == 0) {
+        stamp.jsonInode = st.st_ino;
+        stamp.jsonSize = st.st_size;
+        stamp.jsonMtimeNs = qint64(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    }
+    if (::stat(QFile::encodeName(journalPath(jsonPath)).constData(), &st) == 0) {
+        stamp.journalInode = st.st_ino;
+        stamp.journalSize = st.st_size;
+    }
+    return stamp;
+}
+
+QString SSHStore::journalPath(const QString& jsonPath) {
+    QString path = jsonPath;
+    if (path.endsWith(".json")) path.chop(5);
+    return path + ".journal";
+}
+
+void SSHStore::setAutosave(bool enabled, int delayMs) {
+    autosave_ = enabled;
+    saveTimer_->setInterval(delayMs);
+    if (enabled && isDirty() && !saveTimer_->isActive()) saveTimer_->start();
 }
 
 QString SSHStore::getFilePath() const {
@@ -63,17 +219,32 @@ void SSHStore::ensureDirectoryExists() {
     }
 }
 
-bool SSHStore::load() {
-    QFile file(filePath_);
+bool SSHStore::readHosts(const QString& path, QVector<SSHHost>& hosts, QString& error, bool useSnapshot) {
+    if (!QFile::exists(path)) {
+        hosts.clear();
+        return true; // Empty is fine
+    }
+    // hosts.json and the journal only make sense read together
+    FileLock lock(lockPath(path), false);
+    return readUnlocked(path, hosts, error, useSnapshot);
+}
+
+bool SSHStore::readUnlocked(const QString& path, QVector<SSHHost>& hosts, QString& error, bool useSnapshot) {
+    hosts.clear();
+    
+    QFile file(path);
     if (!file.exists()) {
-        hosts_.clear();
-        console.log("No existing hosts file, starting fresh");
         return true; // Empty is fine
     }
     
+    if (useSnapshot && HostSnapshot::read(path, hosts)) {
+        console.log("Read", hosts.size(), "host(s) from snapshot");
+        replayJournal(path, hosts);
+        return true;
+    }
+    
     if (!file.open(QIODevice::ReadOnly)) {
-        console.error("Cannot read", filePath_.toStdString());
-        emit error("Cannot read " + filePath_);
+        error = "Cannot read " + path;
         return false;
     }
     
@@ -82,65 +253,672 @@ bool SSHStore::load() {
     
     QJsonDocument doc = QJsonDocument::fromJson(data);
     if (!doc.isObject()) {
-        console.error("Invalid JSON format in hosts file");
-        emit error("Invalid JSON format");
+        error = "Invalid JSON format";
         return false;
     }
     
     QJsonArray arr = doc.object()["hosts"].toArray();
-    hosts_.clear();
+    hosts.reserve(arr.size());
     for (const auto& val : arr) {
-        hosts_.append(SSHHost::fromJson(val.toObject()));
+        hosts.append(SSHHost::fromJson(val.toObject()));
+    }
+    replayJournal(path, hosts);
+    return true;
+}
+
+void SSHStore::replayJournal(const QString& jsonPath, QVector<SSHHost>& hosts) {
+    QFile file(journalPath(jsonPath));
+    if (!file.open(QIODevice::ReadOnly)) return;
+    
+    // Every entry is idempotent, so a journal that outlived the hosts.json
+    // it was folded into replays harmlessly. A torn last line is skipped.
+    QVector<JournalOp> ops;
+    while (!file.atEnd()) {
+        const QJsonObject entry = QJsonDocument::fromJson(file.readLine()).object();
+        const QString op = entry["op"].toString();
+        JournalOp change;
+        if (op == "put") {
+            change.host = SSHHost::fromJson(entry["host"].toObject());
+            change.id = change.host.id;
+        } else if (op == "remove") {
+            change.id = entry["id"].toString();
+            change.remove = true;
+        }
+        if (!change.id.isEmpty()) ops.append(change);
+    }
+    const int applied = applyOps(hosts, ops);
+    if (applied > 0) console.log("Replayed", applied, "journal entries");
+}
+
+int SSHStore::applyOps(QVector<SSHHost>& hosts, const QVector<JournalOp>& ops) {
+    QHash<QString, int> rowById;
+    auto index = [&]() {
+        rowById.clear();
+        for (int row = 0; row < hosts.size(); ++row) rowById.insert(hosts[row].id, row);
+    };
+    index();
+    
+    int applied = 0;
+    for (const JournalOp& op : ops) {
+        const int row = rowById.value(op.id, -1);
+        if (op.remove) {
+            if (row < 0) continue;
+            hosts.remove(row);
+            index();
+        } else if (row >= 0) {
+            hosts[row] = op.host;
+        } else {
+            rowById.insert(op.id, hosts.size());
+            hosts.append(op.host);
+        }
+        ++applied;
+    }
+    return applied;
+}
+
+bool SSHStore::load() {
+    if (!QFile::exists(filePath_)) {
+        console.log("No existing hosts file, starting fresh");
+        setHosts(QVector<SSHHost>());
+        return true; // Empty is fine
+    }
+    
+    QVector<SSHHost> hosts;
+    QString err;
+    DiskStamp stamp;
+    {
+        FileLock lock(lockPath(filePath_), false);
+        stamp = stampOf(filePath_);
+        if (!readUnlocked(filePath_, hosts, err, useSnapshot_)) {
+            console.error(err.toStdString());
+            emit error(err);
+            return false;
+        }
     }
     
+    setHosts(hosts);
+    diskStamp_ = stamp;
+    return true;
+}
+
+void SSHStore::setHosts(const QVector<SSHHost>& hosts) {
+    emit hostsAboutToBeReset();
+    hosts_ = hosts;
+    strings_.clear();
+    for (auto& host : hosts_) {
+        intern(host);
+    }
+    // Hosts that were just given an ID must keep it
+    if (rebuildIndexes() > 0) {
+        needsFull_ = true;
+        if (autosave_ && !saveTimer_->isActive()) saveTimer_->start();
+    }
     console.log("Loaded", hosts_.size(), "host(s) from", filePath_.toStdString());
+    emit hostsReset();
     emit hostsChanged();
-    return true;
+}
+
+// Share one buffer between the many hosts that repeat a user, hostname
+// or remote path (QString is implicitly shared).
+void SSHStore::intern(SSHHost& host) {
+    for (QString* field : {&host.user, &host.host, &host.remotePath}) {
+        auto it = strings_.constFind(*field);
+        if (it != strings_.constEnd()) {
+            *field = *it;
+        } else {
+            strings_.insert(*field);
+        }
+    }
+}
+
+int SSHStore::rebuildIndexes() {
+    QElapsedTimer timer;
+    timer.start();
+    int assigned = 0;
+    
+    indexById_.clear();
+    indexByName_.clear();
+    indexByHostname_.clear();
+    searchIndex_.clear();
+    indexById_.reserve(hosts_.size());
+    indexByName_.reserve(hosts_.size());
+    indexByHostname_.reserve(hosts_.size());
+    searchIndex_.reserve(hosts_.size());
+    
+    for (int row = 0; row < hosts_.size(); ++row) {
+        SSHHost& host = hosts_[row];
+        // Older files have no IDs, and hand edits can duplicate one
+        if (host.id.isEmpty() || indexById_.contains(host.id)) {
+            host.id = SSHHost::newId();
+            ++assigned;
+        }
+        indexHost(row);
+    }
+    indexedRows_ = hosts_.size();
+    console.log("Indexed", hosts_.size(), "host(s) in", timer.elapsed(), "ms");
+    return assigned;
+}
+
+void SSHStore::indexHost(int row) {
+    const SSHHost& host = hosts_[row];
+    indexById_.insert(host.id, row);
+    if (indexedRows_ == row) indexedRows_ = row + 1;
+    indexByName_.insert(host.name, host.id);
+    indexByHostname_.insert(host.host, host.id);
+    searchIndex_.insert(host);
+}
+
+void SSHStore::unindexHost(int row) {
+    const SSHHost& host = hosts_[row];
+    indexById_.remove(host.id);
+    indexByName_.remove(host.name, host.id);
+    indexByHostname_.remove(host.host, host.id);
+    searchIndex_.remove(host.id);
+}
+
+// Removing row r moves every later row up by one. Their index entries then
+// hold a row one too high per removal, never lower than indexedRows_, so a
+// lookup can tell a stale entry and fix all of them in one pass.
+void SSHStore::reindexRows() const {
+    for (int row = indexedRows_; row < hosts_.size(); ++row) {
+        indexById_[hosts_[row].id] = row;
+    }
+    indexedRows_ = hosts_.size();
+}
+
+int SSHStore::indexOf(const QString& id) const {
+    auto it = indexById_.constFind(id);
+    if (it == indexById_.constEnd()) return -1;
+    if (it.value() < indexedRows_) return it.value();
+    reindexRows();
+    return indexById_.value(id, -1);
+}
+
+const SSHHost* SSHStore::byId(const QString& id) const {
+    const int row = indexOf(id);
+    return row < 0 ? nullptr : &hosts_[row];
+}
+
+QList<const SSHHost*> SSHStore::byName(const QString& name) const {
+    QList<const SSHHost*> result;
+    for (const QString& id : indexByName_.values(name)) {
+        result.append(byId(id));
+    }
+    return result;
+}
+
+QList<const SSHHost*> SSHStore::byHostname(const QString& hostname) const {
+    QList<const SSHHost*> result;
+    for (const QString& id : indexByHostname_.values(hostname)) {
+        result.append(byId(id));
+    }
+    return result;
 }
 
 bool SSHStore::save() {
-    ensureDirectoryExists();
+    saveTimer_->stop();
+    // Whatever is queued lands first, in order
+    savePool_->waitForDone();
+    if (failedSaves_.fetchAndStoreOrdered(0) > 0) needsFull_ = true;
+    if (!isDirty()) return true;
+    
+    if (reloading_) reloadPending_ = true;
+    QString err;
+    DiskStamp written;
+    bool foreign = false;
+    if (!writeHosts(filePath_, hosts_, pendingOps_, needsFull_ || !journal_, useSnapshot_, diskStamp_,
+                    written, foreign, err)) {
+        console.error(err.toStdString());
+        emit error(err);
+        return false;
+    }
+    pendingOps_.clear();
+    pendingIndex_.clear();
+    needsFull_ = false;
+    diskStamp_ = written;
+    if (foreign) reloadForeign();
+    return true;
+}
+
+void SSHStore::recordChange(const QString& id, bool remove) {
+    JournalOp op;
+    op.id = id;
+    op.remove = remove;
+    if (!remove) op.host = hosts_[indexOf(id)];
+    auto it = pendingIndex_.constFind(id);
+    if (it != pendingIndex_.constEnd()) {
+        pendingOps_[it.value()] = op;
+    } else {
+        pendingIndex_.insert(id, pendingOps_.size());
+        pendingOps_.append(op);
+    }
+    // Not restarted by later changes, so a steady stream of edits still
+    // gets saved every delayMs
+    if (autosave_ && !saveTimer_->isActive()) saveTimer_->start();
+}
+
+void SSHStore::startSave() {
+    if (!isDirty()) return;
+    
+    // Copies are cheap (implicitly shared); the UI thread detaches on its
+    // next edit while the worker serializes this state
+    const QString path = filePath_;
+    const QVector<SSHHost> hosts = hosts_;
+    const QVector<JournalOp> ops = pendingOps_;
+    const bool full = needsFull_ || !journal_;
+    const bool snapshot = useSnapshot_;
+    const DiskStamp expected = diskStamp_;
+    pendingOps_.clear();
+    pendingIndex_.clear();
+    needsFull_ = false;
+    ++savesInFlight_;
+    // A read in progress cannot see this save
+    if (reloading_) reloadPending_ = true;
+    
+    QPointer<SSHStore> self(this);
+    QAtomicInt* failures = &failedSaves_;
+    savePool_->start([self, failures, path, hosts, ops, full, snapshot, expected]() {
+        QString err;
+        DiskStamp written;
+        bool foreign = false;
+        const bool ok = writeHosts(path, hosts, ops, full, snapshot, expected, written, foreign, err);
+        if (!ok) failures->ref();
+        QMetaObject::invokeMethod(QCoreApplication::instance(), [self, ok, err, full, ops, written, foreign]() {
+            if (self) self->onSaveFinished(ok, err, full, ops, written, foreign);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void SSHStore::onSaveFinished(bool ok, const QString& message, bool full, const QVector<JournalOp>& ops,
+                              const DiskStamp& written, bool foreign) {
+    --savesInFlight_;
+    if (ok) {
+        diskStamp_ = written;
+        if (foreign) reloadForeign();
+    } else {
+        console.error("Autosave failed:", message.toStdString());
+        failedSaves_.fetchAndStoreOrdered(0);
+        // Queue the lost changes again unless the host changed since
+        for (const JournalOp& op : ops) {
+            if (pendingIndex_.contains(op.id)) continue;
+            pendingIndex_.insert(op.id, pendingOps_.size());
+            pendingOps_.append(op);
+        }
+        if (full) needsFull_ = true;
+        emit error(message);
+    }
+    if (savesInFlight_ == 0 && reloadPending_) {
+        reloadPending_ = false;
+        checkDisk();
+    }
+}
+
+bool SSHStore::writeHosts(const QString& path, const QVector<SSHHost>& hosts, const QVector<JournalOp>& ops,
+                          bool full, bool snapshot, const DiskStamp& expected, DiskStamp& written,
+                          bool& foreign, QString& error) {
+    QElapsedTimer timer;
+    timer.start();
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    const QString journal = journalPath(path);
+    
+    FileLock lock(lockPath(path), true);
+    // Another process wrote since we last read: our changes go on top of
+    // its file rather than over it
+    const bool theirs = stampOf(path) != expected;
+    
+    foreign = theirs && QFile::exists(path);
+    
+    if (!full && QFile::exists(path) && QFileInfo(journal).size() < JournalLimit) {
+        if (!appendJournal(journal, ops, error)) return false;
+        // Still under the lock, so this is exactly what we wrote
+        written = stampOf(path);
+        console.log("Journaled", ops.size(), "change(s) in", timer.elapsed(), "ms");
+        return true;
+    }
+    
+    QVector<SSHHost> merged;
+    if (theirs && QFile::exists(path)) {
+        QString readError;
+        if (!readUnlocked(path, merged, readError, snapshot)) {
+            error = "Not overwriting " + path + ": " + readError;
+            return false;
+        }
+        // IDs first, so the ops find the hosts they are about
+        reuseIds(merged, hosts);
+        applyOps(merged, ops);
+        console.info(path.toStdString(), "was changed elsewhere; merged", ops.size(), "change(s) into it");
+    }
+    const QVector<SSHHost>& out = theirs && QFile::exists(path) ? merged : hosts;
     
     QJsonArray arr;
-    for (const auto& host : hosts_) {
+    for (const auto& host : out) {
         arr.append(host.toJson());
     }
-    
     QJsonObject root;
     root["hosts"] = arr;
+    if (!writeAtomically(path, QJsonDocument(root).toJson(QJsonDocument::Indented), error)) return false;
+    // Everything in the journal is in hosts.json now
+    if (QFile::exists(journal) && !QFile::remove(journal)) {
+        console.warn("Could not remove", journal.toStdString());
+    }
+    
+    // Written after the JSON so it records the final mtime and size
+    if (snapshot && !HostSnapshot::write(path, out)) {
+        console.warn("Could not write host snapshot", HostSnapshot::pathFor(path).toStdString());
+    }
+    written = stampOf(path);
     
-    QFile file(filePath_);
-    if (!file.open(QIODevice::WriteOnly)) {
-        console.error("Cannot write to", filePath_.toStdString());
-        emit error("Cannot write to " + filePath_);
+    console.log("Saved", out.size(), "host(s) to", path.toStdString(), "in", timer.elapsed(), "ms");
+    return true;
+}
+
+bool SSHStore::writeAtomically(const QString& path, const QByteArray& data, QString& error) {
+    // QSaveFile writes a temporary file, fsyncs it and renames it over path
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || !file.commit()) {
+        error = "Cannot write to " + path + ": " + file.errorString();
+        return false;
+    }
+    // The rename itself is only durable once the directory is synced
+    const QByteArray dir = QFile::encodeName(QFileInfo(path).absolutePath());
+    int fd = ::open(dir.constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd >= 0) {
+        ::fsync(fd);
+        ::close(fd);
+    }
+    return true;
+}
+
+bool SSHStore::appendJournal(const QString& path, const QVector<JournalOp>& ops, QString& error) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadWrite | QIODevice::Append)) {
+        error = "Cannot write to " + path + ": " + file.errorString();
+        return false;
+    }
+    QByteArray out;
+    // A crash mid-append leaves a torn line; start clear of it
+    if (file.size() > 0) {
+        file.seek(file.size() - 1);
+        if (file.read(1) != "\n") out += '\n';
+    }
+    for (const JournalOp& op : ops) {
+        QJsonObject entry;
+        if (op.remove) {
+            entry["op"] = "remove";
+            entry["id"] = op.id;
+        } else {
+            entry["op"] = "put";
+            entry["host"] = op.host.toJson();
+        }
+        out += QJsonDocument(entry).toJson(QJsonDocument::Compact) + '\n';
+    }
+    if (file.write(out) != out.size() || !file.flush() || ::fdatasync(file.handle()) != 0) {
+        error = "Cannot write to " + path + ": " + file.errorString();
         return false;
     }
+    return true;
+}
+
+QString SSHStore::addHost(const SSHHost& host) {
+    SSHHost h = host;
+    if (h.id.isEmpty() || indexById_.contains(h.id)) {
+        h.id = SSHHost::newId();
+    }
+    insertRow(h);
+    recordChange(h.id, false);
+    emit hostsChanged();
+    return h.id;
+}
+
+void SSHStore::removeHost(const QString& id) {
+    int row = indexOf(id);
+    if (row < 0) return;
+    removeRow(row);
+    recordChange(id, true);
+    emit hostsChanged();
+}
+
+void SSHStore::updateHost(const QString& id, const SSHHost& host) {
+    int row = indexOf(id);
+    if (row < 0) return;
+    SSHHost h = host;
+    h.id = id;
+    replaceRow(row, h);
+    recordChange(id, false);
+    emit hostsChanged();
+}
+
+QStringList SSHStore::addHosts(const QVector<SSHHost>& hosts) {
+    QStringList ids;
+    if (hosts.isEmpty()) return ids;
+    ids.reserve(hosts.size());
     
-    QJsonDocument doc(root);
-    file.write(doc.toJson(QJsonDocument::Indented));
-    file.close();
+    QElapsedTimer timer;
+    timer.start();
+    emit hostsAboutToBeReset();
+    hosts_.reserve(hosts_.size() + hosts.size());
+    indexById_.reserve(hosts_.size() + hosts.size());
+    for (const SSHHost& host : hosts) {
+        SSHHost h = host;
+        if (h.id.isEmpty() || indexById_.contains(h.id)) {
+            h.id = SSHHost::newId();
+        }
+        intern(h);
+        hosts_.append(h);
+        indexHost(hosts_.size() - 1);
+        recordChange(h.id, false);
+        ids.append(h.id);
+    }
+    // Past a few hundred lines the journal stops paying off
+    if (hosts.size() > BulkJournalLimit) needsFull_ = true;
+    console.log("Added", hosts.size(), "host(s) in", timer.elapsed(), "ms");
+    emit hostsReset();
+    emit hostsChanged();
+    return ids;
+}
+
+void SSHStore::insertRow(const SSHHost& host) {
+    SSHHost h = host;
+    intern(h);
+    emit hostAboutToBeAdded(hosts_.size());
+    hosts_.append(h);
+    indexHost(hosts_.size() - 1);
+    emit hostAdded(h.id);
+}
+
+void SSHStore::removeRow(int row) {
+    const QString id = hosts_[row].id;
+    emit hostAboutToBeRemoved(id, row);
+    unindexHost(row);
+    hosts_.remove(row);
+    // Later rows moved up; indexOf() catches up on the next lookup
+    indexedRows_ = qMin(indexedRows_, row);
+    emit hostRemoved(id);
+}
+
+void SSHStore::replaceRow(int row, const SSHHost& host) {
+    unindexHost(row);
+    hosts_[row] = host;
+    intern(hosts_[row]);
+    indexHost(row);
+    emit hostUpdated(host.id);
+}
+
+bool SSHStore::startWatching() {
+    if (watchFd_ >= 0) return true;
+    const QString dir = QFileInfo(filePath_).absolutePath();
+    QDir().mkpath(dir);
     
-    console.log("Saved", hosts_.size(), "host(s) to", filePath_.toStdString());
+    watchFd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (watchFd_ < 0) {
+        console.warn("Not watching hosts file: inotify:", strerror(errno));
+        return false;
+    }
+    // The directory, not the file: full writes replace hosts.json by rename
+    if (inotify_add_watch(watchFd_, QFile::encodeName(dir).constData(),
+                          IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE) < 0) {
+        console.warn("Not watching", dir.toStdString() + ":", strerror(errno));
+        ::close(watchFd_);
+        watchFd_ = -1;
+        return false;
+    }
+    watchNotifier_ = new QSocketNotifier(watchFd_, QSocketNotifier::Read, this);
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    connect(watchNotifier_, &QSocketNotifier::activated, this, &SSHStore::onInotify);
+#else
+    connect(watchNotifier_, SIGNAL(activated(int)), this, SLOT(onInotify()));
+#endif
+    // What the store holds now is what the watcher compares against
+    if (!diskStamp_.isValid()) diskStamp_ = stampOf(filePath_);
+    console.log("Watching", filePath_.toStdString(), "for changes");
     return true;
 }
 
-void SSHStore::addHost(const SSHHost& host) {
-    hosts_.append(host);
-    emit hostsChanged();
+void SSHStore::stopWatching() {
+    if (watchFd_ < 0) return;
+    delete watchNotifier_;
+    watchNotifier_ = nullptr;
+    ::close(watchFd_);
+    watchFd_ = -1;
+    reloadTimer_->stop();
 }
 
-void SSHStore::removeHost(int index) {
-    if (index >= 0 && index < hosts_.size()) {
-        hosts_.removeAt(index);
-        emit hostsChanged();
+void SSHStore::onInotify() {
+    const QByteArray json = QFile::encodeName(QFileInfo(filePath_).fileName());
+    const QByteArray journal = QFile::encodeName(QFileInfo(journalPath(filePath_)).fileName());
+    bool relevant = false;
+    alignas(inotify_event) char buf[4096];
+    for (;;) {
+        ssize_t n = ::read(watchFd_, buf, sizeof(buf));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        for (char* p = buf; p < buf + n; p += sizeof(inotify_event) + reinterpret_cast<inotify_event*>(p)->len) {
+            const inotify_event* ev = reinterpret_cast<inotify_event*>(p);
+            if (ev->len == 0) continue;
+            const char* name = ev->name;
+            if (json == name || journal == name) relevant = true;
+        }
     }
+    if (relevant) reloadTimer_->start();
+}
+
+void SSHStore::reloadForeign() {
+    // Without a watcher nobody expects the store to follow the file
+    if (watchFd_ < 0) return;
+    forceReload_ = true;
+    checkDisk();
 }
 
-void SSHStore::updateHost(int index, const SSHHost& host) {
-    if (index >= 0 && index < hosts_.size()) {
-        hosts_[index] = host;
-        emit hostsChanged();
+void SSHStore::checkDisk() {
+    // Our own saves change the stamp; compare once they have all landed
+    if (savesInFlight_ > 0 || reloading_) {
+        reloadPending_ = true;
+        return;
     }
+    if (!forceReload_ && stampOf(filePath_) == diskStamp_) return;
+    
+    reloading_ = true;
+    QPointer<SSHStore> self(this);
+    const QString path = filePath_;
+    const bool snapshot = useSnapshot_;
+    QThreadPool::globalInstance()->start([self, path, snapshot]() {
+        QVector<SSHHost> hosts;
+        QString err;
+        DiskStamp stamp;
+        {
+            FileLock lock(lockPath(path), false);
+            stamp = stampOf(path);
+            readUnlocked(path, hosts, err, snapshot);
+        }
+        QMetaObject::invokeMethod(QCoreApplication::instance(), [self, hosts, stamp, err]() {
+            if (self) self->onDiskRead(hosts, stamp, err);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void SSHStore::onDiskRead(const QVector<SSHHost>& hosts, const DiskStamp& stamp, const QString& error) {
+    reloading_ = false;
+    if (savesInFlight_ > 0 || reloadPending_) {
+        // Stale before it arrived; look again once saves have landed
+        reloadPending_ = false;
+        checkDisk();
+        return;
+    }
+    if (!stamp.isValid()) {
+        // Deleted, or between an editor's delete and write; keep what we have
+        return;
+    }
+    if (!error.isEmpty()) {
+        // Likely caught mid-edit by hand; the next write triggers another try
+        console.warn("Not reloading", filePath_.toStdString() + ":", error.toStdString());
+        return;
+    }
+    diskStamp_ = stamp;
+    forceReload_ = false;
+    
+    QVector<SSHHost> disk = hosts;
+    // A file rewritten without IDs (by a script, say) gets them back from
+    // the hosts it still matches field for field, and is saved with them
+    bool missingIds = false;
+    for (const SSHHost& host : disk) missingIds = missingIds || host.id.isEmpty();
+    if (missingIds) {
+        reuseIds(disk, hosts_);
+        needsFull_ = true;
+        if (autosave_ && !saveTimer_->isActive()) saveTimer_->start();
+    }
+    // Unsaved changes here win over the file
+    applyOps(disk, pendingOps_);
+    
+    // Hosts are matched by ID; a file with duplicate IDs can only be reset
+    QSet<QString> ids;
+    ids.reserve(disk.size());
+    for (const SSHHost& host : disk) {
+        if (host.id.isEmpty() || ids.contains(host.id)) {
+            console.info(filePath_.toStdString(), "changed on disk; reloading all hosts");
+            setHosts(disk);
+            emit reloaded(disk.size());
+            return;
+        }
+        ids.insert(host.id);
+    }
+    
+    // Row by row, each removal moves the rows after it; past a few hundred
+    // a reset is cheaper for the store and for views
+    int removals = 0;
+    for (const SSHHost& host : hosts_) {
+        if (!ids.contains(host.id)) ++removals;
+    }
+    if (removals > BulkReloadLimit) {
+        console.info(filePath_.toStdString(), "changed on disk;", removals, "host(s) gone, reloading all hosts");
+        setHosts(disk);
+        emit reloaded(disk.size());
+        return;
+    }
+    
+    QElapsedTimer timer;
+    timer.start();
+    int changes = 0;
+    // Back to front, so the rows still to visit keep their numbers
+    for (int row = hosts_.size() - 1; row >= 0; --row) {
+        if (ids.contains(hosts_[row].id)) continue;
+        removeRow(row);
+        ++changes;
+    }
+    for (const SSHHost& host : disk) {
+        const int row = indexOf(host.id);
+        if (row < 0) {
+            insertRow(host);
+        } else if (hosts_[row] != host) {
+            replaceRow(row, host);
+        } else {
+            continue;
+        }
+        ++changes;
+    }
+    if (changes == 0) return;
+    
+    console.info("Reloaded", filePath_.toStdString() + ":", changes, "host(s) changed in", timer.elapsed(), "ms");
+    emit reloaded(changes);
 }
 
 #include "ssh_store.moc"
@@ -15,12 +15,23 @@
 
 #pragma once
 
+#include "host_index.hpp"
+#include "sshfs_profile.hpp"
 #include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QVector>
 #include <QJsonArray>
 #include <QJsonObject>
+#include <QAtomicInt>
 #include <QString>
 
+class QThreadPool;
+class QTimer;
+class QSocketNotifier;
+
 struct SSHHost {
+    QString id;         // Stable identity, assigned by SSHStore and kept in hosts.json
     QString name;
     QString user;
     QString host;
@@ -28,33 +39,198 @@ struct SSHHost {
     QString localPath;
     int port = 22;
     bool usePublicKey = false;  // If true, use public key auth only. If false, use password auth.
+    bool favorite = false;      // Pre-warm a connection at startup (key auth only)
+    int controlPersist = 600;   // Seconds an idle shared SSH connection stays up; 0 = no sharing
+    bool lazyMount = false;     // Mount on first access to localPath (key auth only)
+    int idleUnmountMinutes = 0; // Lazy mounts: unmount after this long unused; 0 = never
+    SSHFSProfile profile;       // sshfs/ssh performance options
     
     QJsonObject toJson() const;
     static SSHHost fromJson(const QJsonObject& obj);
+    static QString newId();
+    
+    bool operator==(const SSHHost& other) const;
+    bool operator!=(const SSHHost& other) const { return !(*this == other); }
 };
+// Only implicitly shared members: QVector may move hosts with memmove
+Q_DECLARE_TYPEINFO(SSHHost, Q_MOVABLE_TYPE);
 
+// Hosts are kept in list order for display and indexed by stable ID, name
+// and hostname. Accessors hand out const references; nothing copies the
+// whole inventory. Name and hostname map to IDs, so only the ID -> row
+// index moves when a row is removed, and it is brought up to date lazily,
+// once for a whole batch of removals.
 class SSHStore : public QObject {
     Q_OBJECT
 public:
     explicit SSHStore(QObject* parent = nullptr);
+    ~SSHStore() override;
     
     bool load();
+    // Writes pending changes now, after any autosave still in flight;
+    // nothing to do if the store is clean
     bool save();
     
-    QList<SSHHost> getHosts() const { return hosts_; }
-    void addHost(const SSHHost& host);
-    void removeHost(int index);
-    void updateHost(int index, const SSHHost& host);
+    // Autosave: changes are written delayMs after the first one (later ones
+    // ride along), on a background thread and atomically (temp file, fsync,
+    // rename), so a crash loses at most that window and never the file
+    void setAutosave(bool enabled, int delayMs = 500);
+    // With the journal, a save appends only the changed hosts to
+    // hosts.journal; hosts.json is rewritten once that grows past 256 KiB
+    void setJournalEnabled(bool enabled) { journal_ = enabled; }
+    bool isDirty() const { return needsFull_ || !pendingOps_.isEmpty(); }
+    // An autosave is being written, or a changed file re-read
+    bool isSaving() const { return savesInFlight_ > 0; }
+    bool isReloading() const { return reloading_; }
+    static QString journalPath(const QString& jsonPath);
+    // Advisory flock() target shared by every process using jsonPath:
+    // writers hold it exclusively, readers shared. A separate file, since
+    // hosts.json itself is replaced on every full write.
+    static QString lockPath(const QString& jsonPath);
+    
+    // Watches hosts.json and its journal with inotify. When another
+    // instance or a script changes them the file is re-read off the UI
+    // thread and diffed by host ID against the store: only the hosts that
+    // differ get hostAdded/hostUpdated/hostRemoved, and changes not yet
+    // saved here are kept on top.
+    bool startWatching();
+    void stopWatching();
+    
+    // Thread-safe part of load(): parses a hosts file without touching
+    // the store, so it can run off the UI thread. Hand the result to
+    // setHosts(). A valid binary snapshot (see HostSnapshot) is preferred
+    // over parsing the JSON; the journal, if any, is replayed on top.
+    static bool readHosts(const QString& path, QVector<SSHHost>& hosts, QString& error,
+                          bool useSnapshot = true);
+    void setHosts(const QVector<SSHHost>& hosts);
+    
+    const QVector<SSHHost>& hosts() const { return hosts_; }
+    int count() const { return hosts_.size(); }
+    const SSHHost& at(int row) const { return hosts_[row]; }
+    const SSHHost* byId(const QString& id) const;
+    int indexOf(const QString& id) const;
+    QList<const SSHHost*> byName(const QString& name) const;
+    QList<const SSHHost*> byHostname(const QString& hostname) const;
+    
+    // Ranked fuzzy match over name, user, host and remote path (see
+    // HostSearchIndex); returns host IDs, best first
+    QStringList search(const QString& query, int limit = -1) const { return searchIndex_.search(query, limit); }
+    const HostSearchIndex& searchIndex() const { return searchIndex_; }
+    
+    // Returns the ID given to the new host
+    QString addHost(const SSHHost& host);
+    void removeHost(const QString& id);
+    void updateHost(const QString& id, const SSHHost& host);
+    // Appends many hosts as one change: a single reset for views instead
+    // of a signal per host, and one save. Returns the IDs given to them.
+    QStringList addHosts(const QVector<SSHHost>& hosts);
     
     QString getFilePath() const;
+    // Before load(); the default is ~/.ssh/mounter/hosts.json
+    void setFilePath(const QString& path) { filePath_ = path; }
+    
+    // Keep hosts.bin next to hosts.json on save() and read it on load()
+    void setUseSnapshot(bool enabled) { useSnapshot_ = enabled; }
+    bool useSnapshot() const { return useSnapshot_; }
     
 signals:
+    // Fine-grained notifications for views; the AboutTo signals fire
+    // before the store changes, the others after.
+    void hostsAboutToBeReset();
+    void hostsReset();
+    void hostAboutToBeAdded(int row);
+    void hostAdded(const QString& id);
+    void hostUpdated(const QString& id);
+    void hostAboutToBeRemoved(const QString& id, int row);
+    void hostRemoved(const QString& id);
+    // Once per reload that changed anything
+    void reloaded(int changes);
+    // A change made through this store, or a new set from setHosts().
+    // Row-by-row reloads only emit reloaded(): what they bring in is
+    // already on disk.
     void hostsChanged();
     void error(const QString& message);
     
+private slots:
+    void onInotify();
+    
 private:
-    QList<SSHHost> hosts_;
+    // One changed host for the journal; the last change to a host wins
+    struct JournalOp {
+        QString id;
+        SSHHost host;
+        bool remove = false;
+    };
+    // Identity of what is on disk, to tell our own writes from others'
+    struct DiskStamp {
+        quint64 jsonInode = 0;
+        qint64 jsonSize = -1;
+        qint64 jsonMtimeNs = 0;
+        quint64 journalInode = 0;
+        qint64 journalSize = -1;
+        
+        bool operator==(const DiskStamp& other) const;
+        bool operator!=(const DiskStamp& other) const { return !(*this == other); }
+        bool isValid() const { return jsonSize >= 0; }
+    };
+    
+    void recordChange(const QString& id, bool remove);
+    void startSave();
+    void onSaveFinished(bool ok, const QString& message, bool full, const QVector<JournalOp>& ops,
+                        const DiskStamp& written, bool foreign);
+    // foreign: another process had changed the file, and its changes are
+    // in what was written but not in hosts; written is still exact
+    static bool writeHosts(const QString& path, const QVector<SSHHost>& hosts, const QVector<JournalOp>& ops,
+                           bool full, bool snapshot, const DiskStamp& expected, DiskStamp& written,
+                           bool& foreign, QString& error);
+    // Re-read the file after saving over someone else's changes
+    void reloadForeign();
+    static bool writeAtomically(const QString& path, const QByteArray& data, QString& error);
+    static bool appendJournal(const QString& path, const QVector<JournalOp>& ops, QString& error);
+    static bool readUnlocked(const QString& path, QVector<SSHHost>& hosts, QString& error, bool useSnapshot);
+    static void replayJournal(const QString& jsonPath, QVector<SSHHost>& hosts);
+    static int applyOps(QVector<SSHHost>& hosts, const QVector<JournalOp>& ops);
+    static DiskStamp stampOf(const QString& jsonPath);
+    
+    void checkDisk();
+    void onDiskRead(const QVector<SSHHost>& hosts, const DiskStamp& stamp, const QString& error);
+    
+    // Row edits with their signals, shared by the public mutators and reloads
+    void insertRow(const SSHHost& host);
+    void removeRow(int row);
+    void replaceRow(int row, const SSHHost& host);
+    int rebuildIndexes();
+    void indexHost(int row);
+    void unindexHost(int row);
+    // Rows from indexedRows_ on may have moved; fixes their index entries
+    void reindexRows() const;
+    void intern(SSHHost& host);
+    
+    QVector<SSHHost> hosts_;
+    mutable QHash<QString, int> indexById_;     // Exact below indexedRows_
+    mutable int indexedRows_;
+    QMultiHash<QString, QString> indexByName_;      // To host IDs
+    QMultiHash<QString, QString> indexByHostname_;
+    HostSearchIndex searchIndex_;
+    QSet<QString> strings_;     // Interned user/host/path values
     QString filePath_;
+    bool useSnapshot_;
+    bool autosave_;
+    bool journal_;
+    bool needsFull_;            // Next save rewrites hosts.json
+    QVector<JournalOp> pendingOps_;
+    QHash<QString, int> pendingIndex_;
+    QTimer* saveTimer_;
+    QThreadPool* savePool_;     // One thread: saves land in order
+    QAtomicInt failedSaves_;
+    int savesInFlight_;
+    DiskStamp diskStamp_;       // After our last read or write
+    int watchFd_;
+    QSocketNotifier* watchNotifier_;
+    QTimer* reloadTimer_;       // Coalesces a burst of events into one read
+    bool reloading_;
+    bool reloadPending_;        // Events arrived while saving or reading
+    bool forceReload_;          // Read even though the stamp is ours
     
     void ensureDirectoryExists();
 };
\ No newline at end of file
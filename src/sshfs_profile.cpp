@@ -0,0 +1,173 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#include "sshfs_profile.hpp"
+#include <QRegularExpression>
+
+namespace {
+
+const char* const LanName = "LAN throughput";
+const char* const WanName = "WAN latency";
+const char* const MetadataName = "metadata-heavy";
+
+// Set by SSHMounter itself; a profile must not override them
+const char* const ReservedOptions[] = {
+    "password_stdin", "PubkeyAuthentication", "PasswordAuthentication",
+    "ControlMaster", "ControlPath", "ControlPersist", "reconnect"
+};
+
+} // namespace
+
+QStringList SSHFSProfile::presetNames() {
+    return {DefaultName, LanName, WanName, MetadataName};
+}
+
+SSHFSProfile SSHFSProfile::preset(const QString& name) {
+    SSHFSProfile p;
+    if (name == LanName) {
+        // Fast link, cheap round trips: spend nothing on compression and
+        // pick AEAD ciphers that run at line rate; big requests.
+        p.name = LanName;
+        p.ciphers = "aes128-gcm@openssh.com,chacha20-poly1305@openssh.com";
+        p.compression = false;
+        p.kernelCache = true;
+        p.maxRead = 262144;
+        p.maxWrite = 262144;
+        p.cacheTimeout = 20;
+    } else if (name == WanName) {
+        // Slow link, expensive round trips: compress and cache longer
+        p.name = WanName;
+        p.ciphers = "chacha20-poly1305@openssh.com";
+        p.compression = true;
+        p.kernelCache = true;
+        p.maxConns = 4;
+        p.cacheTimeout = 300;
+        p.attrTimeout = 60;
+    } else if (name == MetadataName) {
+        // Many small files: keep stat and directory results around
+        p.name = MetadataName;
+        p.kernelCache = true;
+        p.maxConns = 8;
+        p.cacheTimeout = 600;
+        p.attrTimeout = 120;
+    }
+    return p;
+}
+
+QStringList SSHFSProfile::validate() const {
+    QStringList errors;
+    if (serverAliveInterval < 0 || serverAliveInterval > 3600)
+        errors << "Keepalive interval must be between 0 and 3600 seconds";
+    if (serverAliveCountMax < 1 || serverAliveCountMax > 100)
+        errors << "Keepalive count must be between 1 and 100";
+    if (maxConns < 1 || maxConns > 64)
+        errors << "Connections must be between 1 and 64";
+    if (maxRead != 0 && (maxRead < 4096 || maxRead > 1048576))
+        errors << "Max read size must be between 4 KiB and 1 MiB";
+    if (maxWrite != 0 && (maxWrite < 4096 || maxWrite > 1048576))
+        errors << "Max write size must be between 4 KiB and 1 MiB";
+    if (cacheTimeout < -1 || cacheTimeout > 86400)
+        errors << "Cache timeout must be between 0 and 86400 seconds";
+    if (attrTimeout < -1 || attrTimeout > 86400)
+        errors << "Attribute timeout must be between 0 and 86400 seconds";
+
+    static const QRegularExpression cipherRe("^[A-Za-z0-9@._-]+(,[A-Za-z0-9@._-]+)*$");
+    if (!ciphers.isEmpty() && !cipherRe.match(ciphers).hasMatch())
+        errors << "Ciphers must be a comma separated list of cipher names";
+
+    if (extraOptions.contains(QRegularExpression("\\s")))
+        errors << "Extra options must not contain spaces";
+    for (const QString& opt : extraOptions.split(',', Qt::SkipEmptyParts)) {
+        const QString key = opt.section('=', 0, 0);
+        for (const char* reserved : ReservedOptions) {
+            if (key.compare(reserved, Qt::CaseInsensitive) == 0) {
+                errors << QString("Extra option %1 is managed by SSH Mounter").arg(key);
+            }
+        }
+    }
+    return errors;
+}
+
+QString SSHFSProfile::optionString() const {
+    QStringList opts;
+    opts << "reconnect"
+         << QString("ServerAliveInterval=%1").arg(serverAliveInterval)
+         << QString("ServerAliveCountMax=%1").arg(serverAliveCountMax)
+         << QString("max_conns=%1").arg(maxConns);
+    // sshfs splits -o on commas; a backslash keeps the cipher list whole
+    if (!ciphers.isEmpty()) opts << "Ciphers=" + QString(ciphers).replace(",", "\\,");
+    // The default profile keeps the option string mounts always used
+    if (compression) opts << "Compression=yes";
+    else if (name != DefaultName) opts << "Compression=no";
+    if (kernelCache) opts << "kernel_cache";
+    if (maxRead > 0) opts << QString("max_read=%1").arg(maxRead);
+    if (maxWrite > 0) opts << QString("max_write=%1").arg(maxWrite);
+    if (cacheTimeout >= 0) opts << QString("cache_timeout=%1").arg(cacheTimeout);
+    if (attrTimeout >= 0) {
+        opts << QString("attr_timeout=%1").arg(attrTimeout)
+             << QString("entry_timeout=%1").arg(attrTimeout);
+    }
+    if (!extraOptions.isEmpty()) opts << extraOptions;
+    return opts.join(",");
+}
+
+QJsonObject SSHFSProfile::toJson() const {
+    QJsonObject obj;
+    obj["name"] = name;
+    // Presets are stored by name so they pick up tuning changes
+    if (isPreset()) return obj;
+
+    obj["serverAliveInterval"] = serverAliveInterval;
+    obj["serverAliveCountMax"] = serverAliveCountMax;
+    obj["maxConns"] = maxConns;
+    obj["ciphers"] = ciphers;
+    obj["compression"] = compression;
+    obj["kernelCache"] = kernelCache;
+    obj["maxRead"] = maxRead;
+    obj["maxWrite"] = maxWrite;
+    obj["cacheTimeout"] = cacheTimeout;
+    obj["attrTimeout"] = attrTimeout;
+    obj["extraOptions"] = extraOptions;
+    return obj;
+}
+
+SSHFSProfile SSHFSProfile::fromJson(const QJsonObject& obj) {
+    const QString name = obj["name"].toString(DefaultName);
+    if (name != CustomName) return preset(name);
+
+    SSHFSProfile p;
+    p.name = CustomName;
+    p.serverAliveInterval = obj["serverAliveInterval"].toInt(p.serverAliveInterval);
+    p.serverAliveCountMax = obj["serverAliveCountMax"].toInt(p.serverAliveCountMax);
+    p.maxConns = obj["maxConns"].toInt(p.maxConns);
+    p.ciphers = obj["ciphers"].toString();
+    p.compression = obj["compression"].toBool(false);
+    p.kernelCache = obj["kernelCache"].toBool(false);
+    p.maxRead = obj["maxRead"].toInt(0);
+    p.maxWrite = obj["maxWrite"].toInt(0);
+    p.cacheTimeout = obj["cacheTimeout"].toInt(-1);
+    p.attrTimeout = obj["attrTimeout"].toInt(-1);
+    p.extraOptions = obj["extraOptions"].toString();
+    return p;
+}
+
+bool SSHFSProfile::operator==(const SSHFSProfile& o) const {
+    return name == o.name && serverAliveInterval == o.serverAliveInterval &&
+           serverAliveCountMax == o.serverAliveCountMax && maxConns == o.maxConns &&
+           ciphers == o.ciphers && compression == o.compression &&
+           kernelCache == o.kernelCache && maxRead == o.maxRead && maxWrite == o.maxWrite &&
+           cacheTimeout == o.cacheTimeout && attrTimeout == o.attrTimeout &&
+           extraOptions == o.extraOptions;
+}
@@ -0,0 +1,59 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#pragma once
+
+#include <QJsonObject>
+#include <QString>
+#include <QStringList>
+
+// sshfs/ssh tuning for one host. Built-in presets cover the common cases;
+// any edit turns the profile into "Custom". optionString() renders the
+// value for sshfs -o; authentication and connection sharing options are
+// added by SSHMounter on top.
+struct SSHFSProfile {
+    QString name = DefaultName;
+
+    int serverAliveInterval = 15;
+    int serverAliveCountMax = 3;
+    int maxConns = 16;
+    QString ciphers;            // ssh Ciphers list; empty = ssh default
+    bool compression = false;
+    bool kernelCache = false;
+    int maxRead = 0;            // bytes; 0 = sshfs default
+    int maxWrite = 0;
+    int cacheTimeout = -1;      // seconds; -1 = sshfs default
+    int attrTimeout = -1;       // FUSE attr_timeout/entry_timeout; -1 = default
+    QString extraOptions;       // Appended verbatim, comma separated
+
+    static constexpr const char* DefaultName = "Default";
+    static constexpr const char* CustomName = "Custom";
+
+    static QStringList presetNames();
+    // Unknown names give the default profile
+    static SSHFSProfile preset(const QString& name);
+    bool isPreset() const { return name != CustomName; }
+
+    // Human-readable problems; empty when the profile can be used
+    QStringList validate() const;
+    QString optionString() const;
+
+    QJsonObject toJson() const;
+    static SSHFSProfile fromJson(const QJsonObject& obj);
+
+    bool operator==(const SSHFSProfile& other) const;
+    bool operator!=(const SSHFSProfile& other) const { return !(*this == other); }
+};
+Q_DECLARE_TYPEINFO(SSHFSProfile, Q_MOVABLE_TYPE);
@@ -0,0 +1,105 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#include "startup.hpp"
+#include "console.hpp"
+#include <QCoreApplication>
+#include <QMetaObject>
+#include <QPair>
+#include <QPointer>
+#include <QThreadPool>
+#include <memory>
+
+extern Console console;
+
+StartupPipeline::StartupPipeline(const QString& hostsPath, QObject* parent)
+    : QObject(parent), hostsPath_(hostsPath), pending_(0), firstPaint_(-1), interactive_(-1) {
+}
+
+QElapsedTimer& StartupPipeline::clock() {
+    static QElapsedTimer timer;
+    return timer;
+}
+
+template<typename Work, typename Deliver>
+void StartupPipeline::runStage(const char* name, Work work, Deliver deliver) {
+    ++pending_;
+    // Only the guard crosses threads; the pipeline may be gone before the
+    // work finishes
+    QPointer<StartupPipeline> self(this);
+    QThreadPool::globalInstance()->start([self, name, work, deliver]() {
+        QElapsedTimer t;
+        t.start();
+        auto result = std::make_shared<decltype(work())>(work());
+        qint64 elapsed = t.elapsed();
+
+        // Back to the UI thread; dropped if the pipeline is gone by then
+        QMetaObject::invokeMethod(QCoreApplication::instance(), [self, name, deliver, result, elapsed]() {
+            if (!self) return;
+            deliver(*result);
+            self->stageDone(name, elapsed);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void StartupPipeline::start() {
+    runStage("capabilities", []() {
+        return Capabilities::probe();
+    }, [this](const Capabilities& caps) {
+        emit capabilitiesReady(caps);
+    });
+
+    const QString path = hostsPath_;
+    runStage("hosts", [path]() {
+        QPair<QVector<SSHHost>, QString> result;
+        if (!SSHStore::readHosts(path, result.first, result.second) && result.second.isEmpty()) {
+            result.second = "Failed to load hosts";
+        }
+        return result;
+    }, [this](const QPair<QVector<SSHHost>, QString>& result) {
+        emit hostsReady(result.first, result.second);
+    });
+
+    runStage("mounts", []() {
+        MountTable table;
+        table.load();
+        return table;
+    }, [this](const MountTable& table) {
+        emit mountTableReady(table);
+    });
+}
+
+void StartupPipeline::stageDone(const char* name, qint64 elapsed) {
+    timings_ << QString("%1 %2 ms").arg(name).arg(elapsed);
+    if (--pending_ > 0) return;
+
+    interactive_ = clock().elapsed();
+    emit finished();
+    report();
+}
+
+void StartupPipeline::markFirstPaint() {
+    if (firstPaint_ >= 0) return;
+    firstPaint_ = clock().elapsed();
+    report();
+}
+
+void StartupPipeline::report() {
+    if (firstPaint_ < 0 || interactive_ < 0) return;
+    console.info("Startup: first paint", firstPaint_, "ms, interactive", interactive_,
+                 "ms (" + timings_.join(", ").toStdString() + ")");
+}
+
+#include "startup.moc"
@@ -0,0 +1,58 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#pragma once
+
+#include "capabilities.hpp"
+#include "mount_table.hpp"
+#include "ssh_store.hpp"
+#include <QElapsedTimer>
+#include <QObject>
+#include <QStringList>
+
+// Runs the startup stages (capability probe, host store load, initial
+// mount table read) in parallel on the global thread pool and delivers
+// each result on the UI thread as soon as it is ready. Also measures time
+// to first paint and time to interactive from process start.
+class StartupPipeline : public QObject {
+    Q_OBJECT
+public:
+    explicit StartupPipeline(const QString& hostsPath, QObject* parent = nullptr);
+
+    // Started at the top of main(); all timings are relative to it
+    static QElapsedTimer& clock();
+
+    void start();
+    void markFirstPaint();
+    bool isFinished() const { return pending_ == 0; }
+
+signals:
+    void capabilitiesReady(const Capabilities& caps);
+    void hostsReady(const QVector<SSHHost>& hosts, const QString& error);
+    void mountTableReady(const MountTable& table);
+    void finished();
+
+private:
+    template<typename Work, typename Deliver>
+    void runStage(const char* name, Work work, Deliver deliver);
+    void stageDone(const char* name, qint64 elapsed);
+    void report();
+
+    QString hostsPath_;
+    int pending_;
+    QStringList timings_;
+    qint64 firstPaint_;
+    qint64 interactive_;
+};
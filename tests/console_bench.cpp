@@ -0,0 +1,135 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#include "harness.hpp"
+#include "console.hpp"
+#include <QCommandLineParser>
+#include <atomic>
+#include <chrono>
+#include <fcntl.h>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+extern Console console;
+
+namespace {
+
+struct CallCost {
+    double meanNs = 0;
+    double slowestNs = 0;
+};
+
+// Runs call(thread, i) calls times on each of threads threads, all started
+// together; the cost per call is each thread's wall time over its calls
+template<typename Call>
+CallCost timeCalls(int threads, long calls, Call call) {
+    std::atomic<int> waiting{threads};
+    std::atomic<bool> go{false};
+    std::vector<double> perCall(std::size_t(threads), 0.0);
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; ++t) {
+        pool.emplace_back([&, t]() {
+            waiting.fetch_sub(1);
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            auto start = std::chrono::steady_clock::now();
+            for (long i = 0; i < calls; ++i) call(t, i);
+            std::chrono::duration<double, std::nano> took = std::chrono::steady_clock::now() - start;
+            perCall[std::size_t(t)] = took.count() / double(calls);
+        });
+    }
+    while (waiting.load() > 0) std::this_thread::yield();
+    go.store(true, std::memory_order_release);
+    for (std::thread& thread : pool) thread.join();
+
+    CallCost cost;
+    for (double ns : perCall) {
+        cost.meanNs += ns / threads;
+        if (ns > cost.slowestNs) cost.slowestNs = ns;
+    }
+    return cost;
+}
+
+QJsonObject toJson(const CallCost& cost) {
+    QJsonObject obj;
+    obj["meanNs"] = cost.meanNs;
+    obj["slowestNs"] = cost.slowestNs;
+    return obj;
+}
+
+void options(QCommandLineParser& parser) {
+    parser.addOption({"threads", "Threads logging at once.", "n", "16"});
+    parser.addOption({"calls", "Calls per thread.", "n", "100000"});
+}
+
+// Per-call cost with many threads logging at once, against a mutex and a
+// write() per line
+int run(TestContext& t) {
+    const int threads = t.intValue("threads");
+    const long calls = t.intValue("calls");
+    const int nullFd = ::open("/dev/null", O_WRONLY | O_CLOEXEC);
+    if (nullFd < 0) {
+        console.error("Cannot open /dev/null");
+        return 1;
+    }
+
+    // info() drops lines once the ring is full; warn() waits for room, so
+    // every line is written, as with the mutex
+    QJsonObject info, warn;
+    {
+        Console bench;
+        bench.setOutput(nullFd);
+        info = toJson(timeCalls(threads, calls, [&bench](int n, long i) { bench.info("bench thread", n, "call", i); }));
+        bench.flush();
+        info["dropped"] = double(bench.dropped());
+    }
+    {
+        Console bench;
+        bench.setOutput(nullFd);
+        warn = toJson(timeCalls(threads, calls, [&bench](int n, long i) { bench.warn("bench thread", n, "call", i); }));
+        bench.flush();
+        warn["dropped"] = double(bench.dropped());
+    }
+    t.check("warn drops nothing", warn["dropped"].toDouble() == 0);
+
+    // What Console did before: a lock and a write per line
+    std::mutex mutex;
+    const CallCost locked = timeCalls(threads, calls, [&mutex, nullFd](int n, long i) {
+        std::lock_guard<std::mutex> lock(mutex);
+        const std::string line = "[INFO] bench thread " + std::to_string(n) + " call " + std::to_string(i) + "\n";
+        for (std::size_t done = 0; done < line.size();) {
+            const ssize_t wrote = ::write(nullFd, line.data() + done, line.size() - done);
+            if (wrote <= 0) break;
+            done += std::size_t(wrote);
+        }
+    });
+    ::close(nullFd);
+
+    QJsonObject& doc = t.report();
+    doc["threads"] = threads;
+    doc["calls"] = double(calls);
+    doc["logLevel"] = SSH_MOUNTER_LOG_LEVEL;
+    doc["info"] = info;
+    doc["warn"] = warn;
+    doc["mutex"] = toJson(locked);
+    return t.finish();
+}
+
+const TestCase consoleBench("console-bench", "Logging cost under contention, against a mutex", TestCase::Bench, run,
+                            options);
+
+} // namespace
@@ -0,0 +1,179 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#include "harness.hpp"
+#include "console.hpp"
+#include "control.hpp"
+#include "mount_manager.hpp"
+#include "mount_watcher.hpp"
+#include "ssh_store.hpp"
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <atomic>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+extern Console console;
+
+namespace {
+
+int connectUnix(const QString& path) {
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    const QByteArray native = QFile::encodeName(path);
+    if (native.size() >= int(sizeof(addr.sun_path))) return -1;
+    memcpy(addr.sun_path, native.constData(), native.size());
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd >= 0 && ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        ::close(fd);
+        fd = -1;
+    }
+    return fd;
+}
+
+bool sendAll(int fd, const QByteArray& data) {
+    for (int sent = 0; sent < data.size();) {
+        const ssize_t n = ::send(fd, data.constData() + sent, size_t(data.size() - sent), MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        sent += int(n);
+    }
+    return true;
+}
+
+// Reply lines from a blocking socket
+struct Replies {
+    int fd;
+    QByteArray buf;
+
+    bool next(QByteArray& line) {
+        for (;;) {
+            const int nl = buf.indexOf('\n');
+            if (nl >= 0) {
+                line = buf.left(nl);
+                buf.remove(0, nl + 1);
+                return true;
+            }
+            char chunk[65536];
+            const ssize_t n = ::read(fd, chunk, sizeof(chunk));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            buf.append(chunk, int(n));
+        }
+    }
+};
+
+void options(QCommandLineParser& parser) {
+    parser.addOption({"hosts", "Hosts in the store.", "n", "1000"});
+    parser.addOption({"requests", "Status queries per run.", "n", "500"});
+    parser.addOption({"pipeline", "Queries in flight at once in the second run.", "n", "16"});
+}
+
+// All-hosts status queries per second against a ControlServer in this
+// process, first strictly request/reply, then pipelined. The client runs
+// on its own thread while the server answers from the event loop.
+int run(TestContext& t) {
+    const int n = t.intValue("hosts");
+    const int total = t.intValue("requests");
+    const int pipeline = t.intValue("pipeline");
+    const QString dir = t.dir();
+    if (!t.check("temporary directory", !dir.isEmpty())) return t.finish();
+
+    SSHStore store;
+    store.setFilePath(dir + "/hosts.json");
+    store.addHosts(syntheticHosts(n, dir + "/mnt"));
+    MountWatcher watcher;
+    watcher.setHosts(store.hosts());
+    MountManager manager;
+    ControlServer server(&store, &watcher, &manager, nullptr);
+    const QString path = dir + "/control.sock";
+    QString error;
+    if (!t.check("listen", server.listen(path, error), error)) return t.finish();
+
+    const int fd = connectUnix(path);
+    if (!t.check("connect", fd >= 0, strerror(errno))) return t.finish();
+
+    const QByteArray query = "{\"cmd\":\"status\"}\n";
+    std::atomic<bool> done{false};
+    int listed = -1;
+    qint64 replyBytes = 0;
+    QVector<double> seconds;
+    std::thread client([&]() {
+        Replies replies{fd};
+        QByteArray line;
+        if (sendAll(fd, query) && replies.next(line)) {
+            listed = QJsonDocument::fromJson(line).object().value("hosts").toArray().size();
+            replyBytes = line.size() + 1;
+        }
+        for (int depth : {1, pipeline}) {
+            if (listed < 0) break;
+            QElapsedTimer timer;
+            timer.start();
+            int sent = 0, received = 0;
+            while (received < total) {
+                // Top up once half the window has drained, not per reply
+                const int outstanding = sent - received;
+                const int burst = outstanding <= depth / 2 ? qMin(depth - outstanding, total - sent) : 0;
+                if (burst > 0) {
+                    if (!sendAll(fd, query.repeated(burst))) break;
+                    sent += burst;
+                }
+                if (!replies.next(line)) break;
+                ++received;
+            }
+            if (received < total) break;
+            seconds.append(timer.nsecsElapsed() / 1e9);
+        }
+        done.store(true);
+    });
+    const bool finished = t.waitFor([&done]() { return done.load(); }, 600000);
+    // Unblocks the client if the server stopped answering
+    ::shutdown(fd, SHUT_RDWR);
+    client.join();
+    ::close(fd);
+
+    t.check("finished", finished);
+    t.check("status lists every host", listed == n, QString("%1 of %2").arg(listed).arg(n));
+    t.check("every query answered", seconds.size() == 2);
+
+    QJsonArray results;
+    for (int i = 0; i < seconds.size(); ++i) {
+        QJsonObject r;
+        r["pipeline"] = i == 0 ? 1 : pipeline;
+        r["requests"] = total;
+        r["seconds"] = seconds[i];
+        r["perSecond"] = qRound64(total / qMax(seconds[i], 1e-9));
+        r["microsPerRequest"] = seconds[i] * 1e6 / total;
+        results.append(r);
+        console.info("Pipeline", r["pipeline"].toInt(), ":", r["perSecond"].toDouble(), "status queries/s");
+    }
+    QJsonObject& doc = t.report();
+    doc["hosts"] = n;
+    doc["query"] = QString::fromUtf8(query.trimmed());
+    doc["replyBytes"] = double(replyBytes);
+    doc["results"] = results;
+    return t.finish();
+}
+
+const TestCase controlBench("control-bench", "All-hosts status queries per second over the control socket",
+                            TestCase::Bench, run, options);
+
+} // namespace
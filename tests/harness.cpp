@@ -0,0 +1,184 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#include "harness.hpp"
+#include "console.hpp"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QTemporaryDir>
+#include <QThread>
+#include <algorithm>
+#include <arpa/inet.h>
+#include <iostream>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+extern Console console;
+
+namespace {
+
+QVector<const TestCase*>& registry() {
+    static QVector<const TestCase*> cases;
+    return cases;
+}
+
+} // namespace
+
+TestCase::TestCase(const char* name, const char* summary, Kind kind, Run run, Options options)
+    : name_(name), summary_(summary), kind_(kind), run_(run), options_(options) {
+    registry().append(this);
+}
+
+const QVector<const TestCase*>& TestCase::all() {
+    return registry();
+}
+
+const TestCase* TestCase::find(const QString& name) {
+    for (const TestCase* c : registry()) {
+        if (name == QLatin1String(c->name())) return c;
+    }
+    return nullptr;
+}
+
+TestContext::TestContext(QCoreApplication& app, const QCommandLineParser& parser, const QString& name)
+    : app_(app), parser_(parser), name_(name), failures_(0) {
+}
+
+TestContext::~TestContext() = default;
+
+QString TestContext::value(const QString& option) const {
+    return parser_.value(option);
+}
+
+int TestContext::intValue(const QString& option, int min) const {
+    return qMax(min, parser_.value(option).toInt());
+}
+
+QString TestContext::dir() {
+    if (!dir_) dir_.reset(new QTemporaryDir(QDir::tempPath() + "/ssh-mounter-" + name_ + "-XXXXXX"));
+    if (!dir_->isValid()) {
+        console.error("Cannot create a temporary directory");
+        return QString();
+    }
+    return dir_->path();
+}
+
+bool TestContext::check(const QString& name, bool ok, const QString& detail) {
+    QJsonObject entry;
+    entry["check"] = name;
+    entry["ok"] = ok;
+    if (!detail.isEmpty()) entry["detail"] = detail;
+    checks_.append(entry);
+    if (!ok) {
+        ++failures_;
+        console.error(name_.toStdString(), "failed:", name.toStdString(), detail.toStdString());
+    }
+    return ok;
+}
+
+bool TestContext::waitFor(const std::function<bool()>& done, int ms) {
+    QElapsedTimer wait;
+    wait.start();
+    while (!done() && wait.elapsed() < ms) {
+        app_.processEvents(QEventLoop::AllEvents, 20);
+        QThread::msleep(2);
+    }
+    return done();
+}
+
+int TestContext::finish() {
+    QJsonObject doc = report_;
+    if (!checks_.isEmpty()) {
+        doc["checks"] = checks_;
+        doc["failures"] = failures_;
+        console.info(checks_.size() - failures_, "of", checks_.size(), name_.toStdString(), "checks passed");
+    }
+    std::cout << QJsonDocument(doc).toJson(QJsonDocument::Indented).constData() << std::flush;
+    return failures_ == 0 ? 0 : 1;
+}
+
+QVector<SSHHost> syntheticHosts(int n, const QString& mountRoot) {
+    static const char* const roles[] = {"web", "db", "cache", "build", "backup", "mail", "proxy", "git"};
+    static const char* const sites[] = {"fra", "ams", "nyc", "sfo", "sgp", "syd"};
+    QVector<SSHFSProfile> profiles;
+    for (const QString& name : SSHFSProfile::presetNames()) profiles.append(SSHFSProfile::preset(name));
+    SSHFSProfile custom = SSHFSProfile::preset(SSHFSProfile::DefaultName);
+    custom.name = SSHFSProfile::CustomName;
+    custom.maxConns = 4;
+    custom.extraOptions = "reconnect";
+    profiles.append(custom);
+
+    QVector<SSHHost> hosts;
+    hosts.reserve(n);
+    for (int i = 0; i < n; ++i) {
+        SSHHost h;
+        h.id = QString("bench-%1").arg(i);
+        h.name = QString("%1-%2-%3").arg(roles[i % 8]).arg(sites[i / 8 % 6]).arg(i);
+        h.user = i % 3 == 0 ? "root" : "deploy";
+        h.host = QString("%1%2.%3.example.com").arg(roles[i % 8]).arg(i).arg(sites[i / 8 % 6]);
+        h.remotePath = i % 2 == 0 ? "/srv" : "/var/www";
+        h.localPath = mountRoot + "/" + h.name;
+        h.port = 22 + i % 3;
+        h.usePublicKey = i % 2 == 0;
+        h.favorite = i % 10 == 0;
+        h.lazyMount = i % 4 == 0;
+        h.idleUnmountMinutes = h.lazyMount ? 15 : 0;
+        h.controlPersist = i % 5 == 0 ? 0 : 600;
+        h.profile = profiles[i % profiles.size()];
+        hosts.append(h);
+    }
+    return hosts;
+}
+
+qint64 residentBytes() {
+    QFile statm("/proc/self/statm");
+    if (!statm.open(QIODevice::ReadOnly)) return 0;
+    const QList<QByteArray> fields = statm.readAll().split(' ');
+    return fields.size() > 1 ? fields[1].toLongLong() * sysconf(_SC_PAGESIZE) : 0;
+}
+
+double medianNs(int runs, const std::function<void()>& fn) {
+    QVector<qint64> times;
+    times.reserve(runs);
+    for (int run = 0; run < qMax(1, runs); ++run) {
+        QElapsedTimer timer;
+        timer.start();
+        fn();
+        times.append(timer.nsecsElapsed());
+    }
+    std::sort(times.begin(), times.end());
+    return double(times[times.size() / 2]);
+}
+
+int loopbackSocket(int& port, int backlog) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    if (fd < 0 || bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        (backlog > 0 && listen(fd, backlog) != 0) ||
+        getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) != 0) {
+        if (fd >= 0) ::close(fd);
+        return -1;
+    }
+    port = ntohs(addr.sin_port);
+    return fd;
+}
@@ -0,0 +1,109 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#pragma once
+
+#include "ssh_store.hpp"
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QString>
+#include <QVector>
+#include <functional>
+#include <memory>
+
+class QCommandLineParser;
+class QCoreApplication;
+class QTemporaryDir;
+class TestContext;
+
+// A benchmark or self-check of the test binary, run as
+// `ssh-mounter-tests NAME [options]`. Cases register themselves from
+// a static TestCase in their own file; `make check` runs every Check.
+class TestCase {
+public:
+    enum Kind { Check, Bench };
+    using Options = void (*)(QCommandLineParser&);
+    using Run = int (*)(TestContext&);
+
+    TestCase(const char* name, const char* summary, Kind kind, Run run, Options options = nullptr);
+
+    const char* name() const { return name_; }
+    const char* summary() const { return summary_; }
+    Kind kind() const { return kind_; }
+    void addOptions(QCommandLineParser& parser) const { if (options_) options_(parser); }
+    int run(TestContext& context) const { return run_(context); }
+
+    static const QVector<const TestCase*>& all();
+    static const TestCase* find(const QString& name);
+
+private:
+    const char* name_;
+    const char* summary_;
+    Kind kind_;
+    Run run_;
+    Options options_;
+};
+
+// What a running case gets: its options, a throwaway directory, and a
+// report that finish() prints as JSON on stdout (the log goes to stderr)
+class TestContext {
+public:
+    TestContext(QCoreApplication& app, const QCommandLineParser& parser, const QString& name);
+    ~TestContext();
+
+    QCoreApplication& app() const { return app_; }
+    const QCommandLineParser& options() const { return parser_; }
+    QString value(const QString& option) const;
+    // An integer option, at least min
+    int intValue(const QString& option, int min = 1) const;
+
+    // Created on first use, removed when the case ends; empty on failure
+    QString dir();
+
+    // One named entry of the report's "checks"; a failure is also logged
+    bool check(const QString& name, bool ok, const QString& detail = QString());
+    int failures() const { return failures_; }
+    // Fields printed next to the checks
+    QJsonObject& report() { return report_; }
+
+    // Runs the event loop until done() holds or ms have passed
+    bool waitFor(const std::function<bool()>& done, int ms = 3000);
+    // Prints the report; the exit code is 1 if a check failed
+    int finish();
+
+private:
+    QCoreApplication& app_;
+    const QCommandLineParser& parser_;
+    QString name_;
+    std::unique_ptr<QTemporaryDir> dir_;
+    QJsonArray checks_;
+    int failures_;
+    QJsonObject report_;
+};
+
+// n hosts shaped like a real inventory: role-site-N names, a few users,
+// every SSHFS preset, and the optional fields set on some of them.
+// IDs are bench-N; mount points go under mountRoot.
+QVector<SSHHost> syntheticHosts(int n, const QString& mountRoot = QString("/mnt"));
+
+// Resident set size from /proc, in bytes
+qint64 residentBytes();
+
+// Median of runs calls of fn, in nanoseconds
+double medianNs(int runs, const std::function<void()>& fn);
+
+// A TCP socket on 127.0.0.1 with a free port. It listens if backlog > 0;
+// otherwise it is only bound, and connecting once it is closed is refused.
+int loopbackSocket(int& port, int backlog);
@@ -0,0 +1,140 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#include "harness.hpp"
+#include "console.hpp"
+#include "host_import.hpp"
+#include "ssh_store.hpp"
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+extern Console console;
+
+namespace {
+
+const int BenchConfigFiles = 16;
+
+bool writeFile(const QString& path, const QByteArray& data) {
+    QFile file(path);
+    return file.open(QIODevice::WriteOnly) && file.write(data) == data.size();
+}
+
+// Synthetic inventories of n hosts in each format, shaped like real ones:
+// the ssh config pulls its hosts in through Include and takes User from
+// wildcard blocks
+QStringList writeBenchSources(const QString& dir, int n) {
+    QDir().mkpath(dir + "/conf.d");
+    QByteArray config = "Host *\n    ServerAliveInterval 30\n\nInclude " + QFile::encodeName(dir) +
+                      "/conf.d/*.conf\n\nHost web-*\n    User deploy\n\nHost db-*\n    User postgres\n    Port 2222\n";
+    const int perFile = (n + BenchConfigFiles - 1) / BenchConfigFiles;
+    for (int f = 0; f < BenchConfigFiles; ++f) {
+        QByteArray part;
+        part.reserve(perFile * 64);
+        for (int i = f * perFile; i < qMin(n, (f + 1) * perFile); ++i) {
+            part += "Host " + QByteArray(i % 2 ? "db-" : "web-") + QByteArray::number(i) + "\n";
+            part += "    HostName 10." + QByteArray::number(i >> 16 & 255) + '.' +
+                    QByteArray::number(i >> 8 & 255) + '.' + QByteArray::number(i & 255) + "\n";
+            if (i % 10 == 0) part += "    Port " + QByteArray::number(2200 + i % 100) + "\n";
+        }
+        if (!writeFile(QString("%1/conf.d/%2.conf").arg(dir).arg(f, 2, 10, QChar('0')), part)) return {};
+    }
+
+    QByteArray csv = "name,hostname,user,port,remote_path\n";
+    QJsonArray json;
+    csv.reserve(n * 48);
+    for (int i = 0; i < n; ++i) {
+        const QByteArray name = "app-" + QByteArray::number(i);
+        const QByteArray address = "app" + QByteArray::number(i) + ".example.com";
+        csv += name + ',' + address + ",ops,22,/srv\n";
+        QJsonObject obj;
+        obj["name"] = QString::fromLatin1(name);
+        obj["hostname"] = QString::fromLatin1(address);
+        obj["user"] = "ops";
+        obj["port"] = 22;
+        json.append(obj);
+    }
+    if (!writeFile(dir + "/config", config) || !writeFile(dir + "/hosts.csv", csv) ||
+        !writeFile(dir + "/hosts.json", QJsonDocument(json).toJson(QJsonDocument::Compact))) {
+        return {};
+    }
+    return {dir + "/config", dir + "/hosts.csv", dir + "/hosts.json"};
+}
+
+void options(QCommandLineParser& parser) {
+    parser.addOption({"hosts", "Hosts per format.", "n", "50000"});
+    parser.addOption({"no-snapshot", "Skip the binary snapshot when saving."});
+}
+
+// Parse, insert into an empty store and save, each timed, per format
+int run(TestContext& t) {
+    const int n = t.intValue("hosts");
+    const bool snapshot = !t.options().isSet("no-snapshot");
+    const QString dir = t.dir();
+    if (!t.check("temporary directory", !dir.isEmpty())) return t.finish();
+    console.info("Writing", n, "hosts per format to", dir.toStdString());
+    const QStringList sources = writeBenchSources(dir, n);
+    if (!t.check("write inputs", !sources.isEmpty())) return t.finish();
+
+    QJsonArray results;
+    for (const QString& source : sources) {
+        const QString name = QFileInfo(source).fileName();
+        const ImportFormat format = HostImporter::detect(source);
+        QElapsedTimer timer;
+        timer.start();
+        HostImporter importer;
+        importer.setMountRoot(dir + "/mnt");
+        QString error;
+        if (!t.check(name + " imports", importer.importFile(source, format, error), error)) continue;
+        const qint64 parseMs = timer.restart();
+
+        SSHStore store;
+        store.setFilePath(dir + "/store-" + name + ".json");
+        store.setUseSnapshot(snapshot);
+        store.load();
+        store.addHosts(importer.hosts());
+        const qint64 insertMs = timer.restart();
+        if (!t.check(name + " saves", store.save())) continue;
+        const qint64 saveMs = timer.elapsed();
+
+        const qint64 totalMs = parseMs + insertMs + saveMs;
+        QJsonObject r;
+        r["source"] = name;
+        r["hosts"] = importer.hosts().size();
+        r["parseMs"] = parseMs;
+        r["insertMs"] = insertMs;
+        r["saveMs"] = saveMs;
+        r["totalMs"] = totalMs;
+        r["hostsPerSecond"] = qRound64(importer.hosts().size() * 1000.0 / qMax<qint64>(totalMs, 1));
+        results.append(r);
+        console.info(name.toStdString() + ":", importer.hosts().size(), "hosts in", totalMs, "ms");
+        t.check(name + " host count", importer.hosts().size() == n,
+                QString("%1 of %2").arg(importer.hosts().size()).arg(n));
+    }
+    t.report()["hosts"] = n;
+    t.report()["snapshot"] = snapshot;
+    t.report()["results"] = results;
+    return t.finish();
+}
+
+const TestCase importBench("import-bench", "Parse, insert and save timings for each import format", TestCase::Bench,
+                           run, options);
+
+} // namespace
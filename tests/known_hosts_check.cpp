@@ -0,0 +1,116 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#include "harness.hpp"
+#include "known_hosts.hpp"
+#include <QFile>
+
+namespace {
+
+// Parsing, lookups and replace() on a throwaway known_hosts file
+int run(TestContext& t) {
+    if (!t.check("temporary directory", !t.dir().isEmpty())) return t.finish();
+    const QString path = t.dir() + "/known_hosts";
+
+    const HostKey alpha{"ssh-ed25519", "key-alpha"};
+    const HostKey alphaRsa{"ssh-rsa", "key-gamma"};
+    const HostKey beta{"ssh-rsa", "key-beta"};
+    const HostKey gamma{"ssh-ed25519", "key-gamma"};
+    const HostKey wild{"ecdsa-sha2-nistp256", "key-wild"};
+    const HostKey revoked{"ssh-ed25519", "key-revoked"};
+    const HostKey fresh{"ssh-ed25519", "key-new"};
+
+    // Hashed names made by HMAC-SHA1 with salt 01..14 outside this code, of
+    // "alpha.example" and "[beta.example]:2222"
+    const QByteArray original =
+        "# kept as is\n"
+        "|1|AQIDBAUGBwgJCgsMDQ4PEBESExQ=|es/CRTokb6yPcF3DzIsEuOkjLXs= ssh-ed25519 a2V5LWFscGhh\n"
+        "|1|AQIDBAUGBwgJCgsMDQ4PEBESExQ=|LezldA54WgD2h8+cCL6kOLpkmcY= ssh-rsa a2V5LWJldGE=\n"
+        "gamma.example,192.0.2.7 ssh-ed25519 a2V5LWdhbW1h\n"
+        "*.wild.example,!bad.wild.example ecdsa-sha2-nistp256 a2V5LXdpbGQ=\n"
+        "@revoked gamma.example ssh-ed25519 a2V5LXJldm9rZWQ=\n"
+        "|1|bogus|x ssh-ed25519 a2V5\n"
+        "Alpha.Example ssh-rsa a2V5LWdhbW1h\n";
+    auto writeFile = [](const QString& file, const QByteArray& data) {
+        QFile out(file);
+        return out.open(QIODevice::WriteOnly | QIODevice::Truncate) && out.write(data) == data.size();
+    };
+    auto readFile = [](const QString& file) {
+        QFile in(file);
+        return in.open(QIODevice::ReadOnly) ? in.readAll() : QByteArray();
+    };
+    auto sameKeys = [](QList<HostKey> got, const QList<HostKey>& expected) {
+        if (got.size() != expected.size()) return false;
+        for (const HostKey& key : expected) {
+            if (!got.removeOne(key)) return false;
+        }
+        return true;
+    };
+    auto loaded = [&path]() {
+        KnownHosts known;
+        known.load({path});
+        return known;
+    };
+    if (!t.check("write known_hosts", writeFile(path, original))) return t.finish();
+
+    KnownHosts known = loaded();
+    t.check("parse", known.size() == 6, QString("%1 entries").arg(known.size()));
+    t.check("hashed", sameKeys(known.keys("alpha.example"), {alpha, alphaRsa})
+                      && sameKeys(known.keys("ALPHA.example"), {alpha, alphaRsa}));
+    t.check("hashed with port", sameKeys(known.keys(KnownHosts::token("beta.example", 2222)), {beta})
+                                && known.keys(KnownHosts::token("beta.example", 22)).isEmpty());
+    t.check("plain names", sameKeys(known.keys("192.0.2.7"), {gamma}));
+    t.check("wildcards", sameKeys(known.keys("x.wild.example"), {wild})
+                         && known.keys("bad.wild.example").isEmpty()
+                         && known.keys("wild.example").isEmpty());
+    t.check("compare", known.compare("alpha.example", {alpha}) == HostKeyStatus::Known
+                       && known.compare("alpha.example", {fresh}) == HostKeyStatus::Changed
+                       && known.compare("delta.example", {fresh}) == HostKeyStatus::New
+                       && known.compare("gamma.example", {revoked, gamma}) == HostKeyStatus::Revoked);
+
+    // Both the hashed and the plain line of alpha go, the new key comes in hashed
+    QString error;
+    bool ok = KnownHosts::replace(path, "alpha.example", {fresh}, true, error);
+    known = loaded();
+    const QByteArray rewritten = readFile(path);
+    t.check("replace hashed", ok && sameKeys(known.keys("alpha.example"), {fresh}) && known.size() == 5
+                              && !rewritten.toLower().contains("alpha.example")
+                              && rewritten.count("|1|") == 3, error);
+    t.check("replace keeps other lines", rewritten.startsWith("# kept as is\n")
+                                         && rewritten.contains("|1|bogus|x ssh-ed25519 a2V5\n")
+                                         && sameKeys(known.keys(KnownHosts::token("beta.example", 2222)), {beta})
+                                         && sameKeys(known.keys("gamma.example"), {gamma})
+                                         && known.compare("gamma.example", {revoked}) == HostKeyStatus::Revoked);
+    t.check("replace keeps old file", readFile(path + ".old") == original);
+
+    ok = KnownHosts::replace(path, KnownHosts::token("beta.example", 2222), {}, false, error);
+    known = loaded();
+    t.check("forget hashed with port", ok && known.keys(KnownHosts::token("beta.example", 2222)).isEmpty()
+                                       && known.size() == 4, error);
+
+    const QByteArray before = readFile(path);
+    ok = KnownHosts::replace(path, "nobody.example", {}, false, error);
+    t.check("forget unknown is a no-op", ok && readFile(path) == before, error);
+
+    const QString nested = t.dir() + "/ssh/known_hosts";
+    ok = KnownHosts::replace(nested, "epsilon.example", {fresh}, false, error);
+    t.check("replace creates file", ok && readFile(nested) == "epsilon.example ssh-ed25519 a2V5LW5ldw==\n", error);
+
+    return t.finish();
+}
+
+const TestCase knownHostsCheck("known-hosts-check", "known_hosts parsing, lookups and rewriting", TestCase::Check, run);
+
+} // namespace
@@ -0,0 +1,58 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#include "harness.hpp"
+#include "console.hpp"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <cstdio>
+#include <unistd.h>
+
+Console console;
+
+// ssh-mounter-tests NAME [options] | --list | --list-checks
+int main(int argc, char** argv) {
+    QCoreApplication app(argc, argv);
+    console.setOutput(STDERR_FILENO);
+
+    const QStringList args = app.arguments();
+    if (args.size() < 2 || args[1] == "--list" || args[1] == "--list-checks" || args[1] == "--help") {
+        const bool checksOnly = args.size() >= 2 && args[1] == "--list-checks";
+        if (!checksOnly) std::printf("Usage: ssh-mounter-tests NAME [options]\n\n");
+        for (const TestCase* c : TestCase::all()) {
+            if (checksOnly) {
+                if (c->kind() == TestCase::Check) std::printf("%s\n", c->name());
+            } else {
+                std::printf("  %-20s %s\n", c->name(), c->summary());
+            }
+        }
+        return args.size() < 2 ? 2 : 0;
+    }
+
+    const TestCase* test = TestCase::find(args[1]);
+    if (!test) {
+        console.error("No test called", args[1].toStdString(), "(see --list)");
+        return 2;
+    }
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QString::fromUtf8(test->summary()));
+    parser.addHelpOption();
+    parser.addPositionalArgument(test->name(), "The test to run.");
+    test->addOptions(parser);
+    parser.process(app);
+
+    TestContext context(app, parser, args[1]);
+    return test->run(context);
+}
@@ -0,0 +1,237 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#include "harness.hpp"
+#include "console.hpp"
+#include "mount_manager.hpp"
+#include "mount_watcher.hpp"
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTimer>
+#include <algorithm>
+#include <unistd.h>
+
+extern Console console;
+
+namespace {
+
+const int FrameMs = 16;
+
+bool writeScript(const QString& path, const QByteArray& body) {
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write("#!/bin/sh\n" + body) < 0) return false;
+    file.close();
+    return file.setPermissions(QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner);
+}
+
+QByteArray readFile(const QString& path) {
+    QFile file(path);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+// Intervals between FrameMs ticks while the event loop runs for ms;
+// started is called from inside the loop, before the first tick
+QVector<double> measureFrames(TestContext& t, int ms, const std::function<void()>& started = {}) {
+    QVector<double> frames;
+    QElapsedTimer clock;
+    QTimer frame;
+    frame.setTimerType(Qt::PreciseTimer);
+    frame.setInterval(FrameMs);
+    QObject::connect(&frame, &QTimer::timeout, [&]() {
+        frames.append(clock.nsecsElapsed() / 1e6);
+        clock.start();
+    });
+    QTimer::singleShot(0, &frame, [&]() {
+        clock.start();
+        frame.start();
+        if (started) started();
+    });
+    t.waitFor([]() { return false; }, ms);
+    return frames;
+}
+
+QJsonObject summarize(QVector<double> frames) {
+    QJsonObject r;
+    if (frames.isEmpty()) return r;
+    std::sort(frames.begin(), frames.end());
+    auto at = [&frames](double q) { return frames[qMin(frames.size() - 1, int(frames.size() * q))]; };
+    r["frames"] = frames.size();
+    r["p50Ms"] = at(0.5);
+    r["p99Ms"] = at(0.99);
+    r["maxMs"] = frames.last();
+    r["late"] = int(std::count_if(frames.begin(), frames.end(), [](double f) { return f > 2 * FrameMs; }));
+    return r;
+}
+
+void options(QCommandLineParser& parser) {
+    parser.addOption({"mounts", "Mounts in flight at once.", "n", "20"});
+    parser.addOption({"seconds", "How long to measure with the mounts in flight.", "s", "3"});
+    parser.addOption({"max-ms", "Fail if the 99th percentile frame takes longer.", "ms", "50"});
+}
+
+// The mount path against stand-in ssh, sshfs and fusermount scripts:
+// event loop latency while many mounts are in flight, a changed host key
+// kept and then removed, and the mount list following the mount table.
+// Nothing here may block; every step finishes from the event loop.
+int run(TestContext& t) {
+    const int n = t.intValue("mounts");
+    const QString dir = t.dir();
+    if (!t.check("temporary directory", !dir.isEmpty() && QDir().mkpath(dir + "/bin"))) return t.finish();
+
+    // Pre-flight connects here; the kernel completes them without accept()
+    int port = 0;
+    const int listener = loopbackSocket(port, n + 8);
+    if (!t.check("loopback listener", listener >= 0)) return t.finish();
+
+    // Stand-ins: ssh answers -G for the loopback listener and has no
+    // masters. sshfs never finishes for the frame hosts, as a slow server
+    // would; for the others it fails on a changed host key while the stale
+    // key is on file, and otherwise adds itself to a mount table that
+    // fusermount takes it out of again.
+    const QString bin = dir + "/bin";
+    const QByteArray knownHosts = QFile::encodeName(dir + "/known_hosts");
+    const QByteArray table = QFile::encodeName(dir + "/mountinfo");
+    const QByteArray token = "[127.0.0.1]:" + QByteArray::number(port);
+    const bool scripts =
+        writeScript(bin + "/ssh", "if [ \"$1\" = -G ]; then\n"
+                                  "    printf 'hostname 127.0.0.1\\nport %s\\nproxyjump none\\n' \"$3\"\n"
+                                  "    printf 'userknownhostsfile " + knownHosts + "\\n'\n"
+                                  "    exit 0\n"
+                                  "fi\n"
+                                  "exit 255\n") &&
+        writeScript(bin + "/sshfs", "case \"$2\" in */frame-*) exec sleep 600;; esac\n"
+                                    "if grep -qF '" + token + " ' '" + knownHosts + "'; then\n"
+                                    "    echo '@    WARNING: REMOTE HOST IDENTIFICATION HAS CHANGED!     @'\n"
+                                    "    echo 'Host key verification failed.'\n"
+                                    "    exit 1\n"
+                                    "fi\n"
+                                    "echo \"$$ 25 0:$$ / $2 rw - fuse.sshfs $1 rw\" >> '" + table + "'\n") &&
+        writeScript(bin + "/fusermount", "grep -v \" $2 rw \" '" + table + "' > '" + table + ".new'\n"
+                                         "cat '" + table + ".new' > '" + table + "'\n") &&
+        QFile(dir + "/known_hosts").open(QIODevice::WriteOnly) &&
+        QFile(dir + "/mountinfo").open(QIODevice::WriteOnly);
+    if (!t.check("stand-in scripts", scripts)) {
+        ::close(listener);
+        return t.finish();
+    }
+    qputenv("PATH", QFile::encodeName(bin) + ':' + qgetenv("PATH"));
+
+    auto makeHost = [&](const QString& id) {
+        SSHHost h;
+        h.id = id;
+        h.name = id;
+        h.user = "test";
+        h.host = "127.0.0.1";
+        h.port = port;
+        h.remotePath = "/";
+        h.localPath = dir + "/mnt/" + id;
+        h.usePublicKey = true;
+        h.controlPersist = 0;
+        QDir().mkpath(h.localPath);
+        return h;
+    };
+
+    // Frame latency, idle and then with n mounts in flight
+    QList<SSHHost> frameHosts;
+    for (int i = 0; i < n; ++i) frameHosts.append(makeHost(QString("frame-%1").arg(i)));
+    const QVector<double> idle = measureFrames(t, 1000);
+    {
+        MountManager manager;
+        manager.setMaxConcurrent(n);
+        manager.reachability()->setReadBanner(false);
+        int errors = 0;
+        QObject::connect(&manager, &MountManager::hostMountError, [&errors](const QString& key, const QString& error) {
+            ++errors;
+            console.error(key.toStdString() + ":", error.toStdString());
+        });
+        const QVector<double> busy = measureFrames(t, t.intValue("seconds") * 1000,
+                                                   [&manager, &frameHosts]() { manager.mountAll(frameHosts); });
+        int inFlight = 0;
+        for (const SSHHost& h : frameHosts) {
+            if (manager.state(MountManager::keyFor(h)) == MountState::Mounting) ++inFlight;
+        }
+        const QJsonObject mounting = summarize(busy);
+        const double p99 = mounting["p99Ms"].toDouble();
+        t.report()["idle"] = summarize(idle);
+        t.report()["mounting"] = mounting;
+        t.report()["mounts"] = n;
+        t.report()["inFlight"] = inFlight;
+        t.check("mounts in flight", inFlight == n && errors == 0,
+                QString("%1 of %2 in flight, %3 error(s)").arg(inFlight).arg(n).arg(errors));
+        t.check("frame budget", !busy.isEmpty() && p99 <= t.value("max-ms").toDouble(),
+                QString("p99 frame %1 ms").arg(p99));
+        // The sessions kill their sshfs on the way out
+    }
+
+    MountManager manager;
+    manager.reachability()->setReadBanner(false);
+    MountWatcher watcher;
+    watcher.start(dir + "/mountinfo");
+    QStringList mismatches, succeeded, failed, finished;
+    QObject::connect(&manager, &MountManager::hostKeyMismatch, [&mismatches](const QString& key) { mismatches << key; });
+    QObject::connect(&manager, &MountManager::hostMountSuccess, [&succeeded](const QString& key) { succeeded << key; });
+    QObject::connect(&manager, &MountManager::hostUnmountSuccess, [&succeeded](const QString& key) { succeeded << key; });
+    QObject::connect(&manager, &MountManager::hostMountError, [&failed](const QString& key, const QString& error) {
+        failed << key;
+        console.error(key.toStdString() + ":", error.toStdString());
+    });
+    QObject::connect(&manager, &MountManager::hostBusyChanged, [&finished](const QString& key, bool busy) {
+        if (!busy) finished << key;
+    });
+    QFile stale(dir + "/known_hosts");
+    if (stale.open(QIODevice::WriteOnly)) stale.write(token + " ssh-ed25519 a2V5LW9sZA==\n");
+    stale.close();
+
+    // Kept: the attempt ends cancelled and known_hosts is left alone
+    const SSHHost kept = makeHost("key-kept");
+    manager.mount(kept);
+    t.check("changed key reported", t.waitFor([&]() { return mismatches.contains("key-kept"); }));
+    manager.keepHostKey("key-kept");
+    t.waitFor([&]() { return finished.contains("key-kept"); });
+    t.check("kept key cancels", finished.contains("key-kept") && !succeeded.contains("key-kept") &&
+                                    !failed.contains("key-kept") && manager.state("key-kept") == MountState::Idle);
+    t.check("kept key stays on file", readFile(dir + "/known_hosts").contains(token));
+
+    // Removed: the key goes, sshfs runs again once and mounts
+    const SSHHost removed = makeHost("key-removed");
+    watcher.setHosts({kept, removed});
+    manager.mount(removed);
+    t.check("changed key reported again", t.waitFor([&]() { return mismatches.contains("key-removed"); }));
+    manager.removeHostKey("key-removed");
+    t.waitFor([&]() { return finished.contains("key-removed"); }, 5000);
+    t.check("removed key remounts", succeeded.contains("key-removed") && !failed.contains("key-removed") &&
+                                        mismatches.count("key-removed") == 1);
+    t.check("removed key is gone", !readFile(dir + "/known_hosts").contains(token));
+
+    // The mount list follows the table; the kernel would wake refresh()
+    // through POLLPRI, a plain file needs a nudge
+    watcher.refresh();
+    t.check("mount list shows the mount", watcher.isMounted("key-removed") && !watcher.isMounted("key-kept"));
+    finished.clear();
+    manager.unmount(removed);
+    t.waitFor([&]() { return finished.contains("key-removed"); });
+    watcher.refresh();
+    t.check("mount list drops the unmount", succeeded.count("key-removed") == 2 && !watcher.isMounted("key-removed"));
+
+    ::close(listener);
+    return t.finish();
+}
+
+const TestCase mountFlowCheck("mount-flow-check", "Frame latency with mounts in flight, host key and mount list flows",
+                              TestCase::Check, run, options);
+
+} // namespace
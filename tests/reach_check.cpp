@@ -0,0 +1,92 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#include "harness.hpp"
+#include "console.hpp"
+#include "reachability.hpp"
+#include <QCommandLineParser>
+#include <string>
+#include <thread>
+#include <sys/socket.h>
+#include <unistd.h>
+
+extern Console console;
+
+namespace {
+
+const char Banner[] = "SSH-2.0-ReachCheck";
+
+void options(QCommandLineParser& parser) {
+    parser.addOption({"deadline", "Pre-flight deadline.", "ms", "2000"});
+}
+
+// Probes a loopback listener that sends an SSH banner, by address and by
+// name, and a closed port on 40 loopback addresses (two ssh -G batches)
+int run(TestContext& t) {
+    int listenPort = 0, closedPort = 0;
+    const int listener = loopbackSocket(listenPort, 64);
+    const int closed = loopbackSocket(closedPort, 0);
+    if (!t.check("loopback sockets", listener >= 0 && closed >= 0)) {
+        if (listener >= 0) ::close(listener);
+        if (closed >= 0) ::close(closed);
+        return t.finish();
+    }
+    // Bound, never listened on, then closed: connecting is refused
+    ::close(closed);
+
+    // Answers every connection the way sshd does, until shut down
+    std::thread server([listener]() {
+        int fd;
+        while ((fd = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC)) >= 0) {
+            const std::string line = std::string(Banner) + "\r\n";
+            if (::write(fd, line.data(), line.size()) < 0) {}
+            ::close(fd);
+        }
+    });
+
+    QVector<ReachTarget> targets;
+    QVector<Reach> expected;
+    targets.append({"127.0.0.1", listenPort});
+    expected.append(Reach::Reachable);
+    // A name goes through the resolver threads
+    targets.append({"localhost", listenPort});
+    expected.append(Reach::Reachable);
+    // Past one ssh -G batch of 32, so the second batch must get answers too
+    for (int i = 1; i <= 40; ++i) {
+        targets.append({QString("127.0.0.%1").arg(i), closedPort});
+        expected.append(Reach::Refused);
+    }
+    const QVector<ReachResult> results = Reachability::probe(targets, t.intValue("deadline", 100), true);
+
+    ::shutdown(listener, SHUT_RDWR);
+    server.join();
+    ::close(listener);
+
+    for (int i = 0; i < targets.size(); ++i) {
+        const ReachResult& r = results[i];
+        bool ok = r.reach == expected[i];
+        if (expected[i] == Reach::Reachable) ok = ok && r.banner == Banner;
+        t.check(targets[i].host + ':' + QString::number(targets[i].port), ok,
+                QString("expected \"%1\", got \"%2\" after %3 ms")
+                    .arg(ReachResult{expected[i], -1, QString()}.describe(), r.describe())
+                    .arg(r.ms));
+    }
+    console.info(targets.size() - t.failures(), "of", targets.size(), "pre-flight checks passed");
+    return t.finish();
+}
+
+const TestCase reachCheck("reach-check", "Pre-flight verdicts against local ports", TestCase::Check, run, options);
+
+} // namespace
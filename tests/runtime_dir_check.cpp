@@ -0,0 +1,69 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#include "harness.hpp"
+#include "runtime_dir.hpp"
+#include <QDir>
+#include <QFile>
+#include <sys/stat.h>
+
+namespace {
+
+// The socket directory is created 0700, and one with a loose mode or that
+// is a symlink is refused, not fixed. XDG_RUNTIME_DIR points at a
+// throwaway directory for the duration.
+int run(TestContext& t) {
+    const QString base = t.dir();
+    if (!t.check("temporary directory", !base.isEmpty())) return t.finish();
+    const QByteArray saved = qgetenv("XDG_RUNTIME_DIR");
+    const bool wasSet = qEnvironmentVariableIsSet("XDG_RUNTIME_DIR");
+    qputenv("XDG_RUNTIME_DIR", QFile::encodeName(base));
+
+    const QString dir = RuntimeDir::path();
+    const QByteArray native = QFile::encodeName(dir);
+    t.check("path", dir == base + "/ssh-mounter", dir);
+
+    QString error;
+    struct stat st;
+    // mkdir() under a strict umask must still end up 0700
+    const mode_t mask = ::umask(0277);
+    const bool created = RuntimeDir::ensure(error);
+    ::umask(mask);
+    t.check("created", created && ::lstat(native.constData(), &st) == 0 && (st.st_mode & 07777) == 0700, error);
+    error.clear();
+    t.check("existing accepted", RuntimeDir::ensure(error), error);
+
+    ::chmod(native.constData(), 0755);
+    error.clear();
+    t.check("loose mode refused", !RuntimeDir::ensure(error) && !error.isEmpty(), error);
+    t.check("loose mode left alone", ::lstat(native.constData(), &st) == 0 && (st.st_mode & 07777) == 0755);
+
+    // A symlink to a directory that would otherwise pass
+    QDir(base).rmdir("ssh-mounter");
+    QDir(base).mkdir("elsewhere");
+    ::chmod(QFile::encodeName(base + "/elsewhere").constData(), 0700);
+    QFile::link(base + "/elsewhere", dir);
+    error.clear();
+    t.check("symlink refused", !RuntimeDir::ensure(error) && !error.isEmpty(), error);
+
+    if (wasSet) qputenv("XDG_RUNTIME_DIR", saved);
+    else qunsetenv("XDG_RUNTIME_DIR");
+    return t.finish();
+}
+
+const TestCase runtimeDirCheck("runtime-dir-check", "Socket directory creation and ownership checks", TestCase::Check,
+                               run);
+
+} // namespace
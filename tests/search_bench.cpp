@@ -0,0 +1,93 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#include "harness.hpp"
+#include "console.hpp"
+#include "host_index.hpp"
+#include "ssh_store.hpp"
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+
+extern Console console;
+
+namespace {
+
+void options(QCommandLineParser& parser) {
+    parser.addOption({"hosts", "Hosts in the index.", "n", "50000"});
+    parser.addOption({"limit", "Rows a view asks for at a time.", "n", "200"});
+    parser.addOption({"runs", "Runs per query; the median is reported.", "n", "21"});
+    parser.addOption({"budget-us", "Fail if a limited query's median takes longer.", "us", "1000"});
+}
+
+// Query latency with and without a limit, and the cost of removing and
+// re-adding hosts. A limited query is what a keystroke in the filter box
+// costs; one over the budget fails the run.
+int run(TestContext& t) {
+    const int n = t.intValue("hosts");
+    const int limit = t.intValue("limit");
+    const int runs = t.intValue("runs");
+    const double budgetUs = t.intValue("budget-us");
+    const QVector<SSHHost> hosts = syntheticHosts(n);
+
+    QElapsedTimer timer;
+    timer.start();
+    HostSearchIndex index;
+    index.reserve(n);
+    for (const SSHHost& h : hosts) index.insert(h);
+    const qint64 buildMs = timer.restart();
+    // The first search also sorts the index into name order
+    index.search("web", limit);
+    const double firstSearchMs = timer.nsecsElapsed() / 1e6;
+
+    // What typing "web-fra" looks like, plus a typo and a miss
+    QJsonArray queries;
+    for (const QString& q : {QString("w"), QString("we"), QString("web"), QString("web-"), QString("web-f"),
+                             QString("web-fra"), QString("wbe-fra"), QString("example.com"),
+                             QString("nothing-here")}) {
+        int all = 0;
+        QJsonObject r;
+        r["query"] = q;
+        r["limitedUs"] = medianNs(runs, [&]() { index.search(q, limit); }) / 1000.0;
+        r["unlimitedUs"] = medianNs(runs, [&]() { all = index.search(q).size(); }) / 1000.0;
+        r["matches"] = all;
+        queries.append(r);
+        t.check(QString("\"%1\" within %2 us").arg(q).arg(budgetUs), r["limitedUs"].toDouble() <= budgetUs,
+                QString("%1 us").arg(r["limitedUs"].toDouble()));
+        console.info("\"" + q.toStdString() + "\":", all, "matches,", r["limitedUs"].toDouble(), "us limited,",
+                     r["unlimitedUs"].toDouble(), "us unlimited");
+    }
+
+    // Every host edited once: remove and re-add, as SSHStore::replaceRow does
+    timer.restart();
+    for (const SSHHost& h : hosts) {
+        index.remove(h.id);
+        index.insert(h);
+    }
+    const qint64 churnNs = timer.nsecsElapsed();
+    t.check("size after churn", index.size() == n, QString("%1 hosts").arg(index.size()));
+
+    QJsonObject& doc = t.report();
+    doc["hosts"] = n;
+    doc["limit"] = limit;
+    doc["buildMs"] = buildMs;
+    doc["firstSearchMs"] = firstSearchMs;
+    doc["updateUs"] = churnNs / 1000.0 / n;
+    doc["queries"] = queries;
+    return t.finish();
+}
+
+const TestCase searchBench("search-bench", "Host search latency and index update cost", TestCase::Bench, run, options);
+
+} // namespace
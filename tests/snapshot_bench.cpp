@@ -0,0 +1,112 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#include "harness.hpp"
+#include "console.hpp"
+#include "host_snapshot.hpp"
+#include "ssh_store.hpp"
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+
+extern Console console;
+
+namespace {
+
+const int Runs = 3;
+
+// Best of Runs, in microseconds
+qint64 timeRead(const QString& path, bool useSnapshot, QVector<SSHHost>& hosts) {
+    qint64 best = -1;
+    for (int run = 0; run < Runs; ++run) {
+        QString error;
+        QElapsedTimer timer;
+        timer.start();
+        if (!SSHStore::readHosts(path, hosts, error, useSnapshot)) {
+            console.error(error.toStdString());
+            return -1;
+        }
+        const qint64 us = timer.nsecsElapsed() / 1000;
+        if (best < 0 || us < best) best = us;
+    }
+    return best;
+}
+
+void options(QCommandLineParser& parser) {
+    parser.addOption({"hosts", "Comma-separated host counts.", "list", "1000,10000,100000"});
+}
+
+// Load times of hosts.json against hosts.bin
+int run(TestContext& t) {
+    const QString dir = t.dir();
+    if (dir.isEmpty()) return 1;
+
+    QJsonArray results;
+    for (const QString& count : t.value("hosts").split(',', Qt::SkipEmptyParts)) {
+        const int n = count.trimmed().toInt();
+        if (n <= 0) {
+            console.error("Bad host count", count.toStdString());
+            return 2;
+        }
+        const QString path = QString("%1/hosts-%2.json").arg(dir).arg(n);
+        {
+            SSHStore store;
+            store.setFilePath(path);
+            store.addHosts(syntheticHosts(n, dir + "/mnt"));
+            if (!store.save()) return 1;
+        }
+        QVector<SSHHost> written;
+        if (!t.check(QString("snapshot written for %1").arg(n), HostSnapshot::read(path, written))) continue;
+
+        QVector<SSHHost> fromJson, fromSnapshot;
+        const qint64 jsonUs = timeRead(path, false, fromJson);
+        const qint64 snapshotUs = timeRead(path, true, fromSnapshot);
+        if (!t.check(QString("snapshot matches JSON for %1").arg(n),
+                     jsonUs >= 0 && snapshotUs >= 0 && fromJson.size() == n && fromJson == fromSnapshot)) {
+            continue;
+        }
+
+        QJsonObject r;
+        r["hosts"] = n;
+        r["jsonBytes"] = QFileInfo(path).size();
+        r["snapshotBytes"] = QFileInfo(HostSnapshot::pathFor(path)).size();
+        r["jsonMs"] = jsonUs / 1000.0;
+        r["snapshotMs"] = snapshotUs / 1000.0;
+        r["speedup"] = double(jsonUs) / qMax<qint64>(snapshotUs, 1);
+        results.append(r);
+        console.info(n, "hosts: json", jsonUs / 1000.0, "ms, snapshot", snapshotUs / 1000.0, "ms");
+
+        // An edit in place that keeps the size and the inode, as an editor
+        // writing straight into the file would make
+        QFile json(path);
+        const QByteArray before = json.open(QIODevice::ReadWrite) ? json.readAll() : QByteArray();
+        const int at = before.indexOf("\"/srv\"");
+        if (at >= 0 && json.seek(at + 4)) json.write("w");
+        json.close();
+        QString error;
+        t.check(QString("edit in place invalidates the snapshot for %1").arg(n),
+                at >= 0 && SSHStore::readHosts(path, fromSnapshot, error, true)
+                && SSHStore::readHosts(path, fromJson, error, false) && fromSnapshot == fromJson
+                && fromJson.size() == n && fromJson != written);
+    }
+    t.report()["results"] = results;
+    return t.finish();
+}
+
+const TestCase snapshotBench("snapshot-bench", "Load times of hosts.json against its binary snapshot",
+                             TestCase::Bench, run, options);
+
+} // namespace
@@ -0,0 +1,105 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#include "harness.hpp"
+#include "console.hpp"
+#include "ssh_store.hpp"
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+
+extern Console console;
+
+namespace {
+
+// Nanoseconds per call of lookup(i) over ops calls
+template <typename F>
+double timeLookups(int ops, F lookup) {
+    QElapsedTimer timer;
+    timer.start();
+    int found = 0;
+    for (int i = 0; i < ops; ++i) found += lookup(i) ? 1 : 0;
+    const double ns = double(timer.nsecsElapsed()) / ops;
+    if (found != ops) console.warn(ops - found, "lookup(s) missed");
+    return ns;
+}
+
+void options(QCommandLineParser& parser) {
+    parser.addOption({"hosts", "Hosts in the store.", "n", "100000"});
+    parser.addOption({"ops", "Lookups per kind.", "n", "1000000"});
+    parser.addOption({"removals", "Hosts removed one at a time.", "n", "1000"});
+}
+
+// Lookup, removal and memory cost per host of a synthetic store
+int run(TestContext& t) {
+    const int n = t.intValue("hosts");
+    const int ops = t.intValue("ops");
+    const int removals = qBound(0, t.value("removals").toInt(), (n - 1) / 2);
+
+    QVector<SSHHost> input = syntheticHosts(n);
+    const qint64 rssBefore = residentBytes();
+    QElapsedTimer timer;
+    timer.start();
+    SSHStore store;
+    const QStringList ids = store.addHosts(input);
+    const qint64 buildMs = timer.elapsed();
+    input.clear();
+    input.squeeze();
+    const qint64 rssAfter = residentBytes();
+
+    // Spread over the whole store rather than walking it in order
+    auto pick = [n](int i) { return int((qint64(i) * 7919) % n); };
+    QJsonObject lookups;
+    lookups["byIdNs"] = timeLookups(ops, [&](int i) { return store.byId(ids[pick(i)]) != nullptr; });
+    lookups["indexOfNs"] = timeLookups(ops, [&](int i) { return store.indexOf(ids[pick(i)]) >= 0; });
+    const int nameOps = qMin(ops, n);
+    lookups["byNameNs"] = timeLookups(nameOps, [&](int i) { return !store.byName(store.at(pick(i)).name).isEmpty(); });
+    lookups["byHostnameNs"] = timeLookups(nameOps, [&](int i) {
+        return !store.byHostname(store.at(pick(i)).host).isEmpty();
+    });
+
+    // One at a time from near the front, each followed by a lookup the way
+    // a view would make one: the worst case for row bookkeeping
+    int lost = 0;
+    timer.restart();
+    for (int i = 0; i < removals; ++i) {
+        store.removeHost(ids[i * 2]);
+        if (store.indexOf(ids.last()) < 0) ++lost;
+    }
+    const double removeUs = removals > 0 ? timer.nsecsElapsed() / 1000.0 / removals : 0;
+    t.check("lookups during removals", lost == 0, QString("%1 missed").arg(lost));
+    int wrongRow = -1;
+    for (int row = 0; row < store.count() && wrongRow < 0; ++row) {
+        if (store.indexOf(store.at(row).id) != row) wrongRow = row;
+    }
+    t.check("row index", store.count() == n - removals && wrongRow < 0,
+            QString("%1 hosts, first wrong row %2").arg(store.count()).arg(wrongRow));
+
+    QJsonObject& doc = t.report();
+    doc["hosts"] = n;
+    doc["buildMs"] = buildMs;
+    doc["residentBytes"] = rssAfter - rssBefore;
+    doc["bytesPerHost"] = double(rssAfter - rssBefore) / n;
+    doc["lookups"] = lookups;
+    doc["removals"] = removals;
+    doc["removeUs"] = removeUs;
+    console.info(n, "hosts:", (rssAfter - rssBefore) / n, "bytes each, byId",
+                 lookups["byIdNs"].toDouble(), "ns, removal", removeUs, "us");
+    return t.finish();
+}
+
+const TestCase storeBench("store-bench", "Lookup, removal and memory cost of a synthetic host store",
+                          TestCase::Bench, run, options);
+
+} // namespace
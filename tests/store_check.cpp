@@ -0,0 +1,401 @@
+/*
+ * SSH Mounter - Simple GUI for SSHFS mounts
+ * Copyright (C) 2025 SonicandTailsCD
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#include "harness.hpp"
+#include "console.hpp"
+#include "host_snapshot.hpp"
+#include "ssh_store.hpp"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QProcess>
+#include <QRandomGenerator>
+#include <QSaveFile>
+#include <QSet>
+#include <QThread>
+#include <atomic>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/file.h>
+#include <thread>
+#include <unistd.h>
+
+extern Console console;
+
+namespace {
+
+// Hosts the crash writer keeps while it journals
+const int CrashJournalHosts = 200;
+
+// The crash writer's full saves differ in size from one generation to the
+// next, so a torn file cannot pass for a whole one
+int crashHostCount(int gen) {
+    return 50 + (gen * 37) % 400;
+}
+
+QVector<SSHHost> crashHosts(int count, int gen) {
+    QVector<SSHHost> hosts;
+    hosts.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        SSHHost h;
+        h.id = QString("crash-%1").arg(i);
+        h.name = QString("host-%1").arg(i);
+        h.user = "deploy";
+        h.host = QString("host%1.example.com").arg(i);
+        h.remotePath = QString("/gen/%1").arg(gen);
+        h.localPath = QString("/mnt/host-%1").arg(i);
+        hosts.append(h);
+    }
+    return hosts;
+}
+
+SSHHost makeHost(int i) {
+    SSHHost h;
+    h.name = QString("host-%1").arg(i);
+    h.user = "deploy";
+    h.host = QString("host%1.example.com").arg(i);
+    h.remotePath = "/srv";
+    h.localPath = QString("/mnt/host-%1").arg(i);
+    return h;
+}
+
+QVector<SSHHost> onDisk(const QString& path, bool snapshot = false) {
+    QVector<SSHHost> hosts;
+    QString err;
+    if (!SSHStore::readHosts(path, hosts, err, snapshot)) console.error(err.toStdString());
+    return hosts;
+}
+
+QByteArray readFile(const QString& file) {
+    QFile in(file);
+    return in.open(QIODevice::ReadOnly) ? in.readAll() : QByteArray();
+}
+
+QSet<QString> idsOf(const QVector<SSHHost>& hosts) {
+    QSet<QString> ids;
+    for (const SSHHost& host : hosts) ids.insert(host.id);
+    return ids;
+}
+
+// Child side of the crash rounds: saves one generation of hosts after
+// another through the store, printing each number once it is on disk,
+// until killed
+int runCrashWriter(const QString& path, bool journal) {
+    SSHStore store;
+    store.setFilePath(path);
+    store.load();
+    const int first = journal ? CrashJournalHosts : crashHostCount(0);
+    store.addHosts(crashHosts(first, 0));
+    if (!store.save()) return 1;
+    std::cout << 0 << std::endl;
+    // Only the first save is full when journaling
+    store.setJournalEnabled(journal);
+
+    // Bounded in case the parent is gone without killing it
+    for (int gen = 1; gen < 1000000; ++gen) {
+        if (journal) {
+            SSHHost h = store.at(gen % CrashJournalHosts);
+            h.remotePath = QString("/gen/%1").arg(gen);
+            store.updateHost(h.id, h);
+        } else {
+            // Kept hosts stay in place and new ones are appended, so the
+            // store's order is crashHosts() order
+            const QVector<SSHHost> target = crashHosts(crashHostCount(gen), gen);
+            for (int i = store.count() - 1; i >= target.size(); --i) store.removeHost(store.at(i).id);
+            for (const SSHHost& h : target) {
+                if (store.byId(h.id)) {
+                    store.updateHost(h.id, h);
+                } else {
+                    store.addHost(h);
+                }
+            }
+        }
+        if (!store.save()) return 1;
+        std::cout << gen << std::endl;
+    }
+    return 0;
+}
+
+void options(QCommandLineParser& parser) {
+    parser.addOption({"crashes", "Writers killed mid-save.", "n", "20"});
+    QCommandLineOption writer("crash-writer", "Save generations to file until killed.", "file");
+    QCommandLineOption writerJournal("crash-journal", "Journal the crash writer's saves.");
+    writer.setFlags(QCommandLineOption::HiddenFromHelp);
+    writerJournal.setFlags(QCommandLineOption::HiddenFromHelp);
+    parser.addOption(writer);
+    parser.addOption(writerJournal);
+}
+
+// Autosave, the journal, two stores on one file, and writers killed at a
+// random point of a save
+int run(TestContext& t) {
+    if (t.options().isSet("crash-writer")) {
+        return runCrashWriter(t.value("crash-writer"), t.options().isSet("crash-journal"));
+    }
+    const int crashes = t.intValue("crashes", 0);
+    const QString dir = t.dir();
+    if (dir.isEmpty()) return 1;
+    const QString path = dir + "/hosts.json";
+    const QString journal = SSHStore::journalPath(path);
+
+    // Every autosave has landed
+    auto settle = [&t](SSHStore& store) {
+        return t.waitFor([&store]() { return !store.isDirty() && !store.isSaving(); }, 5000);
+    };
+
+    SSHStore store;
+    store.setFilePath(path);
+    store.load();
+    store.setJournalEnabled(true);
+    store.setAutosave(true, 20);
+
+    // The first save has no hosts.json to journal against
+    QStringList ids;
+    for (int i = 0; i < 5; ++i) ids << store.addHost(makeHost(i));
+    SSHHost changed = *store.byId(ids[1]);
+    changed.remotePath = "/changed";
+    store.updateHost(ids[1], changed);
+    store.removeHost(ids[2]);
+    t.check("autosave", settle(store) && onDisk(path) == store.hosts() && !QFile::exists(journal));
+
+    changed.remotePath = "/journaled";
+    store.updateHost(ids[1], changed);
+    store.removeHost(ids[3]);
+    ids << store.addHost(makeHost(5));
+    t.check("journal append", settle(store) && readFile(journal).count('\n') == 3
+                              && !readFile(path).contains("/journaled"));
+    t.check("journal replay", onDisk(path) == store.hosts() && onDisk(path, true) == store.hosts());
+    {
+        SSHStore fresh;
+        fresh.setFilePath(path);
+        t.check("load replays journal", fresh.load() && fresh.hosts() == store.hosts());
+    }
+
+    // Two edits of one host before the timer fires are one journal line
+    changed.remotePath = "/first";
+    store.updateHost(ids[1], changed);
+    changed.remotePath = "/second";
+    store.updateHost(ids[1], changed);
+    t.check("edits coalesce", settle(store) && readFile(journal).count('\n') == 4 && onDisk(path) == store.hosts());
+
+    // What a crash in the middle of an append leaves behind
+    {
+        QFile torn(journal);
+        if (torn.open(QIODevice::WriteOnly | QIODevice::Append)) torn.write("{\"op\":\"put\",\"host\":{\"id\":\"torn\"");
+    }
+    t.check("torn line skipped", onDisk(path) == store.hosts());
+    changed.remotePath = "/after-torn";
+    store.updateHost(ids[1], changed);
+    t.check("append after torn line", settle(store) && onDisk(path) == store.hosts()
+                                      && onDisk(path, true) == store.hosts());
+
+    store.setJournalEnabled(false);
+    changed.remotePath = "/folded";
+    store.updateHost(ids[1], changed);
+    t.check("full save folds journal", store.save() && !QFile::exists(journal) && readFile(path).contains("/folded")
+                                       && onDisk(path) == store.hosts() && onDisk(path, true) == store.hosts());
+
+    QStringList leftovers = QDir(dir).entryList(QDir::Files);
+    for (const QString& expected : {QString("hosts.json"), QString("hosts.lock"),
+                                    QFileInfo(HostSnapshot::pathFor(path)).fileName()}) {
+        leftovers.removeAll(expected);
+    }
+    t.check("no temporary files", leftovers.isEmpty(), leftovers.join(' '));
+
+    // Two stores on one file, as two instances would have
+    const QString shared = dir + "/shared/hosts.json";
+    SSHStore first, second;
+    first.setFilePath(shared);
+    first.load();
+    QStringList sharedIds;
+    for (int i = 0; i < 5; ++i) sharedIds << first.addHost(makeHost(i));
+    first.save();
+    second.setFilePath(shared);
+    second.load();
+
+    {
+        // Held the way a writing instance holds it
+        const int lock = ::open(QFile::encodeName(SSHStore::lockPath(shared)).constData(),
+                                O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+        std::atomic<bool> read{false};
+        bool blocked = false;
+        if (lock >= 0 && flock(lock, LOCK_EX) == 0) {
+            std::thread reader([&shared, &read]() {
+                onDisk(shared);
+                read = true;
+            });
+            QThread::msleep(100);
+            blocked = !read;
+            flock(lock, LOCK_UN);
+            reader.join();
+        }
+        if (lock >= 0) ::close(lock);
+        t.check("readers wait for the write lock", blocked && read);
+    }
+
+    // The second saves over a file the first changed since it was read
+    const QString fromFirst = first.addHost(makeHost(10));
+    first.save();
+    const QString fromSecond = second.addHost(makeHost(11));
+    second.save();
+    QSet<QString> expectedIds(sharedIds.begin(), sharedIds.end());
+    expectedIds << fromFirst << fromSecond;
+    t.check("save merges changes made elsewhere", idsOf(onDisk(shared)) == expectedIds);
+
+    struct Counts {
+        int added = 0;
+        int updated = 0;
+        int removed = 0;
+        int resets = 0;
+        int changed = 0;
+        int reloads = 0;
+    } counts;
+    first.load();
+    second.load();
+    QObject::connect(&second, &SSHStore::hostAdded, &second, [&counts]() { ++counts.added; });
+    QObject::connect(&second, &SSHStore::hostUpdated, &second, [&counts]() { ++counts.updated; });
+    QObject::connect(&second, &SSHStore::hostRemoved, &second, [&counts]() { ++counts.removed; });
+    QObject::connect(&second, &SSHStore::hostsReset, &second, [&counts]() { ++counts.resets; });
+    QObject::connect(&second, &SSHStore::hostsChanged, &second, [&counts]() { ++counts.changed; });
+    QObject::connect(&second, &SSHStore::reloaded, &second, [&counts]() { ++counts.reloads; });
+    const bool watching = second.startWatching();
+    t.check("inotify watch", watching);
+    auto reloaded = [&t, &counts]() { return t.waitFor([&counts]() { return counts.reloads > 0; }); };
+
+    if (watching) {
+        SSHHost edited = *first.byId(sharedIds[0]);
+        edited.remotePath = "/edited";
+        first.updateHost(sharedIds[0], edited);
+        first.removeHost(sharedIds[1]);
+        first.addHost(makeHost(12));
+        first.save();
+        t.check("reload by host ID", reloaded() && second.hosts() == first.hosts() && counts.added == 1
+                                     && counts.updated == 1 && counts.removed == 1 && counts.resets == 0
+                                     && counts.changed == 0,
+                QString("%1 added, %2 updated, %3 removed, %4 resets, %5 hostsChanged")
+                    .arg(counts.added).arg(counts.updated).arg(counts.removed).arg(counts.resets).arg(counts.changed));
+
+        SSHHost local = *second.byId(sharedIds[2]);
+        local.remotePath = "/local";
+        second.updateHost(sharedIds[2], local);
+        counts = Counts();
+        edited.remotePath = "/edited-again";
+        first.updateHost(sharedIds[0], edited);
+        first.save();
+        t.check("unsaved edits survive a reload", reloaded() && second.byId(sharedIds[2])->remotePath == "/local"
+                                                  && second.byId(sharedIds[0])->remotePath == "/edited-again"
+                                                  && second.isDirty());
+
+        // Saving over a newer file brings what it added into the store
+        counts = Counts();
+        const QString late = first.addHost(makeHost(13));
+        first.save();
+        second.save();
+        t.check("save over a newer file re-reads it", t.waitFor([&]() { return second.byId(late) != nullptr; })
+                                                      && second.hosts() == onDisk(shared) && counts.resets == 0);
+
+        // A script rewrites the file without IDs and adds a host of its own
+        t.waitFor([&second]() { return !second.isReloading() && !second.isSaving(); });
+        const QSet<QString> before = idsOf(second.hosts());
+        QJsonArray arr;
+        for (const SSHHost& host : second.hosts()) {
+            QJsonObject obj = host.toJson();
+            obj.remove("id");
+            arr.append(obj);
+        }
+        QJsonObject added = makeHost(14).toJson();
+        added.remove("id");
+        arr.append(added);
+        QJsonObject root;
+        root["hosts"] = arr;
+        counts = Counts();
+        QSaveFile script(shared);
+        const bool written = script.open(QIODevice::WriteOnly) && script.write(QJsonDocument(root).toJson()) > 0
+                             && script.commit();
+        const bool seen = written && reloaded();
+        const QSet<QString> after = idsOf(second.hosts());
+        t.check("reload keeps IDs of a file without them",
+                seen && after.contains(before) && after.size() == before.size() + 1 && counts.added == 1
+                && counts.resets == 0 && second.isDirty() && second.save() && idsOf(onDisk(shared)) == after,
+                QString("%1 of %2 IDs kept, %3 added, %4 resets")
+                    .arg(QSet<QString>(after).intersect(before).size()).arg(before.size())
+                    .arg(counts.added).arg(counts.resets));
+    }
+    second.stopWatching();
+
+    // A writer process killed at a random point of a save, with and without
+    // the journal. This is a crash of the process, not of the machine:
+    // what it shows is that no read ever sees a torn file and that every
+    // save the writer finished survives.
+    QStringList crashErrors[2];
+    for (int round = 0; round < crashes; ++round) {
+        const bool journaled = round % 2 == 1;
+        const QString crashPath = QString("%1/crash-%2/hosts.json").arg(dir).arg(round);
+        QDir().mkpath(QFileInfo(crashPath).absolutePath());
+        QStringList& errors = crashErrors[journaled ? 1 : 0];
+
+        QProcess proc;
+        proc.setStandardErrorFile(QProcess::nullDevice());
+        QStringList args{"store-check", "--crash-writer", crashPath};
+        if (journaled) args << "--crash-journal";
+        proc.start(QCoreApplication::applicationFilePath(), args);
+        const bool saving = proc.waitForReadyRead(10000);
+        if (saving) QThread::msleep(QRandomGenerator::global()->bounded(1, 150));
+        proc.kill();
+        proc.waitForFinished(5000);
+        if (!saving) {
+            errors << QString("round %1: the writer never saved").arg(round);
+            continue;
+        }
+        // Each number is printed only once its save is complete
+        const int last = proc.readAllStandardOutput().trimmed().split('\n').last().toInt();
+
+        QVector<SSHHost> json, snapshot;
+        QString err;
+        if (!SSHStore::readHosts(crashPath, json, err, false)) {
+            errors << QString("round %1: %2").arg(round).arg(err);
+            continue;
+        }
+        if (!SSHStore::readHosts(crashPath, snapshot, err, true) || snapshot != json) {
+            errors << QString("round %1: hosts.bin disagrees with hosts.json").arg(round);
+            continue;
+        }
+        if (journaled) {
+            const QString expected = QString("/gen/%1").arg(last);
+            if (json.size() != CrashJournalHosts || json[last % CrashJournalHosts].remotePath != expected) {
+                errors << QString("round %1: journaled save %2 is lost").arg(round).arg(last);
+            }
+        } else {
+            const int gen = json.value(0).remotePath.mid(5).toInt();
+            if ((gen != last && gen != last + 1) || json != crashHosts(crashHostCount(gen), gen)) {
+                errors << QString("round %1: read generation %2 after save %3").arg(round).arg(gen).arg(last);
+            }
+        }
+    }
+    if (crashes > 0) {
+        t.check("crash during full saves", crashErrors[0].isEmpty(), crashErrors[0].join("; "));
+        t.check("crash during journal appends", crashErrors[1].isEmpty(), crashErrors[1].join("; "));
+    }
+    t.report()["crashes"] = crashes;
+    return t.finish();
+}
+
+const TestCase storeCheck("store-check", "Autosave, journal replay, two stores on one file and writers killed mid-save",
+                          TestCase::Check, run, options);
+
+} // namespace